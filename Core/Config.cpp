@@ -4,7 +4,9 @@
 #include "Config.hpp"
 #include "../Utils/TextUtils.hpp"
 #include "../Utils/TimeUtils.hpp"
+#include <algorithm>
 #include <fstream>
+#include <iterator>
 
 namespace utl = vsprofile::utils;
 namespace fs = std::filesystem;
@@ -25,6 +27,9 @@ namespace vsprofile {
                 json j;
                 in >> j;
                 cfg = j.get<Config>();
+                if (ProfileStats stats {ProfileStats::Load(ProfileStats::PathFor(configPath))}; !stats.profiles.empty()) {
+                    cfg.stats = std::move(stats);
+                }
             }
             catch (const json::parse_error&) {
                 // corrupt JSON - keep defaults
@@ -39,17 +44,46 @@ namespace vsprofile {
         return cfg;
     }
 
+    bool Config::MatchesSaved(const fs::path& path) const {
+        auto unchanged = [](const fs::path& file, const std::string& content) {
+            std::ifstream in {file, std::ios::binary};
+            return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}} == content;
+        };
+        return unchanged(path, json(*this).dump(4) + '\n') && unchanged(ProfileStats::PathFor(path), stats.Serialise());
+    }
+
+    bool Config::SaveIfChanged(const fs::path& path) const {
+        if (MatchesSaved(path)) return false;
+        Save(path);
+        return true;
+    }
+
     void Config::Save(const fs::path& path) const {
         fs::create_directories(path.parent_path());
+        const bool durable {durability != utl::Durability::None};
+        // The two files cannot be replaced together, so the stats go first and are best-effort: a crash or
+        // a failure in between only leaves them a step ahead of the config, and they just inform decisions
+        try {
+            WriteReplacing(ProfileStats::PathFor(path), stats.Serialise(), durable);
+        }
+        catch (const std::runtime_error& e) {
+            utl::PrintWarn(std::format("Usage statistics not saved: {}\n", e.what()));
+        }
+        WriteReplacing(path, json(*this).dump(4) + '\n', durable);
+    }
+
+    void Config::WriteReplacing(const fs::path& path, const std::string& content, const bool durable) {
         const fs::path tmp = path.string() + ".tmp";
         // Save to a temporary file
         {
             std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
             if (!out) throw std::runtime_error(std::format("open '{}' failed", tmp.string()));
-            out << json(*this).dump(4) << '\n';
+            out << content;
             out.flush();
             if (!out) throw std::runtime_error(std::format("write '{}' failed", tmp.string()));
         }
+        // Flushed before the rename, or a power loss could leave the new name on an empty file
+        if (durable) utl::SyncFile(tmp);
         // replace target (rename, else remove+rename, else copy)
         std::error_code ec;
         fs::rename(tmp, path, ec);
@@ -60,17 +94,72 @@ namespace vsprofile {
                 fs::copy_file(tmp, path, fs::copy_options::overwrite_existing, ec);
                 fs::remove(tmp);
                 if (ec) throw std::runtime_error(std::format("Failed replacing '{}': {}", path.string(), ec.message()));
+                if (durable) utl::SyncFile(path);
             }
         }
+        if (durable) utl::SyncDirectory(path.parent_path());
+    }
+
+    namespace {
+        // Roots and caches are kept in profiles under the same relative path, which must stay inside both folders
+        bool InsideDataFolder(const fs::path& path) {
+            if (path.empty() || path.has_root_path()) return false;
+            return std::ranges::none_of(path, [](const fs::path& part) { return part == ".." || part == "."; });
+        }
+
+        template <typename T, typename PathOf>
+        void DropOutsideDataFolder(std::vector<T>& entries, const std::string_view key, PathOf pathOf) {
+            std::erase_if(entries, [&](const T& entry) {
+                if (InsideDataFolder(pathOf(entry))) return false;
+                utl::PrintWarn(std::format("Ignoring '{}' in {}, it must be a folder inside the game data folder\n", pathOf(entry).string(), key));
+                return true;
+            });
+        }
+    }
+
+    void to_json(json &j, const ProfileRoot &r) {
+        j = json{
+                {"path",     r.path},
+                {"strategy", utl::ToString(r.strategy)},
+        };
+    }
+
+    void from_json(const json &j, ProfileRoot &r) {
+        r.path = j.at("path").get<fs::path>();
+        r.strategy = utl::SyncStrategyFromString(j.value("strategy", std::string{"copy"}));
     }
 
     // Required by JSON to serialise
     void to_json(json &j, const Config &c) {
+        json volumeCopyOrder = json::object();
+        for (const auto& [volume, order] : c.volumeCopyOrder) volumeCopyOrder[volume.string()] = utl::ToString(order);
+        json copyCalibration = json::object();
+        for (const auto& [pair, cal] : c.copyCalibration) {
+            copyCalibration[pair] = {{"method", utl::ToString(cal.method)}, {"hardLinks", cal.hardLinks}, {"mibPerSecond", cal.mibPerSecond}};
+        }
+        const StashRetention& r {c.stashRetention};
+        const json stashRetention {{"keepLast", r.keepLast}, {"keepDaily", r.keepDaily}, {"keepWeekly", r.keepWeekly},
+                                   {"maxMiB", r.maxMiB}, {"onActivate", r.onActivate}};
         j = json{
                 {"vintagestoryDataPath", c.vintagestoryDataPath},
                 {"profilesPath",         c.profilesPath},
                 {"activeProfile",        c.activeProfile},
                 {"vintagestoryExePath",  c.vintagestoryExePath},
+                {"cachePaths",           c.cachePaths},
+                {"roots",                c.roots},
+                {"snapshotOnActivate",   c.snapshotOnActivate},
+                {"activationStrategy",   c.activationStrategy == ActivationStrategy::Symlink ? "symlink" : "sync"},
+                {"autoPrepare",          c.autoPrepare},
+                {"prewarmOnActivate",    c.prewarmOnActivate},
+                {"volumeCopyOrder",      volumeCopyOrder},
+                {"copyCalibration",      copyCalibration},
+                {"copyIntegrity",        c.copyIntegrity == CopyIntegrity::Verify ? "verify"
+                                         : c.copyIntegrity == CopyIntegrity::Hash ? "hash" : "off"},
+                {"durability",           utl::ToString(c.durability)},
+                {"deltaStashes",         c.deltaStashes},
+                {"coldAfterDays",        c.coldAfterDays},
+                {"stashRetention",       stashRetention},
+                {"activationHistory",    c.activationHistory},
         };
     }
 
@@ -80,6 +169,40 @@ namespace vsprofile {
         c.profilesPath = j.at("profilesPath").get<fs::path>();
         c.activeProfile = j.at("activeProfile").get<std::string>();
         c.vintagestoryExePath = j.at("vintagestoryExePath").get<fs::path>();
+        c.cachePaths = j.value("cachePaths", c.cachePaths); // optional, configs predating it keep the default
+        DropOutsideDataFolder(c.cachePaths, "cachePaths", [](const fs::path& path) -> const fs::path& { return path; });
+        // Configs predating roots only ever copied Mods: they keep doing that, hard links are opted into
+        c.roots = j.value("roots", std::vector<ProfileRoot>{{"Mods", utl::SyncStrategy::Copy}});
+        DropOutsideDataFolder(c.roots, "roots", [](const ProfileRoot& root) -> const fs::path& { return root.path; });
+        if (std::ranges::none_of(c.roots, &ProfileRoot::IsMods)) c.roots.insert(c.roots.begin(), {"Mods", utl::SyncStrategy::Copy});
+        c.snapshotOnActivate = j.value("snapshotOnActivate", c.snapshotOnActivate);
+        c.activationStrategy = j.value("activationStrategy", std::string{"sync"}) == "symlink"
+                               ? ActivationStrategy::Symlink : ActivationStrategy::Sync;
+        c.autoPrepare = j.value("autoPrepare", c.autoPrepare);
+        c.prewarmOnActivate = j.value("prewarmOnActivate", c.prewarmOnActivate);
+        const json volumeCopyOrder = j.value("volumeCopyOrder", json::object());
+        for (const auto& [volume, order] : volumeCopyOrder.items()) {
+            c.volumeCopyOrder[volume] = utl::CopyOrderFromString(order.get<std::string>());
+        }
+        const json copyCalibration = j.value("copyCalibration", json::object());
+        for (const auto& [pair, cal] : copyCalibration.items()) {
+            c.copyCalibration[pair] = {utl::CopyMethodFromString(cal.value("method", std::string{})),
+                                       cal.value("hardLinks", false), cal.value("mibPerSecond", 0.0)};
+        }
+        const std::string integrity {j.value("copyIntegrity", std::string{"off"})};
+        c.copyIntegrity = integrity == "verify" ? CopyIntegrity::Verify
+                          : integrity == "hash" ? CopyIntegrity::Hash : CopyIntegrity::Off;
+        c.durability = utl::DurabilityFromString(j.value("durability", std::string{"none"}));
+        c.deltaStashes = j.value("deltaStashes", c.deltaStashes);
+        c.coldAfterDays = j.value("coldAfterDays", c.coldAfterDays);
+        const json stashRetention = j.value("stashRetention", json::object());
+        StashRetention& r {c.stashRetention};
+        r.keepLast = stashRetention.value("keepLast", r.keepLast);
+        r.keepDaily = stashRetention.value("keepDaily", r.keepDaily);
+        r.keepWeekly = stashRetention.value("keepWeekly", r.keepWeekly);
+        r.maxMiB = stashRetention.value("maxMiB", r.maxMiB);
+        r.onActivate = stashRetention.value("onActivate", r.onActivate);
+        c.activationHistory = j.value("activationHistory", c.activationHistory);
     }
 
     void Config::HandleCorruptConfig(const fs::path& configPath) {
@@ -1,28 +1,85 @@
 #pragma once
 #include "../Include/json.hpp"
 #include "../Utils/AppConstants.hpp"
+#include "../Utils/CopyCalibration.hpp"
+#include "../Utils/DiskLayout.hpp"
+#include "../Utils/Durability.hpp"
+#include "../Utils/SyncPlan.hpp"
+#include "ProfileStats.hpp"
+#include "StashRetention.hpp"
 #include <filesystem>
+#include <map>
 #include <string>
+#include <vector>
 
 using json = nlohmann::json;
 
 namespace vsprofile {
+    // A folder captured by profiles, relative to vintagestoryDataPath. "Mods" is the profile folder itself,
+    // every other root is stored under the profile's metadata folder.
+    struct ProfileRoot {
+        std::filesystem::path path;
+        utils::SyncStrategy strategy {utils::SyncStrategy::Copy};
+
+        [[nodiscard]] bool IsMods() const { return path == "Mods"; }
+    };
+
+    enum class ActivationStrategy {
+        Sync,    // Mods is a real folder reconciled with the profile
+        Symlink, // Mods is a symlink retargeted to the profile folder
+    };
+
+    enum class CopyIntegrity {
+        Off,    // copies are cloned however the filesystem copies fastest
+        Hash,   // copies are hashed as they are read, and the hashes recorded with the destination
+        Verify, // as Hash, then every copy is read back past the page cache and checked
+    };
+
     struct Config {
         std::filesystem::path vintagestoryDataPath {constants::kVintageStoryDataPath};
         std::filesystem::path profilesPath {constants::kAppDir / "Profiles"};
         std::filesystem::path modsPath {constants::kVintageStoryDataPath / "Mods"};
         std::filesystem::path vintagestoryExePath;
         std::string activeProfile;
+        // Folders relative to vintagestoryDataPath that the game rebuilds per mod set, kept with each profile;
+        // none unless listed, so no folder the game has is moved away without the user asking
+        std::vector<std::filesystem::path> cachePaths;
+        bool snapshotOnActivate {false}; // snapshot Saves before every activation
+        ActivationStrategy activationStrategy {ActivationStrategy::Sync};
+        bool autoPrepare {false}; // stage the predicted next profile after every activation
+        bool prewarmOnActivate {false}; // read the new Mods into the page cache after every activation
+        // Copy order per volume (path prefix), for disks whose rotational flag is missing or misleading
+        std::map<std::filesystem::path, utils::CopyOrder> volumeCopyOrder;
+        utils::CopyCalibrations copyCalibration; // fastest copy method per filesystem pair, measured on first use
+        CopyIntegrity copyIntegrity {CopyIntegrity::Off};
+        utils::Durability durability {utils::Durability::None}; // flushing of copies, journals and this config
+        bool deltaStashes {true}; // stashes keep only what the activated profile lacks, see DeltaManifest
+        // Profiles not activated for this many days are packed into the cold tier, 0 for never
+        std::uint32_t coldAfterDays {0};
+        StashRetention stashRetention; // which auto-generated stashes 'prune' keeps
+        std::vector<std::string> activationHistory; // oldest first, capped
+        ProfileStats stats; // saved beside the config by Save, not in it, and best-effort
+        // Folders relative to vintagestoryDataPath that each profile holds; Mods is always one of them. New
+        // configs hard link Mods, a config saved before roots existed only copies Mods, as it always did
+        std::vector<ProfileRoot> roots {
+                {"Mods",      utils::SyncStrategy::Link},
+                {"ModConfig", utils::SyncStrategy::Copy},
+        };
 
         Config() = default;
 
-        void Save(const std::filesystem::path& configPath) const;
+        void Save(const std::filesystem::path& configPath) const; // the stats file first, a failure there only warns
+        bool SaveIfChanged(const std::filesystem::path& configPath) const; // skips the write when up to date
+        [[nodiscard]] bool MatchesSaved(const std::filesystem::path& configPath) const; // what Save would write is already there
         static Config Load(const std::filesystem::path& configPath);
 
     private:
         static void HandleCorruptConfig(const std::filesystem::path& configPath);
+        static void WriteReplacing(const std::filesystem::path& path, const std::string& content, bool durable);
     };
 
+    void to_json(json &j, const ProfileRoot &r);
+    void from_json(const json &j, ProfileRoot &r);
     void to_json(json &j, const Config &p);
     void from_json(const json &j, Config &p);
 }
@@ -4,16 +4,80 @@
 #include "Core.hpp"
 
 #include "../Utils/ConsoleUtils.hpp"
+#include "../Utils/CopyCalibration.hpp"
 #include "../Utils/TextUtils.hpp"
 #include "../Utils/FileUtils.hpp"
+#include "../Utils/DirectoryScan.hpp"
+#include "../Utils/Pack.hpp"
+#include "../Utils/Prewarm.hpp"
+#include "../Utils/ProcessUtils.hpp"
+#include "../Utils/StatsUtils.hpp"
 #include "../Utils/TimeUtils.hpp"
+#include "../Utils/Trash.hpp"
+#include "../Utils/WorkStealing.hpp"
+#include "../Utils/deltaDebug.hpp"
+#include "Journal.hpp"
+#include "Manifest.hpp"
+#include "ResourceHistory.hpp"
+#include "Snapshot.hpp"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <unordered_set>
 
 namespace utl = vsprofile::utils;
 namespace fs = std::filesystem;
+namespace ch = std::chrono;
 
 namespace vsprofile {
 
-    Core::Core(Config config) : config_(std::move(config)) {}
+    namespace {
+        // Whether `file` is still the one a delta stash or a pack listed, going by size and mtime as syncing does
+        bool Unchanged(const fs::path& file, const std::uintmax_t size, const long long mtime) {
+            std::error_code ec;
+            if (!fs::is_regular_file(file, ec) || fs::file_size(file, ec) != size || ec) return false;
+            const auto written {fs::last_write_time(file, ec)};
+            return !ec && written.time_since_epoch().count() == mtime;
+        }
+
+        // Files no other profile or Mods links to, the ones packing a profile actually frees
+        void CollectPackable(const fs::path& dir, const std::string& prefix, std::vector<std::string>& packable, std::size_t& shared) {
+            std::error_code ec;
+            for (const utl::DirEntry& e : utl::DirectoryScan::Read(dir, utl::ScanDetail::Stats, ec)) {
+                if (utl::IsHiddenEntry(e.name)) continue;
+                std::string rel {prefix};
+                rel += e.name;
+                if (e.IsDirectory()) CollectPackable(dir / e.name, rel + '/', packable, shared);
+                else if (e.IsFile() && e.links > 1) ++shared;
+                else if (e.IsFile()) packable.push_back(std::move(rel));
+            }
+        }
+    }
+
+    Core::Core(Config config) : config_(std::move(config)) {
+        ApplySettings();
+        // Before anything else touches Mods; a process holding the lock may be running that activation
+        if (const utl::FileLock lock {constants::kLockPath}; lock.Held()) ResumeActivation();
+        PurgeTrashInBackground(); // whatever earlier runs trashed and is past the undo window
+    }
+
+    bool Core::ReloadConfig(const fs::path& configPath) {
+        // Anything else on disk was written by hand, or by the other of vsprofile and vsprofiled
+        if (config_.MatchesSaved(configPath)) return false;
+        WaitForStaging();
+        config_ = Config::Load(configPath);
+        ApplySettings();
+        return true;
+    }
+
+    void Core::ApplySettings() const {
+        utl::SetCopyOrderOverrides(config_.volumeCopyOrder);
+        utl::SetCopyCalibrations(config_.copyCalibration);
+        utl::SetDurability(config_.durability);
+    }
 
     std::string Core::GenNonEmptyName(const std::string_view nameIn) const{
         if (nameIn.empty()) {
@@ -34,14 +98,24 @@ namespace vsprofile {
         }
         // Create profile directory
         fs::create_directories(profilePath);
-        // Copy mods to the profile directory
-        utl::CopyContents(config_.modsPath, profilePath);
+        // Capture every root into the profile
+        utl::SyncPlan plan;
+        if (!PlanCapture(profilePath, plan)) {
+            utl::PrintErr(std::format("Not saving '{}', a folder it captures could not be read.\n", name));
+            std::error_code ec;
+            fs::remove(profilePath, ec); // still empty
+            return;
+        }
+        const bool synced {ExecutePlan(plan) == 0};
         // Activate the profile
         config_.activeProfile = std::string(name);
+        config_.stats.Touch(name, ch::system_clock::now());
+        if (synced && LinkedProfile().empty()) RecordModsState(name);
         utl::PrintLog(std::format("Saved profile {}\n", name));
     }
 
-    void Core::UpdateProfile(const std::string& name) const {
+    void Core::UpdateProfile(const std::string& name) {
+        WaitForStaging();
         // Check that the profile exists
         fs::path profilePath {config_.profilesPath / name};
         if (!fs::exists(profilePath)) {
@@ -49,15 +123,37 @@ namespace vsprofile {
             utl::PrintErr( std::format("Use 'save {}' to save a new profile with this name.\n", name));
             return;
         }
-        // Clear profile path
-        utl::ClearDirectoryContents(profilePath);
-        // Copy mods to the profile directory
-        utl::CopyContents(config_.modsPath, profilePath);
+        if (!Rehydrate(profilePath)) return;
+        // Bring every root of the profile up to date, touching only what changed
+        const bool active {name == config_.activeProfile};
+        const bool clean {active && ModsClean()};
+        if (clean) utl::PrintLog("Mods unchanged since activation, updating the other folders only\n");
+        utl::SyncPlan plan;
+        if (!PlanCapture(profilePath, plan, !clean)) {
+            utl::PrintErr(std::format("Not updating '{}', a folder it captures could not be read.\n", name));
+            return;
+        }
+        // They link the files about to be replaced
+        if (!plan.Empty() && !MaterialiseDependents(name)) {
+            utl::PrintErr(std::format("Not updating '{}' while a stash listing its files is incomplete.\n", name));
+            return;
+        }
+        if (ExecutePlan(plan) == 0 && active && !clean && LinkedProfile().empty()) RecordModsState(name);
+        std::error_code ec;
+        fs::remove(StashRecordPath(profilePath), ec); // retention recounts an updated stash
         utl::PrintLog(std::format("Updated profile {}\n", name));
     }
 
     void Core::SetActive(const std::string& profileName) {
         config_.activeProfile = profileName;
+        if (!profileName.empty()) {
+            config_.stats.Touch(profileName, ch::system_clock::now());
+            auto& history = config_.activationHistory;
+            history.push_back(profileName);
+            if (history.size() > constants::kActivationHistorySize) {
+                history.erase(history.begin(), history.end() - static_cast<std::ptrdiff_t>(constants::kActivationHistorySize));
+            }
+        }
         if (profileName.empty()) {
             utl::PrintLog("No active profile :£\n");
         } else {
@@ -67,33 +163,1270 @@ namespace vsprofile {
     }
 
     void Core::ActivateProfile(const std::string& profileName, const std::string& stashNameIn) {
+        const auto started {ch::steady_clock::now()};
+        Activation activation;
+        if (!StartActivation(profileName, stashNameIn, activation) || !MoveModsOut(activation)) return;
+        utl::SyncPlan plan;
+        if (!PlanActivation(activation, plan) || !RunActivation(activation, plan, started)) return;
+        if (config_.stashRetention.onActivate) PruneStashes(false);
+        if (config_.coldAfterDays > 0) PackIdleProfiles();
+        if (config_.prewarmOnActivate) PrewarmMods(); // before staging starts competing for the disk
+        if (config_.autoPrepare && !activation.useLink) {
+            if (const std::string next {PredictNextProfile()}; !next.empty()) PrepareProfile(next);
+        }
+    }
+
+    bool Core::StartActivation(const std::string& profileName, const std::string& stashNameIn, Activation& activation) {
+        WaitForStaging();
+        if (!ResumeActivation()) {
+            utl::PrintErr(std::format("An earlier activation is still unfinished, fix what failed and retry, or remove '{}' to give up on it.\n",
+                                      constants::kJournalDir.string()));
+            return false;
+        }
         if (profileName == config_.activeProfile) {
             utl::PrintErr(std::format("Profile '{}' is already active!\n", profileName));
-            return;
+            return false;
         }
-        std::string stashName {GenNonEmptyName(stashNameIn)};
+        const std::string stashName {GenNonEmptyName(stashNameIn)};
         // Ensure profile exists
-        const fs::path profilePath {config_.profilesPath / profileName};
-        if (!fs::exists(profilePath)) {
-            utl::PrintErr(std::format("Profile directory '{}' does not exist.\n", profilePath.string()));
+        activation.profile = profileName;
+        activation.profilePath = config_.profilesPath / profileName;
+        if (!fs::exists(activation.profilePath)) {
+            utl::PrintErr(std::format("Profile directory '{}' does not exist.\n", activation.profilePath.string()));
             utl::PrintErr(std::format("Use 'save {}' to save a new profile with this name.\n", profileName));
-            return;
+            return false;
         }
-        const fs::path stashPath {config_.profilesPath / stashName};
-        if (fs::exists(stashPath)) {
+        activation.stashPath = config_.profilesPath / stashName;
+        if (fs::exists(activation.stashPath)) {
             utl::PrintErr(std::format("Stash directory '{}' already exists, retry with a different name.\n", stashName));
-            return;
+            return false;
+        }
+        if (!Rehydrate(activation.profilePath)) {
+            utl::PrintErr(std::format("Could not put back the files '{}' keeps elsewhere, not activating it.\n", profileName));
+            return false;
         }
         utl::PrintLog(std::format("Activating profile '{}'\n", profileName));
+        if (config_.snapshotOnActivate) {
+            const std::string outgoing {config_.activeProfile.empty() ? "none" : config_.activeProfile};
+            SnapshotStore{constants::kSnapshotDir}.Create(config_.vintagestoryDataPath / "Saves", std::format("{}_{}", utl::GetTimeStamp(), outgoing));
+        }
+        activation.useLink = config_.activationStrategy == ActivationStrategy::Symlink;
+        // The game writes through the link into the profile
+        if (activation.useLink && !MaterialiseDependents(profileName)) {
+            utl::PrintErr(std::format("Not activating '{}' while a stash listing its files is incomplete.\n", profileName));
+            return false;
+        }
+        activation.linked = LinkedProfile();
+        // Mods untouched since the active profile was applied is already stored in that profile
+        activation.clean = !activation.useLink && activation.linked.empty() && ModsClean();
+        if (activation.clean) {
+            utl::PrintLog(std::format("Mods unchanged since '{}' was activated, stashing the other folders to '{}' and listing the mods it holds\n",
+                                      config_.activeProfile, stashName));
+        } else {
+            utl::PrintLog(std::format("Stashing current mods to profile '{}'\n", stashName));
+        }
+        // A staged copy of the profile replaces Mods with renames, leaving only the other roots to sync
+        activation.staged = !activation.useLink && StagedUpToDate(profileName, activation.profilePath);
+        return true;
+    }
+
+    bool Core::MoveModsOut(Activation& activation) {
+        const fs::path& linked {activation.linked};
+        ActivationJournal& journal {activation.journal};
+        journal.profile = activation.profile;
+        journal.stash = activation.stashPath;
+        // What Mods held before, for rolling back should this activation be cut short and its profile vanish
+        journal.modsFrom = !linked.empty() ? linked : activation.clean ? config_.profilesPath / config_.activeProfile : activation.stashPath;
+        journal.modsLinked = !linked.empty();
+        journal.pid = utl::CurrentProcessId();
+        std::error_code ec;
+        if (linked.empty() && (activation.useLink || activation.staged) && fs::exists(config_.modsPath)) {
+            // A real Mods folder moves out whole: into the stash, or back into staging as a base for the
+            // next 'prepare' when it needs no stash
+            const fs::path outgoing {config_.modsPath.parent_path() / ".Mods.vsprofile-outgoing"};
+            fs::remove_all(outgoing, ec);
+            journal.moves.push_back({config_.modsPath, activation.clean ? outgoing : activation.stashPath});
+            if (activation.staged) journal.moves.push_back({StagingPath(), config_.modsPath});
+            if (activation.staged && activation.clean) journal.moves.push_back({outgoing, StagingPath()});
+        } else if (activation.staged) {
+            journal.moves.push_back({StagingPath(), config_.modsPath});
+        }
+        // Everything that changes what Mods is happens under a journal of its own, undone if cut short
+        journal.planned = false;
+        if (!journal.Begin(constants::kJournalDir)) {
+            utl::PrintErr("Could not write the activation journal, not activating.\n");
+            return false;
+        }
+        JournalLog moveLog {constants::kJournalDir};
+        if (!linked.empty()) {
+            // Mods is the outgoing profile itself, so there is nothing to stash for it
+            ReportLinkedChanges();
+            GuardProfile(linked, false);
+            if (!activation.useLink) UnlinkMods();
+        }
+        if (activation.staged) fs::remove(StagingMarkerPath(), ec);
+        for (std::size_t i = 0; i < journal.moves.size(); ++i) {
+            if (!utl::MoveTree(journal.moves[i].from, journal.moves[i].to, ec)) {
+                utl::PrintErr(std::format("Could not move '{}' to '{}': {}\n", journal.moves[i].from.string(),
+                                          journal.moves[i].to.string(), ec.message()));
+                AbandonMoves();
+                return false;
+            }
+            moveLog.Moved(i);
+        }
+        if (activation.staged) utl::PrintLog(std::format("Swapped in the staged copy of '{}'\n", activation.profile));
+        return true;
+    }
+
+    bool Core::PlanActivation(const Activation& activation, utl::SyncPlan& plan) {
+        const fs::path& stashPath {activation.stashPath};
         fs::create_directories(stashPath); // Now both directories exist
-        // Copy contents of Mods into stashName
+        // Stash every root, then reconcile each one with the profile, all in one plan
+        const bool captureMods {!activation.useLink && !activation.staged && !activation.clean};
+        // A clean Mods is exactly the outgoing profile, which the stash then refers to instead of the incoming one
+        const fs::path outgoingPath {activation.clean ? config_.profilesPath / config_.activeProfile : fs::path{}};
+        DeltaManifest delta;
+        delta.reference = activation.clean ? config_.activeProfile : activation.profile;
+        bool planned {PlanCapture(stashPath, plan, captureMods, config_.deltaStashes ? &delta : nullptr)};
+        if (activation.clean) {
+            planned = plan.AddDelta(outgoingPath, stashPath, outgoingPath, ModsStrategy(), delta.roots["Mods"]) && planned;
+            if (delta.roots["Mods"].empty()) delta.roots.erase("Mods");
+        }
+        // Listed before anything lands in the stash, it is what makes the stash whole
+        if (delta.FileCount() > 0 && !delta.Save(stashPath)) {
+            utl::PrintWarn(std::format("Could not record what the stash shares with '{}', stashing everything.\n", delta.reference));
+            plan.ops.clear();
+            planned = PlanCapture(stashPath, plan, captureMods);
+            if (activation.clean) planned = plan.AddSync(outgoingPath, stashPath, ModsStrategy()) && planned;
+        } else if (delta.FileCount() > 0) {
+            utl::PrintLog(std::format("{} files already in '{}' are listed in the stash rather than stored\n", delta.FileCount(), delta.reference));
+        }
+        planned = PlanRestore(activation.profilePath, plan, !activation.useLink && !activation.staged) && planned;
+        if (activation.useLink && !LinkMods(activation.profilePath)) {
+            utl::PrintWarn("Falling back to copying the profile into Mods.\n");
+            fs::create_directories(config_.modsPath);
+            planned = PlanRestore(activation.profilePath, plan, true, false) && planned;
+        }
+        if (planned) return true;
+        // Nothing has been synced yet, so putting Mods back where it was undoes everything
+        utl::PrintErr(std::format("Not activating '{}', a folder it swaps could not be read.\n", activation.profile));
+        AbandonMoves();
+        std::error_code ec;
+        fs::remove(DeltaManifest::PathIn(stashPath), ec);
+        fs::remove(stashPath / constants::kProfileMetaDir, ec);
+        fs::remove(stashPath, ec); // only ever empty by now
+        return false;
+    }
+
+    bool Core::RunActivation(Activation& activation, utl::SyncPlan& plan, const ch::steady_clock::time_point started) {
+        // The plan is journaled before it runs, so a kill part way through is finished on the next start
+        ActivationJournal& journal {activation.journal};
+        journal.ops = plan.ops;
+        journal.planned = true;
+        const bool journaled {journal.Begin(constants::kJournalDir)};
+        JournalLog log {constants::kJournalDir};
+        if (journaled) {
+            plan.completed = [&log](const std::size_t op) { log.Done(op); };
+        } else {
+            ActivationJournal::Discard(constants::kJournalDir); // undoing the moves now would lose what the plan did
+            utl::PrintWarn("Could not write the activation journal, an interrupted activation will need redoing in full.\n");
+        }
+        if (ExecutePlan(plan) != 0) {
+            utl::PrintErr(std::format("Activation of '{}' is incomplete and not committed, {}\n", activation.profile,
+                                      journaled ? "what failed is retried on the next start or activation"
+                                                : "activate it again once what failed is fixed"));
+            return false;
+        }
+        config_.stats.RecordActivation(activation.profile, ch::duration_cast<ch::milliseconds>(ch::steady_clock::now() - started),
+                                       plan.CopyBytes());
+        FinishActivation(activation.profile, activation.stashPath, false, log);
+        return true;
+    }
+
+    void Core::AbandonMoves() {
+        if (const auto written {ActivationJournal::Load(constants::kJournalDir)}) UndoMoves(*written);
+        ActivationJournal::Discard(constants::kJournalDir);
+    }
+
+    fs::path Core::StashRecordPath(const fs::path& stashPath) {
+        return stashPath / constants::kProfileMetaDir / "stash.json";
+    }
+
+    void Core::PruneStashes(const bool dryRun) {
+        WaitForStaging();
+        const fs::path linked {LinkedProfile()};
+        std::vector<StashRecord> stashes;
+        for (const std::string& name : ListNames(config_.profilesPath)) {
+            const auto time {StashTime(name)};
+            // The active profile, even when it is a stash, is never a candidate
+            if (!time || name == config_.activeProfile || name == linked.filename().string()) continue;
+            const fs::path stashPath {config_.profilesPath / name};
+            auto record {StashRecord::Load(StashRecordPath(stashPath))};
+            if (!record) {
+                // Walked once, the first time it is seen; from then on only the record is read
+                record = StashRecord::Scan(stashPath, *time);
+                record->Save(StashRecordPath(stashPath));
+            }
+            record->name = name;
+            // A stash activated since it was made counts from then, so one still in use is kept like a new one
+            record->time = std::max(*time, config_.stats.LastUsed(name).value_or(*time));
+            stashes.push_back(std::move(*record));
+        }
+        const std::vector<PruneDecision> prune {PlanPrune(stashes, config_.stashRetention)};
+        std::uintmax_t reclaimable {};
+        std::size_t removed {};
+        for (const auto& decision : prune) {
+            const std::string why {decision.reason == PruneDecision::Reason::Duplicate
+                                   ? std::format("same as '{}'", decision.duplicateOf) : std::string{ToString(decision.reason)}};
+            reclaimable += decision.ownBytes;
+            if (dryRun) {
+                utl::PrintLog(std::format("Would remove '{}' ({}), {:.1f} MiB\n", decision.name, why, static_cast<double>(decision.ownBytes) / (1024.0 * 1024.0)));
+                continue;
+            }
+            if (!MaterialiseDependents(decision.name)) {
+                utl::PrintErr(std::format("Keeping '{}', a stash listing its files is incomplete\n", decision.name));
+                reclaimable -= decision.ownBytes;
+                continue;
+            }
+            std::error_code ec;
+            if (utl::MoveToTrash(config_.profilesPath / decision.name, ec)) {
+                ++removed;
+                config_.stats.profiles.erase(decision.name);
+                utl::PrintLog(std::format("Removed '{}' ({})\n", decision.name, why));
+            } else {
+                utl::PrintErr(std::format("Could not remove '{}': {}\n", decision.name, ec.message()));
+            }
+        }
+        if (dryRun) {
+            utl::PrintLog(std::format("{} of {} stashes past retention, {:.1f} MiB reclaimable\n", prune.size(), stashes.size(), static_cast<double>(reclaimable) / (1024.0 * 1024.0)));
+        } else if (removed > 0) {
+            utl::PrintLog(std::format("Pruned {} of {} stashes, about {:.1f} MiB freed once the trash is purged\n",
+                                      removed, stashes.size(), static_cast<double>(reclaimable) / (1024.0 * 1024.0)));
+        }
+    }
+
+    void Core::FinishActivation(const std::string& profileName, const fs::path& stashPath, const bool cachesSwapped,
+                                JournalLog& log) {
+        if (!cachesSwapped) {
+            // Caches belong to the outgoing profile, or to the stash when no profile was active
+            const fs::path profilePath {config_.profilesPath / profileName};
+            const fs::path outgoingPath {config_.activeProfile.empty() ? stashPath : config_.profilesPath / config_.activeProfile};
+            SwapCaches(fs::is_directory(outgoingPath) ? outgoingPath : stashPath, profilePath);
+            log.CachesSwapped(); // swapping twice would hand them back
+        }
+        SetActive(profileName); // saving the config commits the activation
+        ActivationJournal::Discard(constants::kJournalDir);
+        if (LinkedProfile().empty()) {
+            RecordModsState(profileName);
+        } else {
+            std::error_code ec;
+            fs::remove(ModsStatePath(), ec);
+        }
+    }
+
+    void Core::UndoMoves(const ActivationJournal& journal) {
+        std::error_code ec;
+        // A link to the incoming profile stands where the outgoing Mods goes back to
+        if (const fs::path linked {LinkedProfile()}; !linked.empty() && !(journal.modsLinked && linked == journal.modsFrom)) {
+            fs::remove(config_.modsPath, ec);
+        }
+        for (std::size_t i = journal.moves.size(); i-- > 0;) {
+            if (!journal.MoveDone(i)) continue;
+            const auto& [from, to] {journal.moves[i]};
+            fs::remove(from, ec); // only ever an empty folder, such as the one unlinking Mods leaves
+            if (!utl::MoveTree(to, from, ec)) {
+                utl::PrintErr(std::format("Could not move '{}' back to '{}': {}\n", to.string(), from.string(), ec.message()));
+            }
+        }
+        if (journal.modsLinked && LinkedProfile().empty()) {
+            fs::remove(config_.modsPath, ec); // the empty folder unlinking left
+            LinkMods(journal.modsFrom);
+        }
+    }
+
+    bool Core::ResumeActivation() {
+        auto journal {ActivationJournal::Load(constants::kJournalDir)};
+        if (!journal) return true;
+        if (journal->pid != utl::CurrentProcessId() && utl::IsAppProcess(journal->pid)) return false; // still running
+        if (journal->profile == config_.activeProfile) {
+            ActivationJournal::Discard(constants::kJournalDir); // committed, only the cleanup was missed
+            return true;
+        }
+        if (!journal->planned) {
+            utl::PrintWarn(std::format("Activation of '{}' was interrupted while moving Mods, moving it back\n", journal->profile));
+            UndoMoves(*journal);
+            ActivationJournal::Discard(constants::kJournalDir);
+            return true;
+        }
+        const fs::path profilePath {config_.profilesPath / journal->profile};
+        // Without the profile there is nothing to roll forward to: finish stashing and put back what was there
+        const bool rollBack {!fs::is_directory(profilePath)};
+        JournalLog log {constants::kJournalDir};
+        const auto intoStash = [&](const fs::path& to) {
+            const fs::path rel {to.lexically_relative(journal->stash)};
+            return !rel.empty() && *rel.begin() != "..";
+        };
+        utl::SyncPlan plan;
+        std::vector<std::size_t> indices; // into the journal's plan, for the log
+        for (std::size_t i = 0; i < journal->ops.size(); ++i) {
+            if (journal->done[i] || (rollBack && !intoStash(journal->ops[i].to))) continue;
+            plan.ops.push_back(journal->ops[i]);
+            indices.push_back(i);
+        }
+        utl::PrintWarn(std::format("Activation of '{}' was interrupted with {} of {} operations left, {}\n", journal->profile,
+                                   std::ranges::count(journal->done, false), journal->ops.size(),
+                                   rollBack ? "the profile is gone so rolling back" : "finishing it"));
+        plan.completed = [&](const std::size_t op) { log.Done(indices[op]); };
+        const bool synced {ExecutePlan(plan) == 0};
+        if (!rollBack) {
+            if (!synced) {
+                utl::PrintErr(std::format("Activation of '{}' still failed, it stays journaled and is retried next time\n", journal->profile));
+                return false;
+            }
+            FinishActivation(journal->profile, journal->stash, journal->cachesSwapped, log);
+            return true;
+        }
+        if (!LinkedProfile().empty()) UnlinkMods(); // the link into the vanished profile
+        // A delta stash's reference is the vanished profile, its shared files are still in the live folders
+        MaterialiseStash(journal->stash);
+        utl::SyncPlan restore;
+        bool planned {true};
+        if (journal->modsLinked) {
+            LinkMods(journal->modsFrom);
+        } else {
+            planned = restore.AddSync(journal->modsFrom, config_.modsPath, ModsStrategy());
+        }
+        if (!PlanRestore(journal->stash, restore, false, true) || !planned) {
+            utl::PrintErr("Could not read what to roll back to, it stays journaled and is retried next time\n");
+            return false;
+        }
+        ExecutePlan(restore);
+        ActivationJournal::Discard(constants::kJournalDir);
+        std::error_code ec;
+        fs::remove(ModsStatePath(), ec);
+        utl::PrintLog(std::format("Rolled back, the previous folders are also kept in '{}'\n", journal->stash.filename().string()));
+        return true;
+    }
+
+    fs::path Core::StagingPath() const {
+        return config_.modsPath.parent_path() / ".Mods.vsprofile-staged";
+    }
+
+    fs::path Core::StagingMarkerPath() const {
+        return config_.modsPath.parent_path() / ".Mods.vsprofile-staged.profile";
+    }
+
+    utl::SyncStrategy Core::ModsStrategy() const {
+        const auto it = std::ranges::find_if(config_.roots, &ProfileRoot::IsMods);
+        return it != config_.roots.end() ? it->strategy : utl::SyncStrategy::Copy;
+    }
+
+    std::string Core::PredictNextProfile() const {
+        // Most frequent successor of the active profile in the history, ties going to the most recent
+        const auto& history = config_.activationHistory;
+        auto usable = [this](const std::string& name) {
+            return name != config_.activeProfile && fs::is_directory(config_.profilesPath / name);
+        };
+        std::map<std::string, std::pair<int, std::size_t>> successors; // count, last position
+        for (std::size_t i = 0; i + 1 < history.size(); ++i) {
+            if (history[i] != config_.activeProfile || !usable(history[i + 1])) continue;
+            auto& [count, last] = successors[history[i + 1]];
+            ++count;
+            last = i;
+        }
+        if (!successors.empty()) {
+            return std::ranges::max_element(successors, {}, [](const auto& kv) { return kv.second; })->first;
+        }
+        // No transitions seen from here yet, fall back to the most recently activated other profile, which
+        // the stats remember past the history's cap, then to the most frequently activated on a tie
+        const ProfileUsage* best {nullptr};
+        std::string bestName;
+        for (const auto& [name, usage] : config_.stats.profiles) {
+            if (usage.activations == 0 || !usable(name)) continue;
+            if (!best || std::pair{usage.lastUsed, usage.activations} > std::pair{best->lastUsed, best->activations}) {
+                best = &usage;
+                bestName = name;
+            }
+        }
+        if (best) return bestName;
+        for (auto it = history.rbegin(); it != history.rend(); ++it) {
+            if (usable(*it)) return *it;
+        }
+        return {};
+    }
+
+    void Core::PrepareProfile(const std::string& nameIn) {
+        const std::string name {nameIn.empty() ? PredictNextProfile() : nameIn};
+        if (name.empty()) {
+            utl::PrintErr("No activation history to predict from, use 'prepare <profile>'.\n");
+            return;
+        }
+        if (config_.activationStrategy == ActivationStrategy::Symlink) {
+            utl::PrintLog("Activation is already a single rename with symlinked Mods, nothing to prepare.\n");
+            return;
+        }
+        if (name == config_.activeProfile) {
+            utl::PrintErr(std::format("Profile '{}' is already active!\n", name));
+            return;
+        }
+        const fs::path profilePath {config_.profilesPath / name};
+        if (!utl::vExistsDirectoryCheck(profilePath)) return;
+        WaitForStaging();
+        if (!Rehydrate(profilePath)) return;
+
+        utl::PrintLog(std::format("Staging profile '{}' in the background\n", name));
+        stager_ = std::jthread{[name, profilePath, staging = StagingPath(), marker = StagingMarkerPath(), strategy = ModsStrategy()] {
+            utl::LowerThreadPriority();
+            utl::tBackgroundOutput = true;
+            std::error_code ec;
+            fs::remove(marker, ec); // the staging folder is not trusted while it changes
+            // Incremental, so restaging after a previous 'prepare' only touches the differences
+            utl::SyncPlan plan;
+            if (!plan.AddSync(profilePath, staging, strategy) || plan.Execute() != 0) return;
+            std::ofstream{marker} << name << '\n';
+            utl::PrintLog(std::format("Profile '{}' is staged for activation\n", name));
+        }};
+    }
+
+    void Core::WaitForStaging() {
+        if (stager_.joinable()) stager_.join();
+    }
+
+    bool Core::StagedUpToDate(const std::string& profileName, const fs::path& profilePath) const {
+        std::string stagedName;
+        std::getline(std::ifstream{StagingMarkerPath()}, stagedName);
+        if (stagedName != profileName) return false;
+        // Stat-only check that neither the profile nor the staged copy changed since staging
+        if (!Diff(ScanManifest(profilePath), ScanManifest(StagingPath())).Empty()) {
+            utl::PrintLog(std::format("Staged copy of '{}' is out of date, syncing instead\n", profileName));
+            return false;
+        }
+        return true;
+    }
+
+    fs::path Core::ModsStatePath() const {
+        return config_.modsPath.parent_path() / ".Mods.vsprofile-state.json";
+    }
+
+    void Core::RecordModsState(const std::string& profileName) const {
+        const auto previous {ModsState::Load(ModsStatePath())};
+        const ModsState state {profileName, previous ? previous->generation + 1 : 1, ScanManifest(config_.modsPath)};
+        state.Save(ModsStatePath());
+        if (cache_) cache_->MarkClean(config_.modsPath, state.generation);
+    }
+
+    bool Core::ModsClean() const {
+        if (config_.activeProfile.empty()) return false;
+        const auto state {ModsState::Load(ModsStatePath())};
+        if (!state || state->profile != config_.activeProfile) return false;
+        // The daemon knows from inotify; otherwise a stat-only walk compared against the record
+        if (cache_ && cache_->IsClean(config_.modsPath, state->generation)) return true;
+        const bool clean {Diff(state->manifest, ScanManifest(config_.modsPath)).Empty()};
+        if (clean && cache_) cache_->MarkClean(config_.modsPath, state->generation);
+        return clean;
+    }
+
+    fs::path Core::LiveRootPath(const ProfileRoot& root) const {
+        return root.IsMods() ? config_.modsPath : config_.vintagestoryDataPath / root.path;
+    }
+
+    fs::path Core::StoredRootPath(const fs::path& profilePath, const ProfileRoot& root) {
+        return root.IsMods() ? profilePath : profilePath / constants::kProfileMetaDir / "roots" / root.path;
+    }
+
+    bool Core::PlanCapture(const fs::path& profilePath, utl::SyncPlan& plan, const bool includeMods, DeltaManifest* delta) const {
+        bool planned {true};
+        for (const auto& root : config_.roots) {
+            if (!includeMods && root.IsMods()) continue;
+            if (!delta) {
+                planned = plan.AddSync(LiveRootPath(root), StoredRootPath(profilePath, root), root.strategy) && planned;
+                continue;
+            }
+            const fs::path reference {StoredRootPath(config_.profilesPath / delta->reference, root)};
+            auto& shared {delta->roots[root.path.generic_string()]};
+            planned = plan.AddDelta(LiveRootPath(root), StoredRootPath(profilePath, root), reference, root.strategy, shared) && planned;
+            if (shared.empty()) delta->roots.erase(root.path.generic_string());
+        }
+        return planned;
+    }
+
+    bool Core::PlanRestore(const fs::path& profilePath, utl::SyncPlan& plan, const bool includeMods, const bool includeOthers) const {
+        // Roots the profile never captured (e.g. saved before the root was added) are left as they are
+        bool planned {true};
+        for (const auto& root : config_.roots) {
+            if (root.IsMods() ? !includeMods : !includeOthers) continue;
+            planned = plan.AddSync(StoredRootPath(profilePath, root), LiveRootPath(root), root.strategy) && planned;
+        }
+        return planned;
+    }
+
+    bool Core::MaterialiseStash(const fs::path& stashPath) const {
+        const auto delta {DeltaManifest::Load(stashPath)};
+        if (!delta) return true;
+        const fs::path reference {config_.profilesPath / delta->reference};
+        UnpackProfile(reference); // references are materialised into their stashes before packing, but still
+        utl::SyncPlan plan;
+        DeltaManifest lost {delta->reference, {}};
+        for (const auto& [rootPath, files] : delta->roots) {
+            ProfileRoot root {rootPath, utl::SyncStrategy::Copy}; // as a root since removed from the config was
+            if (const auto it {std::ranges::find(config_.roots, root.path, &ProfileRoot::path)}; it != config_.roots.end()) root = *it;
+            const auto kind {root.strategy == utl::SyncStrategy::Link ? utl::FileOp::Kind::Link : utl::FileOp::Kind::Copy};
+            // The live folder is the fallback, it still holds the shared files when an activation was rolled back
+            const fs::path sources[] {StoredRootPath(reference, root), LiveRootPath(root)};
+            for (const auto& file : files) {
+                const auto source {std::ranges::find_if(sources, [&](const fs::path& dir) { return Unchanged(dir / file.path, file.size, file.mtime); })};
+                if (source == std::end(sources)) {
+                    lost.roots[rootPath].push_back(file);
+                    utl::PrintErr(std::format("'{}' is gone from '{}', it cannot be put back into '{}'\n",
+                                              file.path, delta->reference, stashPath.filename().string()));
+                    continue;
+                }
+                plan.ops.push_back({kind, *source / file.path, StoredRootPath(stashPath, root) / file.path, file.size});
+            }
+        }
+        utl::PrintLog(std::format("Materialising '{}' from '{}' ({} files)\n", stashPath.filename().string(), delta->reference, plan.ops.size()));
+        if (ExecutePlan(plan) != 0) return false; // the list stays, so a later attempt picks up where this stopped
+        std::error_code ec;
+        fs::remove(StashRecordPath(stashPath), ec); // what it holds on its own changed
+        if (lost.FileCount() > 0) {
+            // Only the lost files stay listed, so the stash keeps saying it is incomplete
+            utl::PrintErr(std::format("{} files of '{}' could not be restored, it stays incomplete until they are back in '{}' or it is removed\n",
+                                      lost.FileCount(), stashPath.filename().string(), delta->reference));
+            lost.Save(stashPath);
+            return false;
+        }
+        fs::remove(DeltaManifest::PathIn(stashPath), ec);
+        return true;
+    }
+
+    bool Core::MaterialiseDependents(const std::string& profileName) const {
+        bool complete {true};
+        for (const std::string& name : ListNames(config_.profilesPath)) {
+            const fs::path stashPath {config_.profilesPath / name};
+            if (name == profileName || !fs::exists(DeltaManifest::PathIn(stashPath))) continue;
+            if (const auto delta {DeltaManifest::Load(stashPath)}; delta && delta->reference == profileName) {
+                complete = MaterialiseStash(stashPath) && complete;
+            }
+        }
+        return complete;
+    }
+
+    fs::path Core::ColdPackPath(const fs::path& profilePath) {
+        return profilePath / constants::kProfileMetaDir / constants::kColdPackName;
+    }
+
+    ch::system_clock::time_point Core::LastUsed(const std::string& profileName) const {
+        ch::system_clock::time_point last {config_.stats.LastUsed(profileName).value_or(ch::system_clock::time_point{})};
+        // Anything that wrote its metadata (a verify, an unpack, a cache swap) counts as use too, and
+        // gives profiles the stats have not seen yet an age to start from
+        const fs::path profilePath {config_.profilesPath / profileName};
+        const fs::path meta {profilePath / constants::kProfileMetaDir};
+        std::error_code ec;
+        const auto written {fs::last_write_time(fs::is_directory(meta, ec) ? meta : profilePath, ec)};
+        if (!ec) last = std::max(last, ch::time_point_cast<ch::system_clock::duration>(ch::file_clock::to_sys(written)));
+        return last;
+    }
+
+    bool Core::PackProfile(const std::string& name) {
+        WaitForStaging();
+        const fs::path profilePath {config_.profilesPath / name};
+        if (!utl::vExistsDirectoryCheck(profilePath)) return false;
+        std::string staged;
+        std::getline(std::ifstream{StagingMarkerPath()}, staged);
+        if (name == config_.activeProfile || fs::absolute(profilePath) == LinkedProfile() || name == staged) {
+            utl::PrintErr(std::format("Profile '{}' is in use, not packing it.\n", name));
+            return false;
+        }
+        const fs::path packPath {ColdPackPath(profilePath)};
+        if (fs::exists(packPath)) {
+            utl::PrintLog(std::format("Profile '{}' is already packed\n", name));
+            return true;
+        }
+        const auto lastUsed {LastUsed(name)};
+        // Neither a delta stash it refers to nor one that refers to it can be left pointing at a pack
+        if (!MaterialiseStash(profilePath) || !MaterialiseDependents(name)) return false;
+
+        std::vector<std::string> packable;
+        std::size_t shared {};
+        CollectPackable(profilePath, {}, packable, shared);
+        const std::string roots {std::format("{}/roots/", constants::kProfileMetaDir)};
+        CollectPackable(profilePath / roots, roots, packable, shared);
+        if (packable.empty()) {
+            utl::PrintLog(std::format("Every file of '{}' is shared with another profile, nothing to pack\n", name));
+            return true;
+        }
+        std::vector<utl::PackEntry> entries;
+        std::error_code ec;
+        if (!utl::WritePack(profilePath, packable, packPath, entries, ec)) {
+            utl::PrintErr(std::format("Could not pack '{}': {}\n", name, ec.message()));
+            return false;
+        }
+        // A file that changed while it was packed stays, unpacking leaves files already in place alone
+        std::uintmax_t bytes {};
+        for (const auto& entry : entries) {
+            const fs::path file {profilePath / entry.path};
+            if (!Unchanged(file, entry.size, entry.mtime) || !fs::remove(file, ec)) continue;
+            bytes += entry.size;
+        }
+        fs::remove(StashRecordPath(profilePath), ec); // what it holds on its own is now the pack
+        // Writing the pack is not a use of the profile
+        fs::last_write_time(profilePath / constants::kProfileMetaDir,
+                            ch::time_point_cast<fs::file_time_type::duration>(ch::file_clock::from_sys(lastUsed)), ec);
+        const std::uintmax_t packBytes {fs::file_size(packPath, ec)};
+        utl::PrintLog(std::format("Packed '{}': {} files, {:.1f} MiB into {:.1f} MiB{}\n", name, entries.size(),
+                                  static_cast<double>(bytes) / (1024.0 * 1024.0), static_cast<double>(packBytes) / (1024.0 * 1024.0),
+                                  shared > 0 ? std::format(", {} files shared with other profiles left in place", shared) : ""));
+        return true;
+    }
+
+    bool Core::UnpackProfile(const fs::path& profilePath) const {
+        const fs::path packPath {ColdPackPath(profilePath)};
+        std::error_code ec;
+        if (!fs::exists(packPath, ec)) return true;
+        const auto reader {utl::PackReader::Open(packPath, ec)};
+        if (!reader) {
+            utl::PrintErr(std::format("Could not read the pack of '{}': {}\n", profilePath.filename().string(), ec.message()));
+            return false;
+        }
+        const auto start {ch::steady_clock::now()};
+        // Where a stored file lives while its root is active, so one still there unchanged is taken from there
+        const auto liveSource = [this](const std::string& stored) -> std::optional<std::pair<fs::path, utl::SyncStrategy>> {
+            for (const auto& root : config_.roots) {
+                const std::string prefix {root.IsMods() ? std::string{}
+                                          : std::format("{}/roots/{}/", constants::kProfileMetaDir, root.path.generic_string())};
+                if (root.IsMods() ? stored.starts_with(constants::kProfileMetaDir) : !stored.starts_with(prefix)) continue;
+                return std::pair{LiveRootPath(root) / stored.substr(prefix.size()), root.strategy};
+            }
+            return std::nullopt;
+        };
+        utl::SyncPlan fromLive;
+        std::vector<const utl::PackEntry*> extract;
+        for (const auto& entry : reader->Entries()) {
+            const fs::path target {profilePath / entry.path};
+            if (Unchanged(target, entry.size, entry.mtime)) continue; // left in place, or unpacked by an interrupted run
+            fs::create_directories(target.parent_path(), ec);
+            const auto live {liveSource(entry.path)};
+            const bool sameMode {!live || static_cast<std::uint32_t>(fs::status(live->first, ec).permissions() & fs::perms::mask) == entry.mode};
+            if (live && sameMode && Unchanged(live->first, entry.size, entry.mtime)) {
+                const auto kind {live->second == utl::SyncStrategy::Link ? utl::FileOp::Kind::Link : utl::FileOp::Kind::Copy};
+                fromLive.ops.push_back({kind, live->first, target, entry.size});
+            } else {
+                extract.push_back(&entry);
+            }
+        }
+        std::size_t failed {fromLive.Empty() ? 0 : ExecutePlan(fromLive)};
+        // Entries are independent, each worker seeks to its own and decompresses it beside its target
+        std::atomic<std::size_t> extractFailed {0};
+        utl::DurableBatch batch;
+        std::vector<std::size_t> order(extract.size());
+        std::iota(order.begin(), order.end(), std::size_t{0});
+        utl::WorkStealingPool<std::size_t>{}.Run(std::move(order), [&](const std::size_t i, auto&&) {
+            const fs::path target {profilePath / extract[i]->path};
+            std::error_code extractEc;
+            if (reader->Extract(*extract[i], target, extractEc)) {
+                batch.Add(target);
+                return;
+            }
+            ++extractFailed;
+            utl::PrintErr(std::format("Could not unpack '{}': {}\n", extract[i]->path, extractEc.message()));
+        });
+        batch.Commit();
+        failed += extractFailed;
+        if (failed > 0) return false; // the pack stays, a later attempt only unpacks what is still missing
+        fs::remove(packPath, ec);
+        fs::remove(StashRecordPath(profilePath), ec);
+        utl::PrintLog(std::format("Unpacked '{}': {} files decompressed, {} taken from live folders in {:.2f} s\n",
+                                  profilePath.filename().string(), extract.size(), fromLive.ops.size(),
+                                  ch::duration<double>(ch::steady_clock::now() - start).count()));
+        return true;
+    }
+
+    void Core::PackIdleProfiles() {
+        const auto cutoff {ch::system_clock::now() - ch::days{config_.coldAfterDays}};
+        for (const std::string& name : ListNames(config_.profilesPath)) {
+            if (name == config_.activeProfile || fs::exists(ColdPackPath(config_.profilesPath / name))) continue;
+            if (LastUsed(name) < cutoff) PackProfile(name);
+        }
+    }
+
+    bool Core::Rehydrate(const fs::path& profilePath) const {
+        return UnpackProfile(profilePath) && MaterialiseStash(profilePath);
+    }
+
+    void Core::ManageColdTier(const std::vector<std::string>& args) {
+        const std::string action {args.size() > 1 ? args[1] : "list"};
+        if (action == "list") {
+            utl::PrintLog(utl::Bold("[Cold profiles]\n"));
+            std::size_t count {};
+            for (const std::string& name : ListNames(config_.profilesPath)) {
+                std::error_code ec;
+                const auto reader {utl::PackReader::Open(ColdPackPath(config_.profilesPath / name), ec)};
+                if (!reader) continue;
+                std::uintmax_t bytes {};
+                for (const auto& entry : reader->Entries()) bytes += entry.size;
+                const auto idle {ch::floor<ch::days>(ch::system_clock::now() - LastUsed(name))};
+                utl::PrintLog(std::format("– {}: {} files, {:.1f} MiB packed into {:.1f} MiB, last used {} days ago\n", name,
+                                          reader->Entries().size(), static_cast<double>(bytes) / (1024.0 * 1024.0),
+                                          static_cast<double>(reader->StoredBytes()) / (1024.0 * 1024.0), idle.count()));
+                ++count;
+            }
+            if (count == 0) utl::PrintLog(utl::Italics("none\n"));
+        } else if (action == "pack" && args.size() > 2) {
+            PackProfile(args[2]);
+        } else if (action == "unpack" && args.size() > 2) {
+            WaitForStaging();
+            const fs::path profilePath {config_.profilesPath / args[2]};
+            if (!utl::vExistsDirectoryCheck(profilePath)) return;
+            if (!fs::exists(ColdPackPath(profilePath))) {
+                utl::PrintLog(std::format("Profile '{}' is not packed\n", args[2]));
+                return;
+            }
+            UnpackProfile(profilePath);
+        } else if (action == "idle") {
+            if (config_.coldAfterDays == 0) {
+                utl::PrintErr("coldAfterDays is 0 in the config, no profile counts as idle.\n");
+                return;
+            }
+            PackIdleProfiles();
+        } else {
+            utl::PrintErr("usage: cold [list | pack <profile> | unpack <profile> | idle]\n");
+        }
+    }
+
+    void Core::ListProfiles(const std::vector<std::string>& args) const {
+        const std::string order {args.size() > 1 ? args[1] : ""};
+        if (!order.empty() && order != "recent" && order != "size") {
+            utl::PrintErr("usage: profiles [recent | size]\n");
+            return;
+        }
+        fs::create_directories(config_.profilesPath);
+        struct Row {
+            std::string name;
+            ProfileUsage usage;
+            std::uintmax_t bytes {};
+        };
+        std::vector<Row> rows;
+        for (const std::string& name : ListNames(config_.profilesPath)) {
+            Row& row {rows.emplace_back(name)};
+            if (const auto it {config_.stats.profiles.find(name)}; it != config_.stats.profiles.end()) row.usage = it->second;
+            // Apparent size, pack and delta-listed files included, so a cold profile sorts by what it holds
+            if (order == "size") row.bytes = StashRecord::Scan(config_.profilesPath / name, {}).bytes;
+        }
+        if (order == "recent") std::ranges::stable_sort(rows, std::ranges::greater{}, [](const Row& r) { return r.usage.lastUsed; });
+        if (order == "size") std::ranges::stable_sort(rows, std::ranges::greater{}, &Row::bytes);
+
+        utl::PrintLog(utl::Bold("[Available profiles]\n"));
+        const auto now {ch::system_clock::now()};
+        for (const Row& row : rows) {
+            const ProfileUsage& u {row.usage};
+            std::string line {std::format("– {}", row.name)};
+            if (row.name == config_.activeProfile) line += utl::Italics(" (active)");
+            if (fs::exists(ColdPackPath(config_.profilesPath / row.name))) line += utl::Italics(" (cold)");
+            line += ": ";
+            if (order == "size") line += std::format("{:.1f} MiB, ", static_cast<double>(row.bytes) / (1024.0 * 1024.0));
+            if (u.activations > 0) {
+                line += std::format("activated {} times in {} ms on average, {:.1f} MiB copied, ", u.activations,
+                                    u.totalMs / u.activations, static_cast<double>(u.bytesMoved) / (1024.0 * 1024.0));
+            }
+            if (const auto last {config_.stats.LastUsed(row.name)}) {
+                line += std::format("last used {} days ago", ch::floor<ch::days>(now - *last).count());
+            } else {
+                line += "never used";
+            }
+            utl::PrintLog(line + '\n');
+        }
+    }
+
+    fs::path Core::LinkedProfile() const {
+        std::error_code ec;
+        if (!fs::is_symlink(config_.modsPath, ec)) return {};
+        const fs::path target {fs::read_symlink(config_.modsPath, ec)};
+        return ec ? fs::path{} : target;
+    }
+
+    bool Core::LinkMods(const fs::path& profilePath) const {
+        // Build the new link beside Mods and rename it over the old one: a single atomic syscall
+        std::error_code ec;
+        const fs::path tmp {config_.modsPath.parent_path() / ".Mods.vsprofile-link"};
+        fs::remove(tmp, ec);
+        fs::create_directory_symlink(fs::absolute(profilePath), tmp, ec);
+        if (!ec) fs::rename(tmp, config_.modsPath, ec);
+        if (ec) {
+            fs::remove(tmp, ec);
+            utl::PrintErr(std::format("Could not link '{}' to '{}'.\n", config_.modsPath.string(), profilePath.string()));
+            return false;
+        }
+        // Remember what the profile held so edits made through the link are noticed later
+        ScanManifest(profilePath).Save(profilePath / constants::kProfileMetaDir / "manifest.json");
+        GuardProfile(profilePath, true);
+        return true;
+    }
+
+    void Core::UnlinkMods() const {
+        std::error_code ec;
+        fs::remove(config_.modsPath, ec); // the link only, never the profile behind it
+        fs::create_directories(config_.modsPath, ec);
+    }
+
+    void Core::ReportLinkedChanges() const {
+        const fs::path linked {LinkedProfile()};
+        if (linked.empty() || !fs::is_directory(linked)) return;
+        const fs::path manifestPath {linked / constants::kProfileMetaDir / "manifest.json"};
+        const auto recorded {Manifest::Load(manifestPath)};
+        if (!recorded) return;
+        const Manifest current {ScanManifest(linked)};
+        const ManifestDiff diff {Diff(*recorded, current)};
+        if (diff.Empty()) return;
+        utl::PrintWarn(std::format("Profile '{}' was modified in place through the Mods link:\n", linked.filename().string()));
+        diff.Print();
+        current.Save(manifestPath); // report each change once
+    }
+
+    void Core::GuardProfile(const fs::path& profilePath, const bool readOnly) {
+        // A read-only folder stops mods being added, removed or renamed through the link
+        constexpr auto write = fs::perms::owner_write | fs::perms::group_write | fs::perms::others_write;
+        std::error_code ec;
+        if (readOnly) fs::permissions(profilePath, write, fs::perm_options::remove, ec);
+        else fs::permissions(profilePath, fs::perms::owner_write, fs::perm_options::add, ec);
+    }
+
+    fs::path Core::TreePath(const fs::path& dir) const {
+        if (dir == config_.modsPath) return config_.modsPath.parent_path() / ".Mods.vsprofile-merkle.json";
+        return dir / constants::kProfileMetaDir / "merkle.json";
+    }
+
+    fs::path Core::CopiedHashesPath(const fs::path& dir) const {
+        if (dir == config_.modsPath) return config_.modsPath.parent_path() / ".Mods.vsprofile-copied.json";
+        return dir / constants::kProfileMetaDir / "copied.json";
+    }
+
+    MerkleTree Core::RefreshTree(const fs::path& dir) const {
+        // Only files whose size or mtime moved since the last tree are read again, unless hashed while copied in
+        const fs::path stored {TreePath(dir)};
+        const auto previous {MerkleTree::Load(stored)};
+        const KnownHashes copied {KnownHashes::Load(CopiedHashesPath(dir))};
+        MerkleTree tree {MerkleTree::Build(dir, previous ? &*previous : nullptr, MerkleTree::Rehash::Changed, &copied)};
+        if (!previous || previous->root != tree.root) tree.Save(stored);
+        std::error_code ec;
+        fs::remove(CopiedHashesPath(dir), ec); // folded into the tree
+        return tree;
+    }
+
+    std::size_t Core::ExecutePlan(utl::SyncPlan& plan) const {
+        if (config_.copyIntegrity == CopyIntegrity::Off) return plan.Execute();
+        utl::CopyHashLog hashes;
+        hashes.verify = config_.copyIntegrity == CopyIntegrity::Verify;
+        plan.hashes = &hashes;
+        const std::size_t failures {plan.Execute()};
+        plan.hashes = nullptr;
+        RecordCopiedHashes(hashes.copies);
+        return failures;
+    }
+
+    void Core::RecordCopiedHashes(const std::vector<utl::HashedCopy>& copies) const {
+        // Grouped by the tree each copy belongs to: Mods, or the profile it landed in
+        std::map<fs::path, KnownHashes> byRoot;
+        for (const auto& copy : copies) {
+            fs::path root {config_.modsPath};
+            fs::path rel {copy.to.lexically_relative(root)};
+            if (rel.empty() || *rel.begin() == "..") {
+                const fs::path inProfiles {copy.to.lexically_relative(config_.profilesPath)};
+                if (inProfiles.empty() || *inProfiles.begin() == "..") continue;
+                root = config_.profilesPath / *inProfiles.begin();
+                rel = copy.to.lexically_relative(root);
+            }
+            // The profile's own metadata is not part of its tree
+            if (std::ranges::any_of(rel, [](const fs::path& part) { return utl::IsHiddenEntry(part.string()); })) continue;
+            auto [it, added] = byRoot.try_emplace(root);
+            if (added) it->second = KnownHashes::Load(CopiedHashesPath(root));
+            it->second.files[rel.generic_string()] = {copy.size, copy.mtime, copy.hash};
+        }
+        for (const auto& [root, known] : byRoot) known.Save(CopiedHashesPath(root));
+    }
+
+    void Core::CompareProfiles(const std::vector<std::string>& args) const {
+        if (args.size() < 2) { utl::PrintErr("usage: compare <profile> [<profile>]\n"); return; }
+        const fs::path a {config_.profilesPath / args[1]};
+        const fs::path b {args.size() > 2 ? config_.profilesPath / args[2] : config_.modsPath};
+        const std::string bName {args.size() > 2 ? args[2] : "Mods"};
+        if (!utl::vExistsDirectoryCheck(a) || !utl::vExistsDirectoryCheck(b)) return;
+        if (!Rehydrate(a) || (b != config_.modsPath && !Rehydrate(b))) return;
+        const ManifestDiff diff {Diff(RefreshTree(a), RefreshTree(b))};
+        if (diff.Empty()) {
+            utl::PrintLog(std::format("'{}' and '{}' hold the same files\n", args[1], bName));
+            return;
+        }
+        utl::PrintLog(utl::Bold(std::format("[From '{}' to '{}']\n", args[1], bName)));
+        diff.Print();
+    }
+
+    void Core::VerifyProfile(const std::vector<std::string>& args) const {
+        if (args.size() < 2) { utl::PrintErr("usage: verify <profile> [full]\n"); return; }
+        const fs::path profilePath {config_.profilesPath / args[1]};
+        if (!utl::vExistsDirectoryCheck(profilePath) || !Rehydrate(profilePath)) return;
+        const bool full {args.size() > 2 && args[2] == "full"};
+        const fs::path stored {TreePath(profilePath)};
+        const auto recorded {MerkleTree::Load(stored)};
+        const KnownHashes copied {KnownHashes::Load(CopiedHashesPath(profilePath))};
+        // 'full' reads every file, catching corruption that left size and mtime untouched
+        const MerkleTree current {MerkleTree::Build(profilePath, recorded ? &*recorded : nullptr,
+                                                    full ? MerkleTree::Rehash::All : MerkleTree::Rehash::Changed, &copied)};
+        if (!recorded || recorded->root != current.root) current.Save(stored);
+        std::error_code ec;
+        fs::remove(CopiedHashesPath(profilePath), ec);
+        if (!recorded) {
+            utl::PrintLog(std::format("Recorded the hashes of {} files in '{}', verify again to check them\n", current.FileCount(), args[1]));
+            return;
+        }
+        const ManifestDiff diff {Diff(*recorded, current)};
+        if (diff.Empty()) {
+            utl::PrintLog(std::format("Profile '{}' matches its recorded hashes ({} files{})\n",
+                                      args[1], current.FileCount(), full ? ", all read" : ""));
+            return;
+        }
+        utl::PrintWarn(std::format("Profile '{}' changed since its hashes were recorded:\n", args[1]));
+        diff.Print();
+    }
+
+    void Core::ManageSnapshots(const std::vector<std::string>& args) const {
+        const SnapshotStore store {constants::kSnapshotDir};
+        const fs::path savesPath {config_.vintagestoryDataPath / "Saves"};
+        const std::string action {args.size() > 1 ? args[1] : "list"};
+        if (action == "list") {
+            utl::PrintLog(utl::Bold("[Save snapshots]\n"));
+            store.PrintList();
+        } else if (action == "save") {
+            const std::string outgoing {config_.activeProfile.empty() ? "none" : config_.activeProfile};
+            store.Create(savesPath, args.size() > 2 ? args[2] : std::format("{}_{}", utl::GetTimeStamp(), outgoing));
+        } else if (action == "restore" && args.size() > 2) {
+            store.Restore(args[2], savesPath);
+        } else if (action == "remove" && args.size() > 2) {
+            store.Remove(args[2]);
+        } else {
+            utl::PrintErr("usage: snapshot [list | save [name] | restore <name> | remove <name>]\n");
+        }
+    }
+
+    std::vector<fs::path> Core::TrashRoots() const {
+        std::vector<fs::path> roots {constants::kTrashDir};
+        for (const fs::path& dir : {config_.profilesPath, config_.modsPath, config_.vintagestoryDataPath}) {
+            if (fs::path root {utl::TrashDirFor(dir)}; std::ranges::find(roots, root) == roots.end()) roots.push_back(std::move(root));
+        }
+        return roots;
+    }
+
+    void Core::PurgeTrashInBackground() {
+        if (purging_.exchange(true)) return;
+        if (purger_.joinable()) purger_.join(); // finished, only its handle is left
+        purger_ = std::jthread{[this, roots = TrashRoots()](const std::stop_token& stop) {
+            utl::LowerThreadPriority();
+            utl::tBackgroundOutput = true;
+            for (const auto& root : roots) {
+                if (stop.stop_requested()) break;
+                utl::PurgeTrash(root, constants::kTrashUndoWindow, stop);
+            }
+            purging_ = false;
+        }};
+    }
+
+    void Core::ManageTrash(const std::vector<std::string>& args) {
+        const std::string action {args.size() > 1 ? args[1] : "list"};
+        std::vector<utl::TrashBatch> batches;
+        for (const auto& root : TrashRoots()) std::ranges::move(utl::ListTrash(root), std::back_inserter(batches));
+        std::ranges::sort(batches, {}, &utl::TrashBatch::time);
+        const auto now {std::chrono::system_clock::now()};
+
+        if (action == "list") {
+            utl::PrintLog(utl::Bold("[Trash]\n"));
+            if (batches.empty()) utl::PrintLog(utl::Italics("empty\n"));
+            for (const auto& batch : batches) {
+                const auto left {std::chrono::ceil<std::chrono::minutes>(batch.time + constants::kTrashUndoWindow - now)};
+                utl::PrintLog(std::format("– {}: {} entries from '{}', {}\n", batch.id, batch.names.size(), batch.origin.string(),
+                                          left.count() > 0 ? std::format("purged in {}", left) : std::string{"purge pending"}));
+            }
+        } else if (action == "restore" && args.size() > 2) {
+            const auto it {args[2] == "last" ? (batches.empty() ? batches.end() : std::prev(batches.end()))
+                                             : std::ranges::find(batches, args[2], &utl::TrashBatch::id)};
+            if (it == batches.end()) {
+                utl::PrintErr(std::format("No trash batch '{}', see 'trash list'.\n", args[2]));
+                return;
+            }
+            WaitForStaging();
+            std::error_code ec;
+            if (utl::RestoreTrash(*it, ec)) {
+                utl::PrintLog(std::format("Restored {} entries to '{}'\n", it->names.size(), it->origin.string()));
+            } else if (ec) {
+                utl::PrintErr(std::format("Could not restore '{}': {}\n", it->id, ec.message()));
+            }
+        } else if (action == "empty") {
+            purger_.request_stop();
+            if (purger_.joinable()) purger_.join();
+            purging_ = false;
+            std::uintmax_t bytes {};
+            for (const auto& root : TrashRoots()) bytes += utl::PurgeTrash(root, std::chrono::seconds{0});
+            utl::PrintLog(std::format("Emptied the trash, {:.1f} MiB freed\n", static_cast<double>(bytes) / (1024.0 * 1024.0)));
+        } else {
+            utl::PrintErr("usage: trash [list | restore <batch | last> | empty]\n");
+        }
+    }
+
+    void Core::SwapCaches(const fs::path& outgoing, const fs::path& incoming) const {
+        for (const auto& rel : config_.cachePaths) {
+            const fs::path live {config_.vintagestoryDataPath / rel};
+            const fs::path parked {outgoing / constants::kProfileMetaDir / "cache" / rel};
+            const fs::path saved {incoming / constants::kProfileMetaDir / "cache" / rel};
+            std::error_code ec;
+            if (fs::exists(live, ec)) {
+                if (fs::exists(parked, ec)) utl::MoveToTrash(parked, ec); // older snapshot of the same profile
+                if (!utl::MoveTree(live, parked, ec)) {
+                    // Leave the live cache alone rather than mixing two profiles' caches
+                    utl::PrintErr(std::format("Could not preserve cache '{}': {}\n", live.string(), ec.message()));
+                    continue;
+                }
+            }
+            if (!fs::exists(saved, ec)) continue;
+            if (utl::MoveTree(saved, live, ec)) {
+                utl::PrintLog(std::format("Restored cache '{}'\n", rel.string()));
+            } else {
+                utl::PrintErr(std::format("Could not restore cache '{}': {}\n", saved.string(), ec.message()));
+            }
+        }
+    }
+
+    bool Core::ResolveGameCommand(const std::vector<std::string>& args, const std::size_t exeArg,
+                                  fs::path& exe, std::vector<std::string>& exeArgs) const {
+        // A stand-in executable given on the command line replaces the game
+        if (args.size() > exeArg) {
+            exe = args[exeArg];
+            exeArgs.assign(args.begin() + static_cast<std::ptrdiff_t>(exeArg) + 1, args.end());
+            return true;
+        }
+        exe = config_.vintagestoryExePath;
+        exeArgs = {"--dataPath", config_.vintagestoryDataPath.string()};
+        if (exe.empty()) {
+            utl::PrintErr("No Vintage Story executable set, add 'vintagestoryExePath' to the config or pass a stand-in.\n");
+            return false;
+        }
+        return true;
+    }
+
+    void Core::ProfileStartup(const std::vector<std::string>& args) const {
+        StartupProfiler profiler {utl::GetContentsList(config_.modsPath)};
+        if (args.size() >= 2 && args[1] == "log") {
+            if (args.size() < 3) { utl::PrintErr("usage: perf log <file>\n"); return; }
+            std::ifstream in {args[2]};
+            if (!in) {
+                utl::PrintErr(std::format("Could not open log '{}'.\n", args[2]));
+                return;
+            }
+            std::string line;
+            while (std::getline(in, line) && !profiler.ReachedReady()) profiler.Feed(line);
+            ExportStartupReport(profiler.Finish(config_.activeProfile));
+            return;
+        }
+        fs::path exe;
+        std::vector<std::string> exeArgs;
+        if (!ResolveGameCommand(args, 1, exe, exeArgs)) return;
+        const std::string modSetHash {HashModSet(config_.modsPath)};
+        std::vector<utl::ResourceSample> samples;
+        if (const auto report {ProfileLaunch(exe, exeArgs, profiler, config_.activeProfile, &samples)}) {
+            ExportStartupReport(*report);
+            RecordResourceRun(modSetHash, std::move(samples));
+        }
+    }
+
+    void Core::LaunchGame(const std::vector<std::string>& args) const {
+        fs::path exe;
+        std::vector<std::string> exeArgs;
+        if (!ResolveGameCommand(args, 1, exe, exeArgs)) return;
+        const std::string modSetHash {HashModSet(config_.modsPath)};
+        utl::PrintLog(std::format("Launching '{}', resources are recorded until it exits\n", exe.string()));
+        utl::ChildProcess game {utl::ChildProcess::Spawn(exe, exeArgs)};
+        if (!game.Valid()) {
+            utl::PrintErr(std::format("Failed to launch '{}'.\n", exe.string()));
+            return;
+        }
+        utl::ResourceSampler sampler {game.Pid(), constants::kResourceSampleInterval};
+        std::string line;
+        while (game.ReadLine(line)) {} // drain output so the game never blocks on a full pipe
+        std::vector<utl::ResourceSample> samples {sampler.Stop()};
+        game.Wait();
+        RecordResourceRun(modSetHash, std::move(samples));
+    }
+
+    void Core::ManageCopyCalibration(const std::vector<std::string>& args) {
+        if (args.size() > 1 && args[1] == "reset") {
+            config_.copyCalibration.clear();
+            utl::SetCopyCalibrations({});
+            config_.Save(constants::kConfigPath);
+            utl::PrintLog("Forgot all copy calibrations, the next large copy between each pair measures again.\n");
+            return;
+        }
+        utl::PrintLog(utl::Bold("[Copy calibration]\n"));
+        if (config_.copyCalibration.empty()) utl::PrintLog(utl::Italics("nothing measured yet\n"));
+        for (const auto& [pair, calibration] : config_.copyCalibration) {
+            utl::PrintLog(std::format("– {}: {} at {:.0f} MiB/s, hard links {}\n", pair, utl::ToString(calibration.method),
+                                      calibration.mibPerSecond, calibration.hardLinks ? "work" : "do not work"));
+        }
+    }
+
+    void Core::PrewarmMods() const {
+        const auto start {std::chrono::steady_clock::now()};
+        const utl::PrewarmStats stats {utl::Prewarm(config_.modsPath)};
+        const auto ms {std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()};
+        utl::PrintLog(std::format("Warmed {} files ({:.1f} MiB) in {} ms, {}\n", stats.files,
+                                  static_cast<double>(stats.bytes) / (1024.0 * 1024.0), ms,
+                                  stats.extentOrder ? "in disk order" : "in inode order (no extent map)"));
+        if (stats.failures != 0) utl::PrintWarn(std::format("{} files could not be warmed.\n", stats.failures));
+    }
+
+    void Core::RecordResourceRun(const std::string& modSetHash, std::vector<utl::ResourceSample> samples) const {
+        if (samples.empty()) {
+            utl::PrintWarn("No resource samples were taken, sampling needs /proc.\n");
+            return;
+        }
+        const ResourceRun run {ResourceRun::FromSamples(config_.activeProfile, modSetHash, std::move(samples))};
+        AppendResourceRun(run);
+        PrintResourceRun(run);
+    }
+
+    void Core::CompareFootprints(const std::vector<std::string>& args) const {
+        const std::vector<ResourceRun> runs {LoadResourceRuns()};
+        if (args.size() < 3) {
+            PrintFootprintSummary(runs);
+            return;
+        }
+        auto hashOf = [this](const std::string& profile) {
+            const fs::path path {config_.profilesPath / profile};
+            return fs::is_directory(path) && Rehydrate(path) ? HashModSet(path) : std::string{};
+        };
+        PrintFootprintComparison(runs, args[1], hashOf(args[1]), args[2], hashOf(args[2]));
+    }
+
+    void Core::ExportStartupReport(const StartupReport& report) const {
+        report.Print();
+
+        fs::create_directories(constants::kPerfDir);
+        const fs::path out {constants::kPerfDir / std::format("{}_{}.json", utl::GetTimeStamp(), config_.activeProfile.empty() ? "none" : config_.activeProfile)};
+        std::ofstream{out} << json(report).dump(4) << '\n';
+        utl::PrintLog(std::format("Exported report to '{}'\n", out.string()));
+    }
+
+    void Core::BisectRegression(const std::vector<std::string>& args) {
+        constexpr std::string_view usage {"usage: bisectperf <good> <bad> [startup|rss] [runs] [<exe> [args...]]\n"};
+        if (args.size() < 3) { utl::PrintErr(usage); return; }
+        const bool useRss = args.size() > 3 && args[3] == "rss";
+        if (args.size() > 3 && !useRss && args[3] != "startup") { utl::PrintErr(usage); return; }
+        int runs {constants::kBisectRuns};
+        if (args.size() > 4) {
+            const auto [_, ec] = std::from_chars(args[4].data(), args[4].data() + args[4].size(), runs);
+            if (ec != std::errc{} || runs < 3) { utl::PrintErr("Runs must be a number of at least 3.\n"); return; }
+        }
+        fs::path exe;
+        std::vector<std::string> exeArgs;
+        if (!ResolveGameCommand(args, 5, exe, exeArgs)) return;
+
+        const fs::path goodPath {config_.profilesPath / args[1]};
+        const fs::path badPath {config_.profilesPath / args[2]};
+        if (!utl::vExistsDirectoryCheck(goodPath) || !utl::vExistsDirectoryCheck(badPath)) return;
+        if (!Rehydrate(goodPath) || !Rehydrate(badPath)) return;
+        std::vector<std::string> goodMods {utl::GetContentsList(goodPath)};
+        std::vector<std::string> badMods {utl::GetContentsList(badPath)};
+        std::ranges::sort(goodMods);
+        std::ranges::sort(badMods);
+        // Configurations are the mods both profiles share plus a subset of the ones only <bad> has
+        std::vector<std::string> shared, added;
+        std::ranges::set_intersection(badMods, goodMods, std::back_inserter(shared));
+        std::ranges::set_difference(badMods, goodMods, std::back_inserter(added));
+        if (added.empty()) {
+            utl::PrintErr(std::format("Profile '{}' adds no mods over '{}', nothing to bisect.\n", args[2], args[1]));
+            return;
+        }
+
+        // Configurations must not be written through the Mods link into the linked profile
+        const fs::path linked {LinkedProfile()};
+        if (!linked.empty()) UnlinkMods();
+        // Keep the current mods safe while configurations are swapped in
+        const std::string stashName {GenNonEmptyName("")};
+        const fs::path stashPath {config_.profilesPath / stashName};
         utl::PrintLog(std::format("Stashing current mods to profile '{}'\n", stashName));
-        utl::CopyContents(config_.modsPath, stashPath);
-        // Clear contents of Mods
-        utl::ClearDirectoryContents(config_.modsPath);
-        // Copy contents of profileName into Mods
-        utl::CopyContents(profilePath, config_.modsPath);
-        SetActive(profileName);
+        utl::SyncPlan stash;
+        if (!stash.AddSync(config_.modsPath, stashPath, ModsStrategy()) || ExecutePlan(stash) != 0) {
+            utl::PrintErr("Could not stash the current mods, not bisecting.\n");
+            if (!linked.empty()) {
+                std::error_code ec;
+                utl::MoveToTrash(config_.modsPath, ec);
+                LinkMods(linked);
+            }
+            return;
+        }
+
+        const std::string_view unit {useRss ? "MiB" : "ms"};
+        bool failed {false};
+        auto measure = [&](const fs::path& from, const std::vector<std::string>& mods) -> utl::MedianEstimate {
+            // Mods is rebuilt to hold exactly this set, folder mods included, so no earlier set lingers
+            utl::SyncPlan plan;
+            if (!plan.AddSelected(from, config_.modsPath, mods, ModsStrategy()) || ExecutePlan(plan) != 0) failed = true;
+            std::vector<double> samples;
+            for (int i = 0; i < runs && !failed; ++i) {
+                StartupProfiler profiler {mods};
+                const auto report {ProfileLaunch(exe, exeArgs, profiler, "")};
+                if (!report) { failed = true; break; }
+                samples.push_back(useRss ? static_cast<double>(report->peakRssKb) / 1024.0 : report->totalMs);
+            }
+            const utl::MedianEstimate est {utl::EstimateMedian(samples)};
+            utl::PrintLog(std::format("{} mods: median {:.1f} {} [{:.1f}, {:.1f}] at {:.1f}% confidence\n",
+                                      mods.size(), est.median, unit, est.lo, est.hi, 100.0 * est.confidence));
+            return est;
+        };
+
+        utl::PrintLog(utl::Bold(std::format("Measuring baseline '{}'\n", args[1])));
+        const utl::MedianEstimate baseline {measure(goodPath, goodMods)};
+        // Regressed only when the intervals do not overlap and the slowdown is large enough to matter
+        auto regressed = [&](const utl::MedianEstimate& est) {
+            return est.lo > baseline.hi && est.median > baseline.median * (1.0 + constants::kBisectMinRegression);
+        };
+
+        std::map<std::vector<std::string>, bool> seen;
+        auto test = [&](const std::vector<std::string>& subset) {
+            std::vector<std::string> key {subset};
+            std::ranges::sort(key);
+            if (const auto it = seen.find(key); it != seen.end()) return it->second;
+            if (failed) return false;
+            std::vector<std::string> mods {shared};
+            mods.insert(mods.end(), key.begin(), key.end());
+            const bool result = regressed(measure(badPath, mods));
+            seen.emplace(std::move(key), result);
+            return result;
+        };
+
+        utl::PrintLog(utl::Bold(std::format("Measuring regressed '{}'\n", args[2])));
+        if (const bool reproduces {test(added)}; !failed && !reproduces) {
+            utl::PrintWarn(std::format("No significant {} regression between '{}' and '{}'.\n",
+                                       useRss ? "peak RSS" : "startup time", args[1], args[2]));
+        } else if (!failed) {
+            const std::vector<std::string> culprits {utl::ddmin(added, test)};
+            if (!failed) {
+                utl::PrintLog(utl::Bold(std::format("[Minimal regressing set ({})]\n", culprits.size())));
+                for (const auto& mod : culprits) utl::PrintLog(std::format("– {}\n", mod));
+            }
+        }
+        if (failed) utl::PrintErr("Bisection aborted, a configuration could not be set up or the game could not be launched.\n");
+
+        // Put the stashed mods back, then drop the stash, which only duplicates them
+        utl::SyncPlan restore;
+        if (restore.AddSync(stashPath, config_.modsPath, ModsStrategy()) && ExecutePlan(restore) == 0) {
+            std::error_code ec;
+            if (!utl::MoveToTrash(stashPath, ec)) utl::PrintWarn(std::format("Could not remove '{}': {}\n", stashName, ec.message()));
+            utl::PrintLog("Restored mods\n");
+        } else {
+            utl::PrintErr(std::format("Could not fully restore mods, they are kept in '{}'\n", stashName));
+        }
+        if (!linked.empty()) {
+            std::error_code ec;
+            utl::MoveToTrash(config_.modsPath, ec);
+            LinkMods(linked);
+        }
     }
 
     void Core::PrintInfo() const {
@@ -108,6 +1441,19 @@ namespace vsprofile {
         std::cout << std::format("VintagestoryData folder path: '{}'\n", utl::Italics(config_.vintagestoryDataPath.string()));
         std::cout << std::format("Vintage Story executable path: '{}'\n", utl::Italics(config_.vintagestoryExePath.string()));
         std::cout << std::format("Config path: '{}'\n", utl::Italics(constants::kConfigPath.string()));
+        std::cout << std::format("Activation strategy: '{}'\n",
+                                 utl::Italics(config_.activationStrategy == ActivationStrategy::Symlink ? "symlink" : "sync"));
+        for (const auto& rel : config_.cachePaths) {
+            std::cout << std::format("Per-profile cache: '{}'\n", utl::Italics((config_.vintagestoryDataPath / rel).string()));
+        }
+        for (const auto& [label, path] : {std::pair{"profiles", config_.profilesPath}, std::pair{"Mods", config_.modsPath}}) {
+            std::cout << std::format("Copy order for {}: '{}'{}\n", label,
+                                     utl::Italics(utl::PreferSequential(path) ? "sequential" : "parallel"),
+                                     utl::IsRotational(path) ? " (spinning disk)" : "");
+        }
+        std::cout << std::format("Durability: '{}'\n", utl::Italics(utl::ToString(config_.durability)));
+        const std::string cold {config_.coldAfterDays == 0 ? std::string{"off"} : std::format("after {} idle days", config_.coldAfterDays)};
+        std::cout << std::format("Cold tier: '{}'{}\n", utl::Italics(cold), utl::PackCompression() ? "" : " (built without zlib, packs are uncompressed)");
     }
 
     void Core::ClearAllProfiles() {
@@ -115,9 +1461,19 @@ namespace vsprofile {
         if (utl::RequestConfirmation("This will clear all profile folders, do you wish to continue? y/n\n")) {
             return;
         }
+        WaitForStaging();
         utl::PrintLog(utl::Bold("Clearing All Profiles...\n"));
+        std::error_code ec;
+        fs::remove(StagingMarkerPath(), ec); // staged copies refer to profiles about to disappear
+        fs::remove(ModsStatePath(), ec);
+        if (const fs::path linked {LinkedProfile()}; !linked.empty()) {
+            GuardProfile(linked, false);
+            UnlinkMods();
+        }
         utl::ClearDirectoryContents(config_.profilesPath, true);
+        config_.stats.profiles.clear();
         utl::PrintLog(utl::Bold("Cleared All Profiles! :3\n"));
+        utl::PrintLog(std::format("Use 'trash restore last' within {} to undo.\n", constants::kTrashUndoWindow));
         SetActive("");
     }
 
@@ -125,20 +1481,18 @@ namespace vsprofile {
         cmds_.clear();
 
         cmds_.emplace("profiles", Command{
-                "profiles", "List available profiles.",
-                [this](const std::vector<std::string>&){
-                    utl::PrintLog(utl::Bold("[Available profiles]\n"));
-                    fs::create_directories(config_.profilesPath);
-                    utl::ListDirectoryContents(config_.profilesPath);
-                }
+                "profiles", "List available profiles and how they have been used, most recent or largest first with "
+                            "'recent' or 'size'. Usage: profiles [recent | size]",
+                [this](const std::vector<std::string>& args){ this->ListProfiles(args); }
         });
 
         cmds_.emplace("profile", Command{
         "profile", "List mods in profile.",
         [this](const std::vector<std::string>& args){
             if (args.size() < 2) { utl::PrintErr("usage: profile <name>\n"); return; }
+            Rehydrate(config_.profilesPath / args[1]);
             utl::PrintLog(utl::Bold(std::format("[Mods in '{}']\n", args[1])));
-            utl::ListDirectoryContents(config_.profilesPath / args[1]);
+            for (const auto& name : ListNames(config_.profilesPath / args[1])) utl::PrintLog(std::format("– {}\n", name));
         }
 });
 
@@ -146,7 +1500,7 @@ namespace vsprofile {
                 "mods", "List current mods.",
                 [this](const std::vector<std::string>&){
                     utl::PrintLog(utl::Bold("[Installed mods]\n"));
-                    utl::ListDirectoryContents(config_.modsPath);
+                    for (const auto& name : ListNames(config_.modsPath)) utl::PrintLog(std::format("– {}\n", name));
                 }
         });
 
@@ -170,10 +1524,94 @@ namespace vsprofile {
                 "activate", "Move mods contained in the given profile name in the Mods folder. Stashes current mod list.",
                 [this](const std::vector<std::string>& args){
                     if (args.size() < 2) { utl::PrintErr("usage: activate <profile>\n"); return; }
-                    this->ActivateProfile(args[1], args[2]);
+                    this->ActivateProfile(args[1], args.size() > 2 ? args[2] : "");
+                }
+        });
+
+        cmds_.emplace("perf", Command{
+                "perf", "Launch the game and rank mods and loading phases by startup time. Usage: perf [log <file> | <exe> [args...]]",
+                [this](const std::vector<std::string>& args){ this->ProfileStartup(args); }
+        });
+
+        cmds_.emplace("bisectperf", Command{
+                "bisectperf", "Find the mods responsible for a startup time or memory regression between two profiles. Usage: bisectperf <good> <bad> [startup|rss] [runs] [<exe> [args...]]",
+                [this](const std::vector<std::string>& args){ this->BisectRegression(args); }
+        });
+
+        cmds_.emplace("play", Command{
+                "play", "Launch the game and record its memory, CPU and I/O use. Usage: play [<exe> [args...]]",
+                [this](const std::vector<std::string>& args){ this->LaunchGame(args); }
+        });
+
+        cmds_.emplace("footprint", Command{
+                "footprint", "Compare the recorded memory and CPU footprint of two profiles. Usage: footprint [<profile> <profile>]",
+                [this](const std::vector<std::string>& args){ this->CompareFootprints(args); }
+        });
+
+        cmds_.emplace("snapshot", Command{
+                "snapshot", "Manage deduplicated snapshots of the Saves folder. Usage: snapshot [list | save [name] | restore <name> | remove <name>]",
+                [this](const std::vector<std::string>& args){ this->ManageSnapshots(args); }
+        });
+
+        cmds_.emplace("compare", Command{
+                "compare", "List the differences between two profiles, or a profile and the Mods folder. Usage: compare <profile> [<profile>]",
+                [this](const std::vector<std::string>& args){ this->CompareProfiles(args); }
+        });
+
+        cmds_.emplace("verify", Command{
+                "verify", "Check a profile against its recorded content hashes. Usage: verify <profile> [full]",
+                [this](const std::vector<std::string>& args){ this->VerifyProfile(args); }
+        });
+
+        cmds_.emplace("trash", Command{
+                "trash", "Restore or purge deleted mods and profiles. Usage: trash [list | restore <batch | last> | empty]",
+                [this](const std::vector<std::string>& args){ this->ManageTrash(args); }
+        });
+
+        cmds_.emplace("prewarm", Command{
+                "prewarm", "Read the Mods folder into the page cache, optionally launching the game right after. Usage: prewarm [launch [exe args...]]",
+                [this](const std::vector<std::string>& args){
+                    this->PrewarmMods();
+                    if (args.size() > 1 && args[1] == "launch") this->LaunchGame({args.begin() + 1, args.end()});
                 }
         });
 
+        cmds_.emplace("calibrate", Command{
+                "calibrate", "Show the copy method measured for each pair of filesystems, or forget them to measure again. Usage: calibrate [reset]",
+                [this](const std::vector<std::string>& args){ this->ManageCopyCalibration(args); }
+        });
+
+        cmds_.emplace("prune", Command{
+                "prune", "Remove auto-generated stashes past the stashRetention policy, or list what would go. Usage: prune [dry]",
+                [this](const std::vector<std::string>& args){ this->PruneStashes(args.size() > 1 && args[1] == "dry"); }
+        });
+
+        cmds_.emplace("materialise", Command{
+                "materialise", "Store in full a stash that only lists the files it shares with another profile. Usage: materialise <stash>",
+                [this](const std::vector<std::string>& args){
+                    if (args.size() < 2) { utl::PrintErr("usage: materialise <stash>\n"); return; }
+                    const fs::path stashPath {config_.profilesPath / args[1]};
+                    if (!utl::vExistsDirectoryCheck(stashPath)) return;
+                    if (!DeltaManifest::Load(stashPath)) { utl::PrintLog(std::format("'{}' is already stored in full\n", args[1])); return; }
+                    MaterialiseStash(stashPath);
+                }
+        });
+
+        cmds_.emplace("cold", Command{
+                "cold", "List packed profiles, pack or unpack one, or pack every profile idle past coldAfterDays. Usage: cold [list | pack <profile> | unpack <profile> | idle]",
+                [this](const std::vector<std::string>& args){ this->ManageColdTier(args); }
+        });
+
+        cmds_.emplace("prepare", Command{
+                "prepare", "Stage a profile beside Mods in the background so activating it is a rename. Usage: prepare [profile] (predicted if omitted)",
+                [this](const std::vector<std::string>& args){ this->PrepareProfile(args.size() > 1 ? args[1] : ""); }
+        });
+
+        cmds_.emplace("status", Command{
+                "status", "Show the active profile and main paths.",
+                [this](const std::vector<std::string>&){ this->PrintInfo(); }
+        });
+
         cmds_.emplace("info", Command{
                 "info", "Show extra information on the current configuration.",
                 [this](const std::vector<std::string>&){ this->PrintExtraInfo(); }
@@ -194,6 +1632,14 @@ namespace vsprofile {
         });
     }
 
+    std::vector<std::string> Core::ListNames(const fs::path& dir) const {
+        return cache_ ? cache_->Names(dir) : utl::GetContentsList(dir);
+    }
+
+    Manifest Core::ScanManifest(const fs::path& root) const {
+        return cache_ ? cache_->ManifestOf(root) : Manifest::Scan(root);
+    }
+
     bool Core::Dispatch(const std::string& cmd, const std::vector<std::string>& args) {
         if (cmds_.empty()) {
             utl::PrintErr("No commands loaded. Did you forget to call BuildCommands?.\n");
@@ -203,7 +1649,24 @@ namespace vsprofile {
             utl::PrintErr("Unknown command. Try 'help'.\n");
             return false;
         }
+        // Commands that only read leave the lock to whichever process changes Mods or the config
+        static const std::unordered_set<std::string> kReadOnly {"help", "info", "mods", "status"};
+        std::optional<utl::FileLock> lock;
+        if (!kReadOnly.contains(cmd)) {
+            lock.emplace(constants::kLockPath);
+            if (!lock->Held()) {
+                const int holder {lock->HolderPid()};
+                utl::PrintErr(std::format("Another vsprofile process{} is changing Mods or the config, try again once it is done.\n",
+                                          holder > 0 ? std::format(" (pid {})", holder) : ""));
+                return false;
+            }
+        }
+        // The other process may have saved since this one last looked
+        if (ReloadConfig(constants::kConfigPath)) utl::PrintLog("Reloaded the config, it was changed on disk\n");
         it->second.run(args);
+        // Copies made by the command may have measured a new pair of filesystems
+        if (utl::TakeNewCopyCalibrations(config_.copyCalibration)) config_.Save(constants::kConfigPath);
+        else config_.SaveIfChanged(constants::kConfigPath); // usage the command recorded without saving
         return true;
     }
 
@@ -5,7 +5,15 @@
 #include "../Include/json.hpp"
 #include "Command.hpp"
 #include "Config.hpp"
+#include "DeltaStash.hpp"
+#include "DirectoryCache.hpp"
+#include "Journal.hpp"
+#include "MerkleTree.hpp"
+#include "Perf.hpp"
+#include <atomic>
+#include <chrono>
 #include <string>
+#include <thread>
 #include <vector>
 #include <format>
 
@@ -16,6 +24,34 @@ namespace vsprofile {
     class Core{
         std::unordered_map<std::string, Command> cmds_;
         Config config_;
+        std::jthread stager_; // background 'prepare', joined before anything touches Mods or profiles
+        std::atomic<bool> purging_ {false};
+        std::jthread purger_; // background purge of expired trash, stopped between files on exit
+        DirectoryCache* cache_ {nullptr}; // set when running inside the daemon
+
+        void ApplySettings() const; // the process-wide ones: copy order, calibrations, durability
+
+        // What one activation settled before changing anything, carried through its steps
+        struct Activation {
+            std::string profile;
+            std::filesystem::path profilePath;
+            std::filesystem::path stashPath;
+            std::filesystem::path linked; // the profile Mods linked to, empty when it was a folder
+            bool useLink {false};         // Mods ends up a link to the profile
+            bool clean {false};           // Mods still held exactly the outgoing profile, so it is listed rather than stashed
+            bool staged {false};          // a staged copy replaces Mods by renames
+            ActivationJournal journal;
+        };
+        // The steps of ActivateProfile, in order; each returns false once the activation stops
+        bool StartActivation(const std::string& profileName, const std::string& stashNameIn, Activation& activation);
+        bool MoveModsOut(Activation& activation); // the journaled renames that set Mods up for the plan
+        bool PlanActivation(const Activation& activation, utils::SyncPlan& plan);
+        bool RunActivation(Activation& activation, utils::SyncPlan& plan, std::chrono::steady_clock::time_point started);
+        // Commits an activation whose plan ran in full
+        void FinishActivation(const std::string& profileName, const std::filesystem::path& stashPath, bool cachesSwapped,
+                              JournalLog& log);
+        void UndoMoves(const ActivationJournal& journal);
+        void AbandonMoves(); // undoes the journaled moves and drops the journal, before any of the plan ran
 
     public:
         explicit Core(Config config);
@@ -23,15 +59,90 @@ namespace vsprofile {
         void BuildCommands();
         [[nodiscard]] const auto& Commands() const { return cmds_; }
         bool Dispatch(const std::string& cmd, const std::vector<std::string>& args);
+        void SetDirectoryCache(DirectoryCache* cache) { cache_ = cache; }
+        bool ReloadConfig(const std::filesystem::path& configPath); // when the files differ from what is held, e.g. a hand edit
+        [[nodiscard]] std::vector<std::string> ListNames(const std::filesystem::path& dir) const;
+        [[nodiscard]] Manifest ScanManifest(const std::filesystem::path& root) const;
 
         void SetActive(const std::string& profileName);
         void ActivateProfile(const std::string& profileName, const std::string& stashName = "");
+        // Finishes, or rolls back, an activation a previous run left journaled; false while one stays unfinished
+        bool ResumeActivation();
+        // Retention of auto-generated stashes, decided from a small record kept in each stash
+        [[nodiscard]] static std::filesystem::path StashRecordPath(const std::filesystem::path& stashPath);
+        void PruneStashes(bool dryRun);
         void ClearAllProfiles();
+        [[nodiscard]] std::filesystem::path LiveRootPath(const ProfileRoot& root) const;
+        [[nodiscard]] static std::filesystem::path StoredRootPath(const std::filesystem::path& profilePath, const ProfileRoot& root);
+        // With `delta`, files its reference profile holds unchanged are listed there instead of captured.
+        // Both return false when a folder could not be read, the plan must then not run.
+        [[nodiscard]] bool PlanCapture(const std::filesystem::path& profilePath, utils::SyncPlan& plan, bool includeMods = true,
+                                       DeltaManifest* delta = nullptr) const;
+        [[nodiscard]] bool PlanRestore(const std::filesystem::path& profilePath, utils::SyncPlan& plan,
+                                       bool includeMods = true, bool includeOthers = true) const;
+        // Delta stashes get their shared files back before anything reads them, and before their reference changes
+        bool MaterialiseStash(const std::filesystem::path& stashPath) const;
+        bool MaterialiseDependents(const std::string& profileName) const; // false when one of them stays incomplete
+        // Cold tier: profiles idle for coldAfterDays keep the files only they hold in a compressed pack
+        [[nodiscard]] static std::filesystem::path ColdPackPath(const std::filesystem::path& profilePath);
+        [[nodiscard]] std::chrono::system_clock::time_point LastUsed(const std::string& profileName) const;
+        bool PackProfile(const std::string& name);
+        bool UnpackProfile(const std::filesystem::path& profilePath) const;
+        void PackIdleProfiles();
+        void ManageColdTier(const std::vector<std::string>& args);
+        // Puts back whatever a profile keeps elsewhere (its pack, a delta stash's shared files) before it is read
+        bool Rehydrate(const std::filesystem::path& profilePath) const;
+
+        // Symlink activation: Mods points at the active profile folder
+        [[nodiscard]] std::filesystem::path LinkedProfile() const; // empty unless Mods is a symlink
+        bool LinkMods(const std::filesystem::path& profilePath) const;
+        void UnlinkMods() const;
+        void ReportLinkedChanges() const;
+        static void GuardProfile(const std::filesystem::path& profilePath, bool readOnly);
+
+        // Pre-staging: a profile materialised beside Mods ahead of time, swapped in on activation
+        [[nodiscard]] std::filesystem::path StagingPath() const;
+        [[nodiscard]] std::filesystem::path StagingMarkerPath() const;
+        [[nodiscard]] utils::SyncStrategy ModsStrategy() const;
+        [[nodiscard]] std::string PredictNextProfile() const;
+        void PrepareProfile(const std::string& nameIn);
+        void WaitForStaging();
+        [[nodiscard]] bool StagedUpToDate(const std::string& profileName, const std::filesystem::path& profilePath) const;
+        // Dirty tracking: whether Mods still holds exactly what the active profile put there
+        [[nodiscard]] std::filesystem::path ModsStatePath() const;
+        void RecordModsState(const std::string& profileName) const;
+        [[nodiscard]] bool ModsClean() const;
+        // Content hashes kept beside each profile and beside Mods, refreshed incrementally
+        [[nodiscard]] std::filesystem::path TreePath(const std::filesystem::path& dir) const;
+        [[nodiscard]] std::filesystem::path CopiedHashesPath(const std::filesystem::path& dir) const;
+        MerkleTree RefreshTree(const std::filesystem::path& dir) const;
+        // Runs a plan, hashing its copies in flight when copyIntegrity asks for it
+        std::size_t ExecutePlan(utils::SyncPlan& plan) const;
+        void RecordCopiedHashes(const std::vector<utils::HashedCopy>& copies) const;
+        void CompareProfiles(const std::vector<std::string>& args) const;
+        void VerifyProfile(const std::vector<std::string>& args) const;
+        // Deletions are renames into a same-filesystem trash, purged at idle priority after the undo window
+        [[nodiscard]] std::vector<std::filesystem::path> TrashRoots() const;
+        void PurgeTrashInBackground();
+        void ManageTrash(const std::vector<std::string>& args);
+        void ManageSnapshots(const std::vector<std::string>& args) const;
+        void SwapCaches(const std::filesystem::path& outgoing, const std::filesystem::path& incoming) const;
 
         void PrintInfo() const;
+        void ListProfiles(const std::vector<std::string>& args) const; // with usage, optionally by recency or size
         void PrintExtraInfo() const;
         void SaveProfile(const std::string& nameIn = "");
-        void UpdateProfile(const std::string& name) const;
+        void UpdateProfile(const std::string& name);
+        void ProfileStartup(const std::vector<std::string>& args) const;
+        void ExportStartupReport(const StartupReport& report) const;
+        void BisectRegression(const std::vector<std::string>& args);
+        void LaunchGame(const std::vector<std::string>& args) const;
+        void PrewarmMods() const;
+        void ManageCopyCalibration(const std::vector<std::string>& args);
+        void RecordResourceRun(const std::string& modSetHash, std::vector<utils::ResourceSample> samples) const;
+        void CompareFootprints(const std::vector<std::string>& args) const;
+        bool ResolveGameCommand(const std::vector<std::string>& args, std::size_t exeArg,
+                                std::filesystem::path& exe, std::vector<std::string>& exeArgs) const;
 
         [[nodiscard]] std::string GenNonEmptyName(std::string_view nameIn) const;
     };
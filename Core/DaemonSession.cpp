@@ -0,0 +1,110 @@
+#include "DaemonSession.hpp"
+#include "Command.hpp"
+#include "../Utils/SocketUtils.hpp"
+#include "../Utils/TextUtils.hpp"
+#include <iostream>
+
+namespace utl = vsprofile::utils;
+
+namespace vsprofile {
+
+    namespace {
+        // Reads from the client, asking it for a line each time the buffer runs dry
+        class ClientInBuf : public std::streambuf {
+            int fd_;
+            std::string line_;
+
+        protected:
+            int_type underflow() override {
+                if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+                if (!utl::SendAll(fd_, std::string_view{&utl::kInputRequest, 1})) return traits_type::eof();
+                if (!utl::ReceiveLine(fd_, line_)) return traits_type::eof();
+                line_ += '\n';
+                setg(line_.data(), line_.data(), line_.data() + line_.size());
+                return traits_type::to_int_type(*gptr());
+            }
+
+        public:
+            explicit ClientInBuf(const int fd) : fd_{fd} {}
+        };
+    }
+
+    std::streamsize ClientOutBuf::xsputn(const char* s, const std::streamsize n) {
+        std::scoped_lock lock {mtx_};
+        if (fd_ >= 0 && !utl::tBackgroundOutput) {
+            utl::SendAll(fd_, {s, static_cast<std::size_t>(n)});
+            return n;
+        }
+        return log_->sputn(s, n);
+    }
+
+    ClientOutBuf::int_type ClientOutBuf::overflow(const int_type c) {
+        if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+        const char ch = traits_type::to_char_type(c);
+        xsputn(&ch, 1);
+        return c;
+    }
+
+    int ClientOutBuf::sync() {
+        std::scoped_lock lock {mtx_};
+        return log_->pubsync();
+    }
+
+    void ClientOutBuf::SetClient(const int fd) {
+        std::scoped_lock lock {mtx_};
+        fd_ = fd;
+    }
+
+    bool ServeClient(const int client, ClientOutBuf& out, const std::function<bool(const std::vector<std::string>&)>& run,
+                     const std::chrono::milliseconds requestTimeout) {
+        // The socket file is the owner's only, this also covers a daemon started with a looser one
+        if (!utl::PeerIsCurrentUser(client)) {
+            utl::PrintWarn("Refused a request from another user\n");
+            return false;
+        }
+        std::string line;
+        utl::SetTimeout(client, requestTimeout);
+        if (!utl::ReceiveLine(client, line)) return false;
+        utl::SetTimeout(client, kAnswerTimeout);
+        const auto args {Command::SplitArgs(line)};
+        if (args.empty()) return false;
+        ClientInBuf in {client};
+        std::streambuf* const stdinBuf {std::cin.rdbuf(&in)};
+        std::cin.clear();
+        out.SetClient(client);
+        const bool succeeded {run(args)};
+        std::cout.flush();
+        out.SetClient(-1);
+        utl::SendAll(client, std::string_view{succeeded ? &utl::kCommandSucceeded : &utl::kCommandFailed, 1});
+        std::cin.rdbuf(stdinBuf);
+        std::cin.clear();
+        return true;
+    }
+
+    std::optional<bool> RunRemote(const std::filesystem::path& socketPath, const std::string& line, std::ostream& out,
+                                  std::istream& in) {
+        const int fd = utl::ConnectUnix(socketPath);
+        if (fd < 0) return std::nullopt;
+        utl::SendAll(fd, line + '\n');
+        bool succeeded {false};
+        char buf[8192];
+        std::ptrdiff_t n;
+        while ((n = utl::ReceiveSome(fd, buf, sizeof buf)) > 0) {
+            for (const std::string_view chunk {buf, static_cast<std::size_t>(n)}; const char c : chunk) {
+                if (c == utl::kCommandSucceeded || c == utl::kCommandFailed) {
+                    succeeded = c == utl::kCommandSucceeded;
+                    continue;
+                }
+                if (c != utl::kInputRequest) { out << c; continue; }
+                out << std::flush;
+                std::string answer;
+                if (std::getline(in, answer)) utl::SendAll(fd, answer + '\n');
+                else utl::ShutdownWrite(fd);
+            }
+        }
+        out << std::flush;
+        utl::CloseSocket(fd);
+        return succeeded;
+    }
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <optional>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace vsprofile {
+
+    // How vsprofile talks to vsprofiled: each connection sends one command line and receives its output,
+    // then a status byte, until the socket closes; commands that ask for confirmation read the answer
+    // back from the client.
+
+    // Requests are served one at a time, so a client that stops reading or writing cannot hold the daemon
+    inline constexpr std::chrono::seconds kRequestTimeout {10};
+    inline constexpr std::chrono::minutes kAnswerTimeout {5}; // a person answering a confirmation
+
+    // While a command is being served its output goes to the client, from whichever thread runs its
+    // work; background staging and purging, and the daemon's own messages, go to the daemon's stdout
+    class ClientOutBuf : public std::streambuf {
+        std::streambuf* log_;
+        std::mutex mtx_;
+        int fd_ {-1};
+
+    protected:
+        std::streamsize xsputn(const char* s, std::streamsize n) override;
+        int_type overflow(int_type c) override;
+        int sync() override;
+
+    public:
+        explicit ClientOutBuf(std::streambuf* log) : log_{log} {}
+
+        void SetClient(int fd);
+    };
+
+    // Reads one command line from `client` and runs it with std::cout going to the client through `out`,
+    // which must be installed on std::cout, and std::cin reading from it. False when nothing was run:
+    // the client is another user, or sent no complete line within `requestTimeout`.
+    bool ServeClient(int client, ClientOutBuf& out, const std::function<bool(const std::vector<std::string>&)>& run,
+                     std::chrono::milliseconds requestTimeout = kRequestTimeout);
+
+    // Runs one command line on the daemon listening at `socketPath`, relaying its output to `out` and any
+    // confirmation it asks for from `in`. Whether the command succeeded, a reply cut short counting as a
+    // failure; empty if the daemon could not be reached.
+    std::optional<bool> RunRemote(const std::filesystem::path& socketPath, const std::string& line, std::ostream& out,
+                                  std::istream& in);
+
+}
@@ -0,0 +1,56 @@
+#include "DeltaStash.hpp"
+#include "../Include/json.hpp"
+#include "../Utils/AppConstants.hpp"
+#include "../Utils/FileUtils.hpp"
+#include <fstream>
+
+using json = nlohmann::json;
+namespace utl = vsprofile::utils;
+namespace fs = std::filesystem;
+
+namespace vsprofile {
+
+    fs::path DeltaManifest::PathIn(const fs::path& stashPath) {
+        return stashPath / constants::kProfileMetaDir / "delta.json";
+    }
+
+    std::optional<DeltaManifest> DeltaManifest::Load(const fs::path& stashPath) {
+        std::ifstream in {PathIn(stashPath)};
+        if (!in) return std::nullopt;
+        try {
+            const json j = json::parse(in);
+            DeltaManifest delta;
+            delta.reference = j.at("reference").get<std::string>();
+            for (const auto& [root, files] : j.at("roots").items()) {
+                auto& shared {delta.roots[root]};
+                // [path, size, mtime] triples, the list runs to every mod a profile holds
+                for (const json& f : files) {
+                    shared.push_back({f.at(0).get<std::string>(), f.at(1).get<std::uintmax_t>(), f.at(2).get<long long>()});
+                }
+            }
+            return delta;
+        }
+        catch (const json::exception&) {
+            return std::nullopt;
+        }
+    }
+
+    bool DeltaManifest::Save(const fs::path& stashPath) const {
+        json rootsJson = json::object();
+        for (const auto& [root, files] : roots) {
+            json list = json::array();
+            for (const auto& f : files) list.push_back({f.path, f.size, f.mtime});
+            rootsJson[root] = std::move(list);
+        }
+        const json j {{"reference", reference}, {"roots", rootsJson}};
+        // Without it the stash is missing files, so it is as durable as the files themselves
+        return utl::WriteJsonAtomically(PathIn(stashPath), j);
+    }
+
+    std::size_t DeltaManifest::FileCount() const {
+        std::size_t count {};
+        for (const auto& [root, files] : roots) count += files.size();
+        return count;
+    }
+
+}
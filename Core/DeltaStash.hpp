@@ -0,0 +1,24 @@
+#pragma once
+#include "../Utils/SyncPlan.hpp"
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace vsprofile {
+
+    // A stash holding only the files its reference profile lacked when it was made. The rest are
+    // listed here, per root, and linked or copied back from the reference when the stash is used.
+    // Profiles other stashes refer to have those stashes materialised before they are changed.
+    struct DeltaManifest {
+        std::string reference; // profile name
+        std::map<std::string, std::vector<utils::SharedFile>> roots; // by root path, relative to where the root is stored
+
+        [[nodiscard]] static std::filesystem::path PathIn(const std::filesystem::path& stashPath);
+        [[nodiscard]] static std::optional<DeltaManifest> Load(const std::filesystem::path& stashPath);
+        bool Save(const std::filesystem::path& stashPath) const;
+        [[nodiscard]] std::size_t FileCount() const;
+    };
+
+}
@@ -0,0 +1,148 @@
+#include "DirectoryCache.hpp"
+#include "../Utils/FileUtils.hpp"
+#include "../Utils/TextUtils.hpp"
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace utl = vsprofile::utils;
+namespace fs = std::filesystem;
+
+namespace vsprofile {
+
+    namespace {
+        std::string Key(const fs::path& p) {
+            return fs::absolute(p).lexically_normal().generic_string();
+        }
+
+        bool IsWithin(const std::string& path, const std::string& root) {
+            return path.size() >= root.size() && path.compare(0, root.size(), root) == 0
+                   && (path.size() == root.size() || path[root.size()] == '/' || root.ends_with('/'));
+        }
+    }
+
+#if defined(__linux__)
+    DirectoryCache::DirectoryCache() : fd_{inotify_init1(IN_NONBLOCK | IN_CLOEXEC)} {
+        if (fd_ < 0) utl::PrintWarn("inotify unavailable, listings will not be cached\n");
+    }
+
+    DirectoryCache::~DirectoryCache() {
+        if (fd_ >= 0) close(fd_);
+    }
+
+    void DirectoryCache::Watch(const fs::path& dir) {
+        const std::string key {Key(dir)};
+        if (watched_.contains(key)) return;
+        constexpr uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE
+                                  | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+        const int wd = inotify_add_watch(fd_, key.c_str(), mask);
+        if (wd < 0) return;
+        watches_[wd].push_back(key);
+        watched_[key] = wd;
+    }
+
+    void DirectoryCache::WatchTree(const fs::path& root) {
+        Watch(root);
+        std::error_code ec;
+        auto it = fs::recursive_directory_iterator(root, ec);
+        for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (utl::IsHiddenEntry(it->path().filename().string())) {
+                if (it->is_directory(ec)) it.disable_recursion_pending();
+                continue;
+            }
+            if (it->is_directory(ec)) Watch(it->path());
+        }
+    }
+
+    void DirectoryCache::Poll() {
+        if (fd_ < 0) return;
+        alignas(inotify_event) char buf[16384];
+        while (true) {
+            const ssize_t n = read(fd_, buf, sizeof buf);
+            if (n <= 0) return;
+            for (char* p = buf; p < buf + n;) {
+                const auto* ev = reinterpret_cast<const inotify_event*>(p);
+                p += sizeof(inotify_event) + ev->len;
+                if (ev->mask & IN_Q_OVERFLOW) {
+                    entries_.clear(); // events were lost, nothing can be trusted
+                    continue;
+                }
+                const auto it = watches_.find(ev->wd);
+                if (it == watches_.end()) continue;
+                const std::vector<std::string> dirs {it->second};
+                if (ev->mask & IN_IGNORED) {
+                    for (const auto& d : dirs) watched_.erase(d);
+                    watches_.erase(it);
+                }
+                for (const auto& d : dirs) Invalidate(d, ev->len ? fs::path{d} / ev->name : fs::path{d});
+            }
+        }
+    }
+#else
+    DirectoryCache::DirectoryCache() = default;
+    DirectoryCache::~DirectoryCache() = default;
+    void DirectoryCache::Watch(const fs::path&) {}
+    void DirectoryCache::WatchTree(const fs::path&) {}
+    void DirectoryCache::Poll() {}
+#endif
+
+    void DirectoryCache::Invalidate(const fs::path& dir, const fs::path& changed) {
+        // Anything containing the event's folder, and anything at or under the changed entry,
+        // which also covers a Mods symlink being retargeted in its parent
+        const std::string d {dir.generic_string()};
+        const std::string c {changed.generic_string()};
+        std::erase_if(entries_, [&](const auto& kv) { return IsWithin(d, kv.first) || IsWithin(kv.first, c); });
+        if (c == d) return;
+        // A replaced entry may be a different folder now, so its watches are re-added on the next query
+        for (auto it = watched_.begin(); it != watched_.end();) {
+            if (!IsWithin(it->first, c)) { ++it; continue; }
+            std::erase(watches_[it->second], it->first);
+            it = watched_.erase(it);
+        }
+    }
+
+    std::vector<std::string> DirectoryCache::Names(const fs::path& dir) {
+        Poll();
+        const std::string key {Key(dir)};
+        if (Enabled()) {
+            if (const auto it = entries_.find(key); it != entries_.end() && it->second.names) return *it->second.names;
+        }
+        std::vector<std::string> names {utl::GetContentsList(dir)};
+        if (Enabled()) {
+            Watch(dir);
+            Watch(fs::absolute(dir).lexically_normal().parent_path());
+            entries_[key].names = names;
+        }
+        return names;
+    }
+
+    Manifest DirectoryCache::ManifestOf(const fs::path& root) {
+        Poll();
+        const std::string key {Key(root)};
+        if (Enabled()) {
+            if (const auto it = entries_.find(key); it != entries_.end() && it->second.manifest) return *it->second.manifest;
+            // Watch before scanning so nothing changing mid-scan goes unnoticed
+            WatchTree(root);
+            Watch(fs::absolute(root).lexically_normal().parent_path());
+        }
+        Manifest m {Manifest::Scan(root)};
+        if (Enabled()) entries_[key].manifest = m;
+        return m;
+    }
+
+    void DirectoryCache::MarkClean(const fs::path& root, const std::uint64_t generation) {
+        // Only meaningful while the manifest it was compared against is still cached, i.e. watched
+        if (const auto it = entries_.find(Key(root)); it != entries_.end() && it->second.manifest) {
+            it->second.cleanGeneration = generation;
+        }
+    }
+
+    bool DirectoryCache::IsClean(const fs::path& root, const std::uint64_t generation) {
+        Poll();
+        const auto it = entries_.find(Key(root));
+        return it != entries_.end() && it->second.cleanGeneration == generation;
+    }
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "Manifest.hpp"
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vsprofile {
+
+    // Listings and manifests kept in memory by the daemon and dropped when inotify reports a change
+    // underneath them, so repeated queries cost no filesystem walk. Without inotify nothing is cached.
+    class DirectoryCache {
+        struct Entry {
+            std::optional<std::vector<std::string>> names; // top-level, hidden entries skipped
+            std::optional<Manifest> manifest;
+            std::optional<std::uint64_t> cleanGeneration; // manifest matched that activation's record
+        };
+        std::unordered_map<std::string, Entry> entries_; // by lexically normal path
+        // A descriptor can stand for several paths: a Mods symlink and the profile it points at share one
+        std::unordered_map<int, std::vector<std::string>> watches_;
+        std::unordered_map<std::string, int> watched_;
+        int fd_ {-1};
+
+        void Watch(const std::filesystem::path& dir);
+        void WatchTree(const std::filesystem::path& root);
+        void Invalidate(const std::filesystem::path& dir, const std::filesystem::path& changed);
+
+    public:
+        DirectoryCache();
+        ~DirectoryCache();
+        DirectoryCache(const DirectoryCache&) = delete;
+        DirectoryCache& operator=(const DirectoryCache&) = delete;
+
+        [[nodiscard]] bool Enabled() const { return fd_ >= 0; }
+        [[nodiscard]] int Fd() const { return fd_; } // readable when events are pending
+        void Poll(); // drains pending events, never blocks
+
+        [[nodiscard]] std::vector<std::string> Names(const std::filesystem::path& dir);
+        [[nodiscard]] Manifest ManifestOf(const std::filesystem::path& root);
+        // Remembered until inotify reports a change under root
+        void MarkClean(const std::filesystem::path& root, std::uint64_t generation);
+        [[nodiscard]] bool IsClean(const std::filesystem::path& root, std::uint64_t generation);
+    };
+
+}
@@ -0,0 +1,145 @@
+#include "Journal.hpp"
+#include "../Include/json.hpp"
+#include "../Utils/Durability.hpp"
+#include "../Utils/FileUtils.hpp"
+#include <charconv>
+#include <chrono>
+#include <format>
+
+using json = nlohmann::json;
+namespace utl = vsprofile::utils;
+namespace fs = std::filesystem;
+
+namespace vsprofile {
+
+    namespace {
+        constexpr std::string_view kCachesSwapped = "caches";
+        constexpr std::string_view kMoved = "move ";
+        constexpr std::string_view kPlanId = "plan ";
+
+        fs::path PlanPath(const fs::path& dir) { return dir / "plan.json"; }
+        fs::path LogPath(const fs::path& dir) { return dir / "done.log"; }
+
+        std::string_view ToString(const utl::FileOp::Kind kind) {
+            switch (kind) {
+                case utl::FileOp::Kind::MakeDir: return "mkdir";
+                case utl::FileOp::Kind::Link: return "link";
+                case utl::FileOp::Kind::Copy: return "copy";
+                default: return "remove";
+            }
+        }
+
+        utl::FileOp::Kind KindFromString(const std::string_view name) {
+            if (name == "mkdir") return utl::FileOp::Kind::MakeDir;
+            if (name == "link") return utl::FileOp::Kind::Link;
+            if (name == "copy") return utl::FileOp::Kind::Copy;
+            return utl::FileOp::Kind::Remove;
+        }
+    }
+
+    bool ActivationJournal::Begin(const fs::path& dir) const {
+        json listed = json::array();
+        for (const auto& op : ops) {
+            listed.push_back({{"kind", ToString(op.kind)}, {"from", op.from.string()}, {"to", op.to.string()}, {"bytes", op.bytes}});
+        }
+        // Tells this plan's log apart from the one it replaces, even for the same profile and process
+        const std::string id {std::format("{}-{}", pid, std::chrono::system_clock::now().time_since_epoch().count())};
+        json renames = json::array();
+        for (const auto& move : moves) renames.push_back({move.from.string(), move.to.string()});
+        const json j {{"profile", profile}, {"stash", stash.string()}, {"modsFrom", modsFrom.string()},
+                      {"modsLinked", modsLinked}, {"pid", pid}, {"ops", listed}, {"moves", renames},
+                      {"planned", planned}, {"id", id}};
+        std::error_code ec;
+        fs::create_directories(dir, ec);
+        // The plan has to outlive a power loss that the operations it lists might survive; the log
+        // does not, losing lines only means redoing those operations
+        if (!utl::WriteJsonAtomically(PlanPath(dir), j)) return false;
+        // Only now is the older log replaced: until its first line names this plan, none of its
+        // lines count, so a kill in between leaves this plan with nothing marked done
+        std::ofstream log {LogPath(dir), std::ios::trunc};
+        log << kPlanId << id << '\n' << std::flush;
+        return true;
+    }
+
+    std::optional<ActivationJournal> ActivationJournal::Load(const fs::path& dir) {
+        std::ifstream in {PlanPath(dir)};
+        if (!in) return std::nullopt;
+        ActivationJournal journal;
+        std::string planId;
+        try {
+            const json j = json::parse(in);
+            journal.profile = j.at("profile").get<std::string>();
+            journal.stash = j.at("stash").get<std::string>();
+            journal.modsFrom = j.at("modsFrom").get<std::string>();
+            journal.modsLinked = j.at("modsLinked").get<bool>();
+            journal.pid = j.at("pid").get<int>();
+            for (const json& op : j.at("ops")) {
+                journal.ops.push_back({KindFromString(op.at("kind").get<std::string>()), op.at("from").get<std::string>(),
+                                       op.at("to").get<std::string>(), op.at("bytes").get<std::uintmax_t>()});
+            }
+            for (const json& move : j.at("moves")) {
+                journal.moves.push_back({move.at(0).get<std::string>(), move.at(1).get<std::string>()});
+            }
+            journal.planned = j.at("planned").get<bool>();
+            planId = j.value("id", "");
+        }
+        catch (const json::exception&) {
+            return std::nullopt;
+        }
+        journal.done.assign(journal.ops.size(), false);
+        journal.moved.assign(journal.moves.size(), false);
+        std::ifstream log {LogPath(dir)};
+        // A log left from another plan, or not yet started, has nothing this one did
+        if (std::string header; !std::getline(log, header) || planId.empty() || header != std::string{kPlanId} + planId) {
+            return journal;
+        }
+        // A line cut short by the kill does not parse and simply counts as not done
+        for (std::string line; std::getline(log, line);) {
+            if (line == kCachesSwapped) {
+                journal.cachesSwapped = true;
+                continue;
+            }
+            const bool move {line.starts_with(kMoved)};
+            const std::string_view number {std::string_view{line}.substr(move ? kMoved.size() : 0)};
+            std::vector<bool>& flags {move ? journal.moved : journal.done};
+            std::size_t index {};
+            const auto [end, err] {std::from_chars(number.data(), number.data() + number.size(), index)};
+            if (err == std::errc{} && end == number.data() + number.size() && index < flags.size()) flags[index] = true;
+        }
+        return journal;
+    }
+
+    bool ActivationJournal::MoveDone(const std::size_t i) const {
+        if (moved[i]) return true;
+        // Moves run in order, so only the first unlogged one can have run; its target never existed before
+        if (i > 0 && !moved[i - 1]) return false;
+        std::error_code ec;
+        return !fs::exists(moves[i].from, ec) && fs::exists(moves[i].to, ec);
+    }
+
+    void ActivationJournal::Discard(const fs::path& dir) {
+        std::error_code ec;
+        fs::remove(PlanPath(dir), ec);
+        fs::remove(LogPath(dir), ec);
+    }
+
+    JournalLog::JournalLog(const fs::path& dir) : path_(LogPath(dir)), out_(path_, std::ios::app) {}
+
+    void JournalLog::Done(const std::size_t op) {
+        // Flushed line by line: a killed process loses nothing the kernel already has
+        std::scoped_lock lock {mtx_};
+        out_ << op << '\n' << std::flush;
+    }
+
+    void JournalLog::Moved(const std::size_t move) {
+        std::scoped_lock lock {mtx_};
+        out_ << kMoved << move << '\n' << std::flush;
+        if (utl::CurrentDurability() != utl::Durability::None) utl::SyncFile(path_);
+    }
+
+    void JournalLog::CachesSwapped() {
+        std::scoped_lock lock {mtx_};
+        out_ << kCachesSwapped << '\n' << std::flush;
+    }
+
+}
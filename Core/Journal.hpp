@@ -0,0 +1,58 @@
+#pragma once
+#include "../Utils/SyncPlan.hpp"
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace vsprofile {
+
+    // Write-ahead record of an activation in progress. The plan is written out before its first
+    // operation runs and every operation that completes is appended to a log beside it, so an
+    // activation that was killed part way is finished (or undone) on the next start by redoing only
+    // the operations that never completed. The renames that set Mods up for the plan come first,
+    // journaled on their own before any of them runs; cut short there, they are undone instead.
+    struct ActivationJournal {
+        struct Move {
+            std::filesystem::path from;
+            std::filesystem::path to; // never exists before the move
+        };
+
+        std::string profile;           // being activated
+        std::filesystem::path stash;   // where the outgoing folders are captured
+        std::filesystem::path modsFrom; // where the outgoing Mods can be restored from on roll back
+        bool modsLinked {false};       // the outgoing Mods was a link to modsFrom rather than a folder
+        int pid {-1};                  // process running the activation
+        std::vector<utils::FileOp> ops;
+        std::vector<bool> done;        // filled in from the log by Load
+        std::vector<Move> moves;       // in order, before the plan
+        std::vector<bool> moved;       // filled in from the log by Load
+        bool planned {true};           // false while only the moves are journaled
+        bool cachesSwapped {false};    // the caches already moved to the incoming profile
+
+        // Whether moves[i] ran: logged, or the one the kill may have cut off before its line was written
+        [[nodiscard]] bool MoveDone(std::size_t i) const;
+
+        // Writes the plan, then starts an empty log tied to it, replacing any earlier journal in `dir`
+        bool Begin(const std::filesystem::path& dir) const;
+        [[nodiscard]] static std::optional<ActivationJournal> Load(const std::filesystem::path& dir);
+        static void Discard(const std::filesystem::path& dir);
+    };
+
+    // Appends to the log of the journal in `dir`, from any of the threads running its plan
+    class JournalLog {
+        std::filesystem::path path_;
+        std::ofstream out_;
+        std::mutex mtx_;
+
+    public:
+        explicit JournalLog(const std::filesystem::path& dir); // the log Begin started; open it after Begin
+
+        void Done(std::size_t op);
+        void Moved(std::size_t move); // made durable, the moves that follow rely on it to be undone
+        void CachesSwapped();
+    };
+
+}
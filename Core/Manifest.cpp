@@ -0,0 +1,110 @@
+#include "Manifest.hpp"
+#include "../Utils/DirectoryScan.hpp"
+#include "../Utils/FileUtils.hpp"
+#include "../Utils/TextUtils.hpp"
+#include <algorithm>
+#include <fstream>
+
+namespace utl = vsprofile::utils;
+namespace fs = std::filesystem;
+
+namespace vsprofile {
+
+    namespace {
+        void ScanInto(const fs::path& dir, const std::string& prefix, std::vector<ManifestEntry>& out) {
+            std::error_code ec;
+            for (const utl::DirEntry& e : utl::DirectoryScan::Read(dir, utl::ScanDetail::Stats, ec)) {
+                if (utl::IsHiddenEntry(e.name)) continue;
+                std::string rel {prefix};
+                rel += e.name;
+                if (e.IsDirectory()) ScanInto(dir / e.name, rel + '/', out);
+                else if (e.IsFile()) out.push_back({std::move(rel), e.size, e.mtime});
+            }
+        }
+    }
+
+    Manifest Manifest::Scan(const fs::path& root) {
+        Manifest m;
+        ScanInto(root, {}, m.entries);
+        std::ranges::sort(m.entries, {}, &ManifestEntry::path); // "a/b" and "a-b" interleave differently than per folder
+        return m;
+    }
+
+    std::optional<Manifest> Manifest::Load(const fs::path& path) {
+        std::ifstream in {path};
+        if (!in) return std::nullopt;
+        try {
+            Manifest m;
+            m.entries = json::parse(in).at("entries").get<std::vector<ManifestEntry>>();
+            std::ranges::sort(m.entries, {}, &ManifestEntry::path);
+            return m;
+        }
+        catch (const json::exception&) {
+            return std::nullopt;
+        }
+    }
+
+    bool Manifest::Save(const fs::path& path) const {
+        return utl::WriteJsonAtomically(path, json{{"entries", entries}});
+    }
+
+    std::optional<ModsState> ModsState::Load(const fs::path& path) {
+        std::ifstream in {path};
+        if (!in) return std::nullopt;
+        try {
+            const json j = json::parse(in);
+            ModsState s;
+            s.profile = j.at("profile").get<std::string>();
+            s.generation = j.at("generation").get<std::uint64_t>();
+            s.manifest.entries = j.at("entries").get<std::vector<ManifestEntry>>();
+            std::ranges::sort(s.manifest.entries, {}, &ManifestEntry::path);
+            return s;
+        }
+        catch (const json::exception&) {
+            return std::nullopt;
+        }
+    }
+
+    bool ModsState::Save(const fs::path& path) const {
+        return utl::WriteJsonAtomically(path, json{{"profile", profile}, {"generation", generation}, {"entries", manifest.entries}});
+    }
+
+    ManifestDiff Diff(const Manifest& before, const Manifest& after) {
+        ManifestDiff d;
+        auto a = before.entries.begin();
+        auto b = after.entries.begin();
+        while (a != before.entries.end() || b != after.entries.end()) {
+            if (b == after.entries.end() || (a != before.entries.end() && a->path < b->path)) {
+                d.removed.push_back((a++)->path);
+            } else if (a == before.entries.end() || b->path < a->path) {
+                d.added.push_back((b++)->path);
+            } else {
+                if (a->size != b->size || a->mtime != b->mtime) d.changed.push_back(b->path);
+                ++a;
+                ++b;
+            }
+        }
+        return d;
+    }
+
+    void ManifestDiff::Print() const {
+        for (const auto& p : added) utl::PrintLog(std::format("+ {}\n", p));
+        for (const auto& p : removed) utl::PrintLog(std::format("- {}\n", p));
+        for (const auto& p : changed) utl::PrintLog(std::format("~ {}\n", p));
+    }
+
+    void to_json(json& j, const ManifestEntry& e) {
+        j = json{
+                {"path",  e.path},
+                {"size",  e.size},
+                {"mtime", e.mtime},
+        };
+    }
+
+    void from_json(const json& j, ManifestEntry& e) {
+        e.path = j.at("path").get<std::string>();
+        e.size = j.at("size").get<std::uintmax_t>();
+        e.mtime = j.at("mtime").get<long long>();
+    }
+
+}
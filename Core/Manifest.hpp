@@ -0,0 +1,52 @@
+#pragma once
+#include "../Include/json.hpp"
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace vsprofile {
+
+    struct ManifestEntry {
+        std::string path; // relative, generic separators
+        std::uintmax_t size {};
+        long long mtime {};
+    };
+
+    // Metadata-only snapshot of a folder's files, taken with stat calls and no reads
+    struct Manifest {
+        std::vector<ManifestEntry> entries; // sorted by path
+
+        [[nodiscard]] static Manifest Scan(const std::filesystem::path& root);
+        [[nodiscard]] static std::optional<Manifest> Load(const std::filesystem::path& path);
+        bool Save(const std::filesystem::path& path) const;
+    };
+
+    // What Mods held when a profile was last applied to it or captured from it. The generation grows
+    // with every activation, so a cached "still clean" answer is tied to one specific activation.
+    struct ModsState {
+        std::string profile;
+        std::uint64_t generation {};
+        Manifest manifest;
+
+        [[nodiscard]] static std::optional<ModsState> Load(const std::filesystem::path& path);
+        bool Save(const std::filesystem::path& path) const;
+    };
+
+    struct ManifestDiff {
+        std::vector<std::string> added;
+        std::vector<std::string> removed;
+        std::vector<std::string> changed;
+
+        [[nodiscard]] bool Empty() const { return added.empty() && removed.empty() && changed.empty(); }
+        void Print() const;
+    };
+
+    [[nodiscard]] ManifestDiff Diff(const Manifest& before, const Manifest& after);
+
+    void to_json(json& j, const ManifestEntry& e);
+    void from_json(const json& j, ManifestEntry& e);
+
+}
@@ -0,0 +1,202 @@
+#include "MerkleTree.hpp"
+#include "../Utils/DirectoryScan.hpp"
+#include "../Utils/FileUtils.hpp"
+#include "../Utils/HashUtils.hpp"
+#include "../Utils/WorkStealing.hpp"
+#include <algorithm>
+#include <fstream>
+
+namespace utl = vsprofile::utils;
+namespace fs = std::filesystem;
+
+namespace vsprofile {
+
+    namespace {
+        constexpr std::size_t kHashBufferSize = 1 << 20;
+
+        struct PendingHash {
+            MerkleNode* node;
+            fs::path path;
+        };
+
+        const MerkleNode* FindChild(const MerkleNode* parent, const std::string_view name) {
+            if (!parent) return nullptr;
+            const auto it = std::ranges::lower_bound(parent->children, name, {}, &MerkleNode::name);
+            return it != parent->children.end() && it->name == name ? &*it : nullptr;
+        }
+
+        const KnownHash* FindKnown(const KnownHashes* known, const std::string& path) {
+            if (!known) return nullptr;
+            const auto it = known->files.find(path);
+            return it != known->files.end() ? &it->second : nullptr;
+        }
+
+        // Lays out the tree from one stat walk and queues the files whose hash cannot be reused
+        void Scan(const fs::path& dir, const std::string& prefix, MerkleNode& node, const MerkleNode* previous,
+                  const MerkleTree::Rehash rehash, const KnownHashes* known) {
+            std::error_code ec;
+            for (const utl::DirEntry& e : utl::DirectoryScan::Read(dir, utl::ScanDetail::Stats, ec)) {
+                if (utl::IsHiddenEntry(e.name) || (!e.IsFile() && !e.IsDirectory())) continue;
+                const MerkleNode* before {FindChild(previous, e.name)};
+                if (before && before->directory != e.IsDirectory()) before = nullptr;
+                MerkleNode& added {node.children.emplace_back()};
+                added.name = e.name;
+                added.directory = e.IsDirectory();
+                const std::string path {prefix + added.name};
+                if (added.directory) {
+                    Scan(dir / e.name, path + '/', added, before, rehash, known);
+                    continue;
+                }
+                added.size = e.size;
+                added.mtime = e.mtime;
+                if (rehash != MerkleTree::Rehash::Changed) continue;
+                if (before && before->size == e.size && before->mtime == e.mtime) {
+                    added.hash = before->hash;
+                } else if (const KnownHash* copied {FindKnown(known, path)}; copied && copied->size == e.size && copied->mtime == e.mtime) {
+                    added.hash = copied->hash;
+                }
+            }
+        }
+
+        void CollectPending(const fs::path& dir, MerkleNode& node, std::vector<PendingHash>& pending) {
+            for (auto& child : node.children) {
+                if (child.directory) CollectPending(dir / child.name, child, pending);
+                else if (child.hash.empty()) pending.push_back({&child, dir / child.name});
+            }
+        }
+
+        std::string HashFile(const fs::path& path) {
+            std::ifstream in {path, std::ios::binary};
+            std::vector<char> buffer(kHashBufferSize);
+            utl::Murmur3Hasher hasher;
+            while (in) {
+                in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                hasher.Update(buffer.data(), static_cast<std::size_t>(in.gcount()));
+            }
+            return hasher.Hex();
+        }
+
+        void HashFolders(MerkleNode& node) {
+            utl::Murmur3Hasher hasher;
+            node.size = 0;
+            for (auto& child : node.children) {
+                if (child.directory) HashFolders(child);
+                hasher.Update(child.name).Update(std::string_view{child.directory ? "\0d" : "\0f", 2}).Update(child.hash);
+                node.size += child.size;
+            }
+            node.hash = hasher.Hex();
+        }
+
+        std::size_t CountFiles(const MerkleNode& node) {
+            std::size_t count {};
+            for (const auto& child : node.children) count += child.directory ? CountFiles(child) : 1;
+            return count;
+        }
+
+        void DiffNodes(const MerkleNode& a, const MerkleNode& b, const std::string& prefix, ManifestDiff& d) {
+            if (a.hash == b.hash) return;
+            auto ia = a.children.begin();
+            auto ib = b.children.begin();
+            auto gone = [&](const MerkleNode& n) { d.removed.push_back(prefix + n.name + (n.directory ? "/" : "")); };
+            auto added = [&](const MerkleNode& n) { d.added.push_back(prefix + n.name + (n.directory ? "/" : "")); };
+            while (ia != a.children.end() || ib != b.children.end()) {
+                if (ib == b.children.end() || (ia != a.children.end() && ia->name < ib->name)) {
+                    gone(*ia++);
+                } else if (ia == a.children.end() || ib->name < ia->name) {
+                    added(*ib++);
+                } else {
+                    if (ia->directory && ib->directory) {
+                        DiffNodes(*ia, *ib, prefix + ia->name + '/', d);
+                    } else if (ia->directory != ib->directory) {
+                        gone(*ia);
+                        added(*ib);
+                    } else if (ia->hash != ib->hash) {
+                        d.changed.push_back(prefix + ia->name);
+                    }
+                    ++ia;
+                    ++ib;
+                }
+            }
+        }
+    }
+
+    MerkleTree MerkleTree::Build(const fs::path& dir, const MerkleTree* previous, const Rehash rehash, const KnownHashes* known) {
+        MerkleTree tree;
+        tree.root.directory = true;
+        std::vector<PendingHash> pending;
+        Scan(dir, {}, tree.root, previous ? &previous->root : nullptr, rehash, known);
+        // Collected after the walk: children vectors no longer move, so the node pointers stay valid
+        CollectPending(dir, tree.root, pending);
+        utl::WorkStealingPool<PendingHash>{}.Run(std::move(pending), [](PendingHash& p, auto&&) {
+            p.node->hash = HashFile(p.path);
+        });
+        HashFolders(tree.root);
+        return tree;
+    }
+
+    std::optional<MerkleTree> MerkleTree::Load(const fs::path& path) {
+        std::ifstream in {path};
+        if (!in) return std::nullopt;
+        try {
+            MerkleTree tree;
+            tree.root = json::parse(in).get<MerkleNode>();
+            return tree;
+        }
+        catch (const json::exception&) {
+            return std::nullopt;
+        }
+    }
+
+    bool MerkleTree::Save(const fs::path& path) const {
+        return utl::WriteJsonAtomically(path, json(root));
+    }
+
+    KnownHashes KnownHashes::Load(const fs::path& path) {
+        KnownHashes known;
+        std::ifstream in {path};
+        if (!in) return known;
+        try {
+            const json j = json::parse(in);
+            for (const auto& [file, entry] : j.items()) {
+                known.files[file] = {entry.at("size").get<std::uintmax_t>(), entry.at("mtime").get<long long>(),
+                                     entry.at("hash").get<std::string>()};
+            }
+        }
+        catch (const json::exception&) {
+            known.files.clear(); // only a cache of reads saved, nothing is lost
+        }
+        return known;
+    }
+
+    bool KnownHashes::Save(const fs::path& path) const {
+        json j = json::object();
+        for (const auto& [file, entry] : files) j[file] = {{"size", entry.size}, {"mtime", entry.mtime}, {"hash", entry.hash}};
+        return utl::WriteJsonAtomically(path, j);
+    }
+
+    std::size_t MerkleTree::FileCount() const {
+        return CountFiles(root);
+    }
+
+    ManifestDiff Diff(const MerkleTree& before, const MerkleTree& after) {
+        ManifestDiff d;
+        DiffNodes(before.root, after.root, {}, d);
+        return d;
+    }
+
+    void to_json(json& j, const MerkleNode& n) {
+        j = json{{"name", n.name}, {"hash", n.hash}, {"size", n.size}};
+        if (n.directory) j["children"] = n.children;
+        else j["mtime"] = n.mtime;
+    }
+
+    void from_json(const json& j, MerkleNode& n) {
+        n.name = j.at("name").get<std::string>();
+        n.hash = j.at("hash").get<std::string>();
+        n.size = j.at("size").get<std::uintmax_t>();
+        n.directory = j.contains("children");
+        if (n.directory) n.children = j.at("children").get<std::vector<MerkleNode>>();
+        else n.mtime = j.at("mtime").get<long long>();
+    }
+
+}
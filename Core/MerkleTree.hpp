@@ -0,0 +1,66 @@
+#pragma once
+#include "../Include/json.hpp"
+#include "Manifest.hpp"
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace vsprofile {
+
+    // A folder's content hashes arranged as a tree: a file hashes its bytes, a folder hashes its
+    // children's names and hashes. Equal hashes mean equal subtrees, so comparisons only descend
+    // where something differs.
+    struct MerkleNode {
+        std::string name;
+        bool directory {};
+        std::string hash;             // Murmur3 128, hex
+        std::uintmax_t size {};       // bytes, summed over the subtree for folders
+        long long mtime {};           // files only, lets an unchanged file keep its hash
+        std::vector<MerkleNode> children; // folders only, sorted by name
+
+        bool operator==(const MerkleNode&) const = default;
+    };
+
+    // Hashes taken while files were copied in, by path relative to the tree's folder, so building the
+    // tree does not read them again. Trusted while size and mtime match, like a previous tree's hashes.
+    struct KnownHash {
+        std::uintmax_t size {};
+        long long mtime {};
+        std::string hash;
+    };
+
+    struct KnownHashes {
+        std::map<std::string, KnownHash> files;
+
+        [[nodiscard]] static KnownHashes Load(const std::filesystem::path& path); // empty when missing
+        bool Save(const std::filesystem::path& path) const;
+    };
+
+    struct MerkleTree {
+        MerkleNode root;
+
+        enum class Rehash {
+            Changed, // reuse the previous hash of files whose size and mtime are unchanged
+            All,     // read every file again, to catch corruption that left the metadata alone
+        };
+
+        // Hidden entries are skipped like everywhere else; the files to hash are read in parallel
+        [[nodiscard]] static MerkleTree Build(const std::filesystem::path& dir, const MerkleTree* previous,
+                                              Rehash rehash = Rehash::Changed, const KnownHashes* known = nullptr);
+        [[nodiscard]] static std::optional<MerkleTree> Load(const std::filesystem::path& path);
+        bool Save(const std::filesystem::path& path) const;
+        [[nodiscard]] std::size_t FileCount() const;
+    };
+
+    // Paths that differ, visiting only subtrees whose hashes differ. A folder present on one side
+    // only is reported as one entry with a trailing '/'.
+    [[nodiscard]] ManifestDiff Diff(const MerkleTree& before, const MerkleTree& after);
+
+    void to_json(json& j, const MerkleNode& n);
+    void from_json(const json& j, MerkleNode& n);
+
+}
@@ -0,0 +1,280 @@
+#include "Perf.hpp"
+#include "../Utils/AppConstants.hpp"
+#include "../Utils/ProcessUtils.hpp"
+#include "../Utils/TextUtils.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <charconv>
+#include <condition_variable>
+#include <mutex>
+#include <ranges>
+#include <thread>
+
+namespace utl = vsprofile::utils;
+
+namespace vsprofile {
+
+    namespace {
+        constexpr std::string_view kBaseGame = "(base game)";
+        constexpr std::string_view kStartupPhase = "process startup";
+
+        // First match wins, so more specific keywords come first
+        constexpr std::array<std::pair<std::string_view, std::string_view>, 17> kPhaseKeywords {{
+                {"compil",      "compiling mods"},
+                {"sorted by dependency", "mod discovery"},
+                {"discover",    "asset discovery"},
+                {"mod system",  "mod systems"},
+                {"modsystem",   "mod systems"},
+                {"patch",       "json patches"},
+                {"texture",     "textures"},
+                {"atlas",       "textures"},
+                {"shader",      "shaders"},
+                {"sound",       "sounds"},
+                {"recipe",      "recipes"},
+                {"entit",       "entities"},
+                {"block",       "blocks & items"},
+                {"item",        "blocks & items"},
+                {"asset",       "assets"},
+                {"chunk",       "world loading"},
+                {"world",       "world loading"},
+        }};
+
+        // Lines after which the game is considered started
+        constexpr std::array<std::string_view, 3> kReadyMarkers {
+                "received level finalize",
+                "dedicated server now running",
+                "server ready",
+        };
+
+        std::string ToLower(std::string_view s) {
+            std::string out {s};
+            std::ranges::transform(out, out.begin(), [](unsigned char c) { return std::tolower(c); });
+            return out;
+        }
+
+        bool IsWordChar(char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; }
+
+        bool ContainsWord(std::string_view hay, std::string_view needle) {
+            for (std::size_t pos = hay.find(needle); pos != std::string_view::npos; pos = hay.find(needle, pos + 1)) {
+                const bool startOk = pos == 0 || !IsWordChar(hay[pos - 1]);
+                const std::size_t end = pos + needle.size();
+                const bool endOk = end == hay.size() || !IsWordChar(hay[end]);
+                if (startOk && endOk) return true;
+            }
+            return false;
+        }
+
+        std::string_view DetectPhase(std::string_view lowerLine) {
+            for (const auto& [keyword, phase] : kPhaseKeywords) {
+                if (lowerLine.find(keyword) != std::string_view::npos) return phase;
+            }
+            return {};
+        }
+
+        template <typename T>
+        bool ReadNumber(std::string_view& s, T& out, char sep) {
+            auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+            if (ec != std::errc{}) return false;
+            s.remove_prefix(ptr - s.data());
+            if (sep) {
+                if (s.empty() || s.front() != sep) return false;
+                s.remove_prefix(1);
+            }
+            return true;
+        }
+
+        std::vector<PerfBucket> Ranked(const std::unordered_map<std::string, PerfBucket>& buckets) {
+            std::vector<PerfBucket> out;
+            out.reserve(buckets.size());
+            for (const auto& b : buckets | std::views::values) out.push_back(b);
+            std::ranges::sort(out, [](const PerfBucket& a, const PerfBucket& b) { return a.ms > b.ms; });
+            return out;
+        }
+
+        void PrintTable(std::string_view title, const std::vector<PerfBucket>& rows, double totalMs, std::size_t top) {
+            std::cout << utl::Bold(std::format("[{}]\n", title));
+            std::size_t rank = 0;
+            for (const auto& row : rows) {
+                if (++rank > top) break;
+                const double share = totalMs > 0 ? 100.0 * row.ms / totalMs : 0.0;
+                std::cout << std::format("{:>3}. {:<40} {:>10.1f} ms {:>6.1f}%\n", rank, row.name, row.ms, share);
+            }
+            if (rows.size() > top) utl::PrintLog(std::format("     … {} more\n", rows.size() - top));
+        }
+    }
+
+    std::optional<double> ParseLogTimestampMs(std::string_view line) {
+        unsigned day {}, month {}, hour {}, minute {}, second {}, millis {};
+        int year {};
+        std::string_view s {line};
+        if (!ReadNumber(s, day, '.') || !ReadNumber(s, month, '.') || !ReadNumber(s, year, ' ')) return std::nullopt;
+        if (!ReadNumber(s, hour, ':') || !ReadNumber(s, minute, ':') || !ReadNumber(s, second, '\0')) return std::nullopt;
+        if (!s.empty() && s.front() == '.') {
+            s.remove_prefix(1);
+            if (!ReadNumber(s, millis, '\0')) return std::nullopt;
+        }
+        namespace ch = std::chrono;
+        const ch::year_month_day ymd {ch::year{year}, ch::month{month}, ch::day{day}};
+        if (!ymd.ok() || hour > 23 || minute > 59 || second > 60) return std::nullopt;
+        const auto tp = ch::sys_days{ymd} + ch::hours{hour} + ch::minutes{minute} + ch::seconds{second};
+        return static_cast<double>(ch::duration_cast<ch::milliseconds>(tp.time_since_epoch()).count() + millis);
+    }
+
+    StartupProfiler::StartupProfiler(const std::vector<std::string>& modFiles) {
+        for (const auto& file : modFiles) {
+            const std::string stem = ToLower(std::filesystem::path(file).stem().string());
+            if (stem.size() >= 3) keys_.push_back({stem, file});
+            // Strip a trailing version, e.g. "carryon_v1.7.2" -> "carryon"
+            for (std::size_t i = 1; i + 1 < stem.size(); ++i) {
+                const char next = stem[i + 1];
+                if ((stem[i] == '_' || stem[i] == '-' || stem[i] == ' ') && (next == 'v' || std::isdigit(static_cast<unsigned char>(next)))) {
+                    if (i >= 3) keys_.push_back({stem.substr(0, i), file});
+                    break;
+                }
+            }
+        }
+        std::ranges::sort(keys_, [](const ModKey& a, const ModKey& b) { return a.key.size() > b.key.size(); });
+    }
+
+    std::string StartupProfiler::MatchMod(std::string_view lowerLine) const {
+        for (const auto& [key, mod] : keys_) {
+            if (ContainsWord(lowerLine, key)) return mod;
+        }
+        return std::string{kBaseGame};
+    }
+
+    void StartupProfiler::MarkStart(const double ms) {
+        firstMs_ = lastMs_ = ms;
+        lastMod_ = kBaseGame;
+        lastPhase_ = kStartupPhase;
+    }
+
+    void StartupProfiler::Feed(std::string_view line, const std::optional<double> arrivalMs) {
+        if (ready_) return;
+        const std::optional<double> stamped = ParseLogTimestampMs(line);
+        const std::optional<double> ms = arrivalMs ? arrivalMs : stamped;
+        if (!ms) return; // continuation lines (stack traces, wrapped messages) carry no timing
+
+        if (lastMs_) {
+            const double delta = std::max(0.0, *ms - *lastMs_);
+            auto& mod = mods_[lastMod_];
+            mod.name = lastMod_;
+            mod.ms += delta;
+            ++mod.lines;
+            auto& phase = phases_[lastPhase_];
+            phase.name = lastPhase_;
+            phase.ms += delta;
+            ++phase.lines;
+        }
+        if (!firstMs_) firstMs_ = ms;
+        lastMs_ = ms;
+
+        const std::string lower = ToLower(line);
+        // A continuation line timed on arrival still belongs to the message it continues, whatever it names
+        if (stamped) {
+            lastMod_ = MatchMod(lower);
+            // Phases are sticky: a line that names no phase continues the current one
+            if (const auto phase = DetectPhase(lower); !phase.empty()) lastPhase_ = phase;
+        }
+        if (lastMod_.empty()) lastMod_ = kBaseGame;
+        if (lastPhase_.empty()) lastPhase_ = kStartupPhase;
+
+        ready_ = std::ranges::any_of(kReadyMarkers, [&](std::string_view m) { return lower.find(m) != std::string::npos; });
+    }
+
+    StartupReport StartupProfiler::Finish(std::string profile) const {
+        StartupReport report;
+        report.profile = std::move(profile);
+        report.reachedReady = ready_;
+        if (firstMs_ && lastMs_) report.totalMs = *lastMs_ - *firstMs_;
+        report.mods = Ranked(mods_);
+        report.phases = Ranked(phases_);
+        return report;
+    }
+
+    std::optional<StartupReport> ProfileLaunch(const std::filesystem::path& exe, const std::vector<std::string>& args,
+                                               StartupProfiler& profiler, std::string profile,
+                                               std::vector<utl::ResourceSample>* samples) {
+        namespace ch = std::chrono;
+        utl::PrintLog(std::format("Launching '{}'\n", exe.string()));
+        const auto start = ch::steady_clock::now();
+        utl::ChildProcess game {utl::ChildProcess::Spawn(exe, args)};
+        if (!game.Valid()) {
+            utl::PrintErr(std::format("Failed to launch '{}'.\n", exe.string()));
+            return std::nullopt;
+        }
+        profiler.MarkStart(0.0);
+        std::optional<utl::ResourceSampler> sampler;
+        if (samples) sampler.emplace(game.Pid(), constants::kResourceSampleInterval);
+
+        // Stop the game if it never reports being ready
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool done {false};
+        std::thread watchdog {[&] {
+            std::unique_lock lock {mtx};
+            if (!cv.wait_for(lock, constants::kPerfTimeout, [&] { return done; })) {
+                utl::PrintWarn("Startup timed out, stopping the game.\n");
+                game.Terminate();
+                // A game ignoring the request keeps its output open, which would block the reader for good
+                if (!cv.wait_for(lock, constants::kTerminateGrace, [&] { return done; })) game.Kill();
+            }
+        }};
+
+        // VmHWM is gone once the process exits, so poll it while output is flowing
+        long long peakRssKb {};
+        auto lastRssPoll = start - ch::seconds{1};
+        std::string line;
+        while (game.ReadLine(line)) {
+            const auto now = ch::steady_clock::now();
+            profiler.Feed(line, ch::duration<double, std::milli>{now - start}.count());
+            if (profiler.ReachedReady() || now - lastRssPoll >= ch::milliseconds{100}) {
+                peakRssKb = std::max(peakRssKb, utl::PeakRssKb(game.Pid()));
+                lastRssPoll = now;
+            }
+            if (profiler.ReachedReady()) {
+                game.Terminate();
+                break;
+            }
+        }
+        { std::lock_guard lock {mtx}; done = true; }
+        cv.notify_one();
+        watchdog.join();
+        if (sampler) *samples = sampler->Stop();
+        game.Wait();
+
+        StartupReport report {profiler.Finish(std::move(profile))};
+        report.peakRssKb = peakRssKb;
+        return report;
+    }
+
+    void StartupReport::Print(const std::size_t top) const {
+        std::cout << utl::Bold(std::format("[Startup profile of '{}': {:.1f} s]\n", profile.empty() ? "none" : profile, totalMs / 1000.0));
+        if (!reachedReady) utl::PrintWarn("Game did not report being ready, the profile covers the log up to its end.\n");
+        if (peakRssKb > 0) std::cout << std::format("Peak RSS: {:.1f} MiB\n", static_cast<double>(peakRssKb) / 1024.0);
+        PrintTable("Mods", mods, totalMs, top);
+        PrintTable("Phases", phases, totalMs, top);
+    }
+
+    void to_json(json& j, const PerfBucket& b) {
+        j = json{
+                {"name",  b.name},
+                {"ms",    b.ms},
+                {"lines", b.lines},
+        };
+    }
+
+    void to_json(json& j, const StartupReport& r) {
+        j = json{
+                {"profile",      r.profile},
+                {"totalMs",      r.totalMs},
+                {"reachedReady", r.reachedReady},
+                {"peakRssKb",    r.peakRssKb},
+                {"mods",         r.mods},
+                {"phases",       r.phases},
+        };
+    }
+
+}
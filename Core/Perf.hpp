@@ -0,0 +1,74 @@
+#pragma once
+#include "../Include/json.hpp"
+#include "../Utils/ResourceSampler.hpp"
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace vsprofile {
+
+    struct PerfBucket {
+        std::string name;
+        double ms {};
+        std::size_t lines {};
+    };
+
+    struct StartupReport {
+        std::string profile;
+        double totalMs {};
+        bool reachedReady {};
+        long long peakRssKb {}; // 0 when not measured
+        std::vector<PerfBucket> mods;   // ranked, most expensive first
+        std::vector<PerfBucket> phases; // ranked, most expensive first
+
+        void Print(std::size_t top = 15) const;
+    };
+
+    void to_json(json& j, const PerfBucket& b);
+    void to_json(json& j, const StartupReport& r);
+
+    // Streaming startup profiler: the time between two timestamped log lines is charged to the mod
+    // and loading phase named by the earlier line, so a live game can be fed while it is still loading.
+    class StartupProfiler {
+        struct ModKey {
+            std::string key; // lowercase token searched for in log lines
+            std::string mod; // mod file it belongs to
+        };
+        std::vector<ModKey> keys_; // longest first
+        std::unordered_map<std::string, PerfBucket> mods_;
+        std::unordered_map<std::string, PerfBucket> phases_;
+        std::optional<double> firstMs_;
+        std::optional<double> lastMs_;
+        std::string lastMod_;
+        std::string lastPhase_;
+        bool ready_ {};
+
+        [[nodiscard]] std::string MatchMod(std::string_view lowerLine) const;
+
+    public:
+        explicit StartupProfiler(const std::vector<std::string>& modFiles);
+
+        void MarkStart(double ms);
+        // arrivalMs overrides the log timestamp, which only has second resolution
+        void Feed(std::string_view line, std::optional<double> arrivalMs = std::nullopt);
+        [[nodiscard]] bool ReachedReady() const { return ready_; }
+        [[nodiscard]] StartupReport Finish(std::string profile) const;
+    };
+
+    // Launches exe and feeds its output to the profiler until the game is ready, exits or times out.
+    // Resource usage is sampled into samples when given. Returns nothing if the executable could not be started.
+    [[nodiscard]] std::optional<StartupReport> ProfileLaunch(const std::filesystem::path& exe,
+                                                             const std::vector<std::string>& args,
+                                                             StartupProfiler& profiler,
+                                                             std::string profile,
+                                                             std::vector<utils::ResourceSample>* samples = nullptr);
+
+    // Parses the "d.M.yyyy HH:mm:ss[.fff]" prefix of Vintage Story log lines into ms since epoch
+    [[nodiscard]] std::optional<double> ParseLogTimestampMs(std::string_view line);
+
+}
@@ -0,0 +1,57 @@
+#include "ProfileStats.hpp"
+#include "../Include/json.hpp"
+#include <fstream>
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+namespace ch = std::chrono;
+
+namespace vsprofile {
+
+    void ProfileStats::Touch(const std::string& name, const ch::system_clock::time_point when) {
+        profiles[name].lastUsed = ch::duration_cast<ch::seconds>(when.time_since_epoch()).count();
+    }
+
+    void ProfileStats::RecordActivation(const std::string& name, const ch::milliseconds took, const std::uintmax_t bytes) {
+        ProfileUsage& usage {profiles[name]};
+        ++usage.activations;
+        usage.lastMs = static_cast<std::uint32_t>(took.count());
+        usage.totalMs += static_cast<std::uint64_t>(took.count());
+        usage.bytesMoved += bytes;
+    }
+
+    std::optional<ch::system_clock::time_point> ProfileStats::LastUsed(const std::string& name) const {
+        const auto it {profiles.find(name)};
+        if (it == profiles.end() || it->second.lastUsed == 0) return std::nullopt;
+        return ch::system_clock::time_point{ch::seconds{it->second.lastUsed}};
+    }
+
+    fs::path ProfileStats::PathFor(const fs::path& configPath) {
+        return configPath.parent_path() / "Stats.json";
+    }
+
+    ProfileStats ProfileStats::Load(const fs::path& path) {
+        ProfileStats stats;
+        std::ifstream in {path};
+        if (!in) return stats;
+        try {
+            const json j = json::parse(in);
+            // One [activations, lastUsed, lastMs, totalMs, bytesMoved] row per profile
+            for (const auto& [name, row] : j.at("profiles").items()) {
+                stats.profiles[name] = {row.at(0).get<std::uint32_t>(), row.at(1).get<std::int64_t>(), row.at(2).get<std::uint32_t>(),
+                                        row.at(3).get<std::uint64_t>(), row.at(4).get<std::uintmax_t>()};
+            }
+        }
+        catch (const json::exception&) {
+            stats.profiles.clear(); // only informs decisions, starting over is harmless
+        }
+        return stats;
+    }
+
+    std::string ProfileStats::Serialise() const {
+        json rows = json::object();
+        for (const auto& [name, u] : profiles) rows[name] = json::array({u.activations, u.lastUsed, u.lastMs, u.totalMs, u.bytesMoved});
+        return json{{"profiles", rows}}.dump() + '\n';
+    }
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+
+namespace vsprofile {
+
+    struct ProfileUsage {
+        std::uint32_t activations {};
+        std::int64_t lastUsed {};     // seconds since the epoch it was last activated or saved, 0 for never
+        std::uint32_t lastMs {};      // how long its last activation took
+        std::uint64_t totalMs {};     // over all its activations, for the average
+        std::uintmax_t bytesMoved {}; // copied by its activations
+    };
+
+    // How each profile has been used, kept in its own file beside the config and written with it, so
+    // decisions on what to keep, stage or pack can go by more than the capped activation history.
+    // Best-effort: a lost, stale or unreadable file only makes those decisions start over
+    struct ProfileStats {
+        std::map<std::string, ProfileUsage> profiles;
+
+        void Touch(const std::string& name, std::chrono::system_clock::time_point when);
+        void RecordActivation(const std::string& name, std::chrono::milliseconds took, std::uintmax_t bytes);
+        [[nodiscard]] std::optional<std::chrono::system_clock::time_point> LastUsed(const std::string& name) const;
+
+        [[nodiscard]] static std::filesystem::path PathFor(const std::filesystem::path& configPath);
+        [[nodiscard]] static ProfileStats Load(const std::filesystem::path& path);
+        [[nodiscard]] std::string Serialise() const;
+    };
+
+}
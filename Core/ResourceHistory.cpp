@@ -0,0 +1,211 @@
+#include "ResourceHistory.hpp"
+#include "Manifest.hpp"
+#include "../Utils/AppConstants.hpp"
+#include "../Utils/HashUtils.hpp"
+#include "../Utils/StatsUtils.hpp"
+#include "../Utils/TextUtils.hpp"
+#include "../Utils/TimeUtils.hpp"
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+namespace utl = vsprofile::utils;
+namespace fs = std::filesystem;
+
+namespace vsprofile {
+
+    namespace {
+        struct Footprint {
+            std::size_t runs {};
+            double peakRssMiB {};
+            double cpuS {};
+            double readMiB {};
+            double writeMiB {};
+            double durationS {};
+        };
+
+        constexpr double kMiB = 1024.0 * 1024.0;
+
+        Footprint Summarise(const std::vector<const ResourceRun*>& runs) {
+            Footprint f;
+            f.runs = runs.size();
+            if (runs.empty()) return f;
+            auto median = [&](auto field) {
+                std::vector<double> values;
+                for (const auto* r : runs) values.push_back(field(*r));
+                return utl::EstimateMedian(std::move(values)).median;
+            };
+            f.peakRssMiB = median([](const ResourceRun& r) { return static_cast<double>(r.peakRssKb) / 1024.0; });
+            f.cpuS = median([](const ResourceRun& r) { return r.cpuMs / 1000.0; });
+            f.readMiB = median([](const ResourceRun& r) { return static_cast<double>(r.readBytes) / kMiB; });
+            f.writeMiB = median([](const ResourceRun& r) { return static_cast<double>(r.writeBytes) / kMiB; });
+            f.durationS = median([](const ResourceRun& r) { return r.durationMs / 1000.0; });
+            return f;
+        }
+
+        // Runs of profile, restricted to the given mod set when any were recorded with it
+        std::vector<const ResourceRun*> Select(const std::vector<ResourceRun>& runs, const std::string& profile, const std::string& hash) {
+            std::vector<const ResourceRun*> all, matching;
+            for (const auto& r : runs) {
+                if (r.profile != profile) continue;
+                all.push_back(&r);
+                if (r.modSetHash == hash) matching.push_back(&r);
+            }
+            if (!matching.empty()) return matching;
+            if (!all.empty()) utl::PrintWarn(std::format("No runs of '{}' with its current mods, using all {} recorded runs.\n", profile, all.size()));
+            return all;
+        }
+
+        std::string Delta(const double a, const double b) {
+            if (a <= 0.0) return "";
+            return std::format("{:+.1f}%", 100.0 * (b - a) / a);
+        }
+    }
+
+    ResourceRun ResourceRun::FromSamples(std::string profile, std::string modSetHash, std::vector<utils::ResourceSample> samples) {
+        ResourceRun run;
+        run.profile = std::move(profile);
+        run.modSetHash = std::move(modSetHash);
+        run.timestamp = utl::GetTimeStamp();
+        for (const auto& s : samples) run.peakRssKb = std::max(run.peakRssKb, s.rssKb);
+        if (!samples.empty()) {
+            const auto& last = samples.back();
+            run.durationMs = last.tMs;
+            run.cpuMs = last.cpuMs;
+            run.readBytes = last.readBytes;
+            run.writeBytes = last.writeBytes;
+        }
+        // Keep the series bounded: merge neighbours, keeping the larger RSS so peaks survive
+        while (samples.size() > constants::kMaxResourceSamples) {
+            std::vector<utils::ResourceSample> merged;
+            merged.reserve(samples.size() / 2 + 1);
+            for (std::size_t i = 0; i < samples.size(); i += 2) {
+                utils::ResourceSample s = i + 1 < samples.size() ? samples[i + 1] : samples[i];
+                s.rssKb = std::max(s.rssKb, samples[i].rssKb);
+                merged.push_back(s);
+            }
+            samples = std::move(merged);
+        }
+        run.samples = std::move(samples);
+        return run;
+    }
+
+    // Series are stored column-wise as integers, which keeps each history line compact
+    void to_json(json& j, const ResourceRun& r) {
+        json t = json::array(), rss = json::array(), rd = json::array(), wr = json::array(), cpu = json::array();
+        for (const auto& s : r.samples) {
+            t.push_back(static_cast<long long>(s.tMs));
+            rss.push_back(s.rssKb);
+            rd.push_back(s.readBytes);
+            wr.push_back(s.writeBytes);
+            cpu.push_back(static_cast<long long>(s.cpuMs));
+        }
+        j = json{
+                {"profile",    r.profile},
+                {"modSetHash", r.modSetHash},
+                {"timestamp",  r.timestamp},
+                {"durationMs", static_cast<long long>(r.durationMs)},
+                {"peakRssKb",  r.peakRssKb},
+                {"cpuMs",      static_cast<long long>(r.cpuMs)},
+                {"readBytes",  r.readBytes},
+                {"writeBytes", r.writeBytes},
+                {"series",     {{"tMs", t}, {"rssKb", rss}, {"readBytes", rd}, {"writeBytes", wr}, {"cpuMs", cpu}}},
+        };
+    }
+
+    void from_json(const json& j, ResourceRun& r) {
+        r.profile = j.at("profile").get<std::string>();
+        r.modSetHash = j.at("modSetHash").get<std::string>();
+        r.timestamp = j.at("timestamp").get<std::string>();
+        r.durationMs = j.at("durationMs").get<double>();
+        r.peakRssKb = j.at("peakRssKb").get<long long>();
+        r.cpuMs = j.at("cpuMs").get<double>();
+        r.readBytes = j.at("readBytes").get<long long>();
+        r.writeBytes = j.at("writeBytes").get<long long>();
+        const json& series = j.at("series");
+        const std::size_t n = series.at("tMs").size();
+        r.samples.resize(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            r.samples[i] = {
+                    series["tMs"][i].get<double>(),
+                    series["rssKb"][i].get<long long>(),
+                    series["readBytes"][i].get<long long>(),
+                    series["writeBytes"][i].get<long long>(),
+                    series["cpuMs"][i].get<double>(),
+            };
+        }
+    }
+
+    void AppendResourceRun(const ResourceRun& run) {
+        fs::create_directories(constants::kResourceHistoryPath.parent_path());
+        std::ofstream out {constants::kResourceHistoryPath, std::ios::app};
+        out << json(run).dump() << '\n';
+        if (!out) utl::PrintErr(std::format("Failed to record run in '{}'\n", constants::kResourceHistoryPath.string()));
+    }
+
+    std::vector<ResourceRun> LoadResourceRuns() {
+        std::vector<ResourceRun> runs;
+        std::ifstream in {constants::kResourceHistoryPath};
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty()) continue;
+            try {
+                runs.push_back(json::parse(line).get<ResourceRun>());
+            }
+            catch (const json::exception&) {
+                // a torn write from an interrupted session, skip it
+            }
+        }
+        return runs;
+    }
+
+    std::string HashModSet(const fs::path& path) {
+        // Every file at every depth, so folder mods and their configs count, and in path order already
+        utl::Fnv1a64 h;
+        for (const ManifestEntry& e : Manifest::Scan(path).entries) h.Update(e.path).Update(static_cast<std::uint64_t>(e.size));
+        return h.Hex();
+    }
+
+    void PrintResourceRun(const ResourceRun& run) {
+        std::cout << utl::Bold(std::format("[Resources of '{}' ({})]\n", run.profile.empty() ? "none" : run.profile, run.modSetHash));
+        std::cout << std::format("Duration: {:.1f} s, CPU: {:.1f} s, peak RSS: {:.1f} MiB\n",
+                                 run.durationMs / 1000.0, run.cpuMs / 1000.0, static_cast<double>(run.peakRssKb) / 1024.0);
+        std::cout << std::format("Read: {:.1f} MiB, written: {:.1f} MiB\n",
+                                 static_cast<double>(run.readBytes) / kMiB, static_cast<double>(run.writeBytes) / kMiB);
+    }
+
+    void PrintFootprintComparison(const std::vector<ResourceRun>& runs, const std::string& a, const std::string& aHash,
+                                  const std::string& b, const std::string& bHash) {
+        const Footprint fa {Summarise(Select(runs, a, aHash))};
+        const Footprint fb {Summarise(Select(runs, b, bHash))};
+        if (fa.runs == 0 || fb.runs == 0) {
+            utl::PrintErr(std::format("No recorded runs for '{}'. Launch it with 'play' first.\n", fa.runs == 0 ? a : b));
+            return;
+        }
+        std::cout << utl::Bold(std::format("{:<16} {:>14} {:>14} {:>9}\n", "median", a, b, "change"));
+        auto row = [](std::string_view label, const double va, const double vb) {
+            std::cout << std::format("{:<16} {:>14.1f} {:>14.1f} {:>9}\n", label, va, vb, Delta(va, vb));
+        };
+        row("runs", static_cast<double>(fa.runs), static_cast<double>(fb.runs));
+        row("peak RSS (MiB)", fa.peakRssMiB, fb.peakRssMiB);
+        row("CPU (s)", fa.cpuS, fb.cpuS);
+        row("read (MiB)", fa.readMiB, fb.readMiB);
+        row("written (MiB)", fa.writeMiB, fb.writeMiB);
+        row("session (s)", fa.durationS, fb.durationS);
+    }
+
+    void PrintFootprintSummary(const std::vector<ResourceRun>& runs) {
+        std::map<std::string, std::vector<const ResourceRun*>> byProfile;
+        for (const auto& r : runs) byProfile[r.profile].push_back(&r);
+        if (byProfile.empty()) {
+            utl::PrintLog("No recorded runs yet. Launch the game with 'play' to record one.\n");
+            return;
+        }
+        std::cout << utl::Bold(std::format("{:<24} {:>5} {:>14} {:>10}\n", "profile", "runs", "peak RSS (MiB)", "CPU (s)"));
+        for (const auto& [profile, list] : byProfile) {
+            const Footprint f {Summarise(list)};
+            std::cout << std::format("{:<24} {:>5} {:>14.1f} {:>10.1f}\n", profile.empty() ? "none" : profile, f.runs, f.peakRssMiB, f.cpuS);
+        }
+    }
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "../Include/json.hpp"
+#include "../Utils/ResourceSampler.hpp"
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace vsprofile {
+
+    // One sampled game session, appended as a single JSON line to the resource history
+    struct ResourceRun {
+        std::string profile;
+        std::string modSetHash;
+        std::string timestamp;
+        double durationMs {};
+        long long peakRssKb {};
+        double cpuMs {};
+        long long readBytes {};
+        long long writeBytes {};
+        std::vector<utils::ResourceSample> samples; // downsampled series
+
+        static ResourceRun FromSamples(std::string profile, std::string modSetHash, std::vector<utils::ResourceSample> samples);
+    };
+
+    void to_json(json& j, const ResourceRun& r);
+    void from_json(const json& j, ResourceRun& r);
+
+    void AppendResourceRun(const ResourceRun& run);
+    [[nodiscard]] std::vector<ResourceRun> LoadResourceRuns();
+
+    // Hash of the relative paths and sizes of every file under a directory, identifies a mod set independently of where it lives
+    [[nodiscard]] std::string HashModSet(const std::filesystem::path& path);
+
+    void PrintResourceRun(const ResourceRun& run);
+    // Side-by-side medians of two profiles' recorded runs; runs of the profile's current mod set are preferred
+    void PrintFootprintComparison(const std::vector<ResourceRun>& runs, const std::string& a, const std::string& aHash,
+                                  const std::string& b, const std::string& bHash);
+    void PrintFootprintSummary(const std::vector<ResourceRun>& runs);
+
+}
@@ -0,0 +1,317 @@
+#include "Snapshot.hpp"
+#include "../Utils/AppConstants.hpp"
+#include "../Utils/Chunker.hpp"
+#include "../Utils/Durability.hpp"
+#include "../Utils/FileUtils.hpp"
+#include "../Utils/HashUtils.hpp"
+#include "../Utils/TextUtils.hpp"
+#include "../Utils/TimeUtils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <unordered_set>
+
+namespace utl = vsprofile::utils;
+namespace fs = std::filesystem;
+
+namespace vsprofile {
+
+    namespace {
+        constexpr double kMiB = 1024.0 * 1024.0;
+
+        long long MTime(const fs::path& path, std::error_code& ec) {
+            return fs::last_write_time(path, ec).time_since_epoch().count();
+        }
+
+        bool ValidName(const std::string_view name) {
+            return !name.empty() && name.find_first_of("/\\") == std::string::npos && name != "." && name != "..";
+        }
+
+        // Writes next to the destination and renames, readers never see a partial file. The write is durable
+        // once `batch` commits, strict durability also flushes the file before it is renamed into place.
+        bool WriteAtomically(const fs::path& path, const void* data, const std::size_t size, utl::DurableBatch& batch) {
+            const fs::path tmp {path.string() + ".tmp"};
+            {
+                std::ofstream out {tmp, std::ios::binary | std::ios::trunc};
+                out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+                if (!out) return false;
+            }
+            if (utl::CurrentDurability() == utl::Durability::Strict) utl::SyncFile(tmp);
+            std::error_code ec;
+            fs::rename(tmp, path, ec);
+            if (ec) return false;
+            batch.Add(path);
+            return true;
+        }
+    }
+
+    std::uintmax_t SnapshotManifest::Bytes() const {
+        std::uintmax_t total {};
+        for (const auto& f : files) total += f.size;
+        return total;
+    }
+
+    void to_json(json& j, const SnapshotFile& f) {
+        j = json{
+                {"path",   f.path},
+                {"size",   f.size},
+                {"mtime",  f.mtime},
+                {"chunks", f.chunks},
+        };
+    }
+
+    void from_json(const json& j, SnapshotFile& f) {
+        f.path = j.at("path").get<std::string>();
+        f.size = j.at("size").get<std::uintmax_t>();
+        f.mtime = j.at("mtime").get<long long>();
+        f.chunks = j.at("chunks").get<std::vector<std::string>>();
+    }
+
+    void to_json(json& j, const SnapshotManifest& m) {
+        j = json{
+                {"name",    m.name},
+                {"created", m.created},
+                {"source",  m.source},
+                {"files",   m.files},
+        };
+    }
+
+    void from_json(const json& j, SnapshotManifest& m) {
+        m.name = j.at("name").get<std::string>();
+        m.created = j.at("created").get<std::string>();
+        m.source = j.at("source").get<fs::path>();
+        m.files = j.at("files").get<std::vector<SnapshotFile>>();
+    }
+
+    fs::path SnapshotStore::ChunkPath(const std::string_view hash) const {
+        return root_ / "chunks" / hash.substr(0, 2) / hash;
+    }
+
+    fs::path SnapshotStore::ManifestPath(const std::string_view name) const {
+        return root_ / std::format("{}.json", name);
+    }
+
+    std::optional<SnapshotManifest> SnapshotStore::Load(const std::string_view name) const {
+        if (!ValidName(name)) return std::nullopt;
+        std::ifstream in {ManifestPath(name)};
+        if (!in) return std::nullopt;
+        try {
+            return json::parse(in).get<SnapshotManifest>();
+        }
+        catch (const json::exception&) {
+            utl::PrintErr(std::format("Snapshot manifest '{}' is corrupt.\n", ManifestPath(name).string()));
+            return std::nullopt;
+        }
+    }
+
+    std::vector<SnapshotManifest> SnapshotStore::LoadAll() const {
+        std::vector<SnapshotManifest> all;
+        std::error_code ec;
+        for (const auto& e : fs::directory_iterator(root_, ec)) {
+            if (e.path().extension() != ".json") continue;
+            if (auto m = Load(e.path().stem().string())) all.push_back(std::move(*m));
+        }
+        std::ranges::sort(all, {}, &SnapshotManifest::created);
+        return all;
+    }
+
+    bool SnapshotStore::Create(const fs::path& source, const std::string& name) const {
+        if (!ValidName(name)) {
+            utl::PrintErr(std::format("'{}' is not a valid snapshot name.\n", name));
+            return false;
+        }
+        if (fs::exists(ManifestPath(name))) {
+            utl::PrintErr(std::format("Snapshot '{}' already exists.\n", name));
+            return false;
+        }
+        std::error_code ec;
+        if (!fs::is_directory(source, ec)) {
+            utl::PrintErr(std::format("Nothing to snapshot, '{}' is not a directory.\n", source.string()));
+            return false;
+        }
+        const auto start = std::chrono::steady_clock::now();
+
+        // Files unchanged since the latest snapshot reuse its chunk lists without being read
+        std::map<std::string, const SnapshotFile*> previous;
+        const std::vector<SnapshotManifest> all {LoadAll()};
+        if (!all.empty()) {
+            for (const auto& f : all.back().files) previous.emplace(f.path, &f);
+        }
+
+        SnapshotManifest manifest;
+        manifest.name = name;
+        manifest.created = utl::GetTimeStamp();
+        manifest.source = source;
+
+        const utl::ContentChunker chunker {constants::kChunkMinSize, constants::kChunkAvgSize, constants::kChunkMaxSize};
+        std::vector<unsigned char> buffer(4 * chunker.MaxSize());
+        std::unordered_set<std::string> known;
+        utl::DurableBatch batch;
+        std::uintmax_t newBytes {};
+        std::size_t reused {};
+
+        for (auto it = fs::recursive_directory_iterator(source, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (!it->is_regular_file(ec)) continue;
+            SnapshotFile file;
+            file.path = fs::relative(it->path(), source, ec).generic_string();
+            file.size = it->file_size(ec);
+            file.mtime = MTime(it->path(), ec);
+            if (const auto prev = previous.find(file.path);
+                prev != previous.end() && prev->second->size == file.size && prev->second->mtime == file.mtime) {
+                file.chunks = prev->second->chunks;
+                manifest.files.push_back(std::move(file));
+                ++reused;
+                continue;
+            }
+
+            std::ifstream in {it->path(), std::ios::binary};
+            if (!in) {
+                utl::PrintErr(std::format("Could not read '{}', snapshot aborted.\n", it->path().string()));
+                return false;
+            }
+            std::size_t filled {}, pos {};
+            bool eof {false};
+            while (true) {
+                // Keep at least one maximal chunk buffered so cut points do not depend on read sizes
+                if (!eof && filled - pos < chunker.MaxSize()) {
+                    std::copy(buffer.begin() + static_cast<std::ptrdiff_t>(pos), buffer.begin() + static_cast<std::ptrdiff_t>(filled), buffer.begin());
+                    filled -= pos;
+                    pos = 0;
+                    in.read(reinterpret_cast<char*>(buffer.data() + filled), static_cast<std::streamsize>(buffer.size() - filled));
+                    filled += static_cast<std::size_t>(in.gcount());
+                    eof = !in;
+                }
+                if (pos == filled) break;
+                const std::size_t len = chunker.Cut(buffer.data() + pos, filled - pos);
+                std::string hash {utl::Murmur3Hasher{}.Update(buffer.data() + pos, len).Hex()};
+                if (!known.contains(hash)) {
+                    const fs::path chunkPath {ChunkPath(hash)};
+                    if (!fs::exists(chunkPath, ec)) {
+                        if (fs::create_directories(chunkPath.parent_path(), ec)) batch.Add(chunkPath.parent_path());
+                        if (!WriteAtomically(chunkPath, buffer.data() + pos, len, batch)) {
+                            utl::PrintErr(std::format("Failed to store chunk '{}', snapshot aborted.\n", chunkPath.string()));
+                            return false;
+                        }
+                        newBytes += len;
+                    }
+                    known.insert(hash);
+                }
+                file.chunks.push_back(std::move(hash));
+                pos += len;
+            }
+            manifest.files.push_back(std::move(file));
+        }
+        if (ec) {
+            utl::PrintErr(std::format("Failed to walk '{}': {}\n", source.string(), ec.message()));
+            return false;
+        }
+
+        // The chunks are on stable storage before the manifest that lists them
+        batch.Commit();
+        if (!utl::WriteJsonAtomically(ManifestPath(name), json(manifest))) {
+            utl::PrintErr(std::format("Failed to write snapshot manifest for '{}'.\n", name));
+            return false;
+        }
+        const std::chrono::duration<double> elapsed {std::chrono::steady_clock::now() - start};
+        utl::PrintLog(std::format("Snapshot '{}': {} files, {:.1f} MiB, {:.1f} MiB new, {} files unchanged, {:.1f} s\n",
+                                  name, manifest.files.size(), static_cast<double>(manifest.Bytes()) / kMiB,
+                                  static_cast<double>(newBytes) / kMiB, reused, elapsed.count()));
+        return true;
+    }
+
+    bool SnapshotStore::Restore(const std::string& name, const fs::path& target) const {
+        if (!ValidName(name)) {
+            utl::PrintErr(std::format("'{}' is not a valid snapshot name.\n", name));
+            return false;
+        }
+        const auto manifest {Load(name)};
+        if (!manifest) {
+            utl::PrintErr(std::format("Snapshot '{}' does not exist.\n", name));
+            return false;
+        }
+        std::vector<char> chunk;
+        utl::DurableBatch batch;
+        std::size_t restored {}, failures {};
+        for (const auto& file : manifest->files) {
+            const fs::path dst {target / fs::path(file.path)};
+            std::error_code ec;
+            // Restored files keep their snapshot mtime, so untouched ones are recognised and skipped
+            if (fs::is_regular_file(dst, ec) && fs::file_size(dst, ec) == file.size && MTime(dst, ec) == file.mtime) continue;
+
+            fs::create_directories(dst.parent_path(), ec);
+            const fs::path tmp {dst.string() + ".vsprofile-tmp"};
+            bool ok {true};
+            {
+                std::ofstream out {tmp, std::ios::binary | std::ios::trunc};
+                for (const auto& hash : file.chunks) {
+                    std::ifstream in {ChunkPath(hash), std::ios::binary};
+                    chunk.assign(std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{});
+                    if (utl::Murmur3Hasher{}.Update(chunk.data(), chunk.size()).Hex() != hash) {
+                        utl::PrintErr(std::format("Chunk '{}' of '{}' is missing or corrupt.\n", hash, file.path));
+                        ok = false;
+                        break;
+                    }
+                    out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+                }
+                ok = ok && static_cast<bool>(out);
+            }
+            if (ok) {
+                fs::last_write_time(tmp, fs::file_time_type{fs::file_time_type::duration{file.mtime}}, ec);
+                if (utl::CurrentDurability() == utl::Durability::Strict) utl::SyncFile(tmp);
+                fs::rename(tmp, dst, ec);
+                ok = !ec;
+            }
+            if (!ok) {
+                fs::remove(tmp, ec);
+                ++failures;
+                continue;
+            }
+            batch.Add(dst);
+            ++restored;
+        }
+        batch.Commit();
+        utl::PrintLog(std::format("Restored {} of {} files from snapshot '{}'{}\n", restored, manifest->files.size(), name,
+                                  failures ? std::format(", {} failed", failures) : ""));
+        return failures == 0;
+    }
+
+    bool SnapshotStore::Remove(const std::string& name) const {
+        std::error_code ec;
+        if (!ValidName(name) || !fs::remove(ManifestPath(name), ec)) {
+            utl::PrintErr(std::format("Snapshot '{}' does not exist.\n", name));
+            return false;
+        }
+        // Mark and sweep: keep every chunk some remaining snapshot still references
+        std::unordered_set<std::string> live;
+        for (const auto& m : LoadAll()) {
+            for (const auto& f : m.files) live.insert(f.chunks.begin(), f.chunks.end());
+        }
+        std::uintmax_t reclaimed {};
+        for (auto it = fs::recursive_directory_iterator(root_ / "chunks", ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (!it->is_regular_file(ec) || live.contains(it->path().filename().string())) continue;
+            reclaimed += it->file_size(ec);
+            fs::remove(it->path(), ec);
+        }
+        utl::PrintLog(std::format("Removed snapshot '{}', reclaimed {:.1f} MiB\n", name, static_cast<double>(reclaimed) / kMiB));
+        return true;
+    }
+
+    void SnapshotStore::PrintList() const {
+        const std::vector<SnapshotManifest> all {LoadAll()};
+        if (all.empty()) {
+            utl::PrintLog("No snapshots yet.\n");
+            return;
+        }
+        for (const auto& m : all) {
+            utl::PrintLog(std::format("– {} ({}, {} files, {:.1f} MiB)\n", m.name, m.created, m.files.size(), static_cast<double>(m.Bytes()) / kMiB));
+        }
+        std::uintmax_t stored {};
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(root_ / "chunks", ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_regular_file(ec)) stored += it->file_size(ec);
+        }
+        utl::PrintLog(std::format("Chunk store: {:.1f} MiB on disk\n", static_cast<double>(stored) / kMiB));
+    }
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "../Include/json.hpp"
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace vsprofile {
+
+    struct SnapshotFile {
+        std::string path; // relative to the snapshot source
+        std::uintmax_t size {};
+        long long mtime {};
+        std::vector<std::string> chunks; // content hashes, in file order
+    };
+
+    struct SnapshotManifest {
+        std::string name;
+        std::string created;
+        std::filesystem::path source;
+        std::vector<SnapshotFile> files;
+
+        [[nodiscard]] std::uintmax_t Bytes() const;
+    };
+
+    void to_json(json& j, const SnapshotFile& f);
+    void from_json(const json& j, SnapshotFile& f);
+    void to_json(json& j, const SnapshotManifest& m);
+    void from_json(const json& j, SnapshotManifest& m);
+
+    // Deduplicated snapshots of a folder (the game's Saves). Files are split into content-defined chunks
+    // stored once under chunks/<hash>; a snapshot is only a manifest listing each file's chunks.
+    class SnapshotStore {
+        std::filesystem::path root_;
+
+        [[nodiscard]] std::filesystem::path ChunkPath(std::string_view hash) const;
+        [[nodiscard]] std::filesystem::path ManifestPath(std::string_view name) const;
+        [[nodiscard]] std::vector<SnapshotManifest> LoadAll() const;
+        [[nodiscard]] std::optional<SnapshotManifest> Load(std::string_view name) const;
+
+    public:
+        explicit SnapshotStore(std::filesystem::path root) : root_(std::move(root)) {}
+
+        bool Create(const std::filesystem::path& source, const std::string& name) const;
+        bool Restore(const std::string& name, const std::filesystem::path& target) const;
+        bool Remove(const std::string& name) const; // also drops chunks no other snapshot uses
+        void PrintList() const;
+    };
+
+}
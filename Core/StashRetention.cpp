@@ -0,0 +1,182 @@
+#include "StashRetention.hpp"
+#include "Config.hpp"
+#include "DeltaStash.hpp"
+#include "../Include/json.hpp"
+#include "../Utils/AppConstants.hpp"
+#include "../Utils/DirectoryScan.hpp"
+#include "../Utils/FileUtils.hpp"
+#include "../Utils/HashUtils.hpp"
+#include "../Utils/Pack.hpp"
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <map>
+#include <set>
+
+using json = nlohmann::json;
+namespace utl = vsprofile::utils;
+namespace fs = std::filesystem;
+namespace ch = std::chrono;
+
+namespace vsprofile {
+
+    namespace {
+        struct StashFile {
+            std::string path;
+            std::uintmax_t size;
+            long long mtime;
+            std::uint32_t links;
+        };
+
+        void ScanInto(const fs::path& dir, const std::string& prefix, std::vector<StashFile>& out) {
+            std::error_code ec;
+            for (const utl::DirEntry& e : utl::DirectoryScan::Read(dir, utl::ScanDetail::Stats, ec)) {
+                if (utl::IsHiddenEntry(e.name)) continue;
+                std::string rel {prefix};
+                rel += e.name;
+                if (e.IsDirectory()) ScanInto(dir / e.name, rel + '/', out);
+                else if (e.IsFile()) out.push_back({std::move(rel), e.size, e.mtime, e.links});
+            }
+        }
+    }
+
+    StashRecord StashRecord::Scan(const fs::path& stashPath, const ch::system_clock::time_point time) {
+        std::vector<StashFile> files;
+        ScanInto(stashPath, {}, files);
+        // Roots other than Mods are stored inside the hidden metadata folder
+        const std::string roots {std::format("{}/roots/", constants::kProfileMetaDir)};
+        ScanInto(stashPath / roots, roots, files);
+        // Files a delta stash only lists count towards what it holds, not towards what removing it frees
+        if (const auto delta {DeltaManifest::Load(stashPath)}) {
+            for (const auto& [root, shared] : delta->roots) {
+                const std::string prefix {ProfileRoot{root}.IsMods() ? std::string{} : roots + root + '/'};
+                for (const auto& f : shared) files.push_back({prefix + f.path, f.size, f.mtime, 2});
+            }
+        }
+        // A cold stash holds its own files in its pack, and takes up what the pack does
+        std::uintmax_t packed {};
+        std::error_code ec;
+        if (const auto pack {utl::PackReader::Open(stashPath / constants::kProfileMetaDir / constants::kColdPackName, ec)}) {
+            for (const auto& e : pack->Entries()) files.push_back({e.path, e.size, e.mtime, 2});
+            packed = pack->StoredBytes();
+        }
+        std::ranges::sort(files, {}, &StashFile::path);
+        const auto [first, last] {std::ranges::unique(files, {}, &StashFile::path)}; // changed after packing, kept both places
+        files.erase(first, last);
+
+        StashRecord record;
+        record.name = stashPath.filename().string();
+        record.time = time;
+        record.files = files.size();
+        utl::Murmur3Hasher hasher;
+        for (const auto& f : files) {
+            record.bytes += f.size;
+            if (f.links <= 1) record.ownBytes += f.size;
+            hasher.Update(f.path).Update(std::string_view{"\0", 1});
+            hasher.Update(&f.size, sizeof f.size).Update(&f.mtime, sizeof f.mtime);
+        }
+        record.ownBytes += packed;
+        record.contentHash = hasher.Hex();
+        return record;
+    }
+
+    std::optional<StashRecord> StashRecord::Load(const fs::path& path) {
+        std::ifstream in {path};
+        if (!in) return std::nullopt;
+        try {
+            const json j = json::parse(in);
+            StashRecord record;
+            record.files = j.at("files").get<std::size_t>();
+            record.bytes = j.at("bytes").get<std::uintmax_t>();
+            record.ownBytes = j.at("ownBytes").get<std::uintmax_t>();
+            record.contentHash = j.at("contentHash").get<std::string>();
+            return record;
+        }
+        catch (const json::exception&) {
+            return std::nullopt;
+        }
+    }
+
+    bool StashRecord::Save(const fs::path& path) const {
+        const json j {{"files", files}, {"bytes", bytes}, {"ownBytes", ownBytes}, {"contentHash", contentHash}};
+        return utl::WriteJsonAtomically(path, j);
+    }
+
+    std::optional<ch::system_clock::time_point> StashTime(const std::string_view name) {
+        // stash_YYYY-MM-DD_HH-MM-SS_<profile>, as GenNonEmptyName writes it
+        constexpr std::string_view kPrefix = "stash_";
+        constexpr std::size_t kStampSize = 19;
+        if (!name.starts_with(kPrefix) || name.size() < kPrefix.size() + kStampSize) return std::nullopt;
+        const std::string_view stamp {name.substr(kPrefix.size(), kStampSize)};
+        if (name.size() > kPrefix.size() + kStampSize && name[kPrefix.size() + kStampSize] != '_') return std::nullopt;
+        if (stamp[4] != '-' || stamp[7] != '-' || stamp[10] != '_' || stamp[13] != '-' || stamp[16] != '-') return std::nullopt;
+        constexpr std::size_t kOffsets[] {0, 5, 8, 11, 14, 17};
+        int parts[6] {};
+        for (std::size_t i = 0; i < 6; ++i) {
+            const char* first {stamp.data() + kOffsets[i]};
+            const char* last {first + (i == 0 ? 4 : 2)};
+            const auto [end, err] {std::from_chars(first, last, parts[i])};
+            if (err != std::errc{} || end != last) return std::nullopt;
+        }
+        const ch::year_month_day date {ch::year{parts[0]}, ch::month{static_cast<unsigned>(parts[1])},
+                                       ch::day{static_cast<unsigned>(parts[2])}};
+        if (!date.ok()) return std::nullopt;
+        return ch::sys_days{date} + ch::hours{parts[3]} + ch::minutes{parts[4]} + ch::seconds{parts[5]};
+    }
+
+    std::string_view ToString(const PruneDecision::Reason reason) {
+        switch (reason) {
+            case PruneDecision::Reason::Duplicate: return "duplicate";
+            case PruneDecision::Reason::OverCap: return "over the size cap";
+            default: return "past retention";
+        }
+    }
+
+    std::vector<PruneDecision> PlanPrune(std::vector<StashRecord> stashes, const StashRetention& policy) {
+        std::ranges::sort(stashes, std::ranges::greater{}, &StashRecord::time);
+        std::vector<PruneDecision> prune;
+
+        // Newest first, so the copy kept of identical stashes is the newest one
+        std::map<std::string, std::string> byHash;
+        std::vector<const StashRecord*> distinct;
+        for (const auto& stash : stashes) {
+            const auto [it, first] {byHash.try_emplace(stash.contentHash, stash.name)};
+            if (first) distinct.push_back(&stash);
+            else prune.push_back({stash.name, PruneDecision::Reason::Duplicate, stash.ownBytes, it->second});
+        }
+
+        std::vector<bool> keep(distinct.size());
+        std::set<ch::sys_days> days;
+        std::set<ch::sys_days> weeks;
+        for (std::size_t i = 0; i < distinct.size(); ++i) {
+            const ch::sys_days day {ch::floor<ch::days>(distinct[i]->time)};
+            // The epoch fell on a Thursday, three days on makes weeks start on Monday
+            const ch::sys_days week {ch::floor<ch::weeks>(day + ch::days{3})};
+            keep[i] = i == 0 || i < policy.keepLast;
+            if (!days.contains(day) && days.size() < policy.keepDaily) {
+                days.insert(day);
+                keep[i] = true;
+            }
+            if (!weeks.contains(week) && weeks.size() < policy.keepWeekly) {
+                weeks.insert(week);
+                keep[i] = true;
+            }
+            if (!keep[i]) prune.push_back({distinct[i]->name, PruneDecision::Reason::Expired, distinct[i]->ownBytes, {}});
+        }
+
+        if (policy.maxMiB == 0) return prune;
+        const std::uintmax_t cap {policy.maxMiB * 1024 * 1024};
+        std::uintmax_t total {};
+        for (std::size_t i = 0; i < distinct.size(); ++i) {
+            if (keep[i]) total += distinct[i]->ownBytes;
+        }
+        for (std::size_t i = distinct.size(); i-- > 1 && total > cap;) {
+            if (!keep[i]) continue;
+            prune.push_back({distinct[i]->name, PruneDecision::Reason::OverCap, distinct[i]->ownBytes, {}});
+            total -= distinct[i]->ownBytes;
+        }
+        return prune;
+    }
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vsprofile {
+
+    // Which of the stashes activation leaves behind (stash_<timestamp>_<profile>) to keep
+    struct StashRetention {
+        std::size_t keepLast {10};
+        std::size_t keepDaily {7};  // newest stash of each of the last days that have one
+        std::size_t keepWeekly {4}; // newest stash of each of the last weeks that have one
+        std::uintmax_t maxMiB {};   // cap on what kept stashes hold on their own, 0 for none
+        bool onActivate {false};    // prune after every activation instead of only on 'prune'
+    };
+
+    // What retention needs to know about a stash, recorded once in the stash so pruning never walks it
+    struct StashRecord {
+        std::string name;
+        std::chrono::system_clock::time_point time; // from the name
+        std::size_t files {};
+        std::uintmax_t bytes {};    // apparent size of everything in it
+        std::uintmax_t ownBytes {}; // files no other hard link shared when recorded, what removing it frees
+        std::string contentHash;    // over every path, size and mtime, so identical stashes hash alike
+
+        // Stats every file in the stash, its stored roots included
+        [[nodiscard]] static StashRecord Scan(const std::filesystem::path& stashPath, std::chrono::system_clock::time_point time);
+        [[nodiscard]] static std::optional<StashRecord> Load(const std::filesystem::path& path);
+        bool Save(const std::filesystem::path& path) const;
+    };
+
+    // Time encoded in an auto-generated stash name, empty for any other profile name
+    [[nodiscard]] std::optional<std::chrono::system_clock::time_point> StashTime(std::string_view name);
+
+    struct PruneDecision {
+        enum class Reason { Duplicate, Expired, OverCap };
+        std::string name;
+        Reason reason;
+        std::uintmax_t ownBytes {};
+        std::string duplicateOf; // Duplicate only: the newer identical stash that is kept
+    };
+
+    [[nodiscard]] std::string_view ToString(PruneDecision::Reason reason);
+
+    // Stashes to remove, in any order. Identical stashes keep only the newest; the rest are kept by
+    // count, day and week, then the oldest kept ones go while the size cap is exceeded. The newest
+    // stash is always kept.
+    [[nodiscard]] std::vector<PruneDecision> PlanPrune(std::vector<StashRecord> stashes, const StashRetention& policy);
+
+}
@@ -0,0 +1,85 @@
+#include "Command.hpp"
+#include "Config.hpp"
+#include "Core.hpp"
+#include "DaemonSession.hpp"
+#include "DirectoryCache.hpp"
+#include "../Utils/SocketUtils.hpp"
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <poll.h>
+
+namespace utl = vsprofile::utils;
+using namespace vsprofile;
+
+// vsprofiled: keeps Config and directory listings in memory and serves the vsprofile CLI over a
+// local socket, one request at a time, see DaemonSession.hpp.
+
+namespace {
+
+    volatile std::sig_atomic_t gStop = 0;
+    constexpr std::chrono::minutes kPurgeInterval {1};
+
+}
+
+int main() {
+    if (const int fd = utl::ConnectUnix(constants::kDaemonSocketPath); fd >= 0) {
+        utl::CloseSocket(fd);
+        utl::PrintErr(std::format("vsprofiled is already running on '{}'\n", constants::kDaemonSocketPath.string()));
+        return 1;
+    }
+
+    const Config config {Config::Load(constants::kConfigPath)};
+    config.SaveIfChanged(constants::kConfigPath);
+    Core core {config};
+    core.BuildCommands();
+    DirectoryCache cache;
+    core.SetDirectoryCache(&cache);
+    core.ReportLinkedChanges();
+
+    const int listenFd = utl::ListenUnix(constants::kDaemonSocketPath);
+    if (listenFd < 0) {
+        utl::PrintErr(std::format("Could not listen on '{}'\n", constants::kDaemonSocketPath.string()));
+        return 1;
+    }
+
+    // No SA_RESTART, so a signal interrupts poll and the loop notices
+    struct sigaction sa {};
+    sa.sa_handler = [](int) { gStop = 1; };
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    ClientOutBuf out {std::cout.rdbuf()};
+    std::streambuf* const stdoutBuf {std::cout.rdbuf(&out)};
+    utl::PrintLog(std::format("vsprofiled listening on '{}'\n", constants::kDaemonSocketPath.string()));
+
+    auto lastPurge {std::chrono::steady_clock::now()};
+    while (!gStop) {
+        pollfd fds[2] {{listenFd, POLLIN, 0}, {cache.Fd(), POLLIN, 0}};
+        const int ready {poll(fds, 2, static_cast<int>(std::chrono::milliseconds{kPurgeInterval}.count()))};
+        // Trash batches expire while the daemon idles, so it purges on a timer rather than only at startup
+        if (const auto now {std::chrono::steady_clock::now()}; now - lastPurge >= kPurgeInterval) {
+            core.PurgeTrashInBackground();
+            lastPurge = now;
+        }
+        if (ready <= 0) continue;
+        if (fds[1].revents & POLLIN) cache.Poll();
+        if (fds[0].revents & POLLIN) {
+            const int client = utl::AcceptClient(listenFd);
+            if (client < 0) continue;
+            ServeClient(client, out, [&core](const std::vector<std::string>& args) {
+                if (args[0] != "shutdown") return core.Dispatch(args[0], args);
+                gStop = 1;
+                return true;
+            });
+            utl::CloseSocket(client);
+        }
+    }
+
+    utl::CloseSocket(listenFd);
+    std::error_code ec;
+    std::filesystem::remove(constants::kDaemonSocketPath, ec);
+    core.WaitForStaging();
+    std::cout.rdbuf(stdoutBuf);
+    utl::PrintLog("vsprofiled stopped\n");
+}
@@ -2,21 +2,80 @@
 #include "../Include/json.hpp"
 #include "Config.hpp"
 #include "Core.hpp"
+#include "DaemonSession.hpp"
 #include <iostream>
+#include <optional>
 
 using json = nlohmann::json;
 namespace fs = std::filesystem;
 using namespace vsprofile;
 
-int main() {
-    const Config config {Config::Load(constants::kConfigPath)};
-    config.Save(constants::kConfigPath);
-    Core core {Core(config)};
-    core.BuildCommands();
+namespace {
+
+    // Through this process's own terminal, empty when vsprofiled is not running
+    std::optional<bool> RunRemote(const std::string& line) {
+        return vsprofile::RunRemote(constants::kDaemonSocketPath, line, std::cout, std::cin);
+    }
+
+    // Commands that run the game stay in this process rather than holding vsprofiled, which serves
+    // one request at a time, for as long as the game runs. A stand-in and its arguments then also
+    // resolve against this process's working directory.
+    bool LaunchesGame(const std::vector<std::string>& args) {
+        if (args[0] == "play" || args[0] == "bisectperf") return true;
+        if (args[0] == "perf") return args.size() < 2 || args[1] != "log";
+        return args[0] == "prewarm" && args.size() > 1 && args[1] == "launch";
+    }
+
+    // A command line for vsprofiled, with file arguments made absolute since it runs in another directory
+    std::string JoinArgs(std::vector<std::string> args) {
+        if (args.size() > 2 && args[0] == "perf" && args[1] == "log") args[2] = fs::absolute(args[2]).string();
+        std::ostringstream oss;
+        for (const auto& arg : args) oss << std::quoted(arg) << ' ';
+        return oss.str();
+    }
+
+    int RunLocal(const std::vector<std::string>& oneShot) {
+        const Config config {Config::Load(constants::kConfigPath)};
+        config.SaveIfChanged(constants::kConfigPath);
+        Core core {Core(config)};
+        core.BuildCommands();
+        core.ReportLinkedChanges();
+
+        if (!oneShot.empty()) return core.Dispatch(oneShot[0], oneShot) ? 0 : 1;
+
+        std::string line;
+        while (true) {
+            core.PrintInfo();
+            std::cout << "> " << std::flush;
+            if (!std::getline(std::cin, line)) break;
+
+            auto args = Command::SplitArgs(line);
+            if (args.empty()) continue;
+
+            // Quit program
+            if (args[0] == "quit" || args[0] == "exit" || args[0] == "q") break;
+
+            core.Dispatch(args[0], args);
+        }
+        std::cout << "Goodbye! :3";
+        return 0;
+    }
+
+}
+
+// With arguments, runs that one command and exits. Commands go to vsprofiled when it is running,
+// otherwise the configuration is loaded and the command runs in this process.
+int main(int argc, char* argv[]) {
+    const std::vector<std::string> oneShot(argv + 1, argv + argc);
+    if (!oneShot.empty()) {
+        if (LaunchesGame(oneShot)) return RunLocal(oneShot);
+        if (const auto succeeded {RunRemote(JoinArgs(oneShot))}) return *succeeded ? 0 : 1;
+        return RunLocal(oneShot);
+    }
+    if (!RunRemote("status").has_value()) return RunLocal({});
 
     std::string line;
     while (true) {
-        core.PrintInfo();
         std::cout << "> " << std::flush;
         if (!std::getline(std::cin, line)) break;
 
@@ -26,7 +85,13 @@ int main() {
         // Quit program
         if (args[0] == "quit" || args[0] == "exit" || args[0] == "q") break;
 
-        core.Dispatch(args[0], args);
+        const bool local {LaunchesGame(args)};
+        if (local) RunLocal(args);
+        if ((!local && !RunRemote(JoinArgs(args)).has_value()) || !RunRemote("status").has_value()) {
+            utl::PrintWarn("Lost the connection to vsprofiled, continuing without it\n");
+            return RunLocal({});
+        }
     }
     std::cout << "Goodbye! :3";
-}
\ No newline at end of file
+    return 0;
+}
@@ -0,0 +1,566 @@
+#include "Check.hpp"
+#include "../Core/Core.hpp"
+#include "../Core/DirectoryCache.hpp"
+#include "../Utils/ProcessUtils.hpp"
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <sstream>
+
+namespace fs = std::filesystem;
+namespace utl = vsprofile::utils;
+using namespace vsprofile;
+using vsprofile::tests::ScratchDir;
+
+namespace {
+
+    // Profiles and game folders inside the scratch folder, with the default Mods and ModConfig roots; the
+    // journal and the config are in the app folder under the test's HOME
+    Config ScratchConfig(const ScratchDir& dir) {
+        Config config;
+        config.vintagestoryDataPath = dir.Path() / "Data";
+        config.modsPath = config.vintagestoryDataPath / "Mods";
+        config.profilesPath = dir.Path() / "Profiles";
+        return config;
+    }
+
+    // Every file under `root` by relative path, with its contents; metadata folders left out
+    std::map<std::string, std::string> Files(const fs::path& root) {
+        std::map<std::string, std::string> files;
+        std::error_code ec;
+        for (auto it {fs::recursive_directory_iterator(root, ec)}; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->path().filename().string().starts_with('.')) {
+                it.disable_recursion_pending();
+                continue;
+            }
+            if (!it->is_regular_file()) continue;
+            std::ifstream in {it->path(), std::ios::binary};
+            files[it->path().lexically_relative(root).generic_string()] = {std::istreambuf_iterator<char>{in}, {}};
+        }
+        return files;
+    }
+
+    using FileMap = std::map<std::string, std::string>;
+
+    fs::path StoredRoot(const fs::path& profile, const std::string& root) {
+        return profile / constants::kProfileMetaDir / "roots" / root;
+    }
+
+    // A copy the sync and delta planners take for the same file: same size, same mtime
+    void CopyAsIs(const fs::path& from, const fs::path& to) {
+        fs::create_directories(to.parent_path());
+        fs::copy_file(from, to, fs::copy_options::overwrite_existing);
+        fs::last_write_time(to, fs::last_write_time(from));
+    }
+
+}
+
+TEST(Activation, SyncReplacesModsAndStashesWhatWasThere) {
+    const ScratchDir dir;
+    dir.Write("Profiles/Survival/a.zip", "a");
+    dir.Write("Profiles/Survival/folder/b.json", "b");
+    dir.Write(StoredRoot("Profiles/Survival", "ModConfig") / "c.json", "c");
+    dir.Write("Data/Mods/old.zip", "old");
+    dir.Write("Data/ModConfig/old.json", "o");
+    const fs::path profiles {dir.Path() / "Profiles"};
+    {
+        Core core {ScratchConfig(dir)};
+        core.ActivateProfile("Survival", "stash");
+    }
+    CHECK_EQ(Files(dir.Path() / "Data/Mods"), (FileMap{{"a.zip", "a"}, {"folder/b.json", "b"}}));
+    CHECK_EQ(Files(dir.Path() / "Data/ModConfig"), (FileMap{{"c.json", "c"}}));
+    CHECK_EQ(Files(profiles / "stash"), (FileMap{{"old.zip", "old"}}));
+    CHECK_EQ(Files(StoredRoot(profiles / "stash", "ModConfig")), (FileMap{{"old.json", "o"}}));
+    CHECK(!DeltaManifest::Load(profiles / "stash").has_value()); // it shares nothing with Survival
+    // Mods links the profile's files rather than copying them
+    CHECK(fs::equivalent(dir.Path() / "Data/Mods/a.zip", profiles / "Survival/a.zip"));
+    // Committed: the config names it and no journal is left
+    CHECK_EQ(Config::Load(constants::kConfigPath).activeProfile, "Survival");
+    CHECK(!ActivationJournal::Load(constants::kJournalDir).has_value());
+    CHECK_EQ(Files(profiles / "Survival"), (FileMap{{"a.zip", "a"}, {"folder/b.json", "b"}}));
+}
+
+TEST(Activation, DeltaStashIsMaterialisedWhenActivated) {
+    const ScratchDir dir;
+    dir.Write("Profiles/Other/shared.zip", "shared");
+    dir.Write("Profiles/Other/own.zip", "own");
+    const fs::path profiles {dir.Path() / "Profiles"};
+    CopyAsIs(profiles / "Other/shared.zip", dir.Path() / "Data/Mods/shared.zip");
+    dir.Write("Data/Mods/mine.zip", "mine");
+    Core core {ScratchConfig(dir)};
+    core.ActivateProfile("Other", "stash");
+    CHECK_EQ(Files(dir.Path() / "Data/Mods"), (FileMap{{"own.zip", "own"}, {"shared.zip", "shared"}}));
+    // What Other already holds is listed in the stash, only the rest is stored there
+    const auto delta {DeltaManifest::Load(profiles / "stash")};
+    CHECK(delta.has_value());
+    if (!delta) return;
+    CHECK_EQ(delta->reference, "Other");
+    CHECK(delta->roots.contains("Mods") && delta->roots.at("Mods").size() == 1 && delta->roots.at("Mods")[0].path == "shared.zip");
+    CHECK_EQ(Files(profiles / "stash"), (FileMap{{"mine.zip", "mine"}}));
+
+    // Activating the stash puts its listed files back first, from Other
+    core.ActivateProfile("stash", "back");
+    CHECK(!DeltaManifest::Load(profiles / "stash").has_value());
+    CHECK_EQ(Files(profiles / "stash"), (FileMap{{"mine.zip", "mine"}, {"shared.zip", "shared"}}));
+    CHECK_EQ(Files(dir.Path() / "Data/Mods"), (FileMap{{"mine.zip", "mine"}, {"shared.zip", "shared"}}));
+    CHECK_EQ(Config::Load(constants::kConfigPath).activeProfile, "stash");
+}
+
+TEST(Activation, CleanModsIsListedInsteadOfStashed) {
+    const ScratchDir dir;
+    dir.Write("Profiles/A/a.zip", "a");
+    dir.Write("Profiles/A/folder/inner.json", "{}");
+    dir.Write(StoredRoot("Profiles/A", "ModConfig") / "a.json", "config a");
+    dir.Write("Profiles/B/b.zip", "b");
+    const fs::path profiles {dir.Path() / "Profiles"};
+    Core core {ScratchConfig(dir)};
+    core.ActivateProfile("A", "first");
+    CHECK(core.ModsClean());
+    dir.Write("Data/ModConfig/a.json", "config a, edited in game");
+
+    core.ActivateProfile("B", "second");
+    CHECK_EQ(Files(dir.Path() / "Data/Mods"), (FileMap{{"b.zip", "b"}}));
+    // Mods was exactly A, so the stash lists A's mods instead of copying them; ModConfig changed and is stored
+    CHECK_EQ(Files(profiles / "second"), FileMap{});
+    CHECK_EQ(Files(StoredRoot(profiles / "second", "ModConfig")), (FileMap{{"a.json", "config a, edited in game"}}));
+    const auto delta {DeltaManifest::Load(profiles / "second")};
+    CHECK(delta.has_value());
+    if (!delta) return;
+    CHECK_EQ(delta->reference, "A");
+    CHECK_EQ(delta->FileCount(), 2u);
+    CHECK(delta->roots.contains("Mods") && delta->roots.at("Mods").size() == 2);
+    CHECK(fs::is_directory(profiles / "second/folder")); // folders are made, so putting files back needs no mkdir
+    CHECK(core.MaterialiseStash(profiles / "second"));
+    CHECK_EQ(Files(profiles / "second"), (FileMap{{"a.zip", "a"}, {"folder/inner.json", "{}"}}));
+}
+
+TEST(Activation, ModsChangedSinceActivationIsStashed) {
+    const ScratchDir dir;
+    dir.Write("Profiles/A/a.zip", "a");
+    dir.Write("Profiles/A/folder/inner.json", "{}");
+    dir.Write("Profiles/B/b.zip", "b");
+    const fs::path profiles {dir.Path() / "Profiles"};
+    Core core {ScratchConfig(dir)};
+    core.ActivateProfile("A", "first");
+    CHECK(core.ModsClean());
+    // An update replacing a mod in game, the profile's own copy untouched
+    fs::remove(dir.Path() / "Data/Mods/a.zip");
+    dir.Write("Data/Mods/a.zip", "a, updated");
+    CHECK(!core.ModsClean());
+
+    core.ActivateProfile("B", "second");
+    CHECK_EQ(Files(profiles / "second"), (FileMap{{"a.zip", "a, updated"}, {"folder/inner.json", "{}"}}));
+    const auto delta {DeltaManifest::Load(profiles / "second")};
+    CHECK(!delta || !delta->roots.contains("Mods"));
+    CHECK_EQ(Files(profiles / "A"), (FileMap{{"a.zip", "a"}, {"folder/inner.json", "{}"}}));
+}
+
+TEST(Activation, CleanAnswerIsTiedToItsGeneration) {
+    const ScratchDir dir;
+    dir.Write("Profiles/A/a.zip", "a");
+    dir.Write("Profiles/A/folder/inner.json", "{}");
+    dir.Write("Profiles/B/b.zip", "b");
+    const fs::path profiles {dir.Path() / "Profiles"};
+    const fs::path statePath {dir.Path() / "Data/.Mods.vsprofile-state.json"};
+    DirectoryCache cache; // as in the daemon, when inotify is there
+    Core core {ScratchConfig(dir)};
+    core.SetDirectoryCache(&cache);
+    core.ActivateProfile("A", "first");
+    CHECK(core.ModsClean());
+
+    // Another process recorded a later activation since, one this process never saw Mods clean for
+    auto state {ModsState::Load(statePath)};
+    CHECK(state.has_value());
+    if (!state) return;
+    ++state->generation;
+    state->manifest.entries.pop_back();
+    CHECK(state->Save(statePath));
+    CHECK(!core.ModsClean());
+
+    core.ActivateProfile("B", "second");
+    CHECK_EQ(Files(profiles / "second"), (FileMap{{"a.zip", "a"}, {"folder/inner.json", "{}"}}));
+    const auto delta {DeltaManifest::Load(profiles / "second")};
+    CHECK(!delta || delta->reference == "B");
+}
+
+namespace {
+
+    constexpr int kGonePid = std::numeric_limits<int>::max(); // past any system's pid range
+
+    // The journal an activation of Survival into an empty profile list leaves behind, cut short once the ops
+    // `ran` picks out had run; its process was `pid`
+    void WriteInterruptedActivation(const ScratchDir& dir, const std::function<bool(const utl::FileOp&)>& ran, const int pid) {
+        const fs::path stash {dir.Path() / "Profiles/stash"};
+        const fs::path mods {dir.Path() / "Data/Mods"};
+        fs::create_directories(stash);
+        utl::SyncPlan plan;
+        CHECK(plan.AddSync(mods, stash, utl::SyncStrategy::Link));
+        CHECK(plan.AddSync(dir.Path() / "Profiles/Survival", mods, utl::SyncStrategy::Link));
+        ActivationJournal journal;
+        journal.profile = "Survival";
+        journal.stash = stash;
+        journal.modsFrom = stash;
+        journal.pid = pid;
+        journal.ops = plan.ops;
+        CHECK(journal.Begin(constants::kJournalDir));
+        JournalLog log {constants::kJournalDir};
+        utl::SyncPlan done;
+        std::vector<std::size_t> indices;
+        for (std::size_t i = 0; i < plan.ops.size(); ++i) {
+            if (!ran(plan.ops[i])) continue;
+            done.ops.push_back(plan.ops[i]);
+            indices.push_back(i);
+        }
+        done.completed = [&](const std::size_t op) { log.Done(indices[op]); };
+        CHECK_EQ(done.Execute(), 0u);
+    }
+
+}
+
+TEST(Activation, InterruptedActivationIsFinishedOnStart) {
+    const ScratchDir dir;
+    dir.Write("Profiles/Survival/a.zip", "a");
+    dir.Write("Profiles/Survival/folder/b.zip", "b");
+    dir.Write("Data/Mods/old.zip", "old");
+    const fs::path stash {dir.Path() / "Profiles/stash"};
+    // Killed once the stash was captured and the first mod was in
+    bool firstMod {true};
+    WriteInterruptedActivation(dir, [&](const utl::FileOp& op) {
+        if (op.kind == utl::FileOp::Kind::Link && op.from.filename() == "a.zip") return std::exchange(firstMod, false);
+        return op.to.string().starts_with(stash.string());
+    }, kGonePid);
+    CHECK_EQ(Files(stash), (FileMap{{"old.zip", "old"}}));
+    CHECK_EQ(Files(dir.Path() / "Data/Mods"), (FileMap{{"a.zip", "a"}, {"old.zip", "old"}}));
+    {
+        const Core core {ScratchConfig(dir)};
+    }
+    CHECK_EQ(Files(dir.Path() / "Data/Mods"), (FileMap{{"a.zip", "a"}, {"folder/b.zip", "b"}}));
+    CHECK_EQ(Files(stash), (FileMap{{"old.zip", "old"}}));
+    CHECK_EQ(Config::Load(constants::kConfigPath).activeProfile, "Survival");
+    CHECK(!ActivationJournal::Load(constants::kJournalDir).has_value());
+}
+
+TEST(Activation, InterruptedActivationRollsBackWithoutItsProfile) {
+    const ScratchDir dir;
+    dir.Write("Profiles/Survival/a.zip", "a");
+    dir.Write("Data/Mods/old.zip", "old");
+    dir.Write("Data/Mods/kept/inner.json", "{}");
+    const fs::path stash {dir.Path() / "Profiles/stash"};
+    // Killed part way into the stash, with a mod of the incoming profile already in Mods
+    bool firstInStash {true};
+    WriteInterruptedActivation(dir, [&](const utl::FileOp& op) {
+        if (op.to.string().starts_with(stash.string()) && op.kind == utl::FileOp::Kind::Link) return std::exchange(firstInStash, false);
+        return op.kind == utl::FileOp::Kind::MakeDir || op.from.filename() == "a.zip";
+    }, kGonePid);
+    Config config {ScratchConfig(dir)};
+    config.activeProfile = "Creative";
+    config.Save(constants::kConfigPath);
+    fs::remove_all(dir.Path() / "Profiles/Survival");
+    {
+        const Core core {config};
+    }
+    // The stash is finished, and Mods put back to what it held
+    CHECK_EQ(Files(stash), (FileMap{{"kept/inner.json", "{}"}, {"old.zip", "old"}}));
+    CHECK_EQ(Files(dir.Path() / "Data/Mods"), (FileMap{{"kept/inner.json", "{}"}, {"old.zip", "old"}}));
+    CHECK_EQ(Config::Load(constants::kConfigPath).activeProfile, "Creative");
+    CHECK(!ActivationJournal::Load(constants::kJournalDir).has_value());
+}
+
+TEST(Activation, OnlyALiveAppProcessHoldsAJournal) {
+    // The test runner is named like the app, so it stands in for an activation still running
+    CHECK(utl::IsAppProcess(utl::CurrentProcessId()));
+    CHECK(!utl::IsAppProcess(kGonePid));
+    CHECK(!utl::IsAppProcess(-1));
+#if defined(__linux__)
+    CHECK(!utl::IsAppProcess(1)); // alive, but another program: a pid reused since the journal was written
+#endif
+}
+
+namespace {
+
+    // The config the last activation saved, switched to `strategy`, as a user editing it between runs would
+    Config SavedWith(const ActivationStrategy strategy) {
+        Config config {Config::Load(constants::kConfigPath)};
+        config.modsPath = config.vintagestoryDataPath / "Mods"; // not part of the saved config
+        config.activationStrategy = strategy;
+        return config;
+    }
+
+    bool Writable(const fs::path& dir) {
+        return (fs::status(dir).permissions() & fs::perms::owner_write) != fs::perms::none;
+    }
+
+    // What `run` printed to std::cout
+    std::string Printed(const std::function<void()>& run) {
+        std::ostringstream out;
+        std::streambuf* const stdoutBuf {std::cout.rdbuf(out.rdbuf())};
+        run();
+        std::cout.rdbuf(stdoutBuf);
+        return out.str();
+    }
+
+}
+
+TEST(Activation, SymlinkIsRetargetedByRename) {
+    const ScratchDir dir;
+    dir.Write("Profiles/A/a.zip", "a");
+    dir.Write("Profiles/B/b.zip", "b");
+    dir.Write("Data/Mods/old.zip", "old");
+    const fs::path profiles {dir.Path() / "Profiles"};
+    const fs::path mods {dir.Path() / "Data/Mods"};
+    Config config {ScratchConfig(dir)};
+    config.activationStrategy = ActivationStrategy::Symlink;
+    Core core {config};
+    core.ActivateProfile("A", "first");
+    // The real folder moved whole into the stash to make way for the link
+    CHECK_EQ(Files(profiles / "first"), (FileMap{{"old.zip", "old"}}));
+    CHECK(fs::is_symlink(mods));
+    CHECK(fs::read_symlink(mods) == fs::absolute(profiles / "A"));
+    CHECK(core.LinkedProfile() == fs::absolute(profiles / "A"));
+
+    // A link left by a run killed between making and renaming it is replaced, never followed
+    fs::create_directory_symlink(profiles / "B", mods.parent_path() / ".Mods.vsprofile-link");
+    core.ActivateProfile("B", "second");
+    CHECK(fs::read_symlink(mods) == fs::absolute(profiles / "B"));
+    CHECK(!fs::exists(fs::symlink_status(mods.parent_path() / ".Mods.vsprofile-link")));
+    CHECK_EQ(Files(mods), (FileMap{{"b.zip", "b"}}));
+    // Mods was A itself, so nothing was stashed from it
+    CHECK_EQ(Files(profiles / "second"), FileMap{});
+    CHECK_EQ(Files(profiles / "A"), (FileMap{{"a.zip", "a"}}));
+    CHECK(!core.ModsClean()); // nothing recorded for a link, what it holds is the profile itself
+    Core::GuardProfile(profiles / "B", false);
+}
+
+TEST(Activation, LinkedProfileIsReadOnly) {
+    const ScratchDir dir;
+    dir.Write("Profiles/A/a.zip", "a");
+    dir.Write("Profiles/B/b.zip", "b");
+    dir.Write("Data/Mods/old.zip", "old");
+    const fs::path profiles {dir.Path() / "Profiles"};
+    Config config {ScratchConfig(dir)};
+    config.activationStrategy = ActivationStrategy::Symlink;
+    Core core {config};
+    core.ActivateProfile("A", "first");
+    // Mods can not gain or lose entries through the link, only while A is linked
+    CHECK(!Writable(profiles / "A"));
+    CHECK(Writable(profiles / "B"));
+    core.ActivateProfile("B", "second");
+    CHECK(Writable(profiles / "A"));
+    CHECK(!Writable(profiles / "B"));
+    Core::GuardProfile(profiles / "B", false); // so the scratch folder can be removed
+}
+
+TEST(Activation, EditsThroughTheLinkAreReportedOnce) {
+    const ScratchDir dir;
+    dir.Write("Profiles/A/a.zip", "a");
+    dir.Write("Profiles/A/b.zip", "b");
+    dir.Write("Data/Mods/old.zip", "old");
+    const fs::path profiles {dir.Path() / "Profiles"};
+    Config config {ScratchConfig(dir)};
+    config.activationStrategy = ActivationStrategy::Symlink;
+    {
+        Core core {config};
+        core.ActivateProfile("A", "first");
+        CHECK_EQ(Printed([&] { core.ReportLinkedChanges(); }), "");
+    }
+    // The game, between runs, rewriting a mod in place through the link
+    dir.Write("Data/Mods/a.zip", "a, patched in game");
+    Core core {SavedWith(ActivationStrategy::Symlink)};
+    const std::string report {Printed([&] { core.ReportLinkedChanges(); })};
+    CHECK(report.find("'A' was modified in place") != std::string::npos);
+    CHECK(report.find("~ a.zip") != std::string::npos);
+    CHECK(report.find("b.zip") == std::string::npos);
+    CHECK_EQ(Printed([&] { core.ReportLinkedChanges(); }), "");
+    CHECK_EQ(dir.Read("Profiles/A/a.zip"), "a, patched in game");
+    Core::GuardProfile(profiles / "A", false);
+}
+
+TEST(Activation, SyncSymlinkSyncLeavesARealMods) {
+    const ScratchDir dir;
+    dir.Write("Profiles/A/a.zip", "a");
+    dir.Write("Profiles/A/folder/inner.json", "{}");
+    dir.Write("Profiles/B/b.zip", "b");
+    dir.Write("Data/Mods/old.zip", "old");
+    const fs::path profiles {dir.Path() / "Profiles"};
+    const fs::path mods {dir.Path() / "Data/Mods"};
+    {
+        Core core {ScratchConfig(dir)};
+        core.ActivateProfile("A", "first");
+    }
+    {
+        Core core {SavedWith(ActivationStrategy::Symlink)};
+        core.ActivateProfile("B", "second");
+        CHECK(fs::is_symlink(mods));
+    }
+    // The real Mods moved out whole into the stash
+    CHECK_EQ(Files(profiles / "second"), (FileMap{{"a.zip", "a"}, {"folder/inner.json", "{}"}}));
+    {
+        Core core {SavedWith(ActivationStrategy::Sync)};
+        core.ActivateProfile("A", "third");
+        CHECK(core.ModsClean());
+    }
+    CHECK(!fs::is_symlink(mods));
+    CHECK(fs::is_directory(mods));
+    CHECK_EQ(Files(mods), (FileMap{{"a.zip", "a"}, {"folder/inner.json", "{}"}}));
+    // B is whole, writable again, and nothing of it was stashed: it was Mods
+    CHECK_EQ(Files(profiles / "B"), (FileMap{{"b.zip", "b"}}));
+    CHECK(Writable(profiles / "B"));
+    CHECK_EQ(Files(profiles / "third"), FileMap{});
+    CHECK_EQ(Files(profiles / "first"), (FileMap{{"old.zip", "old"}}));
+}
+
+TEST(Activation, PreparedProfileIsRenamedIntoPlace) {
+    const ScratchDir dir;
+    dir.Write("Profiles/A/a.zip", "a");
+    dir.Write("Profiles/B/b.zip", "b");
+    dir.Write("Profiles/B/folder/inner.json", "{}");
+    dir.Write("Data/Mods/old.zip", "old");
+    const fs::path profiles {dir.Path() / "Profiles"};
+    const fs::path mods {dir.Path() / "Data/Mods"};
+    const fs::path staging {dir.Path() / "Data/.Mods.vsprofile-staged"};
+    Config config {ScratchConfig(dir)};
+    // Copied rather than linked, so a file synced again from the profile is a new one
+    config.roots = {{"Mods", utl::SyncStrategy::Copy}};
+    Core core {config};
+    core.ActivateProfile("A", "first");
+    core.PrepareProfile("B");
+    core.WaitForStaging();
+    CHECK_EQ(Files(staging), (FileMap{{"b.zip", "b"}, {"folder/inner.json", "{}"}}));
+    CHECK_EQ(dir.Read("Data/.Mods.vsprofile-staged.profile"), "B\n");
+    CHECK(core.StagedUpToDate("B", profiles / "B"));
+    CHECK(!core.StagedUpToDate("A", profiles / "A")); // staged for another profile
+
+    fs::create_hard_link(staging / "b.zip", dir.Path() / "staged-b.zip");
+    core.ActivateProfile("B", "second");
+    CHECK_EQ(Files(mods), (FileMap{{"b.zip", "b"}, {"folder/inner.json", "{}"}}));
+    CHECK(fs::equivalent(mods / "b.zip", dir.Path() / "staged-b.zip")); // the staged file itself, not a copy
+    CHECK(!fs::exists(dir.Path() / "Data/.Mods.vsprofile-staged.profile"));
+    CHECK_EQ(Files(profiles / "B"), (FileMap{{"b.zip", "b"}, {"folder/inner.json", "{}"}}));
+    // Mods was A untouched, so it went back to staging as the base for the next 'prepare'
+    CHECK_EQ(Files(staging), (FileMap{{"a.zip", "a"}}));
+    CHECK_EQ(Files(profiles / "A"), (FileMap{{"a.zip", "a"}}));
+}
+
+TEST(Activation, StaleStageIsSyncedOver) {
+    const ScratchDir dir;
+    dir.Write("Profiles/A/a.zip", "a");
+    dir.Write("Profiles/B/b.zip", "b");
+    dir.Write("Data/Mods/old.zip", "old");
+    const fs::path profiles {dir.Path() / "Profiles"};
+    const fs::path mods {dir.Path() / "Data/Mods"};
+    Config config {ScratchConfig(dir)};
+    config.roots = {{"Mods", utl::SyncStrategy::Copy}};
+    Core core {config};
+    core.ActivateProfile("A", "first");
+    core.PrepareProfile("B");
+    core.WaitForStaging();
+    CHECK(core.StagedUpToDate("B", profiles / "B"));
+
+    // The profile changed after staging
+    dir.Write("Profiles/B/b.zip", "b, updated");
+    CHECK(!core.StagedUpToDate("B", profiles / "B"));
+    core.ActivateProfile("B", "second");
+    CHECK_EQ(Files(mods), (FileMap{{"b.zip", "b, updated"}}));
+
+    // The staged copy changed after staging
+    core.PrepareProfile("A");
+    core.WaitForStaging();
+    CHECK(core.StagedUpToDate("A", profiles / "A"));
+    dir.Write("Data/.Mods.vsprofile-staged/extra.zip", "extra");
+    CHECK(!core.StagedUpToDate("A", profiles / "A"));
+    core.ActivateProfile("A", "third");
+    CHECK_EQ(Files(mods), (FileMap{{"a.zip", "a"}}));
+}
+
+TEST(Activation, NextProfileIsPredictedFromHistory) {
+    const ScratchDir dir;
+    for (const char* name : {"A", "B", "C"}) dir.Write(std::format("Profiles/{}/{}.zip", name, name), name);
+    Config config {ScratchConfig(dir)};
+    config.activeProfile = "A";
+    // B followed A twice, C once
+    config.activationHistory = {"A", "B", "A", "C", "A", "B", "A"};
+    CHECK_EQ(Core{config}.PredictNextProfile(), "B");
+    // A tie goes to the most recent successor
+    config.activationHistory = {"A", "B", "A", "C", "A"};
+    CHECK_EQ(Core{config}.PredictNextProfile(), "C");
+    // A successor whose folder is gone is never predicted
+    config.activationHistory = {"A", "D", "A", "D", "A", "C", "A"};
+    CHECK_EQ(Core{config}.PredictNextProfile(), "C");
+    // Never left A yet: the most recent other profile
+    config.activationHistory = {"C", "B", "A"};
+    CHECK_EQ(Core{config}.PredictNextProfile(), "B");
+    config.activationHistory = {"A"};
+    CHECK_EQ(Core{config}.PredictNextProfile(), "");
+
+    // 'prepare' with no name stages the prediction
+    config.activationHistory = {"A", "C", "A"};
+    Core core {config};
+    core.PrepareProfile("");
+    core.WaitForStaging();
+    CHECK_EQ(dir.Read("Data/.Mods.vsprofile-staged.profile"), "C\n");
+    CHECK_EQ(Files(dir.Path() / "Data/.Mods.vsprofile-staged"), (FileMap{{"C.zip", "C"}}));
+}
+
+TEST(Activation, ConfigWithoutRootsStillCopiesMods) {
+    const ScratchDir dir;
+    dir.Write("Profiles/A/a.zip", "a");
+    dir.Write("Data/ModConfig/a.json", "config");
+    // As written before profiles held more than Mods
+    dir.Write("Config.json", std::format(R"({{"vintagestoryDataPath": "{}", "profilesPath": "{}",
+                                              "activeProfile": "", "vintagestoryExePath": ""}})",
+                                         (dir.Path() / "Data").generic_string(), (dir.Path() / "Profiles").generic_string()));
+    Config config {Config::Load(dir.Path() / "Config.json")};
+    CHECK_EQ(config.roots.size(), 1u);
+    CHECK(config.roots.front().IsMods() && config.roots.front().strategy == utl::SyncStrategy::Copy);
+    config.modsPath = config.vintagestoryDataPath / "Mods";
+    Core core {config};
+    core.ActivateProfile("A", "first");
+    CHECK_EQ(Files(dir.Path() / "Data/Mods"), (FileMap{{"a.zip", "a"}}));
+    // Editing the copy in Mods leaves the profile alone, and ModConfig is not swapped
+    CHECK(!fs::equivalent(dir.Path() / "Data/Mods/a.zip", dir.Path() / "Profiles/A/a.zip"));
+    CHECK_EQ(dir.Read("Data/ModConfig/a.json"), "config");
+    CHECK(!fs::exists(StoredRoot(dir.Path() / "Profiles/first", "ModConfig")));
+
+    // A roots list without Mods gains it, also copied
+    dir.Write("Config.json", std::format(R"({{"vintagestoryDataPath": "{}", "profilesPath": "{}",
+                                              "activeProfile": "", "vintagestoryExePath": "",
+                                              "roots": [{{"path": "ModConfig", "strategy": "copy"}}]}})",
+                                         (dir.Path() / "Data").generic_string(), (dir.Path() / "Profiles").generic_string()));
+    const Config listed {Config::Load(dir.Path() / "Config.json")};
+    CHECK_EQ(listed.roots.size(), 2u);
+    CHECK(listed.roots.front().IsMods() && listed.roots.front().strategy == utl::SyncStrategy::Copy);
+}
+
+TEST(Activation, CachesTravelWithTheirProfile) {
+    const ScratchDir dir;
+    dir.Write("Profiles/A/a.zip", "a");
+    dir.Write("Profiles/B/b.zip", "b");
+    dir.Write("Profiles/C/c.zip", "c");
+    dir.Write("Data/Cache/shaders.bin", "built for A");
+    const fs::path profiles {dir.Path() / "Profiles"};
+    const fs::path live {dir.Path() / "Data/Cache"};
+    auto parked = [&](const std::string& profile) { return profiles / profile / constants::kProfileMetaDir / "cache/Cache"; };
+    dir.Write(fs::path{"Profiles/B"} / constants::kProfileMetaDir / "cache/Cache/shaders.bin", "built for B");
+    Config config {ScratchConfig(dir)};
+    CHECK(config.cachePaths.empty()); // only kept when listed
+    config.cachePaths = {"Cache"};
+    const Core core {config};
+
+    // A parks its cache and B gets its own back
+    core.SwapCaches(profiles / "A", profiles / "B");
+    CHECK_EQ(Files(parked("A")), (FileMap{{"shaders.bin", "built for A"}}));
+    CHECK_EQ(Files(live), (FileMap{{"shaders.bin", "built for B"}}));
+    CHECK(!fs::exists(parked("B")));
+
+    // C never had one, so the game starts it from nothing
+    core.SwapCaches(profiles / "B", profiles / "C");
+    CHECK_EQ(Files(parked("B")), (FileMap{{"shaders.bin", "built for B"}}));
+    CHECK(!fs::exists(live));
+
+    dir.Write("Data/Cache/shaders.bin", "built for C");
+    core.SwapCaches(profiles / "C", profiles / "A");
+    CHECK_EQ(Files(parked("C")), (FileMap{{"shaders.bin", "built for C"}}));
+    CHECK_EQ(Files(live), (FileMap{{"shaders.bin", "built for A"}}));
+    CHECK(!fs::exists(parked("A")));
+}
@@ -0,0 +1,62 @@
+#include "Check.hpp"
+#include "../Utils/StatsUtils.hpp"
+#include "../Utils/deltaDebug.hpp"
+#include <algorithm>
+
+using namespace vsprofile::utils;
+
+namespace {
+
+    bool Contains(const std::vector<std::string>& mods, const std::string& mod) {
+        return std::ranges::find(mods, mod) != mods.end();
+    }
+
+}
+
+TEST(Bisect, MedianIntervalComesFromOrderStatistics) {
+    // Shuffled 1..10: the median is 5.5, and for n = 10 the widest interval still at 95% is
+    // [x(1), x(8)], covering with probability 1 - 2 * 11/1024
+    const MedianEstimate est {EstimateMedian({7, 2, 9, 4, 1, 10, 3, 6, 8, 5})};
+    CHECK_EQ(est.median, 5.5);
+    CHECK_EQ(est.lo, 2.0);
+    CHECK_EQ(est.hi, 9.0);
+    CHECK_EQ(est.confidence, 1.0 - 22.0 / 1024.0);
+}
+
+TEST(Bisect, MedianOfFewSamplesKeepsTheFullRange) {
+    const MedianEstimate est {EstimateMedian({3, 1, 2})};
+    CHECK_EQ(est.median, 2.0);
+    CHECK_EQ(est.lo, 1.0);
+    CHECK_EQ(est.hi, 3.0);
+    CHECK_EQ(est.confidence, 0.75); // all three samples can only reach 1 - 2/8
+    const MedianEstimate none {EstimateMedian({})};
+    CHECK_EQ(none.median, 0.0);
+    CHECK_EQ(none.confidence, 0.0);
+}
+
+TEST(Bisect, WithoutChunkDropsOneRoughlyEqualPart) {
+    const std::vector<std::string> mods {"a", "b", "c", "d", "e"};
+    CHECK_EQ(withoutChunk(mods, 0, 2), (std::vector<std::string>{"d", "e"}));
+    CHECK_EQ(withoutChunk(mods, 1, 2), (std::vector<std::string>{"a", "b", "c"}));
+    CHECK_EQ(withoutChunk(mods, 4, 5), (std::vector<std::string>{"a", "b", "c", "d"}));
+}
+
+TEST(Bisect, DdminFindsAnInteractingPair) {
+    std::vector<std::string> mods;
+    for (char c = 'a'; c <= 'p'; ++c) mods.emplace_back(1, c);
+    std::size_t trials {};
+    const auto regressed = [&](const std::vector<std::string>& set) {
+        ++trials;
+        return Contains(set, "c") && Contains(set, "n");
+    };
+    CHECK_EQ(ddmin(mods, regressed), (std::vector<std::string>{"c", "n"}));
+    CHECK(trials < mods.size() * mods.size()); // far fewer launches than trying every pair
+}
+
+TEST(Bisect, DdminKeepsASingleCulprit) {
+    const std::vector<std::string> mods {"a", "b", "c"};
+    CHECK_EQ(ddmin(mods, [](const auto& set) { return Contains(set, "b"); }),
+             (std::vector<std::string>{"b"}));
+    // When nothing smaller reproduces, the whole set is the answer
+    CHECK_EQ(ddmin(mods, [&](const auto& set) { return set.size() == mods.size(); }), mods);
+}
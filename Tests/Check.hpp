@@ -0,0 +1,76 @@
+#pragma once
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Just enough of a test framework for ctest: TEST registers a case under a group, CHECK and
+// CHECK_EQ record a failure and carry on, and the runner exits non-zero when any check failed.
+namespace vsprofile::tests {
+
+    struct TestCase {
+        std::string_view group;
+        std::string_view name;
+        void (*run)();
+    };
+
+    inline std::vector<TestCase>& Registry() {
+        static std::vector<TestCase> cases;
+        return cases;
+    }
+
+    inline std::size_t& Failures() {
+        static std::size_t failures {};
+        return failures;
+    }
+
+    struct Registrar {
+        Registrar(const std::string_view group, const std::string_view name, void (*run)()) {
+            Registry().push_back({group, name, run});
+        }
+    };
+
+    inline void Fail(const std::string& what, const std::source_location where) {
+        ++Failures();
+        std::cerr << std::format("{}:{}: check failed: {}\n", where.file_name(), where.line(), what);
+    }
+
+    // A fresh folder under the system temp folder, removed with everything in it when it goes
+    class ScratchDir {
+        std::filesystem::path path_;
+
+    public:
+        ScratchDir();
+        ScratchDir(const ScratchDir&) = delete;
+        ScratchDir& operator=(const ScratchDir&) = delete;
+        ~ScratchDir();
+
+        [[nodiscard]] const std::filesystem::path& Path() const { return path_; }
+        // Writes `content` to the relative path `rel`, creating the folders above it
+        void Write(const std::filesystem::path& rel, std::string_view content) const;
+        [[nodiscard]] std::string Read(const std::filesystem::path& rel) const; // empty when missing
+    };
+
+}
+
+#define TEST(group, name)                                                                                      \
+    static void group##_##name();                                                                              \
+    static const ::vsprofile::tests::Registrar group##_##name##_registrar {#group, #name, &group##_##name};   \
+    static void group##_##name()
+
+#define CHECK(expr)                                                                                            \
+    do {                                                                                                       \
+        if (!(expr)) ::vsprofile::tests::Fail(#expr, std::source_location::current());                         \
+    } while (false)
+
+#define CHECK_EQ(actual, expected)                                                                             \
+    do {                                                                                                       \
+        const auto& vsprofileActual_ = (actual);                                                               \
+        const auto& vsprofileExpected_ = (expected);                                                           \
+        if (!(vsprofileActual_ == vsprofileExpected_)) {                                                       \
+            ::vsprofile::tests::Fail(#actual " == " #expected, std::source_location::current());              \
+        }                                                                                                      \
+    } while (false)
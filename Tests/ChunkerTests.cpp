@@ -0,0 +1,74 @@
+#include "Check.hpp"
+#include "../Utils/Chunker.hpp"
+#include <cstdint>
+#include <set>
+
+using vsprofile::utils::ContentChunker;
+
+namespace {
+
+    constexpr std::size_t kMin {2 * 1024}, kAvg {8 * 1024}, kMax {32 * 1024};
+
+    // Reproducible noise, so the boundaries are the same on every run
+    std::vector<unsigned char> Noise(const std::size_t size, std::uint64_t state) {
+        std::vector<unsigned char> bytes(size);
+        for (auto& b : bytes) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            b = static_cast<unsigned char>(state >> 56);
+        }
+        return bytes;
+    }
+
+    // Cut points of the whole buffer, as offsets from its start
+    std::vector<std::size_t> Boundaries(const ContentChunker& chunker, const std::vector<unsigned char>& data) {
+        std::vector<std::size_t> cuts;
+        for (std::size_t pos {}; pos < data.size();) {
+            pos += chunker.Cut(data.data() + pos, data.size() - pos);
+            cuts.push_back(pos);
+        }
+        return cuts;
+    }
+
+}
+
+TEST(Chunker, ChunksStayWithinBounds) {
+    const ContentChunker chunker {kMin, kAvg, kMax};
+    const std::vector<unsigned char> data {Noise(1024 * 1024, 1)};
+    const std::vector<std::size_t> cuts {Boundaries(chunker, data)};
+    CHECK_EQ(cuts.back(), data.size());
+    std::size_t previous {};
+    for (std::size_t i = 0; i < cuts.size(); ++i) {
+        const std::size_t len {cuts[i] - previous};
+        CHECK(len <= kMax);
+        if (i + 1 < cuts.size()) CHECK(len > kMin); // only the tail may come up short
+        previous = cuts[i];
+    }
+    // Normalisation keeps the average near the target rather than anywhere between min and max
+    const std::size_t average {data.size() / cuts.size()};
+    CHECK(average > kAvg / 2 && average < 2 * kAvg);
+}
+
+TEST(Chunker, ShortInputIsOneChunk) {
+    const ContentChunker chunker {kMin, kAvg, kMax};
+    const std::vector<unsigned char> data {Noise(kMin, 2)};
+    CHECK_EQ(chunker.Cut(data.data(), data.size()), kMin);
+    CHECK_EQ(chunker.Cut(data.data(), 10), 10u);
+    // Without a content boundary the chunk is cut at the maximum size
+    const std::vector<unsigned char> flat(4 * kMax, 0);
+    CHECK(chunker.Cut(flat.data(), flat.size()) <= kMax);
+}
+
+TEST(Chunker, AnInsertOnlyMovesNearbyBoundaries) {
+    const ContentChunker chunker {kMin, kAvg, kMax};
+    const std::vector<unsigned char> original {Noise(512 * 1024, 3)};
+    std::vector<unsigned char> edited {original};
+    const std::vector<unsigned char> inserted {Noise(100, 4)};
+    edited.insert(edited.begin() + 1000, inserted.begin(), inserted.end());
+
+    const std::vector<std::size_t> before {Boundaries(chunker, original)};
+    std::set<std::size_t> after;
+    for (const std::size_t cut : Boundaries(chunker, edited)) after.insert(cut - inserted.size());
+    std::size_t kept {};
+    for (const std::size_t cut : before) kept += after.contains(cut);
+    CHECK(kept + 2 >= before.size()); // at most the chunks around the edit differ
+}
@@ -0,0 +1,93 @@
+#include "Check.hpp"
+#include "../Utils/CopyCalibration.hpp"
+#include "../Utils/FileUtils.hpp"
+#include <atomic>
+#include <thread>
+
+namespace fs = std::filesystem;
+namespace utl = vsprofile::utils;
+using vsprofile::tests::ScratchDir;
+
+namespace {
+
+    std::string Pattern(const std::size_t size) {
+        std::string content(size, '\0');
+        for (std::size_t i = 0; i < size; ++i) content[i] = static_cast<char>('a' + i % 23);
+        return content;
+    }
+
+    // Calibrates the pair the scratch folder forms with itself and returns its key, empty where
+    // copies are not calibrated (no Linux)
+    std::string CalibratedPair(const ScratchDir& dir) {
+        utl::SetCopyCalibrations({});
+        utl::CopyCalibrations drained;
+        utl::TakeNewCopyCalibrations(drained);
+        dir.Write("sample.bin", Pattern(512 * 1024)); // above the smallest file worth a sample
+        std::error_code ec;
+        utl::CloneFile(dir.Path() / "sample.bin", dir.Path() / "sample.copy", ec);
+        utl::CopyCalibrations taken;
+        if (!utl::TakeNewCopyCalibrations(taken) || taken.size() != 1) return {};
+        return taken.begin()->first;
+    }
+
+}
+
+TEST(CopyCalibration, MethodNamesRoundTrip) {
+    for (const auto method : {utl::CopyMethod::Reflink, utl::CopyMethod::CopyFileRange, utl::CopyMethod::Sendfile,
+                              utl::CopyMethod::ReadWrite}) {
+        CHECK(utl::CopyMethodFromString(utl::ToString(method)) == method);
+    }
+    CHECK(utl::CopyMethodFromString("splice") == utl::CopyMethod::CopyFileRange);
+    CHECK(utl::CopyMethodFromString("") == utl::CopyMethod::CopyFileRange);
+}
+
+TEST(CopyCalibration, NewPairsAreHandedOverOnce) {
+    const ScratchDir dir;
+    const std::string key {CalibratedPair(dir)};
+    if (key.empty()) return;
+    CHECK(key.find("->") != std::string::npos);
+    CHECK_EQ(dir.Read("sample.copy"), Pattern(512 * 1024));
+    // Already known, so copying between the same pair again measures nothing new
+    std::error_code ec;
+    utl::CloneFile(dir.Path() / "sample.bin", dir.Path() / "again.copy", ec);
+    utl::CopyCalibrations taken {{"kept", {}}};
+    CHECK(!utl::TakeNewCopyCalibrations(taken));
+    CHECK_EQ(taken.size(), 1u);
+}
+
+TEST(CopyCalibration, CloneFileRecoversFromAFailedMethod) {
+    const ScratchDir dir;
+    const std::string key {CalibratedPair(dir)};
+    if (key.empty()) return;
+    constexpr std::size_t kSize = 64 * 1024 * 1024;
+    constexpr std::size_t kShrunk = 1024 * 1024 + 5;
+    const std::string content {Pattern(kSize)};
+    dir.Write("big.bin", content);
+
+    // A plain read and write loop, cut short by the source shrinking once the copy has written some
+    // of it: the calibrated method fails with the destination partly written
+    utl::SetCopyCalibrations({{key, {utl::CopyMethod::ReadWrite, true, 1.0}}});
+    std::atomic<bool> done {false}, shrunk {false};
+    std::thread shrinker {[&] {
+        std::error_code ec;
+        while (!done && fs::file_size(dir.Path() / "big.copy", ec) == 0) {}
+        if (done) return;
+        fs::resize_file(dir.Path() / "big.bin", kShrunk, ec);
+        shrunk = !ec;
+    }};
+    std::error_code ec;
+    const bool copied {utl::CloneFile(dir.Path() / "big.bin", dir.Path() / "big.copy", ec)};
+    done = true;
+    shrinker.join();
+    CHECK(copied);
+    CHECK(!ec);
+    if (shrunk) CHECK(dir.Read("big.copy") == content.substr(0, kShrunk));
+    else CHECK(dir.Read("big.copy") == content); // finished before the source could shrink
+
+    // A method this filesystem refuses from the first call leaves the fallback an empty file
+    utl::SetCopyCalibrations({{key, {utl::CopyMethod::Reflink, true, 1.0}}});
+    dir.Write("small.bin", "reflink or not");
+    CHECK(utl::CloneFile(dir.Path() / "small.bin", dir.Path() / "small.copy", ec));
+    CHECK_EQ(dir.Read("small.copy"), "reflink or not");
+    utl::SetCopyCalibrations({});
+}
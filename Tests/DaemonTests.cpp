@@ -0,0 +1,180 @@
+#include "Check.hpp"
+#include "../Core/DaemonSession.hpp"
+#include "../Core/DirectoryCache.hpp"
+#include "../Utils/SocketUtils.hpp"
+#include "../Utils/TextUtils.hpp"
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+namespace utl = vsprofile::utils;
+using vsprofile::tests::ScratchDir;
+
+namespace {
+
+    using Handler = std::function<bool(const std::vector<std::string>&)>;
+
+    struct Exchange {
+        std::optional<bool> result; // as the client saw it
+        bool served {false};
+        std::string reply; // what the client printed
+        std::string log;   // what stayed on the daemon's stdout
+    };
+
+    // One request from RunRemote to ServeClient over a socket in `dir`, the daemon's side on its own thread
+    Exchange RoundTrip(const ScratchDir& dir, const std::string& line, const Handler& run, const std::string& answers = "") {
+        Exchange exchange;
+        const fs::path socket {dir.Path() / "d.sock"};
+        const int listenFd {utl::ListenUnix(socket)};
+        CHECK(listenFd >= 0);
+        if (listenFd < 0) return exchange;
+        std::ostringstream log;
+        vsprofile::ClientOutBuf out {log.rdbuf()};
+        std::streambuf* const stdoutBuf {std::cout.rdbuf(&out)};
+        std::thread server {[&] {
+            const int client {utl::AcceptClient(listenFd)};
+            exchange.served = vsprofile::ServeClient(client, out, run);
+            utl::CloseSocket(client);
+        }};
+        std::ostringstream reply;
+        std::istringstream in {answers};
+        exchange.result = vsprofile::RunRemote(socket, line, reply, in);
+        server.join();
+        std::cout.rdbuf(stdoutBuf);
+        utl::CloseSocket(listenFd);
+        exchange.reply = reply.str();
+        exchange.log = log.str();
+        return exchange;
+    }
+
+}
+
+TEST(Daemon, RequestAndReply) {
+    const ScratchDir dir;
+    std::vector<std::string> received;
+    const Exchange exchange {RoundTrip(dir, "activate \"My Profile\" stash", [&](const std::vector<std::string>& args) {
+        received = args;
+        std::cout << "from the command\n";
+        std::thread{[] { std::cout << "from its worker\n"; }}.join();
+        std::thread{[] {
+            utl::tBackgroundOutput = true;
+            std::cout << "from the stager\n";
+        }}.join();
+        return true;
+    })};
+    CHECK(exchange.served);
+    CHECK(exchange.result == std::optional<bool>{true});
+    CHECK_EQ(received, (std::vector<std::string>{"activate", "My Profile", "stash"}));
+    // Background work stays in the daemon's log, everything else the command prints reaches the client
+    CHECK_EQ(exchange.reply, "from the command\nfrom its worker\n");
+    CHECK_EQ(exchange.log, "from the stager\n");
+}
+
+TEST(Daemon, ReplyCarriesTheResult) {
+    const ScratchDir dir;
+    const Exchange failed {RoundTrip(dir, "update missing", [](const std::vector<std::string>&) {
+        std::cout << "no such profile\n";
+        return false;
+    })};
+    CHECK(failed.served);
+    CHECK(failed.result == std::optional<bool>{false});
+    CHECK_EQ(failed.reply, "no such profile\n");
+
+    // A confirmation is read back from the client, one line per question
+    std::string answer;
+    const Exchange confirmed {RoundTrip(dir, "clearall", [&](const std::vector<std::string>&) {
+        std::cout << "sure?\n";
+        std::getline(std::cin, answer);
+        return answer == "y";
+    }, "y\n")};
+    CHECK(confirmed.result == std::optional<bool>{true});
+    CHECK_EQ(answer, "y");
+    CHECK_EQ(confirmed.reply, "sure?\n");
+
+    // Nobody listening
+    std::ostringstream reply;
+    std::istringstream in;
+    CHECK(!vsprofile::RunRemote(dir.Path() / "d.sock", "status", reply, in).has_value());
+}
+
+TEST(Daemon, StalledClientTimesOut) {
+    const ScratchDir dir;
+    const fs::path socket {dir.Path() / "d.sock"};
+    const int listenFd {utl::ListenUnix(socket)};
+    CHECK(listenFd >= 0);
+    if (listenFd < 0) return;
+    // Half a command line, then nothing: the daemon gives up on it instead of waiting for the rest
+    const int clientFd {utl::ConnectUnix(socket)};
+    CHECK(utl::SendAll(clientFd, "activate Surv"));
+    std::ostringstream log;
+    vsprofile::ClientOutBuf out {log.rdbuf()};
+    std::atomic<bool> ran {false};
+    const auto start {std::chrono::steady_clock::now()};
+    const int client {utl::AcceptClient(listenFd)};
+    CHECK(!vsprofile::ServeClient(client, out, [&](const std::vector<std::string>&) { return ran = true; },
+                                  std::chrono::milliseconds{200}));
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds{5});
+    CHECK(!ran);
+    utl::CloseSocket(client);
+    char c;
+    CHECK_EQ(utl::ReceiveSome(clientFd, &c, 1), 0); // closed without a reply
+    utl::CloseSocket(clientFd);
+    utl::CloseSocket(listenFd);
+}
+
+TEST(Daemon, SocketIsTheOwnersOnly) {
+    const ScratchDir dir;
+    const fs::path socket {dir.Path() / "d.sock"};
+    dir.Write("d.sock", "stale");
+    const int listenFd {utl::ListenUnix(socket)};
+    CHECK(listenFd >= 0);
+    CHECK(fs::is_socket(socket));
+    CHECK((fs::status(socket).permissions() & fs::perms::all) == (fs::perms::owner_read | fs::perms::owner_write));
+    const int clientFd {utl::ConnectUnix(socket)};
+    const int client {utl::AcceptClient(listenFd)};
+    CHECK(utl::PeerIsCurrentUser(client));
+    utl::CloseSocket(client);
+    utl::CloseSocket(clientFd);
+    utl::CloseSocket(listenFd);
+}
+
+TEST(Daemon, CacheDropsListingsThatChanged) {
+    const ScratchDir dir;
+    dir.Write("Mods/a.zip", "a");
+    const fs::path mods {dir.Path() / "Mods"};
+    vsprofile::DirectoryCache cache;
+    if (!cache.Enabled()) return; // no inotify, nothing is cached
+    CHECK_EQ(cache.Names(mods), std::vector<std::string>{"a.zip"});
+    dir.Write("Mods/b.zip", "b");
+    CHECK_EQ(cache.Names(mods), (std::vector<std::string>{"a.zip", "b.zip"}));
+    fs::remove(mods / "a.zip");
+    CHECK_EQ(cache.Names(mods), std::vector<std::string>{"b.zip"});
+    fs::rename(mods / "b.zip", mods / "c.zip");
+    CHECK_EQ(cache.Names(mods), std::vector<std::string>{"c.zip"});
+}
+
+TEST(Daemon, CacheForgetsACleanModsOnceItChanges) {
+    const ScratchDir dir;
+    dir.Write("Mods/folder/inner.json", "{}");
+    dir.Write("Mods/a.zip", "a");
+    const fs::path mods {dir.Path() / "Mods"};
+    vsprofile::DirectoryCache cache;
+    if (!cache.Enabled()) return;
+    CHECK_EQ(cache.ManifestOf(mods).entries.size(), 2u);
+    cache.MarkClean(mods, 7);
+    CHECK(cache.IsClean(mods, 7));
+    CHECK(!cache.IsClean(mods, 8)); // another activation's record
+    CHECK(cache.IsClean(mods, 7));
+
+    // A write deep inside counts as much as one at the top
+    dir.Write("Mods/folder/inner.json", "{\"changed\": true}");
+    CHECK(!cache.IsClean(mods, 7));
+    const vsprofile::Manifest changed {cache.ManifestOf(mods)};
+    CHECK(changed.entries.size() == 2 && changed.entries[1].path == "folder/inner.json" && changed.entries[1].size == 17);
+
+    cache.MarkClean(mods, 8);
+    fs::remove(mods / "a.zip");
+    CHECK(!cache.IsClean(mods, 8));
+    CHECK_EQ(cache.ManifestOf(mods).entries.size(), 1u);
+}
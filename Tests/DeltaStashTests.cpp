@@ -0,0 +1,107 @@
+#include "Check.hpp"
+#include "../Core/Core.hpp"
+
+namespace fs = std::filesystem;
+namespace utl = vsprofile::utils;
+using namespace vsprofile;
+using vsprofile::tests::ScratchDir;
+
+namespace {
+
+    utl::SharedFile Shared(const ScratchDir& dir, const fs::path& rel, const std::string& path) {
+        const fs::path file {dir.Path() / rel};
+        return {path, fs::file_size(file), fs::last_write_time(file).time_since_epoch().count()};
+    }
+
+    // Profiles and game folders inside the scratch folder, with the default Mods and ModConfig roots
+    Config ScratchConfig(const ScratchDir& dir) {
+        Config config;
+        config.vintagestoryDataPath = dir.Path() / "Data";
+        config.modsPath = config.vintagestoryDataPath / "Mods";
+        config.profilesPath = dir.Path() / "Profiles";
+        return config;
+    }
+
+}
+
+TEST(DeltaStash, ManifestSavesAndLoads) {
+    const ScratchDir dir;
+    DeltaManifest delta;
+    delta.reference = "Survival";
+    delta.roots["Mods"] = {{"a.zip", 5, 111}, {"sub/b.zip", 7, 222}};
+    delta.roots["ModConfig"] = {{"c.json", 2, 333}};
+    const fs::path stash {dir.Path() / "stash"};
+    CHECK(delta.Save(stash));
+    CHECK(fs::exists(DeltaManifest::PathIn(stash)));
+
+    const auto loaded {DeltaManifest::Load(stash)};
+    CHECK(loaded.has_value());
+    if (!loaded) return;
+    CHECK_EQ(loaded->reference, "Survival");
+    CHECK_EQ(loaded->FileCount(), 3u);
+    CHECK_EQ(loaded->roots.size(), 2u);
+    const auto& mods {loaded->roots.at("Mods")};
+    CHECK_EQ(mods.size(), 2u);
+    if (mods.size() == 2) {
+        CHECK_EQ(mods[1].path, "sub/b.zip");
+        CHECK_EQ(mods[1].size, 7u);
+        CHECK_EQ(mods[1].mtime, 222);
+    }
+}
+
+TEST(DeltaStash, OrdinaryAndDamagedStashesHaveNoManifest) {
+    const ScratchDir dir;
+    dir.Write("plain/a.zip", "a");
+    CHECK(!DeltaManifest::Load(dir.Path() / "plain").has_value());
+    dir.Write(fs::path("torn") / constants::kProfileMetaDir / "delta.json", R"({"reference":"Survival","roots":{"Mods":[["a.zip",5)");
+    CHECK(!DeltaManifest::Load(dir.Path() / "torn").has_value());
+}
+
+TEST(DeltaStash, MaterialiseCopiesBackTheSharedFiles) {
+    const ScratchDir dir;
+    dir.Write("Profiles/Survival/a.zip", "shared a");
+    dir.Write(fs::path("Profiles/Survival") / constants::kProfileMetaDir / "roots/ModConfig/c.json", "shared c");
+    // The capture made every folder, shared files or not
+    dir.Write("Profiles/stash/own.zip", "only in the stash");
+    fs::create_directories(dir.Path() / "Profiles/stash" / constants::kProfileMetaDir / "roots/ModConfig");
+    DeltaManifest delta;
+    delta.reference = "Survival";
+    delta.roots["Mods"] = {Shared(dir, "Profiles/Survival/a.zip", "a.zip")};
+    delta.roots["ModConfig"] = {Shared(dir, fs::path("Profiles/Survival") / constants::kProfileMetaDir / "roots/ModConfig/c.json", "c.json")};
+    const fs::path stash {dir.Path() / "Profiles/stash"};
+    CHECK(delta.Save(stash));
+
+    const Core core {ScratchConfig(dir)};
+    CHECK(core.MaterialiseStash(stash));
+    CHECK_EQ(dir.Read("Profiles/stash/a.zip"), "shared a");
+    CHECK_EQ(dir.Read(fs::path("Profiles/stash") / constants::kProfileMetaDir / "roots/ModConfig/c.json"), "shared c");
+    CHECK_EQ(dir.Read("Profiles/stash/own.zip"), "only in the stash");
+    CHECK(!DeltaManifest::Load(stash).has_value()); // a whole stash again
+    CHECK(core.MaterialiseStash(stash)); // nothing left to do
+    CHECK(core.MaterialiseStash(dir.Path() / "Profiles/Survival"));
+}
+
+TEST(DeltaStash, LostFilesKeepTheStashIncomplete) {
+    const ScratchDir dir;
+    dir.Write("Profiles/Survival/a.zip", "shared a");
+    dir.Write("Profiles/Survival/b.zip", "shared b");
+    dir.Write("Profiles/stash/own.zip", "only in the stash");
+    DeltaManifest delta;
+    delta.reference = "Survival";
+    delta.roots["Mods"] = {Shared(dir, "Profiles/Survival/a.zip", "a.zip"), Shared(dir, "Profiles/Survival/b.zip", "b.zip")};
+    const fs::path stash {dir.Path() / "Profiles/stash"};
+    CHECK(delta.Save(stash));
+    dir.Write("Profiles/Survival/b.zip", "changed since"); // neither the reference nor Mods holds it any more
+
+    const Core core {ScratchConfig(dir)};
+    CHECK(!core.MaterialiseStash(stash));
+    CHECK_EQ(dir.Read("Profiles/stash/a.zip"), "shared a");
+    CHECK(!fs::exists(stash / "b.zip"));
+    // Only what is still missing stays listed, so the stash keeps counting as incomplete
+    const auto left {DeltaManifest::Load(stash)};
+    CHECK(left.has_value());
+    if (!left) return;
+    CHECK_EQ(left->reference, "Survival");
+    CHECK_EQ(left->FileCount(), 1u);
+    CHECK(left->roots.contains("Mods") && left->roots.at("Mods").front().path == "b.zip");
+}
@@ -0,0 +1,76 @@
+#include "Check.hpp"
+#include "../Utils/AppConstants.hpp"
+#include "../Utils/DirectoryScan.hpp"
+#include "../Utils/FileUtils.hpp"
+
+namespace fs = std::filesystem;
+namespace utl = vsprofile::utils;
+using vsprofile::tests::ScratchDir;
+
+namespace {
+
+    std::vector<std::string> Names(const utl::DirectoryScan& scan) {
+        std::vector<std::string> names;
+        for (const auto& e : scan) names.emplace_back(e.name);
+        return names;
+    }
+
+}
+
+TEST(DirectoryScan, EntriesAreSortedByName) {
+    const ScratchDir dir;
+    dir.Write("b.zip", "bb");
+    dir.Write("A.zip", "a");
+    dir.Write("a.zip", "aaa");
+    dir.Write("folder/inner.json", "{}");
+    std::error_code ec;
+    const utl::DirectoryScan scan {utl::DirectoryScan::Read(dir.Path(), utl::ScanDetail::Stats, ec)};
+    CHECK(!ec);
+    // Byte order, so uppercase sorts first, and never "." or ".."
+    CHECK_EQ(Names(scan), (std::vector<std::string>{"A.zip", "a.zip", "b.zip", "folder"}));
+
+    const utl::DirEntry* a {scan.Find("a.zip")};
+    CHECK(a && a->IsFile() && a->size == 3);
+    CHECK(a && a->mtime == fs::last_write_time(dir.Path() / "a.zip").time_since_epoch().count());
+    const utl::DirEntry* folder {scan.Find("folder")};
+    CHECK(folder && folder->IsDirectory());
+    CHECK(!scan.Find("inner.json")); // not recursive
+    CHECK(!scan.Find("c.zip"));
+}
+
+TEST(DirectoryScan, StatsAgreeAcrossThreads) {
+    const ScratchDir dir;
+    for (int i = 0; i < 1000; ++i) dir.Write(std::format("{:04}.json", i), std::string(static_cast<std::size_t>(i), 'x'));
+    std::error_code ec;
+    const utl::DirectoryScan scan {utl::DirectoryScan::Read(dir.Path(), utl::ScanDetail::Stats, ec)};
+    CHECK(!ec);
+    CHECK_EQ(scan.size(), 1000u);
+    std::size_t i {};
+    for (const auto& e : scan) {
+        CHECK_EQ(e.name, std::format("{:04}.json", i));
+        CHECK_EQ(e.size, i);
+        ++i;
+    }
+}
+
+TEST(DirectoryScan, HiddenEntriesAreLeftToTheCaller) {
+    const ScratchDir dir;
+    dir.Write("mod.zip", "m");
+    dir.Write(".DS_Store", "");
+    dir.Write(fs::path(vsprofile::constants::kProfileMetaDir) / "Modified", "");
+    std::error_code ec;
+    CHECK_EQ(utl::DirectoryScan::Read(dir.Path(), utl::ScanDetail::Names, ec).size(), 3u);
+    CHECK(utl::IsHiddenEntry(".DS_Store"));
+    CHECK(utl::IsHiddenEntry(vsprofile::constants::kProfileMetaDir));
+    CHECK(!utl::IsHiddenEntry("mod.zip"));
+    CHECK(!utl::IsHiddenEntry(".hidden-mod.zip"));
+    CHECK_EQ(utl::GetContentsList(dir.Path()), (std::vector<std::string>{"mod.zip"}));
+}
+
+TEST(DirectoryScan, MissingFolderReportsAnError) {
+    const ScratchDir dir;
+    std::error_code ec;
+    const utl::DirectoryScan scan {utl::DirectoryScan::Read(dir.Path() / "missing", utl::ScanDetail::Names, ec)};
+    CHECK(ec);
+    CHECK(scan.empty());
+}
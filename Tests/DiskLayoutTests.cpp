@@ -0,0 +1,41 @@
+#include "Check.hpp"
+#include "../Utils/DiskLayout.hpp"
+
+namespace fs = std::filesystem;
+namespace utl = vsprofile::utils;
+using vsprofile::tests::ScratchDir;
+
+TEST(DiskLayout, LongestOverrideWins) {
+    const ScratchDir dir;
+    const fs::path& root {dir.Path()};
+    utl::SetCopyOrderOverrides({{root / "Data", utl::CopyOrder::Sequential},
+                                {root / "Data/Mods/", utl::CopyOrder::Parallel}, // a trailing separator is dropped
+                                {root / "Data/Mods/../Saves/Big", utl::CopyOrder::Parallel},
+                                {root / "Profiles", utl::CopyOrder::Auto}});
+    CHECK(utl::PreferSequential(root / "Data/Logs/client.log"));
+    CHECK(utl::PreferSequential(root / "Data"));
+    CHECK(!utl::PreferSequential(root / "Data/Mods"));
+    CHECK(!utl::PreferSequential(root / "Data/Mods/folder/a.zip"));
+    CHECK(!utl::PreferSequential(root / "Data/Saves/Big/world.vcdbs"));
+    CHECK(utl::PreferSequential(root / "Data/Saves/Small/world.vcdbs"));
+    // Paths are compared normalised and a folder at a time, so a sibling sharing the name's start is no match
+    CHECK(utl::PreferSequential(root / "Data/Mods/../Logs"));
+    CHECK(!utl::PreferSequential(root / "Data/./Mods/a.zip"));
+    CHECK_EQ(utl::PreferSequential(root / "DataBackup/a.zip"), utl::IsRotational(root / "DataBackup/a.zip"));
+    // Auto, or no match at all, is the device's own answer
+    CHECK_EQ(utl::PreferSequential(root / "Profiles/A"), utl::IsRotational(root));
+    utl::SetCopyOrderOverrides({});
+    CHECK_EQ(utl::PreferSequential(root / "Data/Logs"), utl::IsRotational(root));
+}
+
+TEST(DiskLayout, MissingPathsUseTheirNearestFolder) {
+    const ScratchDir dir;
+    CHECK_EQ(utl::IsRotational(dir.Path() / "not/yet/made.zip"), utl::IsRotational(dir.Path()));
+}
+
+TEST(DiskLayout, CopyOrderNamesRoundTrip) {
+    for (const auto order : {utl::CopyOrder::Auto, utl::CopyOrder::Parallel, utl::CopyOrder::Sequential}) {
+        CHECK(utl::CopyOrderFromString(utl::ToString(order)) == order);
+    }
+    CHECK(utl::CopyOrderFromString("hdd") == utl::CopyOrder::Auto);
+}
@@ -0,0 +1,52 @@
+#include "Check.hpp"
+#include "../Utils/Durability.hpp"
+
+namespace fs = std::filesystem;
+namespace utl = vsprofile::utils;
+using vsprofile::tests::ScratchDir;
+
+TEST(Durability, NamesRoundTrip) {
+    for (const auto level : {utl::Durability::None, utl::Durability::Group, utl::Durability::Strict}) {
+        CHECK(utl::DurabilityFromString(utl::ToString(level)) == level);
+    }
+    CHECK(utl::DurabilityFromString("fsync") == utl::Durability::None);
+    CHECK(utl::DurabilityFromString("Strict") == utl::Durability::None);
+    CHECK(utl::DurabilityFromString("") == utl::Durability::None);
+}
+
+TEST(Durability, AddRecordsParentFolders) {
+    const ScratchDir dir;
+    utl::DurableBatch batch;
+    batch.Add(dir.Path() / "Mods/a.zip");
+    batch.Add(dir.Path() / "Mods/b.zip");
+    batch.AddUnsynced(dir.Path() / "Profiles/Survival/c.zip");
+    batch.AddDirectory(dir.Path() / "Snapshots");
+    // Renames and new entries are made durable by flushing the folder holding them
+    CHECK_EQ(batch.Directories(), (std::set<fs::path>{dir.Path() / "Mods", dir.Path() / "Profiles/Survival",
+                                                      dir.Path() / "Snapshots"}));
+}
+
+TEST(Durability, CommitWithoutDurabilityFlushesNothing) {
+    const ScratchDir dir;
+    dir.Write("Mods/a.zip", "a");
+    utl::SetDurability(utl::Durability::None);
+    utl::DurableBatch batch;
+    batch.Add(dir.Path() / "Mods/a.zip");
+    batch.Add(dir.Path() / "Missing/b.zip"); // never opened, so never an error
+    batch.Commit();
+    CHECK(batch.Directories().empty());
+    CHECK_EQ(dir.Read("Mods/a.zip"), "a");
+
+    // The same batch serves the next operation, at whatever level is current by then
+    batch.Add(dir.Path() / "Mods/a.zip");
+    CHECK_EQ(batch.Directories(), std::set<fs::path>{dir.Path() / "Mods"});
+    for (const auto level : {utl::Durability::Group, utl::Durability::Strict}) {
+        utl::SetDurability(level);
+        batch.AddUnsynced(dir.Path() / "Mods/a.zip");
+        batch.Add(dir.Path() / "Missing/b.zip");
+        batch.Commit();
+        CHECK(batch.Directories().empty());
+    }
+    utl::SetDurability(utl::Durability::None);
+    CHECK_EQ(dir.Read("Mods/a.zip"), "a");
+}
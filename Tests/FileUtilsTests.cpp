@@ -0,0 +1,85 @@
+#include "Check.hpp"
+#include "../Utils/FileUtils.hpp"
+#include "../Utils/HashUtils.hpp"
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+
+namespace fs = std::filesystem;
+namespace utl = vsprofile::utils;
+using vsprofile::tests::ScratchDir;
+
+namespace {
+
+    // Larger than the copy buffer and not a multiple of any block size
+    std::string SampleContent() {
+        std::string content(3 * 1024 * 1024 + 7, '\0');
+        std::uint32_t x {2463534242u};
+        for (char& c : content) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            c = static_cast<char>(x);
+        }
+        return content;
+    }
+
+    // Overwrites one byte in place, leaving the size and everything else as it was
+    void FlipByte(const fs::path& file, const std::streamoff at) {
+        std::fstream io {file, std::ios::binary | std::ios::in | std::ios::out};
+        io.seekg(at);
+        const char c {static_cast<char>(io.get())};
+        io.seekp(at);
+        io.put(static_cast<char>(c ^ 0x20));
+    }
+
+    void CheckVerify(const fs::path& copy, const std::string& hash) {
+        std::error_code ec;
+        CHECK(utl::VerifyFileHash(copy, hash, ec));
+        CHECK(!ec);
+        FlipByte(copy, 1024 * 1024 + 3);
+        CHECK(!utl::VerifyFileHash(copy, hash, ec));
+        CHECK(ec);
+    }
+
+}
+
+TEST(FileUtils, CopyAndHashMatchesTheSource) {
+    const ScratchDir dir;
+    const std::string content {SampleContent()};
+    dir.Write("from.zip", content);
+    fs::permissions(dir.Path() / "from.zip", fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read);
+    std::string hash;
+    std::error_code ec;
+    CHECK(utl::CopyAndHash(dir.Path() / "from.zip", dir.Path() / "to.zip", hash, ec));
+    CHECK(!ec);
+    CHECK_EQ(hash, utl::Murmur3Hasher{}.Update(content).Hex());
+    CHECK(dir.Read("to.zip") == content);
+    CHECK(fs::status(dir.Path() / "to.zip").permissions() == fs::status(dir.Path() / "from.zip").permissions());
+
+    CHECK(!utl::CopyAndHash(dir.Path() / "missing.zip", dir.Path() / "other.zip", hash, ec));
+    CHECK(ec);
+}
+
+TEST(FileUtils, VerifyRejectsAChangedCopy) {
+    const ScratchDir dir;
+    dir.Write("from.zip", SampleContent());
+    std::string hash;
+    std::error_code ec;
+    CHECK(utl::CopyAndHash(dir.Path() / "from.zip", dir.Path() / "to.zip", hash, ec));
+    CheckVerify(dir.Path() / "to.zip", hash);
+}
+
+TEST(FileUtils, VerifyWithoutDirectIo) {
+    // tmpfs refuses O_DIRECT, so this reads through the flushed-and-dropped page cache instead
+    const fs::path shm {"/dev/shm"};
+    std::error_code ec;
+    if (!fs::is_directory(shm, ec)) return;
+    const fs::path copy {shm / std::format("vsprofile-test-{}.zip", std::chrono::steady_clock::now().time_since_epoch().count())};
+    const ScratchDir dir;
+    dir.Write("from.zip", SampleContent());
+    std::string hash;
+    CHECK(utl::CopyAndHash(dir.Path() / "from.zip", copy, hash, ec));
+    CheckVerify(copy, hash);
+    fs::remove(copy, ec);
+}
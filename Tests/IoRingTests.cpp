@@ -0,0 +1,100 @@
+#include "Check.hpp"
+#include "../Utils/IoRing.hpp"
+#include <cerrno>
+#include <map>
+#include <tuple>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+namespace utl = vsprofile::utils;
+using vsprofile::tests::ScratchDir;
+
+namespace {
+
+    std::map<std::uint64_t, int> ResultsByTag(const std::vector<utl::IoRing::Completion>& completions) {
+        std::map<std::uint64_t, int> results;
+        for (const auto& [tag, result] : completions) results[tag] = result;
+        return results;
+    }
+
+}
+
+#if defined(__linux__)
+// Where the ring cannot be set up (no io_uring, disabled, or switched off) callers keep their synchronous
+// path and there is nothing to test
+
+TEST(IoRing, LinkRenameChainsReplaceTargets) {
+    utl::IoRing* const ring {utl::IoRing::ForThisThread()};
+    if (!ring || !ring->SupportsLinking()) return;
+    const ScratchDir dir;
+    dir.Write("from/a.zip", "new a");
+    dir.Write("from/b.zip", "new b");
+    dir.Write("to/a.zip", "old a");
+    dir.Write("to/a.zip.tmp", "left by a killed run");
+    dir.Write("to/c.zip", "old c");
+    dir.Write("to/gone.zip", "gone");
+    const std::string root {dir.Path().string()};
+    const std::string fromA {root + "/from/a.zip"}, tmpA {root + "/to/a.zip.tmp"}, toA {root + "/to/a.zip"};
+    const std::string fromB {root + "/from/b.zip"}, tmpB {root + "/to/b.zip.tmp"}, toB {root + "/to/b.zip"};
+    const std::string fromC {root + "/from/missing.zip"}, tmpC {root + "/to/c.zip.tmp"}, toC {root + "/to/c.zip"};
+    const std::string gone {root + "/to/gone.zip"};
+    // As a sync batch queues them: drop a stale temporary, link beside the target, rename over it
+    for (const auto& [from, tmp, to, tag] : {std::tuple{&fromA, &tmpA, &toA, 10}, {&fromB, &tmpB, &toB, 20}, {&fromC, &tmpC, &toC, 30}}) {
+        ring->Reserve(3);
+        ring->UnlinkAt(utl::IoRing::kCwd, tmp->c_str(), 0, tag, utl::IoRing::kHardLink);
+        ring->LinkAt(utl::IoRing::kCwd, from->c_str(), utl::IoRing::kCwd, tmp->c_str(), tag + 1, utl::IoRing::kLink);
+        ring->RenameAt(utl::IoRing::kCwd, tmp->c_str(), utl::IoRing::kCwd, to->c_str(), tag + 2);
+    }
+    ring->UnlinkAt(utl::IoRing::kCwd, gone.c_str(), 0, 40);
+    const auto results {ResultsByTag(ring->Drain())};
+    CHECK_EQ(results.size(), 10u);
+    CHECK(ring->Drain().empty()); // each completion is handed over once
+
+    // A stale temporary or none, the chain goes on either way
+    CHECK_EQ(results.at(10), 0);
+    CHECK(results.at(11) == 0 && results.at(12) == 0);
+    CHECK_EQ(dir.Read("to/a.zip"), "new a");
+    CHECK(fs::equivalent(dir.Path() / "to/a.zip", dir.Path() / "from/a.zip"));
+    CHECK(!fs::exists(dir.Path() / "to/a.zip.tmp"));
+    CHECK_EQ(results.at(20), -ENOENT);
+    CHECK(results.at(21) == 0 && results.at(22) == 0);
+    CHECK_EQ(dir.Read("to/b.zip"), "new b");
+    // After a failed link the rename fails too, leaving the target as it was: cancelled by the chain, or,
+    // where the kernel does not fail the chain for linkat, finding no temporary since the chain dropped it
+    CHECK_EQ(results.at(31), -ENOENT);
+    CHECK(results.at(32) == -ECANCELED || results.at(32) == -ENOENT);
+    CHECK_EQ(dir.Read("to/c.zip"), "old c");
+    CHECK_EQ(results.at(40), 0);
+    CHECK(!fs::exists(dir.Path() / "to/gone.zip"));
+}
+
+TEST(IoRing, StatxBatchAnswersEachEntry) {
+    utl::IoRing* const ring {utl::IoRing::ForThisThread()};
+    if (!ring || !ring->SupportsStatx()) return;
+    const ScratchDir dir;
+    dir.Write("a.zip", "a");
+    dir.Write("b.zip", "0123456789");
+    dir.Write("folder/inner.json", "{}");
+    const int dirFd {::open(dir.Path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)};
+    CHECK(dirFd >= 0);
+    if (dirFd < 0) return;
+    const std::vector<std::string> names {"a.zip", "b.zip", "folder", "missing.zip"};
+    std::vector<struct statx> stats(names.size());
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        ring->Statx(dirFd, names[i].c_str(), AT_SYMLINK_NOFOLLOW, STATX_TYPE | STATX_SIZE, &stats[i], i);
+    }
+    const auto results {ResultsByTag(ring->Drain())};
+    ::close(dirFd);
+    CHECK_EQ(results.size(), names.size());
+    CHECK(results.at(0) == 0 && results.at(1) == 0 && results.at(2) == 0);
+    CHECK(S_ISREG(stats[0].stx_mode) && stats[0].stx_size == 1);
+    CHECK(S_ISREG(stats[1].stx_mode) && stats[1].stx_size == 10);
+    CHECK(S_ISDIR(stats[2].stx_mode));
+    CHECK_EQ(results.at(3), -ENOENT);
+}
+#endif
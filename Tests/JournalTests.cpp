@@ -0,0 +1,165 @@
+#include "Check.hpp"
+#include "../Core/Journal.hpp"
+
+namespace fs = std::filesystem;
+namespace utl = vsprofile::utils;
+using namespace vsprofile;
+using vsprofile::tests::ScratchDir;
+
+namespace {
+
+    ActivationJournal Sample(const fs::path& root) {
+        ActivationJournal journal;
+        journal.profile = "Survival";
+        journal.stash = root / "Profiles/stash_2025-03-04_05-06-07_Creative";
+        journal.modsFrom = root / "Profiles/Creative";
+        journal.modsLinked = true;
+        journal.pid = 4242;
+        journal.ops = {{utl::FileOp::Kind::MakeDir, {}, root / "Mods"},
+                       {utl::FileOp::Kind::Link, root / "Profiles/Survival/a.zip", root / "Mods/a.zip", 5},
+                       {utl::FileOp::Kind::Copy, root / "Profiles/Survival/c.json", root / "ModConfig/c.json", 2},
+                       {utl::FileOp::Kind::Remove, {}, root / "Mods/old.zip"}};
+        journal.moves = {{root / "Mods", root / ".Mods.outgoing"}, {root / ".Mods.staged", root / "Mods"}};
+        return journal;
+    }
+
+}
+
+TEST(Journal, LoadReadsBackWhatBeginWrote) {
+    const ScratchDir dir;
+    const ActivationJournal written {Sample(dir.Path())};
+    CHECK(written.Begin(dir.Path() / "Journal"));
+    const auto loaded {ActivationJournal::Load(dir.Path() / "Journal")};
+    CHECK(loaded.has_value());
+    if (!loaded) return;
+    CHECK_EQ(loaded->profile, written.profile);
+    CHECK(loaded->stash == written.stash);
+    CHECK(loaded->modsFrom == written.modsFrom);
+    CHECK(loaded->modsLinked);
+    CHECK_EQ(loaded->pid, 4242);
+    CHECK(loaded->planned);
+    CHECK(!loaded->cachesSwapped);
+    CHECK_EQ(loaded->ops.size(), written.ops.size());
+    for (std::size_t i = 0; i < std::min(loaded->ops.size(), written.ops.size()); ++i) {
+        CHECK(loaded->ops[i].kind == written.ops[i].kind);
+        CHECK(loaded->ops[i].from == written.ops[i].from);
+        CHECK(loaded->ops[i].to == written.ops[i].to);
+        CHECK_EQ(loaded->ops[i].bytes, written.ops[i].bytes);
+    }
+    CHECK_EQ(loaded->moves.size(), 2u);
+    CHECK_EQ(loaded->done, std::vector<bool>(written.ops.size(), false));
+    CHECK_EQ(loaded->moved, std::vector<bool>(written.moves.size(), false));
+}
+
+TEST(Journal, LogMarksWhatCompleted) {
+    const ScratchDir dir;
+    const fs::path journalDir {dir.Path() / "Journal"};
+    CHECK(Sample(dir.Path()).Begin(journalDir));
+    {
+        JournalLog log {journalDir};
+        log.Moved(0);
+        log.Done(0);
+        log.Done(3);
+        log.CachesSwapped();
+    }
+    // What a kill leaves behind: a line cut short, and nothing that could name an op not in the plan
+    dir.Write("Journal/done.log", dir.Read("Journal/done.log") + "9\nmove \nmov");
+    const auto loaded {ActivationJournal::Load(journalDir)};
+    CHECK(loaded.has_value());
+    if (!loaded) return;
+    CHECK_EQ(loaded->done, (std::vector<bool>{true, false, false, true}));
+    CHECK_EQ(loaded->moved, (std::vector<bool>{true, false}));
+    CHECK(loaded->cachesSwapped);
+}
+
+TEST(Journal, BeginStartsAnEmptyLog) {
+    const ScratchDir dir;
+    const fs::path journalDir {dir.Path() / "Journal"};
+    ActivationJournal journal {Sample(dir.Path())};
+    journal.planned = false;
+    CHECK(journal.Begin(journalDir));
+    JournalLog {journalDir}.Moved(0);
+    journal.planned = true;
+    CHECK(journal.Begin(journalDir));
+    const auto loaded {ActivationJournal::Load(journalDir)};
+    CHECK(loaded.has_value());
+    if (!loaded) return;
+    CHECK(loaded->planned);
+    CHECK_EQ(loaded->moved, (std::vector<bool>{false, false}));
+}
+
+TEST(Journal, StaleLogDoesNotCountForTheNextPlan) {
+    const ScratchDir dir;
+    const fs::path journalDir {dir.Path() / "Journal"};
+    ActivationJournal journal {Sample(dir.Path())};
+    journal.planned = false;
+    CHECK(journal.Begin(journalDir));
+    {
+        JournalLog log {journalDir};
+        log.Moved(0);
+        log.Moved(1);
+    }
+    const std::string movesLog {dir.Read("Journal/done.log")};
+    // Killed once the full plan is in place but before its log was started: the moves' log is still there
+    journal.planned = true;
+    CHECK(journal.Begin(journalDir));
+    dir.Write("Journal/done.log", movesLog + "0\n3\n");
+    auto loaded {ActivationJournal::Load(journalDir)};
+    CHECK(loaded.has_value());
+    if (!loaded) return;
+    CHECK(loaded->planned);
+    CHECK_EQ(loaded->done, std::vector<bool>(journal.ops.size(), false));
+
+    // Nor does a log with no plan named in it, or none at all
+    dir.Write("Journal/done.log", "0\n3\n");
+    loaded = ActivationJournal::Load(journalDir);
+    CHECK(loaded.has_value());
+    if (!loaded) return;
+    CHECK_EQ(loaded->done, std::vector<bool>(journal.ops.size(), false));
+    fs::remove(journalDir / "done.log");
+    CHECK(ActivationJournal::Load(journalDir).has_value());
+}
+
+TEST(Journal, MoveDoneInfersTheRenameCutOffBeforeItsLine) {
+    const ScratchDir dir;
+    const fs::path journalDir {dir.Path() / "Journal"};
+    ActivationJournal journal {Sample(dir.Path())};
+    journal.planned = false;
+    CHECK(journal.Begin(journalDir));
+    dir.Write(".Mods.staged/a.zip", "a");
+    dir.Write("Mods/b.zip", "b");
+    // The first rename ran and was logged, the second ran but the process died before logging it
+    fs::rename(dir.Path() / "Mods", dir.Path() / ".Mods.outgoing");
+    JournalLog {journalDir}.Moved(0);
+    fs::rename(dir.Path() / ".Mods.staged", dir.Path() / "Mods");
+    auto loaded {ActivationJournal::Load(journalDir)};
+    CHECK(loaded.has_value());
+    if (!loaded) return;
+    CHECK(!loaded->planned);
+    CHECK(loaded->MoveDone(0));
+    CHECK(loaded->MoveDone(1));
+
+    // Had it died before the second rename, its source would still be there
+    fs::rename(dir.Path() / "Mods", dir.Path() / ".Mods.staged");
+    CHECK(!loaded->MoveDone(1));
+    // Nor can a rename have run while the one before it is not known to have
+    loaded->moved[0] = false;
+    fs::rename(dir.Path() / ".Mods.staged", dir.Path() / "Mods");
+    CHECK(!loaded->MoveDone(1));
+}
+
+TEST(Journal, DamagedPlans) {
+    const ScratchDir dir;
+    // Cut short while being written, or missing what every plan lists
+    dir.Write("Torn/plan.json", R"({"profile":"A","stash":)");
+    CHECK(!ActivationJournal::Load(dir.Path() / "Torn").has_value());
+    dir.Write("Partial/plan.json", R"({"profile":"A","stash":"s","modsFrom":"m","modsLinked":false,"pid":1,)"
+                                   R"("ops":[{"kind":"copy","from":"x","to":"y","bytes":3}]})");
+    CHECK(!ActivationJournal::Load(dir.Path() / "Partial").has_value());
+    CHECK(!ActivationJournal::Load(dir.Path() / "Missing").has_value());
+
+    CHECK(Sample(dir.Path()).Begin(dir.Path() / "Journal"));
+    ActivationJournal::Discard(dir.Path() / "Journal");
+    CHECK(!fs::exists(dir.Path() / "Journal/plan.json"));
+    CHECK(!ActivationJournal::Load(dir.Path() / "Journal").has_value());
+}
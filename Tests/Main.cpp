@@ -0,0 +1,54 @@
+#include "Check.hpp"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+namespace vsprofile::tests {
+
+    ScratchDir::ScratchDir() {
+        static std::atomic<unsigned> counter {0};
+        const auto ticks {std::chrono::steady_clock::now().time_since_epoch().count()};
+        path_ = fs::temp_directory_path() / std::format("vsprofile-test-{}-{}", ticks, counter++);
+        fs::create_directories(path_);
+    }
+
+    ScratchDir::~ScratchDir() {
+        std::error_code ec;
+        fs::remove_all(path_, ec);
+    }
+
+    void ScratchDir::Write(const fs::path& rel, const std::string_view content) const {
+        const fs::path file {path_ / rel};
+        fs::create_directories(file.parent_path());
+        std::ofstream out {file, std::ios::binary | std::ios::trunc};
+        out.write(content.data(), static_cast<std::streamsize>(content.size()));
+    }
+
+    std::string ScratchDir::Read(const fs::path& rel) const {
+        std::ifstream in {path_ / rel, std::ios::binary};
+        return {std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    }
+
+}
+
+// Usage: vsprofile_tests [group], every group when none is given
+int main(const int argc, char** argv) {
+    using namespace vsprofile::tests;
+    const std::string_view only {argc > 1 ? argv[1] : ""};
+    std::size_t ran {};
+    for (const TestCase& test : Registry()) {
+        if (!only.empty() && test.group != only) continue;
+        const std::size_t before {Failures()};
+        test.run();
+        ++ran;
+        std::cout << std::format("{} {}.{}\n", Failures() == before ? "ok  " : "FAIL", test.group, test.name);
+    }
+    if (ran == 0) {
+        std::cerr << std::format("No tests in group '{}'\n", only);
+        return 1;
+    }
+    return Failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+#include "Check.hpp"
+#include "../Core/MerkleTree.hpp"
+#include <algorithm>
+
+namespace fs = std::filesystem;
+using namespace vsprofile;
+using vsprofile::tests::ScratchDir;
+
+namespace {
+
+    MerkleNode File(const std::string& name, const std::string& hash) {
+        MerkleNode node;
+        node.name = name;
+        node.hash = hash;
+        return node;
+    }
+
+    // Children must be given sorted by name, as Build leaves them
+    MerkleNode Dir(const std::string& name, const std::string& hash, std::vector<MerkleNode> children) {
+        MerkleNode node {File(name, hash)};
+        node.directory = true;
+        node.children = std::move(children);
+        return node;
+    }
+
+    MerkleTree Tree(const std::string& hash, std::vector<MerkleNode> children) {
+        return {Dir({}, hash, std::move(children))};
+    }
+
+    std::vector<std::string> Sorted(std::vector<std::string> paths) {
+        std::ranges::sort(paths);
+        return paths;
+    }
+
+}
+
+TEST(MerkleTree, DiffReportsAddedRemovedAndChanged) {
+    const MerkleTree before {Tree("r1", {File("a.zip", "1"), File("b.zip", "2"),
+                                         Dir("cfg", "c1", {File("x.json", "3"), File("y.json", "4")}),
+                                         Dir("old", "o1", {File("z", "5")})})};
+    const MerkleTree after {Tree("r2", {File("a.zip", "1"), File("c.zip", "6"),
+                                        Dir("cfg", "c2", {File("x.json", "7"), File("y.json", "4")}),
+                                        Dir("new", "n1", {File("z", "5")})})};
+    const ManifestDiff d {Diff(before, after)};
+    CHECK_EQ(Sorted(d.added), (std::vector<std::string>{"c.zip", "new/"}));
+    CHECK_EQ(Sorted(d.removed), (std::vector<std::string>{"b.zip", "old/"}));
+    CHECK_EQ(d.changed, (std::vector<std::string>{"cfg/x.json"}));
+}
+
+TEST(MerkleTree, DiffSkipsSubtreesWithEqualHashes) {
+    // The children differ but the folder hashes match, so the diff must not look inside
+    const MerkleTree before {Tree("r1", {Dir("same", "s", {File("x", "1")}), File("f", "1")})};
+    const MerkleTree after {Tree("r2", {Dir("same", "s", {File("x", "2")}), File("f", "2")})};
+    const ManifestDiff d {Diff(before, after)};
+    CHECK(d.added.empty());
+    CHECK(d.removed.empty());
+    CHECK_EQ(d.changed, (std::vector<std::string>{"f"}));
+    CHECK(Diff(before, before).Empty());
+}
+
+TEST(MerkleTree, DiffTreatsATypeChangeAsRemoveAndAdd) {
+    const MerkleTree before {Tree("r1", {File("thing", "1")})};
+    const MerkleTree after {Tree("r2", {Dir("thing", "d", {File("x", "1")})})};
+    const ManifestDiff d {Diff(before, after)};
+    CHECK_EQ(d.removed, (std::vector<std::string>{"thing"}));
+    CHECK_EQ(d.added, (std::vector<std::string>{"thing/"}));
+    CHECK(d.changed.empty());
+}
+
+TEST(MerkleTree, BuiltTreesDiffLikeTheFolders) {
+    const ScratchDir dir;
+    dir.Write("mods/a.zip", "alpha");
+    dir.Write("mods/b.zip", "beta");
+    dir.Write("mods/sub/c.json", "{}");
+    dir.Write("mods/.vsprofile/hidden", "skipped");
+    const MerkleTree before {MerkleTree::Build(dir.Path() / "mods", nullptr)};
+    CHECK_EQ(before.FileCount(), 3u);
+    CHECK(Diff(before, MerkleTree::Build(dir.Path() / "mods", &before)).Empty());
+
+    dir.Write("mods/b.zip", "BETA"); // same size, new content
+    fs::last_write_time(dir.Path() / "mods/b.zip", fs::last_write_time(dir.Path() / "mods/b.zip") + std::chrono::seconds{5});
+    dir.Write("mods/sub/d.json", "[]");
+    fs::remove(dir.Path() / "mods/a.zip");
+    const ManifestDiff d {Diff(before, MerkleTree::Build(dir.Path() / "mods", &before))};
+    CHECK_EQ(d.added, (std::vector<std::string>{"sub/d.json"}));
+    CHECK_EQ(d.removed, (std::vector<std::string>{"a.zip"}));
+    CHECK_EQ(d.changed, (std::vector<std::string>{"b.zip"}));
+}
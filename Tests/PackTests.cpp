@@ -0,0 +1,112 @@
+#include "Check.hpp"
+#include "../Utils/Pack.hpp"
+#include <algorithm>
+#include <fstream>
+
+namespace fs = std::filesystem;
+namespace utl = vsprofile::utils;
+using vsprofile::tests::ScratchDir;
+
+namespace {
+
+    std::string Compressible() {
+        std::string text;
+        while (text.size() < 200 * 1024) text += "modid = \"example\", version = \"1.0.0\"\n";
+        return text;
+    }
+
+    // Bytes that do not compress, as in a mod zip
+    std::string Incompressible() {
+        std::string bytes(300 * 1024, '\0');
+        std::uint64_t x {0x9E3779B97F4A7C15};
+        for (char& c : bytes) {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            c = static_cast<char>(x);
+        }
+        return bytes;
+    }
+
+}
+
+TEST(Pack, RoundTripRestoresContentTimesAndModes) {
+    const ScratchDir dir;
+    const std::vector<std::string> paths {"config.json", "mods/big.zip", "mods/empty.txt", "run.sh"};
+    dir.Write("src/config.json", Compressible());
+    dir.Write("src/mods/big.zip", Incompressible());
+    dir.Write("src/mods/empty.txt", "");
+    dir.Write("src/run.sh", "#!/bin/sh\n");
+    fs::permissions(dir.Path() / "src/run.sh", fs::perms::owner_all | fs::perms::group_read | fs::perms::group_exec);
+    fs::permissions(dir.Path() / "src/config.json", fs::perms::owner_read | fs::perms::owner_write);
+    const auto mtime {fs::file_time_type{} + std::chrono::hours{24 * 365 * 50}};
+    fs::last_write_time(dir.Path() / "src/mods/big.zip", mtime);
+
+    std::vector<utl::PackEntry> written;
+    std::error_code ec;
+    CHECK(utl::WritePack(dir.Path() / "src", paths, dir.Path() / "pack.bin", written, ec));
+    CHECK(!ec);
+    CHECK_EQ(written.size(), paths.size());
+    CHECK(!fs::exists(dir.Path() / "pack.bin.tmp"));
+
+    const auto reader {utl::PackReader::Open(dir.Path() / "pack.bin", ec)};
+    CHECK(reader.has_value());
+    if (!reader) return;
+    CHECK_EQ(reader->Entries().size(), paths.size());
+    for (const auto& entry : reader->Entries()) {
+        const fs::path to {dir.Path() / "out" / entry.path};
+        fs::create_directories(to.parent_path());
+        CHECK(reader->Extract(entry, to, ec));
+        CHECK_EQ(dir.Read(fs::path{"out"} / entry.path), dir.Read(fs::path{"src"} / entry.path));
+        CHECK(fs::status(to).permissions() == fs::status(dir.Path() / "src" / entry.path).permissions());
+        CHECK(fs::last_write_time(to) == fs::last_write_time(dir.Path() / "src" / entry.path));
+    }
+    const auto big {std::ranges::find(reader->Entries(), std::string{"mods/big.zip"}, &utl::PackEntry::path)};
+    CHECK(big != reader->Entries().end() && big->method == utl::PackEntry::Method::Stored);
+    if (utl::PackCompression()) {
+        const auto text {std::ranges::find(reader->Entries(), std::string{"config.json"}, &utl::PackEntry::path)};
+        CHECK(text != reader->Entries().end() && text->method == utl::PackEntry::Method::Deflate && text->stored < text->size);
+    }
+}
+
+TEST(Pack, ExtractRejectsCorruptedContent) {
+    const ScratchDir dir;
+    dir.Write("src/a.bin", Incompressible());
+    std::vector<utl::PackEntry> written;
+    std::error_code ec;
+    CHECK(utl::WritePack(dir.Path() / "src", {"a.bin"}, dir.Path() / "pack.bin", written, ec));
+    {
+        // Flip bits of the stored entry, which starts right after the 8 byte header
+        const char original {dir.Read("src/a.bin")[100 - 8]};
+        std::fstream pack {dir.Path() / "pack.bin", std::ios::binary | std::ios::in | std::ios::out};
+        pack.seekp(100);
+        pack.put(static_cast<char>(original ^ 0x5a));
+    }
+    const auto reader {utl::PackReader::Open(dir.Path() / "pack.bin", ec)};
+    CHECK(reader.has_value());
+    if (!reader) return;
+    CHECK(!reader->Extract(reader->Entries().front(), dir.Path() / "a.bin", ec));
+    CHECK(ec);
+    CHECK(!fs::exists(dir.Path() / "a.bin"));
+    CHECK(!fs::exists(dir.Path() / "a.bin.vsprofile-tmp"));
+}
+
+TEST(Pack, OpenRejectsWhatIsNotAPack) {
+    const ScratchDir dir;
+    dir.Write("short.bin", "VSPK");
+    dir.Write("other.bin", std::string(64, 'x'));
+    std::error_code ec;
+    CHECK(!utl::PackReader::Open(dir.Path() / "missing.bin", ec).has_value());
+    CHECK(!utl::PackReader::Open(dir.Path() / "short.bin", ec).has_value());
+    CHECK(!utl::PackReader::Open(dir.Path() / "other.bin", ec).has_value());
+    CHECK(ec == std::errc::illegal_byte_sequence);
+
+    // A pack from a newer format is refused rather than misread
+    dir.Write("src/a.txt", "a");
+    std::vector<utl::PackEntry> written;
+    CHECK(utl::WritePack(dir.Path() / "src", {"a.txt"}, dir.Path() / "newer.bin", written, ec));
+    {
+        std::fstream pack {dir.Path() / "newer.bin", std::ios::binary | std::ios::in | std::ios::out};
+        pack.seekp(4); // the u32 version after the magic
+        pack.put(2);
+    }
+    CHECK(!utl::PackReader::Open(dir.Path() / "newer.bin", ec).has_value());
+}
@@ -0,0 +1,101 @@
+#include "Check.hpp"
+#include "../Core/Perf.hpp"
+
+namespace ch = std::chrono;
+using namespace std::chrono_literals;
+using namespace vsprofile;
+
+namespace {
+
+    double Ms(const ch::sys_days day, const ch::milliseconds time) {
+        return static_cast<double>((day + time).time_since_epoch() / 1ms);
+    }
+
+    const PerfBucket* Find(const std::vector<PerfBucket>& buckets, const std::string& name) {
+        for (const auto& bucket : buckets) {
+            if (bucket.name == name) return &bucket;
+        }
+        return nullptr;
+    }
+
+}
+
+TEST(Perf, ParsesLogTimestamps) {
+    const auto ms {ParseLogTimestampMs("4.3.2025 05:06:07 [Notification] Loaded 12 mods")};
+    CHECK(ms.has_value());
+    if (ms) CHECK_EQ(*ms, Ms(ch::sys_days{2025y / 3 / 4}, 5h + 6min + 7s));
+    const auto fraction {ParseLogTimestampMs("31.12.2024 23:59:59.250 [Debug] x")};
+    CHECK(fraction.has_value());
+    if (fraction) CHECK_EQ(*fraction, Ms(ch::sys_days{2024y / 12 / 31}, 23h + 59min + 59s + 250ms));
+}
+
+TEST(Perf, RejectsLinesWithoutATimestamp) {
+    CHECK(!ParseLogTimestampMs("").has_value());
+    CHECK(!ParseLogTimestampMs("   at Vintagestory.Server.Main()").has_value());
+    CHECK(!ParseLogTimestampMs("[Notification] Loaded 12 mods").has_value());
+    CHECK(!ParseLogTimestampMs("4.3.2025 05:06 [Notification] no seconds").has_value());
+    CHECK(!ParseLogTimestampMs("31.2.2025 05:06:07 [Notification] no such day").has_value());
+    CHECK(!ParseLogTimestampMs("4.3.2025 24:06:07 [Notification] no such hour").has_value());
+}
+
+TEST(Perf, ChargesEachGapToTheLineBeforeIt) {
+    StartupProfiler profiler {{"carryon_v1.7.2.zip", "xlib.zip", "ab.zip"}};
+    profiler.Feed("4.3.2025 05:06:07 [Notification] Loading carryon textures");
+    profiler.Feed("   at a stack frame without a timestamp, mentioning xlib");
+    profiler.Feed("4.3.2025 05:06:09 [Notification] xlib compiling");
+    CHECK(!profiler.ReachedReady());
+    profiler.Feed("4.3.2025 05:06:10.500 [Notification] Received level finalize");
+    CHECK(profiler.ReachedReady());
+    profiler.Feed("4.3.2025 05:06:30 [Notification] carryon after the game was ready");
+
+    const StartupReport report {profiler.Finish("Survival")};
+    CHECK_EQ(report.profile, "Survival");
+    CHECK(report.reachedReady);
+    CHECK_EQ(report.totalMs, 3500.0);
+    // Ranked, most expensive first; the version suffix does not stop a mod from being recognised
+    CHECK_EQ(report.mods.size(), 2u);
+    if (report.mods.size() == 2) {
+        CHECK_EQ(report.mods[0].name, "carryon_v1.7.2.zip");
+        CHECK_EQ(report.mods[0].ms, 2000.0);
+        CHECK_EQ(report.mods[1].name, "xlib.zip");
+        CHECK_EQ(report.mods[1].ms, 1500.0);
+    }
+    const PerfBucket* textures {Find(report.phases, "textures")};
+    const PerfBucket* compiling {Find(report.phases, "compiling mods")};
+    CHECK(textures && textures->ms == 2000.0);
+    CHECK(compiling && compiling->ms == 1500.0);
+}
+
+TEST(Perf, LiveContinuationLinesStayWithTheirMessage) {
+    StartupProfiler profiler {{"carryon_v1.7.2.zip", "xlib.zip"}};
+    profiler.MarkStart(0.0);
+    // Read from the game's output, every line is timed on arrival, stack frames included
+    profiler.Feed("4.3.2025 05:06:07 [Error] carryon failed loading textures", 100.0);
+    profiler.Feed("   at XLib.Patches.Apply() in a stack frame naming xlib while compiling", 150.0);
+    profiler.Feed("4.3.2025 05:06:08 [Notification] xlib ready to go", 1000.0);
+    profiler.Feed("done", 1200.0);
+    const StartupReport report {profiler.Finish({})};
+    const PerfBucket* carryon {Find(report.mods, "carryon_v1.7.2.zip")};
+    const PerfBucket* xlib {Find(report.mods, "xlib.zip")};
+    CHECK(carryon && carryon->ms == 900.0 && carryon->lines == 2);
+    CHECK(xlib && xlib->ms == 200.0);
+    CHECK(!Find(report.phases, "compiling mods") && !Find(report.phases, "json patches"));
+    CHECK(Find(report.phases, "textures") && Find(report.phases, "textures")->ms == 1100.0);
+}
+
+TEST(Perf, UnmatchedLinesGoToTheBaseGame) {
+    StartupProfiler profiler {{"ab.zip"}}; // too short a name to search for
+    profiler.MarkStart(0.0);
+    profiler.Feed("ab said something", 400.0);
+    profiler.Feed("done", 1000.0);
+    const StartupReport report {profiler.Finish({})};
+    CHECK(!report.reachedReady);
+    CHECK_EQ(report.totalMs, 1000.0);
+    CHECK_EQ(report.mods.size(), 1u);
+    if (!report.mods.empty()) {
+        CHECK_EQ(report.mods[0].name, "(base game)");
+        CHECK_EQ(report.mods[0].lines, 2u);
+    }
+    const PerfBucket* startup {Find(report.phases, "process startup")};
+    CHECK(startup && startup->ms == 1000.0);
+}
@@ -0,0 +1,55 @@
+#include "Check.hpp"
+#include "../Utils/AppConstants.hpp"
+#include "../Utils/Prewarm.hpp"
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+namespace utl = vsprofile::utils;
+namespace constants = vsprofile::constants;
+using vsprofile::tests::ScratchDir;
+
+#if !defined(_WIN32)
+TEST(Prewarm, CountsWhatItRead) {
+    const ScratchDir dir;
+    dir.Write("a.zip", "0123456789");
+    dir.Write("folder/b.json", "{\"b\"}");
+    dir.Write("folder/deeper/c.dll", "1234567");
+    // Nothing to read, and vsprofile's own or the OS's entries at any depth
+    dir.Write("empty.txt", "");
+    dir.Write("folder/.DS_Store", "finder");
+    dir.Write(fs::path{"folder"} / constants::kProfileMetaDir / "manifest.json", "{}");
+    dir.Write(std::string{constants::kVolumeTrashPrefix} + "1/old.zip", "trashed");
+    const utl::PrewarmStats stats {utl::Prewarm(dir.Path())};
+    CHECK_EQ(stats.files, 3u);
+    CHECK_EQ(stats.bytes, 22u);
+    CHECK_EQ(stats.failures, 0u);
+}
+
+TEST(Prewarm, UnreadableFilesAreFailures) {
+    if (::geteuid() == 0) return; // root reads everything
+    const ScratchDir dir;
+    dir.Write("a.zip", "0123456789");
+    dir.Write("locked.zip", "locked");
+    fs::permissions(dir.Path() / "locked.zip", fs::perms::none);
+    const utl::PrewarmStats stats {utl::Prewarm(dir.Path())};
+    CHECK_EQ(stats.files, 1u);
+    CHECK_EQ(stats.bytes, 10u);
+    CHECK_EQ(stats.failures, 1u);
+    fs::permissions(dir.Path() / "locked.zip", fs::perms::owner_all);
+}
+#endif
+
+TEST(Prewarm, NothingToWarm) {
+    const ScratchDir dir;
+    dir.Write("empty.txt", "");
+    for (const fs::path& path : {dir.Path(), dir.Path() / "missing"}) {
+        const utl::PrewarmStats stats {utl::Prewarm(path)};
+        CHECK_EQ(stats.files, 0u);
+        CHECK_EQ(stats.bytes, 0u);
+        CHECK_EQ(stats.failures, 0u);
+        CHECK(!stats.extentOrder);
+    }
+}
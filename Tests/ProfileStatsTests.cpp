@@ -0,0 +1,57 @@
+#include "Check.hpp"
+#include "../Core/ProfileStats.hpp"
+
+namespace ch = std::chrono;
+using namespace std::chrono_literals;
+using vsprofile::ProfileStats;
+using vsprofile::tests::ScratchDir;
+
+TEST(ProfileStats, RecordsActivationsAndUse) {
+    ProfileStats stats;
+    CHECK(!stats.LastUsed("Survival").has_value());
+    const ch::system_clock::time_point when {ch::sys_days{2025y / 3 / 4} + 5h};
+    stats.Touch("Survival", when + 900ms); // kept to the second
+    stats.RecordActivation("Survival", 1200ms, 5000);
+    stats.RecordActivation("Survival", 800ms, 0);
+    stats.RecordActivation("Creative", 300ms, 42);
+
+    const auto last {stats.LastUsed("Survival")};
+    CHECK(last.has_value());
+    if (last) CHECK(*last == when);
+    const auto& survival {stats.profiles.at("Survival")};
+    CHECK_EQ(survival.activations, 2u);
+    CHECK_EQ(survival.lastMs, 800u);
+    CHECK_EQ(survival.totalMs, 2000u);
+    CHECK_EQ(survival.bytesMoved, 5000u);
+    // Activated, but never touched: there is no time to give
+    CHECK(!stats.LastUsed("Creative").has_value());
+}
+
+TEST(ProfileStats, SerialiseThenLoadRoundTrips) {
+    const ScratchDir dir;
+    ProfileStats stats;
+    stats.Touch("Survival", ch::system_clock::time_point{ch::seconds{1'700'000'000}});
+    stats.RecordActivation("Survival", 1234ms, std::uintmax_t{6} << 30); // past 32 bits
+    stats.Touch("stash_2025-03-04_05-06-07_Survival", ch::system_clock::time_point{ch::seconds{1'600'000'000}});
+    const auto path {ProfileStats::PathFor(dir.Path() / "Config.json")};
+    CHECK(path == dir.Path() / "Stats.json");
+    dir.Write("Stats.json", stats.Serialise());
+
+    const ProfileStats loaded {ProfileStats::Load(path)};
+    CHECK_EQ(loaded.Serialise(), stats.Serialise());
+    CHECK_EQ(loaded.profiles.size(), 2u);
+    const auto& survival {loaded.profiles.at("Survival")};
+    CHECK_EQ(survival.activations, 1u);
+    CHECK_EQ(survival.lastUsed, 1'700'000'000);
+    CHECK_EQ(survival.totalMs, 1234u);
+    CHECK_EQ(survival.bytesMoved, std::uintmax_t{6} << 30);
+}
+
+TEST(ProfileStats, MissingOrDamagedFilesStartOver) {
+    const ScratchDir dir;
+    CHECK(ProfileStats::Load(dir.Path() / "Stats.json").profiles.empty());
+    dir.Write("Torn.json", R"({"profiles":{"A":[1,2,3,4,5],"B":[1,2)");
+    CHECK(ProfileStats::Load(dir.Path() / "Torn.json").profiles.empty());
+    dir.Write("Short.json", R"({"profiles":{"A":[1,2,3,4,5],"B":[1,2]}})");
+    CHECK(ProfileStats::Load(dir.Path() / "Short.json").profiles.empty()); // no half-read set either
+}
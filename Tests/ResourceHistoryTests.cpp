@@ -0,0 +1,148 @@
+#include "Check.hpp"
+#include "../Core/ResourceHistory.hpp"
+#include "../Utils/AppConstants.hpp"
+#include "../Utils/ProcessUtils.hpp"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+namespace utl = vsprofile::utils;
+using namespace std::chrono_literals;
+using namespace vsprofile;
+using vsprofile::tests::ScratchDir;
+
+namespace {
+
+    // "key: value" lines of a proc file, read the plain way
+    std::map<std::string, long long> ProcFields(const fs::path& path) {
+        std::map<std::string, long long> fields;
+        std::ifstream in {path};
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream words {line};
+            std::string key;
+            long long value {};
+            if (words >> key >> value) fields[key] = value;
+        }
+        return fields;
+    }
+
+    ResourceRun Run(const std::string& profile, const std::string& hash, const long long peakRssMiB, const double cpuS) {
+        ResourceRun run;
+        run.profile = profile;
+        run.modSetHash = hash;
+        run.peakRssKb = peakRssMiB * 1024;
+        run.cpuMs = cpuS * 1000.0;
+        return run;
+    }
+
+    // The row of a comparison table from its label on, past any styling left open by the header
+    std::string Row(const std::string& table, const std::string& label) {
+        std::istringstream lines {table};
+        std::string line;
+        while (std::getline(lines, line)) {
+            if (const std::size_t pos {line.find(label)}; pos != std::string::npos) return line.substr(pos);
+        }
+        return {};
+    }
+
+}
+
+#if defined(__linux__)
+TEST(ResourceHistory, SamplesThisProcess) {
+    utl::ResourceSampler sampler {utl::CurrentProcessId(), 5ms};
+    std::this_thread::sleep_for(30ms);
+    // Something to see: 64 MiB touched, and CPU time spent
+    std::vector<char> block(64u << 20);
+    for (std::size_t i = 0; i < block.size(); i += 4096) block[i] = static_cast<char>(i);
+    const auto busyUntil {std::chrono::steady_clock::now() + 60ms};
+    volatile unsigned spin {0};
+    while (std::chrono::steady_clock::now() < busyUntil) spin = spin + 1;
+    std::this_thread::sleep_for(30ms);
+    const auto samples {sampler.Stop()};
+    CHECK(samples.size() >= 5);
+    if (samples.empty()) return;
+    CHECK(std::ranges::is_sorted(samples, {}, &utl::ResourceSample::tMs));
+    CHECK(std::ranges::is_sorted(samples, {}, &utl::ResourceSample::cpuMs));
+    const auto peak {std::ranges::max(samples, {}, &utl::ResourceSample::rssKb).rssKb};
+    CHECK(samples.front().rssKb > 0);
+    CHECK(peak - samples.front().rssKb >= 32 * 1024);
+    CHECK(samples.back().cpuMs > 0.0);
+    CHECK(block[4096] == static_cast<char>(4096));
+
+    // Nothing touched storage since the last sample, so its counters are the kernel's; write_bytes is
+    // told apart from cancelled_write_bytes
+    const auto io {ProcFields("/proc/self/io")};
+    const auto field = [&](const std::string& key) { return io.contains(key) ? io.at(key) : 0; };
+    CHECK_EQ(samples.back().readBytes, field("read_bytes:"));
+    CHECK_EQ(samples.back().writeBytes, field("write_bytes:"));
+}
+#endif
+
+TEST(ResourceHistory, NoProcessNoSamples) {
+    utl::ResourceSampler sampler {0, 5ms};
+    CHECK(sampler.Stop().empty());
+    const ResourceRun run {ResourceRun::FromSamples("A", "h", {})};
+    CHECK_EQ(run.peakRssKb, 0);
+    CHECK_EQ(run.durationMs, 0.0);
+    CHECK(run.samples.empty());
+}
+
+TEST(ResourceHistory, LongSeriesAreDownsampledKeepingThePeak) {
+    std::vector<utl::ResourceSample> samples;
+    for (int i = 0; i < 2000; ++i) {
+        samples.push_back({static_cast<double>(i), i == 1233 ? 999'999 : 1000 + i, 10LL * i, 20LL * i, 2.0 * i});
+    }
+    const ResourceRun run {ResourceRun::FromSamples("A", "h", samples)};
+    // Halved until within the cap
+    CHECK_EQ(run.samples.size(), 500u);
+    CHECK_EQ(run.peakRssKb, 999'999);
+    CHECK_EQ(std::ranges::max(run.samples, {}, &utl::ResourceSample::rssKb).rssKb, 999'999);
+    // Totals come from the full series, and its end survives
+    CHECK_EQ(run.durationMs, 1999.0);
+    CHECK_EQ(run.cpuMs, 3998.0);
+    CHECK_EQ(run.readBytes, 19'990);
+    CHECK_EQ(run.writeBytes, 39'980);
+    CHECK_EQ(run.samples.back().tMs, 1999.0);
+
+    samples.resize(constants::kMaxResourceSamples);
+    CHECK_EQ(ResourceRun::FromSamples("A", "h", samples).samples.size(), constants::kMaxResourceSamples);
+    samples.push_back(samples.back());
+    CHECK_EQ(ResourceRun::FromSamples("A", "h", samples).samples.size(), constants::kMaxResourceSamples / 2 + 1);
+}
+
+TEST(ResourceHistory, ModSetHashFollowsPathsAndSizes) {
+    const ScratchDir a, b;
+    for (const ScratchDir* dir : {&a, &b}) {
+        dir->Write("a.zip", "aaaa");
+        dir->Write("folder/config.json", "{}");
+    }
+    // Where the mods live does not matter, and neither do contents of the same size
+    CHECK_EQ(HashModSet(a.Path()), HashModSet(b.Path()));
+    b.Write("a.zip", "bbbb");
+    CHECK_EQ(HashModSet(a.Path()), HashModSet(b.Path()));
+    b.Write("folder/config.json", "{ }");
+    CHECK(HashModSet(a.Path()) != HashModSet(b.Path()));
+    b.Write("folder/config.json", "{}");
+    fs::rename(b.Path() / "a.zip", b.Path() / "c.zip");
+    CHECK(HashModSet(a.Path()) != HashModSet(b.Path()));
+}
+
+TEST(ResourceHistory, ComparisonUsesMediansOfTheCurrentModSet) {
+    const std::vector<ResourceRun> runs {
+            Run("A", "a1", 100, 10), Run("A", "a1", 200, 20), Run("A", "a1", 900, 90), // one outlier
+            Run("B", "b0", 5000, 500),                                                   // an older mod set
+            Run("B", "b1", 300, 30), Run("B", "b1", 300, 30),
+    };
+    std::ostringstream out;
+    std::streambuf* const stdoutBuf {std::cout.rdbuf(out.rdbuf())};
+    PrintFootprintComparison(runs, "A", "a1", "B", "b1");
+    std::cout.rdbuf(stdoutBuf);
+    const std::string table {out.str()};
+    CHECK_EQ(Row(table, "runs"), std::format("{:<16} {:>14.1f} {:>14.1f} {:>9}", "runs", 3.0, 2.0, "-33.3%"));
+    CHECK_EQ(Row(table, "peak RSS (MiB)"), std::format("{:<16} {:>14.1f} {:>14.1f} {:>9}", "peak RSS (MiB)", 200.0, 300.0, "+50.0%"));
+    CHECK_EQ(Row(table, "CPU (s)"), std::format("{:<16} {:>14.1f} {:>14.1f} {:>9}", "CPU (s)", 20.0, 30.0, "+50.0%"));
+}
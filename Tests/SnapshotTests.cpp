@@ -0,0 +1,69 @@
+#include "Check.hpp"
+#include "../Core/Snapshot.hpp"
+
+namespace fs = std::filesystem;
+using vsprofile::SnapshotStore;
+using vsprofile::tests::ScratchDir;
+
+namespace {
+
+    // Spans several chunks, so restoring it has to put them back together in order
+    std::string LargeSave(const char seed) {
+        std::string text;
+        for (int i = 0; text.size() < 600 * 1024; ++i) text += std::format("{}-{}:{};", seed, i, i * 7919 % 104729);
+        return text;
+    }
+
+}
+
+TEST(Snapshot, CreateThenRestoreRoundTrips) {
+    const ScratchDir dir;
+    const std::string world {LargeSave('w')};
+    dir.Write("saves/world.vcdbs", world);
+    dir.Write("saves/backups/old.vcdbs", "old");
+    dir.Write("saves/empty.txt", "");
+    const SnapshotStore store {dir.Path() / "store"};
+    CHECK(store.Create(dir.Path() / "saves", "first"));
+    CHECK(!store.Create(dir.Path() / "saves", "first")); // names are not reused
+
+    dir.Write("saves/world.vcdbs", "overwritten");
+    fs::remove(dir.Path() / "saves/backups/old.vcdbs");
+    CHECK(store.Restore("first", dir.Path() / "saves"));
+    CHECK(dir.Read("saves/world.vcdbs") == world);
+    CHECK_EQ(dir.Read("saves/backups/old.vcdbs"), "old");
+    CHECK(fs::exists(dir.Path() / "saves/empty.txt"));
+
+    CHECK(store.Restore("first", dir.Path() / "elsewhere"));
+    CHECK(dir.Read("elsewhere/world.vcdbs") == world);
+    CHECK(!store.Restore("missing", dir.Path() / "elsewhere"));
+}
+
+TEST(Snapshot, RemoveKeepsChunksOthersStillUse) {
+    const ScratchDir dir;
+    const std::string world {LargeSave('w')};
+    dir.Write("saves/world.vcdbs", world);
+    const SnapshotStore store {dir.Path() / "store"};
+    CHECK(store.Create(dir.Path() / "saves", "first"));
+    dir.Write("saves/other.vcdbs", LargeSave('o'));
+    CHECK(store.Create(dir.Path() / "saves", "second"));
+
+    CHECK(store.Remove("first"));
+    CHECK(!store.Remove("first"));
+    CHECK(store.Restore("second", dir.Path() / "restored"));
+    CHECK(dir.Read("restored/world.vcdbs") == world);
+    CHECK(dir.Read("restored/other.vcdbs") == LargeSave('o'));
+}
+
+TEST(Snapshot, NamesCannotLeaveTheStore) {
+    const ScratchDir dir;
+    dir.Write("saves/world.vcdbs", "world");
+    const SnapshotStore store {dir.Path() / "store"};
+    CHECK(store.Create(dir.Path() / "saves", "first"));
+    // A manifest beside the store, which a name with a separator would otherwise reach
+    fs::copy_file(dir.Path() / "store/first.json", dir.Path() / "outside.json");
+    CHECK(!store.Create(dir.Path() / "saves", "../outside2"));
+    CHECK(!store.Restore("../outside", dir.Path() / "restored"));
+    CHECK(!fs::exists(dir.Path() / "restored"));
+    CHECK(!store.Remove("../outside"));
+    CHECK(fs::exists(dir.Path() / "outside.json"));
+}
@@ -0,0 +1,103 @@
+#include "Check.hpp"
+#include "../Core/StashRetention.hpp"
+#include <algorithm>
+
+namespace ch = std::chrono;
+using namespace std::chrono_literals;
+using namespace vsprofile;
+
+namespace {
+
+    ch::system_clock::time_point At(const ch::year_month_day date, const ch::hours hour = 12h) {
+        return ch::sys_days{date} + hour;
+    }
+
+    StashRecord Stash(const std::string& name, const ch::system_clock::time_point time, const std::string& hash,
+                      const std::uintmax_t ownBytes = 1) {
+        StashRecord record;
+        record.name = name;
+        record.time = time;
+        record.contentHash = hash;
+        record.ownBytes = ownBytes;
+        return record;
+    }
+
+    // Names only, sorted, so the unordered result of PlanPrune compares directly
+    std::vector<std::string> Pruned(const std::vector<PruneDecision>& prune) {
+        std::vector<std::string> names;
+        for (const auto& decision : prune) names.push_back(decision.name);
+        std::ranges::sort(names);
+        return names;
+    }
+
+}
+
+TEST(StashRetention, StashTimeParsesGeneratedNames) {
+    const auto time {StashTime("stash_2025-03-04_05-06-07_Survival")};
+    CHECK(time.has_value());
+    if (time) CHECK(*time == ch::sys_days{2025y / 3 / 4} + 5h + 6min + 7s);
+    CHECK(StashTime("stash_2025-03-04_05-06-07").has_value()); // the profile part may be empty
+    CHECK(StashTime("stash_2025-03-04_05-06-07_with_underscores").has_value());
+}
+
+TEST(StashRetention, StashTimeRejectsOtherNames) {
+    CHECK(!StashTime("Survival").has_value());
+    CHECK(!StashTime("stash_").has_value());
+    CHECK(!StashTime("stash_2025-03-04").has_value());
+    CHECK(!StashTime("stash_2025-03-04_05-06-07X").has_value());
+    CHECK(!StashTime("stash_2025/03/04_05-06-07_A").has_value());
+    CHECK(!StashTime("stash_2025-3-004_05-06-07_A").has_value());
+    CHECK(!StashTime("stash_2025-13-04_05-06-07_A").has_value());
+    CHECK(!StashTime("stash_2025-02-30_05-06-07_A").has_value());
+    CHECK(!StashTime("stash_20x5-03-04_05-06-07_A").has_value());
+}
+
+TEST(StashRetention, DuplicatesKeepTheNewest) {
+    const StashRetention policy {.keepLast = 10, .keepDaily = 0, .keepWeekly = 0};
+    const auto prune {PlanPrune({Stash("old", At(2025y / 3 / 1), "same"), Stash("new", At(2025y / 3 / 2), "same"),
+                                 Stash("other", At(2025y / 2 / 1), "different")}, policy)};
+    CHECK_EQ(prune.size(), 1u);
+    if (prune.size() != 1) return;
+    CHECK_EQ(prune[0].name, "old");
+    CHECK(prune[0].reason == PruneDecision::Reason::Duplicate);
+    CHECK_EQ(prune[0].duplicateOf, "new");
+}
+
+TEST(StashRetention, KeepsTheLastByCount) {
+    const StashRetention policy {.keepLast = 2, .keepDaily = 0, .keepWeekly = 0};
+    const auto prune {PlanPrune({Stash("a", At(2025y / 3 / 1), "a"), Stash("b", At(2025y / 3 / 2), "b"),
+                                 Stash("c", At(2025y / 3 / 3), "c"), Stash("d", At(2025y / 3 / 4), "d")}, policy)};
+    CHECK_EQ(Pruned(prune), (std::vector<std::string>{"a", "b"}));
+    CHECK(std::ranges::all_of(prune, [](const PruneDecision& d) { return d.reason == PruneDecision::Reason::Expired; }));
+}
+
+TEST(StashRetention, KeepsTheNewestOfEachDay) {
+    const StashRetention policy {.keepLast = 1, .keepDaily = 2, .keepWeekly = 0};
+    const auto prune {PlanPrune({Stash("day1-morning", At(2025y / 3 / 1, 8h), "1"), Stash("day1-evening", At(2025y / 3 / 1, 20h), "2"),
+                                 Stash("day2-morning", At(2025y / 3 / 2, 8h), "3"), Stash("day2-evening", At(2025y / 3 / 2, 20h), "4"),
+                                 Stash("day3", At(2025y / 3 / 3), "5")}, policy)};
+    CHECK_EQ(Pruned(prune), (std::vector<std::string>{"day1-evening", "day1-morning", "day2-morning"}));
+}
+
+TEST(StashRetention, WeeksStartOnMonday) {
+    // 2025-03-10 is a Monday, the Sunday before it belongs to the previous week
+    const StashRetention policy {.keepLast = 1, .keepDaily = 0, .keepWeekly = 2};
+    const auto prune {PlanPrune({Stash("monday", At(2025y / 3 / 10), "1"), Stash("sunday", At(2025y / 3 / 9), "2"),
+                                 Stash("saturday", At(2025y / 3 / 8), "3")}, policy)};
+    CHECK_EQ(Pruned(prune), (std::vector<std::string>{"saturday"}));
+}
+
+TEST(StashRetention, SizeCapDropsTheOldestKept) {
+    constexpr std::uintmax_t kKiB {1024};
+    const StashRetention policy {.keepLast = 10, .keepDaily = 0, .keepWeekly = 0, .maxMiB = 1};
+    const auto prune {PlanPrune({Stash("a", At(2025y / 3 / 1), "a", 600 * kKiB), Stash("b", At(2025y / 3 / 2), "b", 600 * kKiB),
+                                 Stash("c", At(2025y / 3 / 3), "c", 600 * kKiB)}, policy)};
+    CHECK_EQ(Pruned(prune), (std::vector<std::string>{"a", "b"}));
+    CHECK(std::ranges::all_of(prune, [](const PruneDecision& d) { return d.reason == PruneDecision::Reason::OverCap; }));
+}
+
+TEST(StashRetention, NewestIsAlwaysKept) {
+    const StashRetention policy {.keepLast = 0, .keepDaily = 0, .keepWeekly = 0, .maxMiB = 1};
+    const auto prune {PlanPrune({Stash("old", At(2025y / 3 / 1), "a"), Stash("huge", At(2025y / 3 / 2), "b", 8 * 1024 * 1024)}, policy)};
+    CHECK_EQ(Pruned(prune), (std::vector<std::string>{"old"}));
+}
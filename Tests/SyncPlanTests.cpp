@@ -0,0 +1,140 @@
+#include "Check.hpp"
+#include "../Utils/DiskLayout.hpp"
+#include "../Utils/SyncPlan.hpp"
+#include <algorithm>
+
+namespace fs = std::filesystem;
+namespace utl = vsprofile::utils;
+using vsprofile::tests::ScratchDir;
+
+// Folder removals are left out: they go to the app's trash, outside the scratch folder
+
+TEST(SyncPlan, CaptureReadsBeforeRestoreWrites) {
+    for (const auto kind : {utl::FileOp::Kind::Copy, utl::FileOp::Kind::Link}) {
+        const ScratchDir dir;
+        dir.Write("live/a.zip", "outgoing a");
+        dir.Write("live/b.zip", "outgoing b");
+        dir.Write("live/gone.zip", "outgoing gone");
+        dir.Write("profile/a.zip", "incoming a");
+        dir.Write("profile/b.zip", "incoming b");
+        dir.Write("stash/placeholder", "");
+        const fs::path& root {dir.Path()};
+        utl::SyncPlan plan;
+        // The stash captures the live files, then the incoming profile replaces or removes them
+        plan.ops = {{kind, root / "live/a.zip", root / "stash/a.zip", 10},
+                    {kind, root / "live/b.zip", root / "stash/b.zip", 10},
+                    {kind, root / "live/gone.zip", root / "stash/gone.zip", 13},
+                    {kind, root / "profile/a.zip", root / "live/a.zip", 10},
+                    {kind, root / "profile/b.zip", root / "live/b.zip", 10},
+                    {utl::FileOp::Kind::Remove, {}, root / "live/gone.zip"}};
+        CHECK_EQ(plan.Execute(), 0u);
+        CHECK_EQ(dir.Read("stash/a.zip"), "outgoing a");
+        CHECK_EQ(dir.Read("stash/b.zip"), "outgoing b");
+        CHECK_EQ(dir.Read("stash/gone.zip"), "outgoing gone");
+        CHECK_EQ(dir.Read("live/a.zip"), "incoming a");
+        CHECK_EQ(dir.Read("live/b.zip"), "incoming b");
+        CHECK(!fs::exists(root / "live/gone.zip"));
+        CHECK_EQ(dir.Read("profile/a.zip"), "incoming a"); // a hard-linked target is replaced, never written through
+    }
+}
+
+TEST(SyncPlan, AddSyncMirrorsAndThenHasNothingLeft) {
+    const ScratchDir dir;
+    dir.Write("from/a.zip", "a");
+    dir.Write("from/cfg/x.json", "x");
+    dir.Write("from/deep/er/y.json", "y");
+    dir.Write("to/a.zip", "stale");
+    dir.Write("to/extra.zip", "extra");
+    dir.Write("to/deep", "a file where the source has a folder");
+    utl::SyncPlan plan;
+    CHECK(plan.AddSync(dir.Path() / "from", dir.Path() / "to", utl::SyncStrategy::Copy));
+    CHECK(!plan.Empty());
+    CHECK_EQ(plan.Execute(), 0u);
+    CHECK_EQ(dir.Read("to/a.zip"), "a");
+    CHECK_EQ(dir.Read("to/cfg/x.json"), "x");
+    CHECK_EQ(dir.Read("to/deep/er/y.json"), "y");
+    CHECK(!fs::exists(dir.Path() / "to/extra.zip"));
+
+    utl::SyncPlan again;
+    CHECK(again.AddSync(dir.Path() / "from", dir.Path() / "to", utl::SyncStrategy::Copy));
+    CHECK(again.Empty());
+}
+
+TEST(SyncPlan, CompletedReportsEveryOperation) {
+    const ScratchDir dir;
+    for (int i = 0; i < 20; ++i) dir.Write(std::format("from/{}/f{}.json", i % 4, i), std::to_string(i));
+    utl::SyncPlan plan;
+    CHECK(plan.AddSync(dir.Path() / "from", dir.Path() / "to", utl::SyncStrategy::Link));
+    std::vector<bool> completed(plan.ops.size());
+    std::mutex mtx;
+    plan.completed = [&](const std::size_t i) {
+        std::scoped_lock lock {mtx};
+        completed[i] = true;
+    };
+    CHECK_EQ(plan.Execute(), 0u);
+    CHECK_EQ(completed, std::vector<bool>(plan.ops.size(), true));
+    CHECK_EQ(dir.Read("to/3/f19.json"), "19");
+}
+
+TEST(SyncPlan, AddSelectedKeepsOnlyTheNamedEntries) {
+    const ScratchDir dir;
+    dir.Write("from/a.zip", "a");
+    dir.Write("from/b.zip", "b");
+    dir.Write("from/folder/c.json", "c");
+    dir.Write("to/b.zip", "old b");
+    dir.Write("to/z.zip", "z");
+    utl::SyncPlan plan;
+    CHECK(plan.AddSelected(dir.Path() / "from", dir.Path() / "to", {"b.zip", "folder", "missing.zip"}, utl::SyncStrategy::Copy));
+    CHECK_EQ(plan.Execute(), 0u);
+    CHECK(!fs::exists(dir.Path() / "to/a.zip"));
+    CHECK(!fs::exists(dir.Path() / "to/z.zip"));
+    CHECK_EQ(dir.Read("to/b.zip"), "b");
+    CHECK_EQ(dir.Read("to/folder/c.json"), "c");
+}
+
+TEST(SyncPlan, UnreadableFolderPlansNothing) {
+    const ScratchDir dir;
+    dir.Write("from/a.zip", "a");
+    dir.Write("from/locked/b.json", "b");
+    dir.Write("to/locked/b.json", "b");
+    dir.Write("to/locked/keep.json", "kept");
+    const fs::path locked {dir.Path() / "from/locked"};
+    fs::permissions(locked, fs::perms::none);
+    std::error_code ec;
+    fs::directory_iterator probe {locked, ec};
+    if (ec) { // unless the user can read anything regardless, as root can
+        utl::SyncPlan plan;
+        CHECK(!plan.AddSync(dir.Path() / "from", dir.Path() / "to", utl::SyncStrategy::Copy));
+        CHECK(plan.Empty());
+        utl::SyncPlan selected;
+        CHECK(!selected.AddSelected(dir.Path() / "from", dir.Path() / "to", {"a.zip", "locked"}, utl::SyncStrategy::Copy));
+        CHECK(selected.Empty());
+    }
+    fs::permissions(locked, fs::perms::owner_all); // so the scratch folder can be removed
+}
+
+TEST(SyncPlan, SequentialCopiesRunInDiskOrder) {
+    const ScratchDir dir;
+    dir.Write("to/placeholder", "");
+    std::vector<std::pair<std::uint64_t, int>> byKey;
+    for (int i = 0; i < 8; ++i) {
+        const std::string name {std::format("from/{}.zip", i)};
+        dir.Write(name, std::string(static_cast<std::size_t>(1 + i * 1000), 'x'));
+        byKey.emplace_back(utl::DiskOrderKey(dir.Path() / name), i);
+    }
+    // Planned back to front, as a spinning disk would least like them
+    std::ranges::sort(byKey, std::greater{});
+    utl::SyncPlan plan;
+    for (const auto& [key, i] : byKey) {
+        plan.ops.push_back({utl::FileOp::Kind::Copy, dir.Path() / std::format("from/{}.zip", i),
+                            dir.Path() / std::format("to/{}.zip", i), static_cast<std::uintmax_t>(1 + i * 1000)});
+    }
+    std::vector<std::uint64_t> order;
+    plan.completed = [&](const std::size_t op) { order.push_back(utl::DiskOrderKey(plan.ops[op].from)); };
+    utl::SetCopyOrderOverrides({{dir.Path(), utl::CopyOrder::Sequential}});
+    CHECK_EQ(plan.Execute(), 0u);
+    utl::SetCopyOrderOverrides({});
+    CHECK_EQ(order.size(), 8u);
+    CHECK(std::ranges::is_sorted(order));
+    CHECK_EQ(dir.Read("to/7.zip").size(), 7001u);
+}
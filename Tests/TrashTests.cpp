@@ -0,0 +1,124 @@
+#include "Check.hpp"
+#include "../Utils/Trash.hpp"
+#include <algorithm>
+#include <optional>
+
+namespace fs = std::filesystem;
+namespace utl = vsprofile::utils;
+using vsprofile::tests::ScratchDir;
+
+namespace {
+
+    std::optional<utl::TrashBatch> FindBatch(const fs::path& trashDir, const std::string& id) {
+        for (auto& batch : utl::ListTrash(trashDir)) {
+            if (batch.id == id) return std::move(batch);
+        }
+        return std::nullopt;
+    }
+
+    // A batch written the way MoveToTrash leaves one, `age` old
+    void WriteBatch(const ScratchDir& dir, const std::string& trash, const std::chrono::system_clock::duration age,
+                    const std::string& sequence) {
+        const auto ms {std::chrono::duration_cast<std::chrono::milliseconds>(
+                (std::chrono::system_clock::now() - age).time_since_epoch()).count()};
+        const std::string batch {std::format("{}/{}-1-{}", trash, ms, sequence)};
+        dir.Write(batch + "/origin", (dir.Path() / "Mods").string() + '\n');
+        dir.Write(batch + "/files/folder/inner.json", "{}");
+        dir.Write(batch + "/files/mod.zip", "zip");
+    }
+
+}
+
+TEST(Trash, BatchRestoresToItsOrigin) {
+    const ScratchDir dir;
+    dir.Write("Mods/a.zip", "a");
+    dir.Write("Mods/folder/inner.json", "{}");
+    dir.Write("Mods/kept.zip", "k");
+    const fs::path mods {dir.Path() / "Mods"};
+    std::error_code ec;
+    const std::string id {utl::MoveToTrash(mods, {mods / "a.zip", mods / "folder"}, ec)};
+    CHECK(!ec);
+    CHECK(!id.empty());
+    CHECK(!fs::exists(mods / "a.zip"));
+    CHECK(!fs::exists(mods / "folder"));
+
+    const fs::path trashDir {utl::TrashDirFor(mods)};
+    const auto batch {FindBatch(trashDir, id)};
+    CHECK(batch.has_value());
+    if (!batch) return;
+    CHECK(batch->origin == fs::absolute(mods));
+    CHECK_EQ(batch->names, (std::vector<std::string>{"a.zip", "folder"}));
+    CHECK(utl::RestoreTrash(*batch, ec));
+    CHECK(!ec);
+    CHECK_EQ(dir.Read("Mods/a.zip"), "a");
+    CHECK_EQ(dir.Read("Mods/folder/inner.json"), "{}");
+    CHECK_EQ(dir.Read("Mods/kept.zip"), "k");
+    CHECK(!FindBatch(trashDir, id).has_value());
+}
+
+TEST(Trash, RestoreLeavesARecreatedEntry) {
+    const ScratchDir dir;
+    dir.Write("Mods/a.zip", "old");
+    dir.Write("Mods/b.zip", "b");
+    const fs::path mods {dir.Path() / "Mods"};
+    std::error_code ec;
+    const std::string id {utl::MoveToTrash(mods, {mods / "a.zip", mods / "b.zip"}, ec)};
+    dir.Write("Mods/a.zip", "new");
+
+    const fs::path trashDir {utl::TrashDirFor(mods)};
+    auto batch {FindBatch(trashDir, id)};
+    CHECK(batch.has_value());
+    if (!batch) return;
+    // The rest comes back, the entry whose name was taken stays in the batch
+    CHECK(!utl::RestoreTrash(*batch, ec));
+    CHECK_EQ(dir.Read("Mods/a.zip"), "new");
+    CHECK_EQ(dir.Read("Mods/b.zip"), "b");
+    batch = FindBatch(trashDir, id);
+    CHECK(batch.has_value());
+    if (!batch) return;
+    CHECK_EQ(batch->names, std::vector<std::string>{"a.zip"});
+
+    fs::remove(mods / "a.zip");
+    CHECK(utl::RestoreTrash(*batch, ec));
+    CHECK_EQ(dir.Read("Mods/a.zip"), "old");
+    CHECK(!FindBatch(trashDir, id).has_value());
+}
+
+TEST(Trash, PurgeKeepsBatchesInsideTheUndoWindow) {
+    const ScratchDir dir;
+    WriteBatch(dir, "Trash", std::chrono::hours{1}, "0");
+    WriteBatch(dir, "Trash", std::chrono::seconds{0}, "1");
+    const fs::path trashDir {dir.Path() / "Trash"};
+    CHECK_EQ(utl::ListTrash(trashDir).size(), 2u);
+    const std::uintmax_t batchBytes {5 + (dir.Path() / "Mods").string().size() + 1}; // its files and origin
+
+    CHECK_EQ(utl::PurgeTrash(trashDir, std::chrono::minutes{10}), batchBytes);
+    const auto left {utl::ListTrash(trashDir)};
+    CHECK_EQ(left.size(), 1u);
+    CHECK(left.size() == 1 && left[0].id.ends_with("-1"));
+    CHECK(left.size() == 1 && left[0].origin == dir.Path() / "Mods");
+
+    CHECK_EQ(utl::PurgeTrash(trashDir, std::chrono::seconds{0}), batchBytes);
+    CHECK(utl::ListTrash(trashDir).empty());
+    CHECK(fs::is_empty(trashDir));
+}
+
+TEST(Trash, PurgeFinishesAnInterruptedPurge) {
+    const ScratchDir dir;
+    // Claimed by a purge that was stopped part way, so young as it is it is never restorable again
+    WriteBatch(dir, "Trash", std::chrono::seconds{0}, "0");
+    const fs::path trashDir {dir.Path() / "Trash"};
+    const std::string id {utl::ListTrash(trashDir).front().id};
+    fs::rename(trashDir / id, trashDir / (".purging-" + id));
+    fs::remove(trashDir / (".purging-" + id) / "files/mod.zip");
+    CHECK(utl::ListTrash(trashDir).empty());
+
+    // A stop before the first file leaves it for the next purge
+    std::stop_source stopped;
+    stopped.request_stop();
+    CHECK_EQ(utl::PurgeTrash(trashDir, std::chrono::minutes{10}, stopped.get_token()), 0u);
+    CHECK(fs::exists(trashDir / (".purging-" + id)));
+
+    CHECK_EQ(utl::PurgeTrash(trashDir, std::chrono::minutes{10}), 2 + (dir.Path() / "Mods").string().size() + 1);
+    CHECK(fs::is_empty(trashDir));
+}
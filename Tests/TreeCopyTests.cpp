@@ -0,0 +1,96 @@
+#include "Check.hpp"
+#include "../Utils/TreeCopy.hpp"
+#include "../Utils/WorkStealing.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace fs = std::filesystem;
+namespace utl = vsprofile::utils;
+using vsprofile::tests::ScratchDir;
+
+TEST(TreeCopy, CopiesNestedFolders) {
+    const ScratchDir dir;
+    dir.Write("From/modinfo.json", "{}");
+    dir.Write("From/assets/game/lang/en.json", "lang");
+    dir.Write("From/assets/game/textures/block/stone.png", "png");
+    fs::create_directories(dir.Path() / "From/assets/empty");
+    const utl::TreeCopyStats stats {utl::CopyTree(dir.Path() / "From", dir.Path() / "To")};
+    CHECK_EQ(stats.failures, 0u);
+    CHECK_EQ(stats.files, 3u);
+    CHECK_EQ(stats.bytes, 9u);
+    CHECK_EQ(stats.directories, 6u); // assets, game, lang, textures, block, empty
+    CHECK_EQ(dir.Read("To/modinfo.json"), "{}");
+    CHECK_EQ(dir.Read("To/assets/game/lang/en.json"), "lang");
+    CHECK_EQ(dir.Read("To/assets/game/textures/block/stone.png"), "png");
+    CHECK(fs::is_directory(dir.Path() / "To/assets/empty"));
+}
+
+TEST(TreeCopy, RecreatesSymlinksAsLinks) {
+    const ScratchDir dir;
+    dir.Write("From/data/real.json", "real");
+    fs::create_symlink("data/real.json", dir.Path() / "From/alias.json");
+    const utl::TreeCopyStats stats {utl::CopyTree(dir.Path() / "From", dir.Path() / "To")};
+    CHECK_EQ(stats.failures, 0u);
+    CHECK_EQ(stats.symlinks, 1u);
+    const fs::path alias {dir.Path() / "To/alias.json"};
+    CHECK(fs::is_symlink(alias));
+    // Not followed: the copy points where the original did, relative to its own folder
+    CHECK(fs::read_symlink(alias) == fs::path{"data/real.json"});
+    CHECK_EQ(dir.Read("To/alias.json"), "real");
+}
+
+TEST(TreeCopy, KeepsModesAndMtimes) {
+    const ScratchDir dir;
+    dir.Write("From/locked/inner/file.txt", "x");
+    dir.Write("From/top.txt", "y");
+    const fs::file_time_type old {fs::file_time_type::clock::now() - std::chrono::hours{24 * 30}};
+    const fs::file_time_type older {old - std::chrono::hours{24}};
+    fs::last_write_time(dir.Path() / "From/top.txt", old);
+    fs::last_write_time(dir.Path() / "From/locked/inner/file.txt", older);
+    fs::last_write_time(dir.Path() / "From/locked/inner", old);
+    fs::last_write_time(dir.Path() / "From/locked", older);
+    // Read-only once filled, which the copy can only match after writing its contents
+    const fs::perms readOnly {fs::perms::owner_read | fs::perms::owner_exec | fs::perms::group_read | fs::perms::group_exec};
+    fs::permissions(dir.Path() / "From/locked", readOnly);
+
+    const utl::TreeCopyStats stats {utl::CopyTree(dir.Path() / "From", dir.Path() / "To")};
+    CHECK_EQ(stats.failures, 0u);
+    CHECK_EQ(dir.Read("To/locked/inner/file.txt"), "x");
+    CHECK((fs::status(dir.Path() / "To/locked").permissions() & fs::perms::all) == readOnly);
+    CHECK(fs::last_write_time(dir.Path() / "To/top.txt") == old);
+    CHECK(fs::last_write_time(dir.Path() / "To/locked/inner/file.txt") == older);
+    CHECK(fs::last_write_time(dir.Path() / "To/locked/inner") == old);
+    CHECK(fs::last_write_time(dir.Path() / "To/locked") == older);
+
+    // Writable again, so the scratch folder can be removed
+    fs::permissions(dir.Path() / "From/locked", fs::perms::owner_all);
+    fs::permissions(dir.Path() / "To/locked", fs::perms::owner_all);
+}
+
+TEST(TreeCopy, ManyTasksFromOneWorker) {
+    // Every task is spawned by the first one, so the other workers only get work by stealing it
+    constexpr std::size_t kTasks = 5000;
+    std::vector<std::atomic<int>> runs(kTasks + 1);
+    std::mutex mtx;
+    std::vector<std::thread::id> workers;
+    utl::WorkStealingPool<std::size_t> pool {4};
+    pool.Run({kTasks}, [&](const std::size_t task, auto&& spawn) {
+        ++runs[task];
+        if (task == kTasks) {
+            for (std::size_t i = 0; i < kTasks; ++i) spawn(i);
+        }
+        std::scoped_lock lock {mtx};
+        if (std::ranges::find(workers, std::this_thread::get_id()) == workers.end()) workers.push_back(std::this_thread::get_id());
+    });
+    std::size_t once {};
+    for (const auto& count : runs) once += count == 1;
+    CHECK_EQ(once, kTasks + 1);
+    CHECK(workers.size() <= 4u);
+
+    // A pool can run again once the last run ended
+    std::atomic<std::size_t> total {};
+    pool.Run({1, 2, 3}, [&](const std::size_t task, auto&&) { total += task; });
+    CHECK_EQ(total.load(), 6u);
+}
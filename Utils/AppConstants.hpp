@@ -2,6 +2,7 @@
 // Created by Jacopo Uggeri on 28/07/2025.
 //
 #pragma once
+#include <chrono>
 #include <filesystem>
 #define VSPROFILE_VERSION "0.1.0"
 
@@ -41,6 +42,39 @@ namespace vsprofile::constants {
 // App-specific directory and files
     inline const fs::path kAppDir        = kAppDataDir / kAppName;
     inline const fs::path kConfigPath    = kAppDir / "Config.json";
+    inline const fs::path kPerfDir       = kAppDir / "Perf";
+    inline const fs::path kResourceHistoryPath = kAppDir / "ResourceHistory.jsonl";
+    inline const fs::path kSnapshotDir   = kAppDir / "Snapshots";
+    inline const fs::path kDaemonSocketPath = kAppDir / "vsprofiled.sock";
+    inline const fs::path kTrashDir      = kAppDir / "Trash";
+    // Trash folders kept on other volumes, named with the user id after this prefix
+    inline constexpr std::string_view kVolumeTrashPrefix = ".vsprofile-trash-";
+    inline const fs::path kJournalDir    = kAppDir / "Journal";
+    // Held by whichever vsprofile or vsprofiled process is running a command that changes Mods or the config
+    inline const fs::path kLockPath      = kAppDir / "vsprofile.lock";
     inline const fs::path kVintageStoryDataPath = kAppDataDir / "VintagestoryData";
+    // Per-profile metadata lives in this hidden folder inside each profile and is never treated as a mod
+    inline constexpr std::string_view kProfileMetaDir = ".vsprofile";
+    // Cold profiles keep the files no other profile links to in this pack inside their metadata folder
+    inline constexpr std::string_view kColdPackName = "cold.vspack";
+
+    // Longest a profiled game launch may take before it is stopped
+    inline constexpr std::chrono::minutes kPerfTimeout {10};
+    // How long a stopped child process gets to exit before it is killed
+    inline constexpr std::chrono::seconds kTerminateGrace {5};
+    // Launches per configuration when bisecting a regression, and the smallest slowdown that counts
+    inline constexpr int kBisectRuns = 5;
+    inline constexpr double kBisectMinRegression = 0.05;
+    // Resource sampling of launched games, and the series length kept per recorded run
+    inline constexpr std::chrono::milliseconds kResourceSampleInterval {250};
+    inline constexpr std::size_t kMaxResourceSamples = 512;
+    // Activations remembered for predicting which profile to stage next
+    inline constexpr std::size_t kActivationHistorySize = 64;
+    // Deleted folders stay restorable in the trash for this long before the background purge removes them
+    inline constexpr std::chrono::minutes kTrashUndoWindow {10};
+    // Content-defined chunk sizes for save snapshots
+    inline constexpr std::size_t kChunkMinSize = 16 * 1024;
+    inline constexpr std::size_t kChunkAvgSize = 64 * 1024;
+    inline constexpr std::size_t kChunkMaxSize = 256 * 1024;
 
 }
\ No newline at end of file
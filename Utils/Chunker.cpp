@@ -0,0 +1,55 @@
+#include "Chunker.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace vsprofile::utils {
+
+    namespace {
+        // Mask of `bits` ones in the high end of the fingerprint, whose bits depend on the most bytes
+        std::uint64_t HighMask(const int bits) {
+            return bits <= 0 ? 0 : ~std::uint64_t{0} << (64 - bits);
+        }
+    }
+
+    const std::array<std::uint64_t, 256>& ContentChunker::Gear() {
+        // Fixed pseudo-random table (splitmix64), boundaries must be identical across runs and builds
+        static const std::array<std::uint64_t, 256> table = [] {
+            std::array<std::uint64_t, 256> t {};
+            std::uint64_t state = 0x9e3779b97f4a7c15ULL;
+            for (auto& v : t) {
+                std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+                v = z ^ (z >> 31);
+            }
+            return t;
+        }();
+        return table;
+    }
+
+    ContentChunker::ContentChunker(const std::size_t minSize, const std::size_t avgSize, const std::size_t maxSize)
+        : min_(minSize), avg_(avgSize), max_(maxSize) {
+        const int bits = std::bit_width(avgSize) - 1;
+        maskSmall_ = HighMask(bits + 2);
+        maskLarge_ = HighMask(bits - 2);
+    }
+
+    std::size_t ContentChunker::Cut(const unsigned char* data, std::size_t size) const {
+        if (size <= min_) return size;
+        size = std::min(size, max_);
+        const std::size_t normal = std::min(size, avg_);
+        const auto& gear = Gear();
+        std::uint64_t fp = 0;
+        std::size_t i = min_;
+        for (; i < normal; ++i) {
+            fp = (fp << 1) + gear[data[i]];
+            if (!(fp & maskSmall_)) return i + 1;
+        }
+        for (; i < size; ++i) {
+            fp = (fp << 1) + gear[data[i]];
+            if (!(fp & maskLarge_)) return i + 1;
+        }
+        return size;
+    }
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace vsprofile::utils {
+
+    // Content-defined chunking with a Gear rolling hash and FastCDC-style normalisation: a stricter mask
+    // below the average size and a looser one above it keeps chunk sizes close to the average. Boundaries
+    // depend only on nearby bytes, so an edit inside a large file only changes the chunks around it.
+    class ContentChunker {
+        std::size_t min_;
+        std::size_t avg_;
+        std::size_t max_;
+        std::uint64_t maskSmall_;
+        std::uint64_t maskLarge_;
+
+        static const std::array<std::uint64_t, 256>& Gear();
+
+    public:
+        ContentChunker(std::size_t minSize, std::size_t avgSize, std::size_t maxSize);
+
+        [[nodiscard]] std::size_t MaxSize() const { return max_; }
+        // Length of the chunk starting at data; size is what is buffered and must reach MaxSize() unless at end of input
+        [[nodiscard]] std::size_t Cut(const unsigned char* data, std::size_t size) const;
+    };
+
+}
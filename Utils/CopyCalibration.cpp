@@ -0,0 +1,213 @@
+#include "CopyCalibration.hpp"
+#include "TextUtils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <unistd.h>
+#endif
+
+namespace vsprofile::utils {
+
+    namespace {
+        constexpr std::uintmax_t kMinSampleSize = 256 * 1024; // smaller files time syscalls, not copies
+        constexpr std::uintmax_t kSampleBytes = 8 * 1024 * 1024; // a small sample is copied repeatedly up to this
+        constexpr std::size_t kMaxSampleRuns = 16;
+        constexpr std::size_t kBufferSize = 1024 * 1024;
+        constexpr CopyMethod kMethods[] {CopyMethod::Reflink, CopyMethod::CopyFileRange, CopyMethod::Sendfile, CopyMethod::ReadWrite};
+
+        std::mutex gMtx;
+        CopyCalibrations gKnown;
+        CopyCalibrations gNew;        // measured this run, not yet handed to the config
+        std::set<std::string> gBusy;  // pairs being measured, copied the default way meanwhile
+
+#if defined(__linux__)
+        std::string_view FilesystemType(const unsigned long magic) {
+            switch (magic) {
+                case 0xEF53: return "ext4";
+                case 0x9123683E: return "btrfs";
+                case 0x58465342: return "xfs";
+                case 0x6969: return "nfs";
+                case 0x2FC12FC2: return "zfs";
+                case 0x01021994: return "tmpfs";
+                case 0x794C7630: return "overlay";
+                case 0xFF534D42: return "cifs";
+                case 0x65735546: return "fuse";
+                default: return "fs";
+            }
+        }
+
+        std::string FilesystemId(const struct statfs& s) {
+            int fsid[2] {};
+            static_assert(sizeof(fsid) == sizeof(s.f_fsid));
+            std::memcpy(fsid, &s.f_fsid, sizeof(fsid));
+            return std::format("{}:{:08x}{:08x}", FilesystemType(static_cast<unsigned long>(s.f_type)),
+                               static_cast<unsigned>(fsid[0]), static_cast<unsigned>(fsid[1]));
+        }
+
+        std::string PairKey(const int src, const int dst) {
+            struct statfs a {}, b {};
+            if (fstatfs(src, &a) != 0 || fstatfs(dst, &b) != 0) return {};
+            return std::format("{}->{}", FilesystemId(a), FilesystemId(b));
+        }
+
+        std::string PairKey(const fs::path& from, const fs::path& toDir) {
+            struct statfs a {}, b {};
+            if (statfs(from.c_str(), &a) != 0 || statfs(toDir.c_str(), &b) != 0) return {};
+            return std::format("{}->{}", FilesystemId(a), FilesystemId(b));
+        }
+
+        // Copies all of src into the empty dst from offset zero, leaving src's file offset alone
+        bool CopyWith(const CopyMethod method, const int src, const int dst, const std::uintmax_t size) {
+            off_t in {0};
+            bool ok {true};
+            switch (method) {
+                case CopyMethod::Reflink:
+#if defined(FICLONE)
+                    ok = ioctl(dst, FICLONE, src) == 0;
+#else
+                    ok = false;
+#endif
+                    break;
+                case CopyMethod::CopyFileRange: {
+                    off_t out {0};
+                    while (ok && static_cast<std::uintmax_t>(in) < size) {
+                        const ssize_t n {copy_file_range(src, &in, dst, &out, size - static_cast<std::uintmax_t>(in), 0)};
+                        ok = n > 0;
+                    }
+                    break;
+                }
+                case CopyMethod::Sendfile:
+                    while (ok && static_cast<std::uintmax_t>(in) < size) {
+                        ok = sendfile(dst, src, &in, size - static_cast<std::uintmax_t>(in)) > 0;
+                    }
+                    break;
+                case CopyMethod::ReadWrite: {
+                    std::vector<char> buffer(kBufferSize);
+                    while (ok && static_cast<std::uintmax_t>(in) < size) {
+                        const ssize_t n {pread(src, buffer.data(), buffer.size(), in)};
+                        ok = n > 0;
+                        for (ssize_t done = 0; ok && done < n;) {
+                            const ssize_t w {write(dst, buffer.data() + done, static_cast<std::size_t>(n - done))};
+                            ok = w > 0;
+                            done += w;
+                        }
+                        in += n;
+                    }
+                    break;
+                }
+            }
+            struct stat st {};
+            return ok && fstat(dst, &st) == 0 && static_cast<std::uintmax_t>(st.st_size) == size;
+        }
+
+        CopyCalibration Calibrate(const int src, const fs::path& from, const fs::path& to, const std::uintmax_t size) {
+            CopyCalibration best {CopyMethod::ReadWrite, false, 0.0};
+            const fs::path sample {to.parent_path() / std::format(".vsprofile-calibrate-{}", to.filename().string())};
+            const std::size_t runs {std::clamp<std::size_t>(kSampleBytes / size, 1, kMaxSampleRuns)};
+            for (const CopyMethod method : kMethods) {
+                bool valid {true};
+                std::chrono::steady_clock::duration elapsed {};
+                for (std::size_t run = 0; run < runs && valid; ++run) {
+                    const int dst {open(sample.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600)};
+                    if (dst < 0) return best;
+                    // Every run reads from disk and is timed until its data is down, so a method that only
+                    // fills the page cache fastest does not win, nor does the one running after the others
+                    posix_fadvise(src, 0, 0, POSIX_FADV_DONTNEED);
+                    const auto start {std::chrono::steady_clock::now()};
+                    valid = CopyWith(method, src, dst, size) && fdatasync(dst) == 0;
+                    elapsed += std::chrono::steady_clock::now() - start;
+                    close(dst);
+                    unlink(sample.c_str());
+                }
+                const double seconds {std::chrono::duration<double>(elapsed).count()};
+                const double speed {static_cast<double>(size * runs) / (1024.0 * 1024.0) / std::max(seconds, 1e-9)};
+                if (valid && speed > best.mibPerSecond) best = {method, false, speed};
+            }
+            best.hardLinks = link(from.c_str(), sample.c_str()) == 0;
+            unlink(sample.c_str());
+            return best;
+        }
+#endif
+    }
+
+    std::string_view ToString(const CopyMethod method) {
+        switch (method) {
+            case CopyMethod::Reflink: return "reflink";
+            case CopyMethod::Sendfile: return "sendfile";
+            case CopyMethod::ReadWrite: return "readwrite";
+            default: return "copy_file_range";
+        }
+    }
+
+    CopyMethod CopyMethodFromString(const std::string_view name) {
+        if (name == "reflink") return CopyMethod::Reflink;
+        if (name == "sendfile") return CopyMethod::Sendfile;
+        if (name == "readwrite") return CopyMethod::ReadWrite;
+        return CopyMethod::CopyFileRange;
+    }
+
+    void SetCopyCalibrations(const CopyCalibrations& calibrations) {
+        std::scoped_lock lock {gMtx};
+        gKnown = calibrations;
+    }
+
+    bool TakeNewCopyCalibrations(CopyCalibrations& into) {
+        std::scoped_lock lock {gMtx};
+        if (gNew.empty()) return false;
+        for (const auto& [key, calibration] : gNew) into[key] = calibration;
+        gNew.clear();
+        return true;
+    }
+
+    bool CopyCalibrated(const int src, const int dst, const fs::path& from, const fs::path& to, const std::uintmax_t size) {
+#if defined(__linux__)
+        const std::string key {PairKey(src, dst)};
+        if (key.empty()) return false;
+        {
+            std::unique_lock lock {gMtx};
+            if (const auto it {gKnown.find(key)}; it != gKnown.end()) {
+                const CopyMethod method {it->second.method};
+                lock.unlock();
+                return CopyWith(method, src, dst, size);
+            }
+            if (size < kMinSampleSize || !gBusy.insert(key).second) return false;
+        }
+        const CopyCalibration calibration {Calibrate(src, from, to, size)};
+        {
+            std::scoped_lock lock {gMtx};
+            gKnown[key] = calibration;
+            gNew[key] = calibration;
+            gBusy.erase(key);
+        }
+        PrintLog(std::format("Calibrated copies {}: {} at {:.0f} MiB/s, hard links {}\n", key, ToString(calibration.method),
+                             calibration.mibPerSecond, calibration.hardLinks ? "work" : "do not work"));
+        return CopyWith(calibration.method, src, dst, size);
+#else
+        return false;
+#endif
+    }
+
+    bool HardLinksKnownBroken(const fs::path& from, const fs::path& to) {
+#if defined(__linux__)
+        const std::string key {PairKey(from, to.parent_path())};
+        std::scoped_lock lock {gMtx};
+        const auto it {gKnown.find(key)};
+        return it != gKnown.end() && !it->second.hardLinks;
+#else
+        return false;
+#endif
+    }
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <filesystem>
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace vsprofile::utils {
+
+    namespace fs = std::filesystem;
+
+    enum class CopyMethod {
+        Reflink,       // FICLONE, shares extents on btrfs and XFS
+        CopyFileRange, // in-kernel copy, offloaded to the server on NFS
+        Sendfile,      // in-kernel copy for kernels or filesystems where copy_file_range falls short
+        ReadWrite,     // plain buffered copy through userspace
+    };
+
+    [[nodiscard]] std::string_view ToString(CopyMethod method);
+    [[nodiscard]] CopyMethod CopyMethodFromString(std::string_view name); // unknown names map to CopyFileRange
+
+    // Fastest copy found for one (source filesystem, destination filesystem) pair
+    struct CopyCalibration {
+        CopyMethod method {CopyMethod::CopyFileRange};
+        bool hardLinks {false}; // a hard link from source to destination works
+        double mibPerSecond {};
+    };
+
+    // Calibrations are keyed "<source fs>-><destination fs>", each filesystem named by type and fsid
+    // (e.g. "ext4:4d2c6a1b8e0f3a27"), which stays stable across reboots and remounts
+    using CopyCalibrations = std::map<std::string, CopyCalibration>;
+
+    // Results loaded from the config, used from then on instead of measuring again
+    void SetCopyCalibrations(const CopyCalibrations& calibrations);
+    // Moves pairs measured since the last call into `into`, true if there were any to persist
+    bool TakeNewCopyCalibrations(CopyCalibrations& into);
+
+    // Copies an open file with the method calibrated for this pair of filesystems. The first large
+    // enough file copied between a new pair is the sample: every method copies it beside `to` and the
+    // fastest one that produced the whole file is kept. False when the chosen method failed.
+    bool CopyCalibrated(int src, int dst, const fs::path& from, const fs::path& to, std::uintmax_t size);
+    // Whether hard links from `from` into `to`'s folder are known not to work
+    [[nodiscard]] bool HardLinksKnownBroken(const fs::path& from, const fs::path& to);
+
+}
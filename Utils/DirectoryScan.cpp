@@ -0,0 +1,220 @@
+#include "DirectoryScan.hpp"
+#include "IoRing.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+#endif
+
+namespace vsprofile::utils {
+
+    namespace {
+        constexpr std::size_t kDirentBufferSize = 64 * 1024;
+        constexpr std::size_t kStatsPerThread = 256; // below this, threads cost more than they save
+
+        // Runs fn over [0, count) split across hardware threads when there is enough work
+        template <typename Fn>
+        void ParallelFor(const std::size_t count, Fn fn) {
+            const std::size_t threads {std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                                             count / kStatsPerThread)};
+            if (threads <= 1) {
+                fn(0, count);
+                return;
+            }
+            std::vector<std::jthread> pool;
+            const std::size_t step {(count + threads - 1) / threads};
+            for (std::size_t begin = step; begin < count; begin += step) {
+                pool.emplace_back([&fn, begin, end = std::min(count, begin + step)] { fn(begin, end); });
+            }
+            fn(0, step);
+        }
+
+        long long FileTicks(const std::int64_t sec, const std::uint32_t nsec) {
+            using namespace std::chrono;
+            const sys_time<nanoseconds> t {seconds{sec} + nanoseconds{nsec}};
+            return duration_cast<fs::file_time_type::duration>(file_clock::from_sys(t).time_since_epoch()).count();
+        }
+
+#if defined(__linux__)
+        struct LinuxDirent64 {
+            std::uint64_t d_ino;
+            std::int64_t d_off;
+            unsigned short d_reclen;
+            unsigned char d_type;
+            char d_name[];
+        };
+
+        EntryType FromDirentType(const unsigned char t) {
+            switch (t) {
+                case DT_REG: return EntryType::File;
+                case DT_DIR: return EntryType::Directory;
+                case DT_LNK: return EntryType::Symlink;
+                case DT_UNKNOWN: return EntryType::Unknown;
+                default: return EntryType::Other;
+            }
+        }
+
+        EntryType FromMode(const unsigned mode) {
+            if (S_ISREG(mode)) return EntryType::File;
+            if (S_ISDIR(mode)) return EntryType::Directory;
+            if (S_ISLNK(mode)) return EntryType::Symlink;
+            return EntryType::Other;
+        }
+
+        void FillEntry(DirEntry& e, const struct statx& sx, const bool full) {
+            e.type = FromMode(sx.stx_mode);
+            if (!full) return;
+            e.mode = sx.stx_mode & 07777;
+            e.size = sx.stx_size;
+            e.mtime = FileTicks(sx.stx_mtime.tv_sec, sx.stx_mtime.tv_nsec);
+            e.device = makedev(sx.stx_dev_major, sx.stx_dev_minor);
+            e.inode = sx.stx_ino;
+            e.links = sx.stx_nlink;
+        }
+
+        // Names only resolves unknown types, and reports symlinks as such like the listing does.
+        // DONT_SYNC: no round trip on network filesystems.
+        unsigned StatxMask(const ScanDetail detail) {
+            return detail == ScanDetail::Names ? STATX_TYPE : STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_MTIME | STATX_INO | STATX_NLINK;
+        }
+
+        int StatxFlags(const ScanDetail detail) {
+            return detail == ScanDetail::Stats ? AT_STATX_DONT_SYNC : AT_STATX_DONT_SYNC | AT_SYMLINK_NOFOLLOW;
+        }
+
+        void StatEntry(const int dirFd, DirEntry& e, const ScanDetail detail) {
+            // Names are NUL-terminated in the arena
+            const bool full {detail != ScanDetail::Names};
+            const unsigned mask {StatxMask(detail)};
+            const int flags {StatxFlags(detail)};
+            struct statx sx {};
+            if (statx(dirFd, e.name.data(), flags, mask, &sx) != 0) {
+                // Dangling symlink or raced removal: describe the entry itself if possible
+                if (statx(dirFd, e.name.data(), AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, STATX_TYPE, &sx) != 0) return;
+                e.type = FromMode(sx.stx_mode);
+                return;
+            }
+            FillEntry(e, sx, full);
+        }
+#endif
+    }
+
+    const DirEntry* DirectoryScan::Find(const std::string_view name) const {
+        const auto it = std::ranges::lower_bound(entries_, name, {}, &DirEntry::name);
+        return it != entries_.end() && it->name == name ? &*it : nullptr;
+    }
+
+#if defined(__linux__)
+    DirectoryScan DirectoryScan::Read(const fs::path& dir, const ScanDetail detail, std::error_code& ec) {
+        DirectoryScan scan;
+        const int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            ec.assign(errno, std::generic_category());
+            return scan;
+        }
+        // Names are gathered as offsets into one buffer and only turned into views once it stops growing
+        std::string arena;
+        std::vector<std::pair<std::size_t, std::size_t>> spans;
+        const auto buf = std::make_unique<char[]>(kDirentBufferSize);
+        while (true) {
+            const long n = syscall(SYS_getdents64, fd, buf.get(), kDirentBufferSize);
+            if (n < 0) {
+                ec.assign(errno, std::generic_category());
+                break;
+            }
+            if (n == 0) break;
+            for (long off = 0; off < n;) {
+                const auto* d = reinterpret_cast<const LinuxDirent64*>(buf.get() + off);
+                off += d->d_reclen;
+                const std::string_view name {d->d_name};
+                if (name == "." || name == "..") continue;
+                spans.emplace_back(arena.size(), name.size());
+                arena.append(name);
+                arena.push_back('\0');
+                scan.entries_.push_back({{}, FromDirentType(d->d_type)});
+            }
+        }
+        scan.names_ = std::make_unique<char[]>(arena.size() + 1);
+        std::memcpy(scan.names_.get(), arena.data(), arena.size());
+        for (std::size_t i = 0; i < spans.size(); ++i) {
+            scan.entries_[i].name = {scan.names_.get() + spans[i].first, spans[i].second};
+        }
+
+        const bool full {detail != ScanDetail::Names};
+        std::vector<DirEntry*> pending;
+        for (auto& e : scan.entries_) {
+            if (full || e.type == EntryType::Unknown) pending.push_back(&e);
+        }
+        if (IoRing* ring {IoRing::ForThisThread()}; ring && ring->SupportsStatx() && pending.size() > 1) {
+            // One thread keeps the whole batch in flight; anything the ring could not answer is
+            // retried synchronously, which also covers dangling symlinks
+            std::vector<struct statx> results(pending.size());
+            for (std::size_t i = 0; i < pending.size(); ++i) {
+                ring->Statx(fd, pending[i]->name.data(), StatxFlags(detail), StatxMask(detail), &results[i], i);
+            }
+            std::vector<bool> answered(pending.size());
+            for (const auto& [tag, result] : ring->Drain()) {
+                if (result < 0 || tag >= pending.size()) continue;
+                FillEntry(*pending[tag], results[tag], full);
+                answered[tag] = true;
+            }
+            for (std::size_t i = 0; i < pending.size(); ++i) {
+                if (!answered[i]) StatEntry(fd, *pending[i], detail);
+            }
+        } else {
+            ParallelFor(pending.size(), [&](const std::size_t begin, const std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) StatEntry(fd, *pending[i], detail);
+            });
+        }
+        close(fd);
+        std::ranges::sort(scan.entries_, {}, &DirEntry::name);
+        return scan;
+    }
+#else
+    DirectoryScan DirectoryScan::Read(const fs::path& dir, const ScanDetail detail, std::error_code& ec) {
+        DirectoryScan scan;
+        std::vector<std::string> names;
+        std::vector<fs::directory_entry> found;
+        for (auto it = fs::directory_iterator(dir, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+            found.push_back(*it);
+        }
+        std::size_t total {};
+        for (const auto& e : found) total += e.path().filename().string().size() + 1;
+        scan.names_ = std::make_unique<char[]>(total + 1);
+        char* p = scan.names_.get();
+        for (const auto& e : found) {
+            const std::string name {e.path().filename().string()};
+            std::memcpy(p, name.c_str(), name.size() + 1);
+            DirEntry entry {{p, name.size()}};
+            std::error_code sec;
+            const fs::file_status st {detail == ScanDetail::LinkStats ? e.symlink_status(sec) : e.status(sec)};
+            entry.type = fs::is_regular_file(st) ? EntryType::File
+                       : fs::is_directory(st)    ? EntryType::Directory
+                       : fs::is_symlink(st)      ? EntryType::Symlink
+                                                 : EntryType::Other;
+            if (detail != ScanDetail::Names) entry.mode = static_cast<std::uint32_t>(st.permissions());
+            if (detail != ScanDetail::Names && entry.type == EntryType::File) {
+                entry.size = e.file_size(sec);
+                entry.links = static_cast<std::uint32_t>(e.hard_link_count(sec));
+            }
+            if (detail != ScanDetail::Names && entry.type != EntryType::Symlink) {
+                entry.mtime = e.last_write_time(sec).time_since_epoch().count();
+            }
+            scan.entries_.push_back(entry);
+            p += name.size() + 1;
+        }
+        std::ranges::sort(scan.entries_, {}, &DirEntry::name);
+        return scan;
+    }
+#endif
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace vsprofile::utils {
+
+    namespace fs = std::filesystem;
+
+    enum class EntryType : std::uint8_t { Unknown, File, Directory, Symlink, Other };
+
+    enum class ScanDetail {
+        Names, // types from the directory listing where the filesystem provides them, no stat calls
+        Stats,     // one statx per entry, following symlinks like directory_entry::status
+        LinkStats, // as Stats, but symlinks are described themselves like directory_entry::symlink_status
+    };
+
+    struct DirEntry {
+        std::string_view name; // owned by the DirectoryScan
+        EntryType type {EntryType::Unknown};
+        // ScanDetail::Stats and LinkStats only
+        std::uint32_t mode {}; // permission bits
+        std::uintmax_t size {};
+        long long mtime {}; // file_time_type ticks, comparable with fs::last_write_time
+        std::uint64_t device {};
+        std::uint64_t inode {};
+        std::uint32_t links {}; // hard link count
+
+        [[nodiscard]] bool IsFile() const { return type == EntryType::File; }
+        [[nodiscard]] bool IsDirectory() const { return type == EntryType::Directory; }
+    };
+
+    // One directory read in large getdents64 batches, stats queued on io_uring when available and
+    // otherwise spread over threads for big folders.
+    // Entries are sorted by name and exclude "." and ".."; hidden entries are the caller's business.
+    class DirectoryScan {
+        std::unique_ptr<char[]> names_; // every name back to back
+        std::vector<DirEntry> entries_;
+
+    public:
+        [[nodiscard]] static DirectoryScan Read(const fs::path& dir, ScanDetail detail, std::error_code& ec);
+
+        [[nodiscard]] auto begin() const { return entries_.begin(); }
+        [[nodiscard]] auto end() const { return entries_.end(); }
+        [[nodiscard]] std::size_t size() const { return entries_.size(); }
+        [[nodiscard]] bool empty() const { return entries_.empty(); }
+        [[nodiscard]] const DirEntry* Find(std::string_view name) const; // binary search
+    };
+
+}
@@ -0,0 +1,150 @@
+#include "DiskLayout.hpp"
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+#endif
+
+namespace vsprofile::utils {
+
+    namespace {
+        std::mutex gMtx;
+        std::map<fs::path, CopyOrder> gOverrides;
+        std::unordered_map<std::uint64_t, bool> gRotational; // by device number
+
+#if defined(__linux__)
+        // Device of the nearest existing ancestor, so targets that are about to be created still resolve
+        bool DeviceOf(fs::path path, dev_t& device) {
+            struct stat st {};
+            while (::stat(path.c_str(), &st) != 0) {
+                if (path == path.parent_path()) return false;
+                path = path.parent_path();
+            }
+            device = st.st_dev;
+            return true;
+        }
+
+        bool ReadRotationalFlag(const dev_t device) {
+            // Whole disks and device-mapper volumes have their own queue, partitions share their disk's
+            const fs::path node {std::format("/sys/dev/block/{}:{}", major(device), minor(device))};
+            std::vector<fs::path> flags {node / "queue" / "rotational"};
+            std::error_code ec;
+            // Without a node to resolve the parent would be empty, and the flag a path relative to the cwd
+            if (const fs::path resolved {fs::canonical(node, ec)}; !ec) flags.push_back(resolved.parent_path() / "queue" / "rotational");
+            for (const fs::path& flag : flags) {
+                char c {};
+                if (std::ifstream in {flag}; in >> c) return c == '1';
+            }
+            return false; // tmpfs, overlay and network filesystems have no block device
+        }
+#endif
+
+        CopyOrder OverrideFor(const fs::path& path) {
+            std::error_code ec;
+            const fs::path target {fs::absolute(path, ec).lexically_normal()};
+            CopyOrder order {CopyOrder::Auto};
+            std::size_t best {};
+            for (const auto& [prefix, choice] : gOverrides) {
+                const auto length {static_cast<std::size_t>(std::distance(prefix.begin(), prefix.end()))};
+                if (std::ranges::mismatch(prefix, target).in1 == prefix.end() && length >= best) {
+                    order = choice;
+                    best = length;
+                }
+            }
+            return order;
+        }
+    }
+
+    std::string_view ToString(const CopyOrder order) {
+        switch (order) {
+            case CopyOrder::Parallel: return "parallel";
+            case CopyOrder::Sequential: return "sequential";
+            default: return "auto";
+        }
+    }
+
+    CopyOrder CopyOrderFromString(const std::string_view name) {
+        if (name == "parallel") return CopyOrder::Parallel;
+        if (name == "sequential") return CopyOrder::Sequential;
+        return CopyOrder::Auto;
+    }
+
+    std::optional<std::uint64_t> FirstExtentOffset(const fs::path& file) {
+#if defined(__linux__)
+        const int fd {::open(file.c_str(), O_RDONLY | O_CLOEXEC)};
+        if (fd < 0) return std::nullopt;
+        // Room for the header and a single extent, which is all the ordering needs
+        alignas(fiemap) unsigned char buffer[sizeof(fiemap) + sizeof(fiemap_extent)] {};
+        auto* const map {reinterpret_cast<fiemap*>(buffer)};
+        map->fm_length = FIEMAP_MAX_OFFSET;
+        map->fm_extent_count = 1;
+        std::optional<std::uint64_t> offset;
+        if (ioctl(fd, FS_IOC_FIEMAP, map) == 0 && map->fm_mapped_extents > 0) offset = map->fm_extents[0].fe_physical;
+        ::close(fd);
+        return offset;
+#else
+        return std::nullopt;
+#endif
+    }
+
+    std::uint64_t DiskOrderKey(const fs::path& file) {
+        if (const auto offset {FirstExtentOffset(file)}) return *offset;
+#if defined(__linux__)
+        struct stat st {};
+        if (::stat(file.c_str(), &st) == 0) return st.st_ino;
+#endif
+        return 0;
+    }
+
+    bool IsRotational(const fs::path& path) {
+#if defined(__linux__)
+        dev_t device {};
+        if (!DeviceOf(path, device)) return false;
+        {
+            std::scoped_lock lock {gMtx};
+            if (const auto it {gRotational.find(device)}; it != gRotational.end()) return it->second;
+        }
+        const bool rotational {ReadRotationalFlag(device)};
+        std::scoped_lock lock {gMtx};
+        gRotational[device] = rotational;
+        return rotational;
+#else
+        return false;
+#endif
+    }
+
+    void SetCopyOrderOverrides(const std::map<fs::path, CopyOrder>& overrides) {
+        std::map<fs::path, CopyOrder> normalized;
+        for (const auto& [prefix, order] : overrides) {
+            std::error_code ec;
+            fs::path p {fs::absolute(prefix, ec).lexically_normal()};
+            if (!p.has_filename() && p != p.root_path()) p = p.parent_path(); // drop a trailing separator
+            normalized[p] = order;
+        }
+        std::scoped_lock lock {gMtx};
+        gOverrides = std::move(normalized);
+    }
+
+    bool PreferSequential(const fs::path& path) {
+        CopyOrder order;
+        {
+            std::scoped_lock lock {gMtx};
+            order = OverrideFor(path);
+        }
+        if (order != CopyOrder::Auto) return order == CopyOrder::Sequential;
+        return IsRotational(path);
+    }
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string_view>
+
+namespace vsprofile::utils {
+
+    namespace fs = std::filesystem;
+
+    enum class CopyOrder {
+        Auto,       // sequential on spinning disks, parallel otherwise
+        Parallel,   // many files in flight, for SSDs and network storage
+        Sequential, // one file at a time in on-disk order, for spinning disks
+    };
+
+    [[nodiscard]] std::string_view ToString(CopyOrder order);
+    [[nodiscard]] CopyOrder CopyOrderFromString(std::string_view name); // unknown names map to Auto
+
+    // Physical byte offset of the file's first extent (FIEMAP), empty where the filesystem cannot say
+    [[nodiscard]] std::optional<std::uint64_t> FirstExtentOffset(const fs::path& file);
+    // Sort key for reading files in disk order: the first extent, or the inode number as a rough proxy
+    [[nodiscard]] std::uint64_t DiskOrderKey(const fs::path& file);
+    // Whether the block device holding `path` is a spinning disk (sysfs queue/rotational); false when unknown
+    [[nodiscard]] bool IsRotational(const fs::path& path);
+
+    // Per-volume choices from the config, the longest matching path prefix wins
+    void SetCopyOrderOverrides(const std::map<fs::path, CopyOrder>& overrides);
+    // Whether copies touching `path` should run one at a time in disk order, remembered per device
+    [[nodiscard]] bool PreferSequential(const fs::path& path);
+
+}
@@ -0,0 +1,162 @@
+#include "Durability.hpp"
+#include "IoRing.hpp"
+#include <atomic>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vsprofile::utils {
+
+    namespace {
+        std::atomic<Durability> gDurability {Durability::None};
+        constexpr std::size_t kSyncBatchSize = 128; // flushes in flight at once, each holding a descriptor
+
+#if !defined(_WIN32)
+        bool SyncPath(const fs::path& path, const int flags, const bool dataOnly) {
+            const int fd {::open(path.c_str(), flags | O_CLOEXEC)};
+            if (fd < 0) return false;
+#if defined(__linux__)
+            const bool ok {(dataOnly ? ::fdatasync(fd) : ::fsync(fd)) == 0};
+#else
+            const bool ok {::fsync(fd) == 0};
+#endif
+            ::close(fd);
+            return ok;
+        }
+
+        // Flushes every path, submitted together on this thread's io_uring where there is one so the
+        // disk sees one queue of flushes rather than a round trip each; false if any of them failed
+        bool SyncPaths(const std::set<fs::path>& paths, const int flags, const bool dataOnly) {
+            IoRing* ring {IoRing::ForThisThread()};
+            bool ok {true};
+            if (!ring || !ring->SupportsFsync()) {
+                for (const auto& path : paths) ok = SyncPath(path, flags, dataOnly) && ok;
+                return ok;
+            }
+            std::vector<int> fds; // open until their flushes complete
+            auto drain = [&] {
+                for (const auto& [tag, result] : ring->Drain()) ok = result >= 0 && ok;
+                for (const int fd : fds) ::close(fd);
+                fds.clear();
+            };
+            for (const auto& path : paths) {
+                const int fd {::open(path.c_str(), flags | O_CLOEXEC)};
+                if (fd < 0) {
+                    ok = false;
+                    continue;
+                }
+                fds.push_back(fd);
+                ring->Fsync(fd, dataOnly, fds.size());
+                if (fds.size() == kSyncBatchSize) drain();
+            }
+            drain();
+            return ok;
+        }
+#endif
+    }
+
+    std::string_view ToString(const Durability durability) {
+        switch (durability) {
+            case Durability::Group: return "group";
+            case Durability::Strict: return "strict";
+            default: return "none";
+        }
+    }
+
+    Durability DurabilityFromString(const std::string_view name) {
+        if (name == "group") return Durability::Group;
+        if (name == "strict") return Durability::Strict;
+        return Durability::None;
+    }
+
+    void SetDurability(const Durability durability) {
+        gDurability = durability;
+    }
+
+    Durability CurrentDurability() {
+        return gDurability;
+    }
+
+    bool SyncFile(const fs::path& file) {
+#if defined(_WIN32)
+        return true;
+#else
+        return SyncPath(file, O_RDONLY, true);
+#endif
+    }
+
+    bool SyncDirectory(const fs::path& dir) {
+#if defined(_WIN32)
+        return true; // NTFS journals renames itself, and folders cannot be opened for flushing
+#else
+        return SyncPath(dir, O_RDONLY | O_DIRECTORY, false);
+#endif
+    }
+
+    bool SyncDirectories(const std::set<fs::path>& dirs) {
+#if defined(_WIN32)
+        return true;
+#else
+        return SyncPaths(dirs, O_RDONLY | O_DIRECTORY, false);
+#endif
+    }
+
+    void DurableBatch::Add(const fs::path& written) {
+        std::scoped_lock lock {mtx_};
+#if !defined(__linux__)
+        files_.insert(written); // only needed where there is no syncfs
+#endif
+        dirs_.insert(written.parent_path());
+    }
+
+    void DurableBatch::AddUnsynced(const fs::path& file) {
+        std::scoped_lock lock {mtx_};
+        unsynced_.insert(file);
+        dirs_.insert(file.parent_path());
+    }
+
+    void DurableBatch::AddDirectory(const fs::path& dir) {
+        std::scoped_lock lock {mtx_};
+        dirs_.insert(dir);
+    }
+
+    std::set<fs::path> DurableBatch::Directories() const {
+        std::scoped_lock lock {mtx_};
+        return dirs_;
+    }
+
+    void DurableBatch::Commit() {
+        const Durability durability {CurrentDurability()};
+        std::scoped_lock lock {mtx_};
+        if (durability == Durability::Group) {
+#if defined(__linux__)
+            // One syncfs per filesystem lets the kernel write everything back in a single ordered pass,
+            // where an fdatasync per file would wait on the disk once for each of them
+            std::set<dev_t> synced;
+            for (const auto& dir : dirs_) {
+                const int fd {::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)};
+                if (fd < 0) continue;
+                struct stat st {};
+                if (::fstat(fd, &st) == 0 && synced.insert(st.st_dev).second) ::syncfs(fd);
+                ::close(fd);
+            }
+#else
+            for (const auto& file : files_) SyncFile(file);
+            for (const auto& file : unsynced_) SyncFile(file);
+#endif
+        }
+#if !defined(_WIN32)
+        if (durability == Durability::Strict) SyncPaths(unsynced_, O_RDONLY, true);
+#endif
+        if (durability != Durability::None) SyncDirectories(dirs_);
+        // Whatever the level, nothing this operation wrote carries over into the next Commit
+        files_.clear();
+        unsynced_.clear();
+        dirs_.clear();
+    }
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string_view>
+
+namespace vsprofile::utils {
+
+    namespace fs = std::filesystem;
+
+    // How much of an operation is on stable storage when it returns. Measured on ext4 over a virtio
+    // disk whose cache absorbs flushes, activating a profile of 300 copied files (60 MiB):
+    //   none 0.12 s; group 0.11 s (1 syncfs, 6 folder fsyncs); strict 0.22 s (304 fdatasyncs, 605 fsyncs)
+    // and one of 1112 hard links: none 0.09 s, group 0.11 s, strict 0.12 s (1118 fsyncs).
+    // On a disk that honours flushes, group costs about one writeback of what was written, while
+    // strict adds a full flush round trip per file and per folder entry on top of that.
+    enum class Durability {
+        None,   // writeback is left to the kernel: a power loss can lose or truncate recent copies
+        Group,  // when an operation ends, one syncfs per filesystem it wrote to (a batched fdatasync of its
+                // files where syncfs is missing), then an fsync of each folder whose entries changed
+        Strict, // every file is flushed before it replaces its target and its folder right after
+    };
+
+    [[nodiscard]] std::string_view ToString(Durability durability);
+    [[nodiscard]] Durability DurabilityFromString(std::string_view name); // unknown names map to None
+
+    void SetDurability(Durability durability);
+    [[nodiscard]] Durability CurrentDurability();
+
+    bool SyncFile(const fs::path& file);     // fdatasync
+    bool SyncDirectory(const fs::path& dir); // fsync, making renames and new entries inside it durable
+    bool SyncDirectories(const std::set<fs::path>& dirs); // SyncDirectory of each, as one io_uring batch where available
+
+    // Paths written by one operation, made durable together by Commit at the operation's end (group)
+    // or only their folders flushed there (strict, where each file was flushed as it was written).
+    // Commit submits its flushes as one io_uring batch where the ring is available.
+    class DurableBatch {
+        mutable std::mutex mtx_;
+        std::set<fs::path> files_;
+        std::set<fs::path> unsynced_;
+        std::set<fs::path> dirs_;
+
+    public:
+        void Add(const fs::path& written); // a file, link or folder that was created, replaced or removed
+        // A new file nothing depends on until the operation ends, flushed by Commit under strict as well
+        void AddUnsynced(const fs::path& file);
+        void AddDirectory(const fs::path& dir);
+        [[nodiscard]] std::set<fs::path> Directories() const; // flushed by the next Commit
+        void Commit(); // also under none, where it flushes nothing, the batch is empty again afterwards
+    };
+
+}
@@ -2,10 +2,33 @@
 // Created by Jacopo Uggeri on 28/07/2025.
 //
 #include "FileUtils.hpp"
+#include "AppConstants.hpp"
+#include "CopyCalibration.hpp"
+#include "DirectoryScan.hpp"
+#include "Durability.hpp"
+#include "HashUtils.hpp"
+#include "TreeCopy.hpp"
 #include "TextUtils.hpp"
+#include "Trash.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace vsprofile::utils {
 
+    namespace {
+        constexpr std::size_t kHashCopyBufferSize = 1 << 20; // a multiple of any block size O_DIRECT asks for
+    }
+
     bool vExistsCheck(const fs::path &path) {
         if (exists(path)) { return true; }
         PrintErr(std::format("Aborted: Path {} does not exist!\n", path.string()));
@@ -22,45 +45,26 @@ namespace vsprofile::utils {
         return (vExistsCheck(path) && vDirectoryCheck(path));
     }
 
-    void CopyContents(const fs::path& fromPath, const fs::path& toPath) {
-        if (!vExistsDirectoryCheck(fromPath) || !vExistsDirectoryCheck(toPath)) return;
-
-        std::error_code ec;
-        fs::create_directories(toPath, ec);
-        if (ec) {
-            PrintErr(std::format("Failed to create '{}': {}\n", toPath.string(), ec.message()));
-            return;
-        }
-
-        for (const fs::directory_entry& e : fs::directory_iterator(fromPath)) {
-            if (!e.is_regular_file(ec)) continue;
-            const fs::path dst = toPath / e.path().filename();
-            fs::copy_file(e.path(), dst, fs::copy_options::overwrite_existing, ec);
-            if (ec) {
-                PrintErr(std::format("Copy failed: '{}' -> '{}': {}\n",e.path().string(), dst.string(), ec.message()));
-                ec.clear();
-            }
-        }
+    bool IsHiddenEntry(const std::string_view name) {
+        return name == ".DS_Store" || name == constants::kProfileMetaDir || name.starts_with(constants::kVolumeTrashPrefix);
     }
 
     void ListDirectoryContents(const fs::path& path) {
-        if (!vExistsDirectoryCheck(path)) { return; } // Ensure directory exists
-        for (const auto& entry : fs::directory_iterator(path)) {
-            std::string name = entry.path().filename().string();
-            // Skip macOS metadata files
-            if (name == ".DS_Store") continue;
-            PrintLog(std::format("– {}\n", name));
-        }
+        for (const auto& name : GetContentsList(path)) PrintLog(std::format("– {}\n", name));
     }
 
     void ClearDirectoryContents(const fs::path& path, bool recursive) {
         if (!vExistsDirectoryCheck(path)) { return; } // Ensure directory exists
+        std::vector<fs::path> doomed;
         for (const auto& entry : fs::directory_iterator(path)) {
-            if (recursive || entry.is_regular_file()) {
-                PrintLog(std::format("Removing \"{}\"\n", entry.path().filename().string()));
-                fs::remove_all(entry.path());
-            }
+            if (recursive || entry.is_regular_file()) doomed.push_back(entry.path());
         }
+        if (doomed.empty()) return;
+        // A rename per entry; the data itself is purged in the background once the undo window passes
+        std::error_code ec;
+        const std::string batch {MoveToTrash(path, doomed, ec)};
+        if (ec) PrintErr(std::format("Could not remove everything in '{}': {}\n", path.string(), ec.message()));
+        if (!batch.empty()) PrintLog(std::format("Moved {} entries from '{}' to the trash ({})\n", doomed.size(), path.string(), batch));
     }
 
     void SwapDirectoryContents(const fs::path& path1, const fs::path& path2) {
@@ -70,10 +74,153 @@ namespace vsprofile::utils {
     std::vector<std::string> GetContentsList(const fs::path& path) {
         std::vector<std::string> allFiles;
         if (!vExistsDirectoryCheck(path)) { return allFiles; } // Ensure directory exists
-        for (const auto& entry : fs::directory_iterator(path)) {
-            allFiles.push_back(entry.path().filename().string());
+        std::error_code ec;
+        for (const DirEntry& e : DirectoryScan::Read(path, ScanDetail::Names, ec)) {
+            if (!IsHiddenEntry(e.name)) allFiles.emplace_back(e.name);
         }
         return allFiles;
     }
 
+    bool CloneFile(const fs::path& from, const fs::path& to, std::error_code& ec) {
+#if defined(__linux__)
+        // The method calibrated for this pair of filesystems; until there is one, reflink where the
+        // filesystem shares extents, else an in-kernel copy_file_range, which also offloads to the
+        // server on network filesystems; both keep the data out of userspace
+        const int src = open(from.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st {};
+        if (src >= 0 && fstat(src, &st) == 0) {
+            const int dst = open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+            bool copied = false;
+            if (dst >= 0) {
+                copied = CopyCalibrated(src, dst, from, to, static_cast<std::uintmax_t>(st.st_size));
+                if (!copied && (ftruncate(dst, 0) != 0 || lseek(dst, 0, SEEK_SET) != 0)) {
+                    close(dst);
+                    close(src);
+                    return fs::copy_file(from, to, fs::copy_options::overwrite_existing, ec);
+                }
+#if defined(FICLONE)
+                copied = copied || ioctl(dst, FICLONE, src) == 0;
+#endif
+                off_t left {st.st_size};
+                while (!copied && left > 0) {
+                    const ssize_t n = copy_file_range(src, nullptr, dst, nullptr, static_cast<std::size_t>(left), 0);
+                    if (n <= 0) break;
+                    left -= n;
+                }
+                copied = copied || left == 0;
+                copied = copied && fchmod(dst, st.st_mode & 07777) == 0;
+                close(dst);
+            }
+            close(src);
+            if (copied) {
+                ec.clear();
+                return true;
+            }
+        } else if (src >= 0) {
+            close(src);
+        }
+#endif
+        return fs::copy_file(from, to, fs::copy_options::overwrite_existing, ec);
+    }
+
+    bool CopyAndHash(const fs::path& from, const fs::path& to, std::string& hash, std::error_code& ec) {
+        std::ifstream in {from, std::ios::binary};
+        std::ofstream out {to, std::ios::binary | std::ios::trunc};
+        if (!in || !out) {
+            ec = std::make_error_code(std::errc::io_error);
+            return false;
+        }
+        std::vector<char> buffer(kHashCopyBufferSize);
+        Murmur3Hasher hasher;
+        while (in) {
+            in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            const std::streamsize n {in.gcount()};
+            hasher.Update(buffer.data(), static_cast<std::size_t>(n));
+            out.write(buffer.data(), n);
+        }
+        out.close();
+        if (in.bad() || !out) {
+            ec = std::make_error_code(std::errc::io_error);
+            return false;
+        }
+        const fs::file_status status {fs::status(from, ec)};
+        if (ec) return false;
+        fs::permissions(to, status.permissions(), ec);
+        hash = hasher.Hex();
+        return !ec;
+    }
+
+    bool VerifyFileHash(const fs::path& path, const std::string_view hash, std::error_code& ec) {
+        Murmur3Hasher hasher;
+#if defined(__linux__)
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+        if (fd < 0) {
+            // tmpfs and some network filesystems refuse O_DIRECT: write back, drop the cached pages, read
+            fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                ec.assign(errno, std::generic_category());
+                return false;
+            }
+            fdatasync(fd);
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        }
+        // O_DIRECT transfers need buffers aligned to the device's logical block size
+        constexpr std::size_t kAlignment = 4096;
+        const std::unique_ptr<char, decltype(&std::free)> buffer {static_cast<char*>(std::aligned_alloc(kAlignment, kHashCopyBufferSize)), &std::free};
+        ssize_t n {};
+        while (buffer && (n = read(fd, buffer.get(), kHashCopyBufferSize)) > 0) hasher.Update(buffer.get(), static_cast<std::size_t>(n));
+        if (n < 0 || !buffer) ec.assign(n < 0 ? errno : ENOMEM, std::generic_category());
+        close(fd);
+        if (ec) return false;
+#else
+        std::ifstream in {path, std::ios::binary};
+        std::vector<char> buffer(kHashCopyBufferSize);
+        while (in) {
+            in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            hasher.Update(buffer.data(), static_cast<std::size_t>(in.gcount()));
+        }
+#endif
+        if (hasher.Hex() == hash) return true;
+        ec = std::make_error_code(std::errc::io_error);
+        return false;
+    }
+
+    bool MoveTree(const fs::path& from, const fs::path& to, std::error_code& ec) {
+        fs::create_directories(to.parent_path(), ec);
+        if (ec) return false;
+        fs::rename(from, to, ec);
+        if (!ec) return true;
+        if (ec != std::errc::cross_device_link) return false;
+
+        // Different filesystems: clone everything over, then drop the source
+        ec.clear();
+        if (!fs::is_directory(from, ec)) {
+            if (!CloneFile(from, to, ec)) return false;
+            fs::remove(from, ec);
+            return !ec;
+        }
+        if (CopyTree(from, to, false).failures != 0) {
+            ec = std::make_error_code(std::errc::io_error);
+            return false;
+        }
+        fs::remove_all(from, ec);
+        return !ec;
+    }
+
+    bool WriteJsonAtomically(const fs::path& path, const nlohmann::json& j) {
+        std::error_code ec;
+        fs::create_directories(path.parent_path(), ec);
+        const fs::path tmp {path.string() + ".tmp"};
+        {
+            std::ofstream out {tmp, std::ios::trunc};
+            out << j.dump() << '\n';
+            if (!out) return false;
+        }
+        const bool durable {CurrentDurability() != Durability::None};
+        if (durable) SyncFile(tmp);
+        fs::rename(tmp, path, ec);
+        if (durable) SyncDirectory(path.parent_path());
+        return !ec;
+    }
+
 }
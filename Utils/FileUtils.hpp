@@ -2,9 +2,11 @@
 // Created by Jacopo Uggeri on 28/07/2025.
 //
 #pragma once
+#include "../Include/json.hpp"
 #include <filesystem>
 #include <string>
 #include <format>
+#include <vector>
 
 namespace vsprofile::utils {
 
@@ -15,10 +17,23 @@ namespace vsprofile::utils {
     [[nodiscard]] bool vDirectoryCheck(const fs::path& path);
     [[nodiscard]] bool vExistsDirectoryCheck(const fs::path& path);
 
-    void CopyContents(const fs::path& fromPath, const fs::path& toPath);
+    [[nodiscard]] bool IsHiddenEntry(std::string_view name); // OS metadata and vsprofile's own folders, trash included
+
     void ListDirectoryContents(const fs::path& path); // Lists all contents
-    void ClearDirectoryContents(const fs::path& path, bool recursive = false); // Clears files
+    void ClearDirectoryContents(const fs::path& path, bool recursive = false); // Moves files (and folders if recursive) to the trash
     void SwapDirectoryContents(const fs::path& path1, const fs::path& path2);
     [[nodiscard]] std::vector<std::string> GetContentsList(const fs::path& path);
 
+    // Copy-on-write clone where the filesystem supports it (reflink), plain copy otherwise
+    bool CloneFile(const fs::path& from, const fs::path& to, std::error_code& ec);
+    // Copy that hashes (Murmur3 128, hex) what it reads before writing it, so the hash costs no second read
+    bool CopyAndHash(const fs::path& from, const fs::path& to, std::string& hash, std::error_code& ec);
+    // Re-reads a file past the page cache (O_DIRECT where the filesystem allows it) and compares its hash
+    bool VerifyFileHash(const fs::path& path, std::string_view hash, std::error_code& ec);
+    // Moves a file or tree with a single rename, falling back to cloning it across filesystems
+    bool MoveTree(const fs::path& from, const fs::path& to, std::error_code& ec);
+    // Writes `j` next to `path` and renames it over, so readers never see a partial file, flushing
+    // both before and after the rename unless CurrentDurability() is none
+    bool WriteJsonAtomically(const fs::path& path, const nlohmann::json& j);
+
 }
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <string>
+#include <string_view>
+
+namespace vsprofile::utils {
+
+    // FNV-1a, cheap non-cryptographic hash for identifying small keys such as mod sets
+    class Fnv1a64 {
+        std::uint64_t h_ {0xcbf29ce484222325ULL};
+
+    public:
+        Fnv1a64& Update(std::string_view data) {
+            for (const unsigned char c : data) {
+                h_ ^= c;
+                h_ *= 0x100000001b3ULL;
+            }
+            return *this;
+        }
+
+        Fnv1a64& Update(const std::uint64_t value) {
+            for (int i = 0; i < 8; ++i) {
+                h_ ^= (value >> (8 * i)) & 0xff;
+                h_ *= 0x100000001b3ULL;
+            }
+            return *this;
+        }
+
+        [[nodiscard]] std::uint64_t Digest() const { return h_; }
+        [[nodiscard]] std::string Hex() const { return std::format("{:016x}", h_); }
+    };
+
+    // MurmurHash3 x64 128-bit, fed incrementally. Fast enough to hash file contents at disk speed and wide
+    // enough to address content (chunks, files) without practical collisions; not a cryptographic hash.
+    class Murmur3Hasher {
+        std::uint64_t h1_;
+        std::uint64_t h2_;
+        std::uint64_t length_ {};
+        std::array<unsigned char, 16> tail_ {};
+        std::size_t tailSize_ {};
+
+        static constexpr std::uint64_t kC1 = 0x87c37b91114253d5ULL;
+        static constexpr std::uint64_t kC2 = 0x4cf5ad432745937fULL;
+
+        static std::uint64_t Rotl(const std::uint64_t x, const int r) { return (x << r) | (x >> (64 - r)); }
+
+        static std::uint64_t Fmix(std::uint64_t k) {
+            k ^= k >> 33;
+            k *= 0xff51afd7ed558ccdULL;
+            k ^= k >> 33;
+            k *= 0xc4ceb9fe1a85ec53ULL;
+            k ^= k >> 33;
+            return k;
+        }
+
+        static std::uint64_t Load64(const unsigned char* p) {
+            std::uint64_t v;
+            std::memcpy(&v, p, 8);
+            return v; // little-endian hosts, which covers every platform the game runs on
+        }
+
+        void Block(const unsigned char* p) {
+            std::uint64_t k1 = Load64(p);
+            std::uint64_t k2 = Load64(p + 8);
+            k1 *= kC1; k1 = Rotl(k1, 31); k1 *= kC2; h1_ ^= k1;
+            h1_ = Rotl(h1_, 27); h1_ += h2_; h1_ = h1_ * 5 + 0x52dce729;
+            k2 *= kC2; k2 = Rotl(k2, 33); k2 *= kC1; h2_ ^= k2;
+            h2_ = Rotl(h2_, 31); h2_ += h1_; h2_ = h2_ * 5 + 0x38495ab5;
+        }
+
+    public:
+        explicit Murmur3Hasher(const std::uint64_t seed = 0) : h1_(seed), h2_(seed) {}
+
+        Murmur3Hasher& Update(const void* data, std::size_t size) {
+            auto p = static_cast<const unsigned char*>(data);
+            length_ += size;
+            if (tailSize_) {
+                const std::size_t take = std::min(size, tail_.size() - tailSize_);
+                std::memcpy(tail_.data() + tailSize_, p, take);
+                tailSize_ += take;
+                p += take;
+                size -= take;
+                if (tailSize_ < tail_.size()) return *this;
+                Block(tail_.data());
+                tailSize_ = 0;
+            }
+            for (; size >= 16; p += 16, size -= 16) Block(p);
+            std::memcpy(tail_.data(), p, size);
+            tailSize_ = size;
+            return *this;
+        }
+
+        Murmur3Hasher& Update(const std::string_view data) { return Update(data.data(), data.size()); }
+
+        [[nodiscard]] std::array<std::uint64_t, 2> Digest() const {
+            std::uint64_t h1 = h1_, h2 = h2_, k1 = 0, k2 = 0;
+            const unsigned char* t = tail_.data();
+            switch (tailSize_) {
+                case 15: k2 ^= static_cast<std::uint64_t>(t[14]) << 48; [[fallthrough]];
+                case 14: k2 ^= static_cast<std::uint64_t>(t[13]) << 40; [[fallthrough]];
+                case 13: k2 ^= static_cast<std::uint64_t>(t[12]) << 32; [[fallthrough]];
+                case 12: k2 ^= static_cast<std::uint64_t>(t[11]) << 24; [[fallthrough]];
+                case 11: k2 ^= static_cast<std::uint64_t>(t[10]) << 16; [[fallthrough]];
+                case 10: k2 ^= static_cast<std::uint64_t>(t[9]) << 8; [[fallthrough]];
+                case 9:  k2 ^= static_cast<std::uint64_t>(t[8]);
+                         k2 *= kC2; k2 = Rotl(k2, 33); k2 *= kC1; h2 ^= k2; [[fallthrough]];
+                case 8:  k1 ^= static_cast<std::uint64_t>(t[7]) << 56; [[fallthrough]];
+                case 7:  k1 ^= static_cast<std::uint64_t>(t[6]) << 48; [[fallthrough]];
+                case 6:  k1 ^= static_cast<std::uint64_t>(t[5]) << 40; [[fallthrough]];
+                case 5:  k1 ^= static_cast<std::uint64_t>(t[4]) << 32; [[fallthrough]];
+                case 4:  k1 ^= static_cast<std::uint64_t>(t[3]) << 24; [[fallthrough]];
+                case 3:  k1 ^= static_cast<std::uint64_t>(t[2]) << 16; [[fallthrough]];
+                case 2:  k1 ^= static_cast<std::uint64_t>(t[1]) << 8; [[fallthrough]];
+                case 1:  k1 ^= static_cast<std::uint64_t>(t[0]);
+                         k1 *= kC1; k1 = Rotl(k1, 31); k1 *= kC2; h1 ^= k1;
+                default: break;
+            }
+            h1 ^= length_; h2 ^= length_;
+            h1 += h2; h2 += h1;
+            h1 = Fmix(h1); h2 = Fmix(h2);
+            h1 += h2; h2 += h1;
+            return {h1, h2};
+        }
+
+        [[nodiscard]] std::string Hex() const {
+            const auto [h1, h2] = Digest();
+            return std::format("{:016x}{:016x}", h1, h2);
+        }
+    };
+
+}
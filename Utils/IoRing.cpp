@@ -0,0 +1,265 @@
+#include "IoRing.hpp"
+#include <cstdlib>
+#include <memory>
+#include <string_view>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace vsprofile::utils {
+
+#if defined(__linux__)
+    namespace {
+        constexpr unsigned kRingEntries = 256; // deep enough for one thread to keep a device busy
+
+        int Setup(const unsigned entries, io_uring_params& p) {
+            return static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+        }
+
+        int Enter(const int fd, const unsigned submit, const unsigned wait) {
+            return static_cast<int>(syscall(__NR_io_uring_enter, fd, submit, wait,
+                                            wait ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0));
+        }
+
+        // The kernel updates the other side of each ring concurrently
+        unsigned LoadAcquire(const unsigned* p) {
+            return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+        }
+
+        void StoreRelease(unsigned* p, const unsigned v) {
+            __atomic_store_n(p, v, __ATOMIC_RELEASE);
+        }
+    }
+
+    struct IoRing::Impl {
+        int fd {-1};
+        void* sqRing {MAP_FAILED};
+        void* cqRing {MAP_FAILED};
+        std::size_t sqRingSize {}, cqRingSize {};
+        io_uring_sqe* sqes {static_cast<io_uring_sqe*>(MAP_FAILED)};
+        unsigned entries {};
+        unsigned *sqHead {}, *sqTail {}, *sqMask {}, *sqArray {};
+        unsigned *cqHead {}, *cqTail {}, *cqMask {};
+        io_uring_cqe* cqes {};
+        unsigned unsubmitted {};
+        unsigned inFlight {}; // submitted, not yet reaped
+        std::vector<Completion> done;
+        std::uint8_t supported[IORING_OP_LAST] {};
+
+        ~Impl() {
+            if (sqes != MAP_FAILED) munmap(sqes, entries * sizeof(io_uring_sqe));
+            if (cqRing != MAP_FAILED && cqRing != sqRing) munmap(cqRing, cqRingSize);
+            if (sqRing != MAP_FAILED) munmap(sqRing, sqRingSize);
+            if (fd >= 0) close(fd);
+        }
+
+        bool Init() {
+            io_uring_params p {};
+            fd = Setup(kRingEntries, p);
+            if (fd < 0) return false;
+            entries = p.sq_entries;
+            sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+            cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+            const bool single {(p.features & IORING_FEAT_SINGLE_MMAP) != 0};
+            if (single) sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+            sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+            if (sqRing == MAP_FAILED) return false;
+            cqRing = single ? sqRing : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) return false;
+            sqes = static_cast<io_uring_sqe*>(mmap(nullptr, entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                                                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+            if (sqes == MAP_FAILED) return false;
+            auto* sq = static_cast<char*>(sqRing);
+            auto* cq = static_cast<char*>(cqRing);
+            sqHead = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+            sqTail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+            sqMask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+            sqArray = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+            cqHead = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+            cqTail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+            cqMask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+            // Which opcodes this kernel knows; older ones lack the *at operations
+            const std::size_t probeSize {sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op)};
+            const auto probeBuf = std::make_unique<unsigned char[]>(probeSize);
+            std::memset(probeBuf.get(), 0, probeSize);
+            auto* probe = reinterpret_cast<io_uring_probe*>(probeBuf.get());
+            if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) < 0) return false;
+            for (unsigned op = 0; op < IORING_OP_LAST && op <= probe->last_op; ++op) {
+                supported[op] = (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+            }
+            return true;
+        }
+
+        void Reap() {
+            unsigned head {*cqHead};
+            const unsigned tail {LoadAcquire(cqTail)};
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe {cqes[head & *cqMask]};
+                done.push_back({cqe.user_data, cqe.res});
+                --inFlight;
+            }
+            StoreRelease(cqHead, head);
+        }
+
+        // Submits everything queued and waits until at least wait completions arrived. False if the
+        // ring is unusable; operations that never complete count as failed for the caller.
+        bool Flush(const unsigned wait) {
+            bool ok {true};
+            while (true) {
+                const int n = Enter(fd, unsubmitted, wait);
+                if (n >= 0) {
+                    inFlight += static_cast<unsigned>(n);
+                    unsubmitted -= static_cast<unsigned>(n);
+                    break;
+                }
+                if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                    ok = false;
+                    break;
+                }
+            }
+            Reap();
+            return ok;
+        }
+
+        unsigned Free() const {
+            return entries - (*sqTail - LoadAcquire(sqHead));
+        }
+
+        io_uring_sqe& Next(const std::uint8_t opcode, const std::uint64_t tag, const unsigned sqeFlags) {
+            bool ok {true};
+            while (ok && (Free() == 0 || inFlight + unsubmitted >= entries)) ok = Flush(1);
+            if (!ok) {
+                // Never submitted, so the operation simply gets no completion
+                thread_local io_uring_sqe scratch;
+                return scratch;
+            }
+            const unsigned tail {*sqTail};
+            const unsigned index {tail & *sqMask};
+            io_uring_sqe& sqe {sqes[index]};
+            std::memset(&sqe, 0, sizeof sqe);
+            sqe.opcode = opcode;
+            sqe.flags = static_cast<std::uint8_t>(sqeFlags);
+            sqe.user_data = tag;
+            sqArray[index] = index;
+            StoreRelease(sqTail, tail + 1);
+            ++unsubmitted;
+            return sqe;
+        }
+    };
+
+    IoRing* IoRing::ForThisThread() {
+        static const bool disabled {[] {
+            const char* env = std::getenv("VSPROFILE_IO_URING");
+            return env && std::string_view{env} == "0";
+        }()};
+        thread_local std::unique_ptr<IoRing> ring;
+        thread_local bool probed {false};
+        if (disabled) return nullptr;
+        if (!probed) {
+            probed = true;
+            auto impl = std::make_unique<Impl>();
+            if (impl->Init()) ring.reset(new IoRing{impl.release()});
+        }
+        return ring.get();
+    }
+
+    IoRing::~IoRing() {
+        delete impl_;
+    }
+
+    bool IoRing::Supports(const std::uint8_t opcode) const {
+        return opcode < IORING_OP_LAST && impl_->supported[opcode];
+    }
+
+    bool IoRing::SupportsStatx() const {
+        return Supports(IORING_OP_STATX);
+    }
+
+    bool IoRing::SupportsLinking() const {
+        return Supports(IORING_OP_UNLINKAT) && Supports(IORING_OP_LINKAT) && Supports(IORING_OP_RENAMEAT);
+    }
+
+    bool IoRing::SupportsFsync() const {
+        return Supports(IORING_OP_FSYNC);
+    }
+
+    void IoRing::Reserve(const unsigned count) {
+        while (impl_->Free() < count || impl_->inFlight + impl_->unsubmitted + count > impl_->entries) {
+            if (!impl_->Flush(impl_->inFlight ? 1 : 0)) return;
+        }
+    }
+
+    void IoRing::Statx(const int dirFd, const char* path, const int flags, const unsigned mask, struct statx* out,
+                       const std::uint64_t tag, const unsigned sqeFlags) {
+        io_uring_sqe& sqe {impl_->Next(IORING_OP_STATX, tag, sqeFlags)};
+        sqe.fd = dirFd;
+        sqe.addr = reinterpret_cast<std::uintptr_t>(path);
+        sqe.len = mask;
+        sqe.off = reinterpret_cast<std::uintptr_t>(out);
+        sqe.statx_flags = static_cast<std::uint32_t>(flags);
+    }
+
+    void IoRing::UnlinkAt(const int dirFd, const char* path, const int flags, const std::uint64_t tag, const unsigned sqeFlags) {
+        io_uring_sqe& sqe {impl_->Next(IORING_OP_UNLINKAT, tag, sqeFlags)};
+        sqe.fd = dirFd;
+        sqe.addr = reinterpret_cast<std::uintptr_t>(path);
+        sqe.unlink_flags = static_cast<std::uint32_t>(flags);
+    }
+
+    void IoRing::LinkAt(const int oldDirFd, const char* oldPath, const int newDirFd, const char* newPath,
+                        const std::uint64_t tag, const unsigned sqeFlags) {
+        io_uring_sqe& sqe {impl_->Next(IORING_OP_LINKAT, tag, sqeFlags)};
+        sqe.fd = oldDirFd;
+        sqe.addr = reinterpret_cast<std::uintptr_t>(oldPath);
+        sqe.len = static_cast<std::uint32_t>(newDirFd);
+        sqe.addr2 = reinterpret_cast<std::uintptr_t>(newPath);
+    }
+
+    void IoRing::RenameAt(const int oldDirFd, const char* oldPath, const int newDirFd, const char* newPath,
+                          const std::uint64_t tag, const unsigned sqeFlags) {
+        io_uring_sqe& sqe {impl_->Next(IORING_OP_RENAMEAT, tag, sqeFlags)};
+        sqe.fd = oldDirFd;
+        sqe.addr = reinterpret_cast<std::uintptr_t>(oldPath);
+        sqe.len = static_cast<std::uint32_t>(newDirFd);
+        sqe.addr2 = reinterpret_cast<std::uintptr_t>(newPath);
+    }
+
+    void IoRing::Fsync(const int fd, const bool dataOnly, const std::uint64_t tag, const unsigned sqeFlags) {
+        io_uring_sqe& sqe {impl_->Next(IORING_OP_FSYNC, tag, sqeFlags)};
+        sqe.fd = fd;
+        sqe.fsync_flags = dataOnly ? IORING_FSYNC_DATASYNC : 0u;
+    }
+
+    std::vector<IoRing::Completion> IoRing::Drain() {
+        bool ok {impl_->Flush(0)};
+        while (ok && impl_->inFlight) ok = impl_->Flush(1);
+        return std::exchange(impl_->done, {});
+    }
+#else
+    struct IoRing::Impl {};
+    IoRing* IoRing::ForThisThread() { return nullptr; }
+    IoRing::~IoRing() = default;
+    bool IoRing::Supports(std::uint8_t) const { return false; }
+    bool IoRing::SupportsStatx() const { return false; }
+    bool IoRing::SupportsLinking() const { return false; }
+    bool IoRing::SupportsFsync() const { return false; }
+    void IoRing::Reserve(unsigned) {}
+    void IoRing::Statx(int, const char*, int, unsigned, struct statx*, std::uint64_t, unsigned) {}
+    void IoRing::UnlinkAt(int, const char*, int, std::uint64_t, unsigned) {}
+    void IoRing::LinkAt(int, const char*, int, const char*, std::uint64_t, unsigned) {}
+    void IoRing::RenameAt(int, const char*, int, const char*, std::uint64_t, unsigned) {}
+    void IoRing::Fsync(int, bool, std::uint64_t, unsigned) {}
+    std::vector<IoRing::Completion> IoRing::Drain() { return {}; }
+#endif
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct statx;
+
+namespace vsprofile::utils {
+
+    // Minimal io_uring submission ring over the raw syscalls, for batching metadata operations and
+    // flushes that would otherwise cost one blocking syscall each. One ring per thread; ForThisThread() returns
+    // nullptr where io_uring is missing, disabled (kernel.io_uring_disabled, seccomp) or switched off
+    // with VSPROFILE_IO_URING=0, and callers keep their synchronous path.
+    //
+    // Queued operations reference the caller's buffers and strings, which must stay alive until
+    // Drain() returns. Chains (kLink / kHardLink on every entry but the last) are never split
+    // across submissions.
+    class IoRing {
+    public:
+        static constexpr unsigned kLink = 1u << 2;     // IOSQE_IO_LINK: run next only if this succeeds
+        static constexpr unsigned kHardLink = 1u << 3; // IOSQE_IO_HARDLINK: run next regardless
+        static constexpr int kCwd = -100;                // AT_FDCWD, for paths not relative to a folder
+
+        struct Completion {
+            std::uint64_t tag;
+            int result; // >= 0 on success, -errno otherwise (-ECANCELED for a broken chain)
+        };
+
+        [[nodiscard]] static IoRing* ForThisThread();
+        ~IoRing();
+        IoRing(const IoRing&) = delete;
+        IoRing& operator=(const IoRing&) = delete;
+
+        [[nodiscard]] bool Supports(std::uint8_t opcode) const;
+        [[nodiscard]] bool SupportsStatx() const;
+        [[nodiscard]] bool SupportsLinking() const; // unlinkat, linkat and renameat
+        [[nodiscard]] bool SupportsFsync() const;
+
+        void Reserve(unsigned count); // room for a chain of count entries
+        void Statx(int dirFd, const char* path, int flags, unsigned mask, struct statx* out, std::uint64_t tag, unsigned sqeFlags = 0);
+        void UnlinkAt(int dirFd, const char* path, int flags, std::uint64_t tag, unsigned sqeFlags = 0);
+        void LinkAt(int oldDirFd, const char* oldPath, int newDirFd, const char* newPath, std::uint64_t tag, unsigned sqeFlags = 0);
+        void RenameAt(int oldDirFd, const char* oldPath, int newDirFd, const char* newPath, std::uint64_t tag, unsigned sqeFlags = 0);
+        void Fsync(int fd, bool dataOnly, std::uint64_t tag, unsigned sqeFlags = 0); // fdatasync when dataOnly
+
+        // Submits what is queued and waits for every outstanding operation
+        [[nodiscard]] std::vector<Completion> Drain();
+
+    private:
+        struct Impl;
+        Impl* impl_;
+        explicit IoRing(Impl* impl) : impl_{impl} {}
+    };
+
+}
@@ -0,0 +1,335 @@
+#include "Pack.hpp"
+#include "Durability.hpp"
+#include "HashUtils.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+
+#if defined(VSPROFILE_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+namespace vsprofile::utils {
+
+    namespace {
+        constexpr std::array<char, 4> kMagic {'V', 'S', 'P', 'K'};
+        constexpr std::array<char, 4> kIndexMagic {'V', 'S', 'P', 'I'};
+        constexpr std::uint32_t kVersion = 1;
+        constexpr std::size_t kTrailerSize = 8 + kIndexMagic.size();
+        constexpr std::size_t kHashSize = 32;
+        constexpr std::size_t kBufferSize = 1 << 20;
+        // Only this much of a file is test-compressed to decide whether the rest is worth compressing
+        constexpr std::size_t kSampleSize = 64 * 1024;
+
+        template <typename T>
+        void Put(std::string& out, const T value) {
+            const auto bits {static_cast<std::uint64_t>(value)};
+            for (std::size_t i = 0; i < sizeof(T); ++i) out.push_back(static_cast<char>((bits >> (8 * i)) & 0xff));
+        }
+
+        template <typename T>
+        bool Get(const char*& p, const char* end, T& value) {
+            if (static_cast<std::size_t>(end - p) < sizeof(T)) return false;
+            std::uint64_t bits {};
+            for (std::size_t i = 0; i < sizeof(T); ++i) bits |= std::uint64_t{static_cast<unsigned char>(p[i])} << (8 * i);
+            value = static_cast<T>(bits);
+            p += sizeof(T);
+            return true;
+        }
+
+        bool Fail(std::error_code& ec, const std::errc code = std::errc::io_error) {
+            ec = std::make_error_code(code);
+            return false;
+        }
+
+        bool WorthCompressing(const char* data, const std::size_t size) {
+#if defined(VSPROFILE_HAVE_ZLIB)
+            const uLong sample {static_cast<uLong>(std::min(size, kSampleSize))};
+            if (sample == 0) return false;
+            std::vector<Bytef> out(compressBound(sample));
+            uLongf outSize {static_cast<uLongf>(out.size())};
+            if (compress2(out.data(), &outSize, reinterpret_cast<const Bytef*>(data), sample, Z_BEST_SPEED) != Z_OK) return false;
+            return outSize < sample - sample / 10;
+#else
+            return false;
+#endif
+        }
+
+        // Streams the rest of `in` into `out`, `first` bytes of it already read into `buffer`
+        bool StoreStream(std::ifstream& in, std::vector<char>& buffer, std::streamsize first, std::ofstream& out,
+                         Murmur3Hasher& hasher, std::uintmax_t& size) {
+            for (std::streamsize n {first};;) {
+                hasher.Update(buffer.data(), static_cast<std::size_t>(n));
+                out.write(buffer.data(), n);
+                size += static_cast<std::uintmax_t>(n);
+                if (!in) break;
+                in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                n = in.gcount();
+            }
+            return !in.bad() && out;
+        }
+
+        bool DeflateStream(std::ifstream& in, std::vector<char>& buffer, std::streamsize first, std::ofstream& out,
+                           Murmur3Hasher& hasher, std::uintmax_t& size) {
+#if defined(VSPROFILE_HAVE_ZLIB)
+            z_stream z {};
+            if (deflateInit(&z, Z_DEFAULT_COMPRESSION) != Z_OK) return false;
+            std::vector<char> zout(kBufferSize);
+            bool ok {false};
+            for (std::streamsize n {first};;) {
+                hasher.Update(buffer.data(), static_cast<std::size_t>(n));
+                size += static_cast<std::uintmax_t>(n);
+                const bool last {!in};
+                z.next_in = reinterpret_cast<Bytef*>(buffer.data());
+                z.avail_in = static_cast<uInt>(n);
+                int rc;
+                do {
+                    z.next_out = reinterpret_cast<Bytef*>(zout.data());
+                    z.avail_out = static_cast<uInt>(zout.size());
+                    rc = deflate(&z, last ? Z_FINISH : Z_NO_FLUSH);
+                    out.write(zout.data(), static_cast<std::streamsize>(zout.size() - z.avail_out));
+                } while (z.avail_out == 0);
+                if (last) {
+                    ok = rc == Z_STREAM_END;
+                    break;
+                }
+                in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                n = in.gcount();
+            }
+            deflateEnd(&z);
+            return ok && !in.bad() && out;
+#else
+            return StoreStream(in, buffer, first, out, hasher, size);
+#endif
+        }
+
+        bool InflateStream(std::ifstream& in, std::uint64_t remaining, std::ofstream& out, Murmur3Hasher& hasher,
+                           std::uintmax_t& size, std::error_code& ec) {
+#if defined(VSPROFILE_HAVE_ZLIB)
+            z_stream z {};
+            if (inflateInit(&z) != Z_OK) return Fail(ec);
+            std::vector<char> zin(kBufferSize);
+            std::vector<char> buffer(kBufferSize);
+            int rc {Z_OK};
+            while (rc != Z_STREAM_END && remaining > 0) {
+                in.read(zin.data(), static_cast<std::streamsize>(std::min<std::uint64_t>(zin.size(), remaining)));
+                const auto n {static_cast<std::uint64_t>(in.gcount())};
+                if (n == 0) break;
+                remaining -= n;
+                z.next_in = reinterpret_cast<Bytef*>(zin.data());
+                z.avail_in = static_cast<uInt>(n);
+                do {
+                    z.next_out = reinterpret_cast<Bytef*>(buffer.data());
+                    z.avail_out = static_cast<uInt>(buffer.size());
+                    rc = inflate(&z, Z_NO_FLUSH);
+                    if (rc != Z_OK && rc != Z_STREAM_END) break;
+                    const std::size_t produced {buffer.size() - z.avail_out};
+                    hasher.Update(buffer.data(), produced);
+                    out.write(buffer.data(), static_cast<std::streamsize>(produced));
+                    size += produced;
+                } while (z.avail_out == 0 && rc != Z_STREAM_END);
+                if (rc != Z_OK && rc != Z_STREAM_END) break;
+            }
+            inflateEnd(&z);
+            return rc == Z_STREAM_END ? true : Fail(ec);
+#else
+            return Fail(ec, std::errc::not_supported); // packed by a build that had zlib
+#endif
+        }
+    }
+
+    bool PackCompression() {
+#if defined(VSPROFILE_HAVE_ZLIB)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool WritePack(const fs::path& root, const std::vector<std::string>& paths, const fs::path& packPath,
+                   std::vector<PackEntry>& written, std::error_code& ec) {
+        ec.clear();
+        written.clear();
+        const fs::path tmp {packPath.string() + ".tmp"};
+        std::ofstream out {tmp, std::ios::binary | std::ios::trunc};
+        if (!out) return Fail(ec);
+        std::string header;
+        header.append(kMagic.data(), kMagic.size());
+        Put(header, kVersion);
+        out.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+        std::vector<char> buffer(kBufferSize);
+        for (const std::string& path : paths) {
+            const fs::path file {root / path};
+            PackEntry entry;
+            entry.path = path;
+            entry.mtime = fs::last_write_time(file, ec).time_since_epoch().count();
+            if (!ec) entry.mode = static_cast<std::uint32_t>(fs::status(file, ec).permissions() & fs::perms::mask);
+            std::ifstream in {file, std::ios::binary};
+            if (ec || !in) {
+                out.close();
+                fs::remove(tmp, ec);
+                return Fail(ec);
+            }
+            entry.offset = static_cast<std::uint64_t>(out.tellp());
+            in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            const std::streamsize first {in.gcount()};
+            entry.method = WorthCompressing(buffer.data(), static_cast<std::size_t>(first))
+                           ? PackEntry::Method::Deflate : PackEntry::Method::Stored;
+            Murmur3Hasher hasher;
+            const bool ok {entry.method == PackEntry::Method::Deflate
+                           ? DeflateStream(in, buffer, first, out, hasher, entry.size)
+                           : StoreStream(in, buffer, first, out, hasher, entry.size)};
+            if (!ok) {
+                out.close();
+                fs::remove(tmp, ec);
+                return Fail(ec);
+            }
+            entry.stored = static_cast<std::uint64_t>(out.tellp()) - entry.offset;
+            entry.hash = hasher.Hex();
+            written.push_back(std::move(entry));
+        }
+
+        const auto indexOffset {static_cast<std::uint64_t>(out.tellp())};
+        std::string index;
+        Put(index, static_cast<std::uint64_t>(written.size()));
+        for (const auto& e : written) {
+            Put(index, static_cast<std::uint16_t>(e.path.size()));
+            index += e.path;
+            Put(index, static_cast<std::uint64_t>(e.size));
+            Put(index, e.mtime);
+            Put(index, e.offset);
+            Put(index, e.stored);
+            Put(index, static_cast<std::uint8_t>(e.method));
+            Put(index, e.mode);
+            index += e.hash;
+        }
+        Put(index, indexOffset);
+        index.append(kIndexMagic.data(), kIndexMagic.size());
+        out.write(index.data(), static_cast<std::streamsize>(index.size()));
+        out.close();
+        if (!out) {
+            fs::remove(tmp, ec);
+            return Fail(ec);
+        }
+        // Always flushed, whatever the durability setting: the packed files are deleted on the strength of it
+        SyncFile(tmp);
+        fs::rename(tmp, packPath, ec);
+        if (ec) return false;
+        SyncDirectory(packPath.parent_path());
+        return true;
+    }
+
+    std::optional<PackReader> PackReader::Open(const fs::path& packPath, std::error_code& ec) {
+        std::ifstream in {packPath, std::ios::binary | std::ios::ate};
+        if (!in) {
+            Fail(ec, std::errc::no_such_file_or_directory);
+            return std::nullopt;
+        }
+        const auto size {static_cast<std::uint64_t>(in.tellg())};
+        std::string head(kMagic.size() + sizeof(kVersion), '\0');
+        std::string trailer(kTrailerSize, '\0');
+        if (size < head.size() + 8 + kTrailerSize) {
+            Fail(ec, std::errc::illegal_byte_sequence);
+            return std::nullopt;
+        }
+        in.seekg(0);
+        in.read(head.data(), static_cast<std::streamsize>(head.size()));
+        in.seekg(static_cast<std::streamoff>(size - kTrailerSize));
+        in.read(trailer.data(), static_cast<std::streamsize>(trailer.size()));
+        const char* p {trailer.data()};
+        std::uint64_t indexOffset {};
+        std::uint32_t version {};
+        const char* hp {head.data() + kMagic.size()};
+        if (!in || std::memcmp(head.data(), kMagic.data(), kMagic.size()) != 0
+            || std::memcmp(trailer.data() + 8, kIndexMagic.data(), kIndexMagic.size()) != 0
+            || !Get(hp, head.data() + head.size(), version) || version != kVersion
+            || !Get(p, trailer.data() + trailer.size(), indexOffset) || indexOffset > size - kTrailerSize) {
+            Fail(ec, std::errc::illegal_byte_sequence);
+            return std::nullopt;
+        }
+
+        std::string index(size - kTrailerSize - indexOffset, '\0');
+        in.seekg(static_cast<std::streamoff>(indexOffset));
+        in.read(index.data(), static_cast<std::streamsize>(index.size()));
+        PackReader reader;
+        reader.path_ = packPath;
+        p = index.data();
+        const char* end {index.data() + index.size()};
+        std::uint64_t count {};
+        bool ok {in && Get(p, end, count)};
+        for (std::uint64_t i = 0; ok && i < count; ++i) {
+            PackEntry e;
+            std::uint16_t pathSize {};
+            std::uint64_t fileSize {};
+            std::uint8_t method {};
+            ok = Get(p, end, pathSize) && static_cast<std::size_t>(end - p) >= pathSize;
+            if (!ok) break;
+            e.path.assign(p, pathSize);
+            p += pathSize;
+            ok = Get(p, end, fileSize) && Get(p, end, e.mtime) && Get(p, end, e.offset) && Get(p, end, e.stored)
+                 && Get(p, end, method) && Get(p, end, e.mode) && static_cast<std::size_t>(end - p) >= kHashSize
+                 && e.offset + e.stored <= indexOffset && method <= static_cast<std::uint8_t>(PackEntry::Method::Deflate);
+            if (!ok) break;
+            e.size = fileSize;
+            e.method = static_cast<PackEntry::Method>(method);
+            e.hash.assign(p, kHashSize);
+            p += kHashSize;
+            reader.entries_.push_back(std::move(e));
+        }
+        if (!ok) {
+            Fail(ec, std::errc::illegal_byte_sequence);
+            return std::nullopt;
+        }
+        return reader;
+    }
+
+    std::uintmax_t PackReader::StoredBytes() const {
+        std::error_code ec;
+        const std::uintmax_t size {fs::file_size(path_, ec)};
+        return ec ? 0 : size;
+    }
+
+    bool PackReader::Extract(const PackEntry& entry, const fs::path& to, std::error_code& ec) const {
+        std::ifstream in {path_, std::ios::binary};
+        in.seekg(static_cast<std::streamoff>(entry.offset));
+        const fs::path tmp {to.string() + ".vsprofile-tmp"};
+        std::ofstream out {tmp, std::ios::binary | std::ios::trunc};
+        if (!in || !out) return Fail(ec);
+        Murmur3Hasher hasher;
+        std::uintmax_t size {};
+        bool ok {true};
+        if (entry.method == PackEntry::Method::Deflate) {
+            ok = InflateStream(in, entry.stored, out, hasher, size, ec);
+        } else {
+            std::vector<char> buffer(kBufferSize);
+            for (std::uint64_t remaining {entry.stored}; remaining > 0 && ok;) {
+                in.read(buffer.data(), static_cast<std::streamsize>(std::min<std::uint64_t>(buffer.size(), remaining)));
+                const auto n {static_cast<std::uint64_t>(in.gcount())};
+                hasher.Update(buffer.data(), n);
+                out.write(buffer.data(), static_cast<std::streamsize>(n));
+                size += n;
+                remaining -= n;
+                ok = n > 0;
+            }
+        }
+        out.close();
+        if (ok && (!out || size != entry.size || hasher.Hex() != entry.hash)) ok = Fail(ec);
+        if (ok) fs::last_write_time(tmp, fs::file_time_type{fs::file_time_type::duration{entry.mtime}}, ec);
+        if (ok && !ec) fs::permissions(tmp, static_cast<fs::perms>(entry.mode), fs::perm_options::replace, ec);
+        if (ok && !ec) {
+            if (CurrentDurability() == Durability::Strict) SyncFile(tmp);
+            fs::rename(tmp, to, ec);
+        }
+        if (!ok || ec) {
+            std::error_code ignored;
+            fs::remove(tmp, ignored);
+            if (!ec) Fail(ec);
+            return false;
+        }
+        if (CurrentDurability() == Durability::Strict) SyncDirectory(to.parent_path());
+        return true;
+    }
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace vsprofile::utils {
+
+    namespace fs = std::filesystem;
+
+    // One entry of a pack: a file's content, compressed on its own so it can be read without the others
+    struct PackEntry {
+        enum class Method : std::uint8_t { Stored, Deflate };
+        std::string path;       // relative, '/'-separated
+        std::uintmax_t size {};
+        long long mtime {};     // file_time_type ticks
+        std::uint64_t offset {};
+        std::uint64_t stored {}; // bytes the entry takes up in the pack
+        Method method {Method::Stored};
+        std::uint32_t mode {};  // permission bits (fs::perms)
+        std::string hash;       // Murmur3 128 of the content, hex
+    };
+
+    // Whether packs are compressed (built with zlib); without it entries are stored as they are
+    [[nodiscard]] bool PackCompression();
+
+    // Packs the files at `paths` (relative to `root`) into `packPath`, written beside it and renamed
+    // over it. Layout, little-endian:
+    //   "VSPK" u32 version | entry data... | index | u64 index offset | "VSPI"
+    // with the index a u64 count then, per entry, u16 path length, path, u64 size, i64 mtime,
+    // u64 offset, u64 stored size, u8 method, u32 permission bits and the 32 hex digits of its hash.
+    // Entries that do not compress (mod zips mostly) are stored, judged from their first block.
+    bool WritePack(const fs::path& root, const std::vector<std::string>& paths, const fs::path& packPath,
+                   std::vector<PackEntry>& written, std::error_code& ec);
+
+    class PackReader {
+        fs::path path_;
+        std::vector<PackEntry> entries_;
+
+    public:
+        // Reads only the index from the end of the pack
+        [[nodiscard]] static std::optional<PackReader> Open(const fs::path& packPath, std::error_code& ec);
+        [[nodiscard]] const std::vector<PackEntry>& Entries() const { return entries_; }
+        [[nodiscard]] std::uintmax_t StoredBytes() const;
+
+        // Writes one entry to `to` through a temporary file, checked against its hash and given its
+        // mtime and permissions. Each call reads the pack on its own, so entries can be extracted in parallel.
+        bool Extract(const PackEntry& entry, const fs::path& to, std::error_code& ec) const;
+    };
+
+}
@@ -0,0 +1,104 @@
+#include "Prewarm.hpp"
+#include "DirectoryScan.hpp"
+#include "DiskLayout.hpp"
+#include "FileUtils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace vsprofile::utils {
+
+    namespace {
+        constexpr unsigned kMaxPrewarmThreads = 8;
+
+        struct WarmItem {
+            fs::path path;
+            std::uintmax_t size;
+            std::uint64_t device;
+            std::uint64_t physical; // first extent, or the inode number without FIEMAP
+            bool mapped;
+        };
+
+        void Collect(const fs::path& dir, std::vector<WarmItem>& items) {
+            std::error_code ec;
+            for (const DirEntry& e : DirectoryScan::Read(dir, ScanDetail::Stats, ec)) {
+                if (IsHiddenEntry(e.name)) continue;
+                if (e.IsDirectory()) {
+                    Collect(dir / e.name, items);
+                } else if (e.IsFile() && e.size > 0) {
+                    items.push_back({dir / e.name, e.size, e.device, e.inode, false});
+                }
+            }
+        }
+
+        // Runs fn(item) over the items in order, handing out the next one to whichever thread is free
+        template <typename Fn>
+        void ForEachInOrder(std::vector<WarmItem>& items, Fn fn) {
+            std::atomic<std::size_t> next {};
+            auto worker = [&] {
+                for (std::size_t i = next++; i < items.size(); i = next++) fn(items[i]);
+            };
+            const unsigned threads {std::clamp(std::thread::hardware_concurrency(), 1u, kMaxPrewarmThreads)};
+            std::vector<std::jthread> pool;
+            for (unsigned t = 1; t < threads && t < items.size(); ++t) pool.emplace_back(worker);
+            worker();
+        }
+
+        void MapFirstExtent(WarmItem& item) {
+            if (const auto offset {FirstExtentOffset(item.path)}) {
+                item.physical = *offset;
+                item.mapped = true;
+            }
+        }
+
+        bool Warm(const WarmItem& item) {
+#if defined(_WIN32)
+            return false;
+#else
+            const int fd {::open(item.path.c_str(), O_RDONLY | O_CLOEXEC)};
+            if (fd < 0) return false;
+#if defined(__linux__)
+            // Unlike the advisory fadvise, readahead blocks until the data has been read, so the files are
+            // warm by the time Prewarm returns and a launch right after finds them cached
+            const bool ok {::readahead(fd, 0, item.size) == 0};
+#else
+            const bool ok {::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED) == 0};
+#endif
+            ::close(fd);
+            return ok;
+#endif
+        }
+    }
+
+    PrewarmStats Prewarm(const fs::path& dir) {
+        PrewarmStats stats;
+        std::vector<WarmItem> items;
+        Collect(dir, items);
+        ForEachInOrder(items, MapFirstExtent);
+        stats.extentOrder = !items.empty() && std::ranges::all_of(items, &WarmItem::mapped);
+        // Files FIEMAP could not place keep their inode number, which is a rough proxy for disk position
+        std::ranges::sort(items, {}, [](const WarmItem& i) { return std::pair{i.device, i.physical}; });
+
+        std::atomic<std::size_t> failures {};
+        std::atomic<std::uintmax_t> bytes {};
+        ForEachInOrder(items, [&](const WarmItem& item) {
+            if (Warm(item)) {
+                bytes += item.size;
+            } else {
+                ++failures;
+            }
+        });
+        stats.files = items.size() - failures;
+        stats.failures = failures;
+        stats.bytes = bytes;
+        return stats;
+    }
+
+}
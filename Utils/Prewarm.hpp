@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+
+namespace vsprofile::utils {
+
+    namespace fs = std::filesystem;
+
+    struct PrewarmStats {
+        std::size_t files {};
+        std::size_t failures {};
+        std::uintmax_t bytes {};
+        bool extentOrder {}; // false when the filesystem has no FIEMAP and inode order was used instead
+    };
+
+    // Pulls every file under `dir` into the page cache ahead of use: readahead on Linux, fadvise WILLNEED
+    // elsewhere. Files are queued in order of their first physical extent, so a spinning disk reads in
+    // one sweep, by a few threads so the I/O scheduler always has requests queued.
+    PrewarmStats Prewarm(const fs::path& dir);
+
+}
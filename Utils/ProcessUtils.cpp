@@ -0,0 +1,331 @@
+#include "ProcessUtils.hpp"
+#include "AppConstants.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <thread>
+#include <utility>
+
+#if defined(_WIN32)
+#include <algorithm>
+#include <fcntl.h>
+#include <io.h>
+#include <share.h>
+#include <sys/locking.h>
+#include <sys/stat.h>
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <csignal>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace vsprofile::utils {
+
+    ChildProcess::ChildProcess(ChildProcess&& other) noexcept
+        : out_(std::exchange(other.out_, nullptr)), pid_(std::exchange(other.pid_, -1)), terminated_(other.terminated_)
+#if defined(_WIN32)
+        , process_(std::exchange(other.process_, nullptr)), job_(std::exchange(other.job_, nullptr))
+#endif
+    {}
+
+    ChildProcess& ChildProcess::operator=(ChildProcess&& other) noexcept {
+        if (this != &other) {
+            if (Valid()) { Terminate(); Wait(); }
+            out_ = std::exchange(other.out_, nullptr);
+            pid_ = std::exchange(other.pid_, -1);
+            terminated_ = other.terminated_;
+#if defined(_WIN32)
+            process_ = std::exchange(other.process_, nullptr);
+            job_ = std::exchange(other.job_, nullptr);
+#endif
+        }
+        return *this;
+    }
+
+    ChildProcess::~ChildProcess() {
+        if (Valid()) { Terminate(); Wait(); }
+    }
+
+    bool ChildProcess::ReadLine(std::string& line) {
+        line.clear();
+        if (!out_) return false;
+        char buf[4096];
+        while (std::fgets(buf, sizeof buf, out_)) {
+            line += buf;
+            if (!line.empty() && line.back() == '\n') break;
+        }
+        if (line.empty()) return false;
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+        return true;
+    }
+
+#if defined(_WIN32)
+    namespace {
+        // One argument as CommandLineToArgvW splits it back: quoted, with backslashes doubled only before a quote
+        void AppendQuoted(std::wstring& cmd, const std::wstring& arg) {
+            cmd += L'"';
+            std::size_t backslashes {};
+            for (const wchar_t c : arg) {
+                if (c == L'\\') {
+                    ++backslashes;
+                    continue;
+                }
+                cmd.append(c == L'"' ? backslashes * 2 + 1 : backslashes, L'\\');
+                backslashes = 0;
+                cmd += c;
+            }
+            cmd.append(backslashes * 2, L'\\');
+            cmd += L'"';
+        }
+
+        BOOL CALLBACK CloseWindowOf(const HWND window, const LPARAM processId) {
+            DWORD owner {};
+            GetWindowThreadProcessId(window, &owner);
+            if (owner == static_cast<DWORD>(processId)) PostMessageW(window, WM_CLOSE, 0, 0);
+            return TRUE;
+        }
+    }
+
+    ChildProcess ChildProcess::Spawn(const fs::path& exe, const std::vector<std::string>& args) {
+        std::wstring cmd;
+        AppendQuoted(cmd, exe.wstring());
+        for (const auto& a : args) {
+            cmd += L' ';
+            AppendQuoted(cmd, fs::path{a}.wstring());
+        }
+        SECURITY_ATTRIBUTES inherit {sizeof inherit, nullptr, TRUE};
+        HANDLE readEnd {}, writeEnd {};
+        if (!CreatePipe(&readEnd, &writeEnd, &inherit, 0)) return {nullptr, -1};
+        SetHandleInformation(readEnd, HANDLE_FLAG_INHERIT, 0);
+        const HANDLE job {CreateJobObjectW(nullptr, nullptr)};
+        STARTUPINFOW si {};
+        si.cb = sizeof si;
+        si.dwFlags = STARTF_USESTDHANDLES;
+        si.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+        si.hStdOutput = writeEnd;
+        si.hStdError = writeEnd;
+        PROCESS_INFORMATION pi {};
+        // Suspended until it is in the job, so nothing it starts can escape it
+        const bool started {job && CreateProcessW(nullptr, cmd.data(), nullptr, nullptr, TRUE, CREATE_SUSPENDED, nullptr,
+                                                  nullptr, &si, &pi)};
+        CloseHandle(writeEnd);
+        if (!started || !AssignProcessToJobObject(job, pi.hProcess)) {
+            if (started) {
+                TerminateProcess(pi.hProcess, 1);
+                CloseHandle(pi.hThread);
+                CloseHandle(pi.hProcess);
+            }
+            if (job) CloseHandle(job);
+            CloseHandle(readEnd);
+            return {nullptr, -1};
+        }
+        ResumeThread(pi.hThread);
+        CloseHandle(pi.hThread);
+        const int fd {_open_osfhandle(reinterpret_cast<intptr_t>(readEnd), _O_RDONLY)};
+        std::FILE* out {fd >= 0 ? _fdopen(fd, "r") : nullptr};
+        if (!out) {
+            if (fd >= 0) _close(fd);
+            else CloseHandle(readEnd);
+            TerminateJobObject(job, 1);
+            CloseHandle(pi.hProcess);
+            CloseHandle(job);
+            return {nullptr, -1};
+        }
+        ChildProcess child {out, -1};
+        child.process_ = pi.hProcess;
+        child.job_ = job;
+        return child;
+    }
+
+    void ChildProcess::Terminate() {
+        if (!process_) return;
+        if (terminated_ == std::chrono::steady_clock::time_point{}) terminated_ = std::chrono::steady_clock::now();
+        // The closest thing to SIGTERM for a windowed game: ask its windows to close
+        EnumWindows(CloseWindowOf, static_cast<LPARAM>(GetProcessId(process_)));
+    }
+
+    void ChildProcess::Kill() {
+        if (job_) TerminateJobObject(job_, 1);
+    }
+
+    int ChildProcess::Wait() {
+        if (out_) std::fclose(std::exchange(out_, nullptr));
+        if (!process_) return -1;
+        if (terminated_ != std::chrono::steady_clock::time_point{}) {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    terminated_ + constants::kTerminateGrace - std::chrono::steady_clock::now());
+            if (WaitForSingleObject(process_, static_cast<DWORD>(std::max<long long>(0, left.count()))) != WAIT_OBJECT_0) Kill();
+        }
+        WaitForSingleObject(process_, INFINITE);
+        DWORD code {};
+        const bool exited {GetExitCodeProcess(process_, &code) != 0};
+        CloseHandle(std::exchange(process_, nullptr));
+        CloseHandle(std::exchange(job_, nullptr));
+        return exited ? static_cast<int>(code) : -1;
+    }
+#else
+    ChildProcess ChildProcess::Spawn(const fs::path& exe, const std::vector<std::string>& args) {
+        // Built before forking: the child of a threaded process may only make async-signal-safe calls
+        std::string exeStr = exe.string();
+        std::vector<std::string> owned(args);
+        std::vector<char*> argv;
+        argv.push_back(exeStr.data());
+        for (auto& a : owned) argv.push_back(a.data());
+        argv.push_back(nullptr);
+        int fds[2];
+        if (pipe(fds) != 0) return {nullptr, -1};
+        const pid_t pid = fork();
+        if (pid < 0) {
+            close(fds[0]); close(fds[1]);
+            return {nullptr, -1};
+        }
+        if (pid == 0) {
+            dup2(fds[1], STDOUT_FILENO);
+            dup2(fds[1], STDERR_FILENO);
+            close(fds[0]); close(fds[1]);
+            setpgid(0, 0); // own process group so Terminate() reaches helpers spawned by launch scripts
+            execvp(argv[0], argv.data());
+            _exit(127);
+        }
+        close(fds[1]);
+        setpgid(pid, pid); // also from the parent, whichever runs first wins
+        fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+        return {fdopen(fds[0], "r"), pid};
+    }
+
+    void ChildProcess::Terminate() {
+        if (pid_ <= 0) return;
+        if (terminated_ == std::chrono::steady_clock::time_point{}) terminated_ = std::chrono::steady_clock::now();
+        if (kill(-pid_, SIGTERM) != 0) kill(pid_, SIGTERM);
+    }
+
+    void ChildProcess::Kill() {
+        if (pid_ <= 0) return;
+        if (kill(-pid_, SIGKILL) != 0) kill(pid_, SIGKILL);
+    }
+
+    int ChildProcess::Wait() {
+        if (out_) std::fclose(std::exchange(out_, nullptr));
+        if (pid_ <= 0) return -1;
+        int status = 0;
+        if (terminated_ != std::chrono::steady_clock::time_point{}) {
+            // Polled through the grace period, then the group is killed
+            const auto deadline = terminated_ + constants::kTerminateGrace;
+            while (waitpid(pid_, &status, WNOHANG) == 0) {
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    Kill();
+                    waitpid(pid_, &status, 0);
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds{50});
+            }
+            pid_ = -1;
+            return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        }
+        waitpid(std::exchange(pid_, -1), &status, 0);
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+#endif
+
+    FileLock::FileLock(const fs::path& path) {
+        std::error_code ec;
+        fs::create_directories(path.parent_path(), ec);
+#if defined(_WIN32)
+        if (_wsopen_s(&fd_, path.c_str(), _O_RDWR | _O_CREAT, _SH_DENYNO, _S_IREAD | _S_IWRITE) != 0) fd_ = -1;
+        held_ = fd_ >= 0 && _locking(fd_, _LK_NBLCK, 1) == 0;
+#else
+        fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0) return;
+        held_ = flock(fd_, LOCK_EX | LOCK_NB) == 0;
+        if (held_) {
+            // Only read by a process that found the lock taken, to say who has it
+            const std::string pid {std::to_string(getpid())};
+            if (ftruncate(fd_, 0) == 0) (void) pwrite(fd_, pid.data(), pid.size(), 0);
+            return;
+        }
+        char buf[16] {};
+        if (const ssize_t n {pread(fd_, buf, sizeof buf - 1, 0)}; n > 0) holder_ = std::atoi(buf);
+        if (holder_ <= 0) holder_ = -1;
+#endif
+    }
+
+    FileLock::~FileLock() {
+        if (fd_ < 0) return;
+#if defined(_WIN32)
+        if (held_) {
+            _lseek(fd_, 0, SEEK_SET);
+            _locking(fd_, _LK_UNLCK, 1);
+        }
+        _close(fd_);
+#else
+        close(fd_); // releases the lock with it
+#endif
+    }
+
+    void LowerThreadPriority() {
+#if defined(__linux__)
+        // ioprio_set has no glibc wrapper; who = IOPRIO_WHO_PROCESS with id 0 means the calling thread
+        constexpr int kIoprioWhoProcess = 1;
+        constexpr int kIoprioClassIdle = 3;
+        constexpr int kIoprioClassShift = 13;
+        syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, kIoprioClassIdle << kIoprioClassShift);
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#endif
+    }
+
+    long long PeakRssKb(const int pid) {
+        if (pid <= 0) return 0;
+        std::ifstream status {std::format("/proc/{}/status", pid)};
+        std::string key;
+        while (status >> key) {
+            if (key == "VmHWM:") {
+                long long kb {};
+                status >> kb;
+                return kb;
+            }
+            status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        }
+        return 0;
+    }
+
+    int CurrentProcessId() {
+#if defined(_WIN32)
+        return static_cast<int>(GetCurrentProcessId());
+#else
+        return static_cast<int>(getpid());
+#endif
+    }
+
+    bool IsAppProcess(const int pid) {
+#if defined(_WIN32)
+        if (pid <= 0) return false;
+        const HANDLE process {OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(pid))};
+        // Running, but another user's and closed to this one, as EPERM is below
+        if (!process) return GetLastError() == ERROR_ACCESS_DENIED;
+        DWORD code {};
+        const bool alive {GetExitCodeProcess(process, &code) && code == STILL_ACTIVE};
+        wchar_t image[MAX_PATH];
+        DWORD size {MAX_PATH};
+        const bool named {QueryFullProcessImageNameW(process, 0, image, &size) != 0};
+        CloseHandle(process);
+        if (!alive) return false;
+        const std::wstring app {constants::kAppName.begin(), constants::kAppName.end()};
+        return !named || fs::path{std::wstring{image, size}}.stem().wstring().starts_with(app);
+#else
+        if (pid <= 0 || (kill(pid, 0) != 0 && errno != EPERM)) return false;
+        std::string name;
+        std::getline(std::ifstream{std::format("/proc/{}/comm", pid)}, name);
+        // Without /proc (macOS) a live pid is all there is to go on
+        return name.empty() || name.starts_with(constants::kAppName);
+#endif
+    }
+
+}
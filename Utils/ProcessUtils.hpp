@@ -0,0 +1,73 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace vsprofile::utils {
+
+    namespace fs = std::filesystem;
+
+    // Child process whose stdout and stderr are merged into a single pipe read line by line. On Windows
+    // it runs in a job object, which stands in for the process group.
+    class ChildProcess {
+        std::FILE* out_ {nullptr};
+        int pid_ {-1};
+        std::chrono::steady_clock::time_point terminated_ {}; // when Terminate() was first called, epoch if never
+#if defined(_WIN32)
+        void* process_ {nullptr}; // HANDLEs
+        void* job_ {nullptr};
+#endif
+
+        ChildProcess(std::FILE* out, int pid) : out_(out), pid_(pid) {}
+
+    public:
+        ChildProcess(const ChildProcess&) = delete;
+        ChildProcess& operator=(const ChildProcess&) = delete;
+        ChildProcess(ChildProcess&& other) noexcept;
+        ChildProcess& operator=(ChildProcess&& other) noexcept;
+        ~ChildProcess();
+
+        // Returns an invalid process (Valid() == false) if the executable could not be started
+        static ChildProcess Spawn(const fs::path& exe, const std::vector<std::string>& args);
+
+        [[nodiscard]] bool Valid() const { return out_ != nullptr; }
+        [[nodiscard]] int Pid() const { return pid_; } // -1 where the platform does not expose it
+        bool ReadLine(std::string& line); // Blocks until a full line or EOF, strips the line ending
+        void Terminate(); // Asks the process group to stop
+        void Kill();      // Stops the process group outright
+        // Closes the pipe and returns the exit code; after Terminate() the group is killed if it has
+        // not exited within kTerminateGrace
+        int Wait();
+    };
+
+    // Exclusive lock on a file shared by every vsprofile process, held until destroyed. Taking it
+    // does not wait: while another process holds it Held() is false and HolderPid() names that process.
+    class FileLock {
+        int fd_ {-1};
+        bool held_ {false};
+        int holder_ {-1};
+
+    public:
+        explicit FileLock(const fs::path& path);
+        FileLock(const FileLock&) = delete;
+        FileLock& operator=(const FileLock&) = delete;
+        ~FileLock();
+
+        [[nodiscard]] bool Held() const { return held_; }
+        [[nodiscard]] int HolderPid() const { return holder_; } // -1 where not known
+    };
+
+    // Moves the calling thread to idle I/O priority and lowest CPU priority (Linux), so background
+    // work only uses the disk when nothing else does
+    void LowerThreadPriority();
+
+    // Peak resident set size (VmHWM) of a running process in KiB, 0 where unavailable
+    [[nodiscard]] long long PeakRssKb(int pid);
+
+    [[nodiscard]] int CurrentProcessId();
+    // Whether `pid` is a live vsprofile or vsprofiled process, so a reused pid is not mistaken for one
+    [[nodiscard]] bool IsAppProcess(int pid);
+
+}
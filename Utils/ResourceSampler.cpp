@@ -0,0 +1,107 @@
+#include "ResourceSampler.hpp"
+#include <charconv>
+#include <condition_variable>
+#include <format>
+#include <string_view>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace vsprofile::utils {
+
+    namespace {
+        // Value following "key" in a "key: value" style proc file, 0 if missing
+        long long FieldAfter(std::string_view text, std::string_view key) {
+            const std::size_t pos = text.find(key);
+            if (pos == std::string_view::npos) return 0;
+            std::string_view rest = text.substr(pos + key.size());
+            while (!rest.empty() && (rest.front() == ' ' || rest.front() == '\t')) rest.remove_prefix(1);
+            long long value {};
+            std::from_chars(rest.data(), rest.data() + rest.size(), value);
+            return value;
+        }
+
+#if defined(__linux__)
+        std::string_view ReadAll(const int fd, char* buf, const std::size_t size) {
+            if (fd < 0) return {};
+            const ssize_t n = pread(fd, buf, size - 1, 0);
+            return n > 0 ? std::string_view{buf, static_cast<std::size_t>(n)} : std::string_view{};
+        }
+
+        // utime + stime in ms; fields 14 and 15 of /proc/<pid>/stat, counted after the ")" closing comm
+        double CpuMs(std::string_view stat) {
+            const std::size_t close = stat.rfind(')');
+            if (close == std::string_view::npos) return 0.0;
+            std::string_view rest = stat.substr(close + 2);
+            long long ticks {};
+            for (int field = 3; field <= 15 && !rest.empty(); ++field) {
+                const std::size_t space = rest.find(' ');
+                if (field >= 14) {
+                    long long value {};
+                    std::from_chars(rest.data(), rest.data() + rest.size(), value);
+                    ticks += value;
+                }
+                if (space == std::string_view::npos) break;
+                rest.remove_prefix(space + 1);
+            }
+            static const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+            return 1000.0 * static_cast<double>(ticks) / static_cast<double>(ticksPerSecond);
+        }
+#endif
+    }
+
+    ResourceSampler::ResourceSampler(const int pid, const std::chrono::milliseconds interval)
+        : pid_(pid), interval_(interval) {
+        if (pid_ > 0) worker_ = std::jthread{[this](const std::stop_token& stop) { Run(stop); }};
+    }
+
+    ResourceSampler::~ResourceSampler() {
+        Stop();
+    }
+
+    std::vector<ResourceSample> ResourceSampler::Stop() {
+        if (worker_.joinable()) {
+            worker_.request_stop();
+            worker_.join();
+        }
+        std::lock_guard lock {mtx_};
+        return std::move(samples_);
+    }
+
+    void ResourceSampler::Run(const std::stop_token& stop) {
+#if defined(__linux__)
+        const int statusFd = open(std::format("/proc/{}/status", pid_).c_str(), O_RDONLY | O_CLOEXEC);
+        const int ioFd = open(std::format("/proc/{}/io", pid_).c_str(), O_RDONLY | O_CLOEXEC);
+        const int statFd = open(std::format("/proc/{}/stat", pid_).c_str(), O_RDONLY | O_CLOEXEC);
+        const auto start = std::chrono::steady_clock::now();
+        char buf[4096];
+        std::mutex waitMtx;
+        std::condition_variable_any cv;
+        while (!stop.stop_requested()) {
+            ResourceSample s;
+            s.tMs = std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start}.count();
+            const std::string_view status = ReadAll(statusFd, buf, sizeof buf);
+            if (status.empty()) break; // process is gone
+            s.rssKb = FieldAfter(status, "VmRSS:");
+            const std::string_view io = ReadAll(ioFd, buf, sizeof buf);
+            s.readBytes = FieldAfter(io, "read_bytes:");
+            s.writeBytes = FieldAfter(io, "\nwrite_bytes:");
+            s.cpuMs = CpuMs(ReadAll(statFd, buf, sizeof buf));
+            {
+                std::lock_guard lock {mtx_};
+                samples_.push_back(s);
+            }
+            std::unique_lock lock {waitMtx};
+            cv.wait_for(lock, stop, interval_, [] { return false; });
+        }
+        for (const int fd : {statusFd, ioFd, statFd}) {
+            if (fd >= 0) close(fd);
+        }
+#else
+        (void)stop;
+#endif
+    }
+
+}
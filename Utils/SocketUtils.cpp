@@ -0,0 +1,128 @@
+#include "SocketUtils.hpp"
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace vsprofile::utils {
+
+#if !defined(_WIN32)
+    namespace {
+        bool FillAddress(const fs::path& path, sockaddr_un& addr) {
+            addr = {};
+            addr.sun_family = AF_UNIX;
+            const std::string s {path.string()};
+            if (s.size() >= sizeof addr.sun_path) return false;
+            std::memcpy(addr.sun_path, s.c_str(), s.size() + 1);
+            return true;
+        }
+    }
+
+    int ConnectUnix(const fs::path& path) {
+        sockaddr_un addr {};
+        if (!FillAddress(path, addr)) return -1;
+        const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        if (connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    int ListenUnix(const fs::path& path) {
+        sockaddr_un addr {};
+        if (!FillAddress(path, addr)) return -1;
+        const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        unlink(addr.sun_path);
+        // Connecting takes write permission on the socket file, which the umask alone may give to everyone
+        if (bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0 || chmod(addr.sun_path, S_IRUSR | S_IWUSR) != 0
+            || listen(fd, 16) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    int AcceptClient(const int listenFd) {
+        return accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    }
+
+    bool PeerIsCurrentUser(const int fd) {
+#if defined(__linux__)
+        ucred cred {};
+        socklen_t len {sizeof cred};
+        return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && cred.uid == geteuid();
+#else
+        uid_t uid;
+        gid_t gid;
+        return getpeereid(fd, &uid, &gid) == 0 && uid == geteuid();
+#endif
+    }
+
+    void SetTimeout(const int fd, const std::chrono::milliseconds timeout) {
+        const auto us {std::chrono::duration_cast<std::chrono::microseconds>(timeout).count()};
+        const timeval tv {static_cast<time_t>(us / 1'000'000), static_cast<suseconds_t>(us % 1'000'000)};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof tv);
+    }
+
+    bool SendAll(const int fd, std::string_view data) {
+        while (!data.empty()) {
+            const ssize_t n = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            data.remove_prefix(static_cast<std::size_t>(n));
+        }
+        return true;
+    }
+
+    bool ReceiveLine(const int fd, std::string& line) {
+        line.clear();
+        char c;
+        while (true) {
+            const ssize_t n = recv(fd, &c, 1, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) return false; // a partial line cut short by a timeout is not a request
+            if (n == 0) return !line.empty();
+            if (c == '\n') return true;
+            line += c;
+        }
+    }
+
+    std::ptrdiff_t ReceiveSome(const int fd, char* buf, const std::size_t size) {
+        while (true) {
+            const ssize_t n = recv(fd, buf, size, 0);
+            if (n < 0 && errno == EINTR) continue;
+            return n;
+        }
+    }
+
+    void ShutdownWrite(const int fd) {
+        shutdown(fd, SHUT_WR);
+    }
+
+    void CloseSocket(const int fd) {
+        if (fd >= 0) close(fd);
+    }
+#else
+    int ConnectUnix(const fs::path&) { return -1; }
+    int ListenUnix(const fs::path&) { return -1; }
+    int AcceptClient(int) { return -1; }
+    bool PeerIsCurrentUser(int) { return false; }
+    void SetTimeout(int, std::chrono::milliseconds) {}
+    bool SendAll(int, std::string_view) { return false; }
+    bool ReceiveLine(int, std::string&) { return false; }
+    std::ptrdiff_t ReceiveSome(int, char*, std::size_t) { return -1; }
+    void ShutdownWrite(int) {}
+    void CloseSocket(int) {}
+#endif
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace vsprofile::utils {
+
+    namespace fs = std::filesystem;
+
+    // Sent by the daemon when a command reads from stdin; the client answers with one line
+    inline constexpr char kInputRequest = '\x05';
+    // Sent by the daemon as the last byte of a reply, telling the client how the command went
+    inline constexpr char kCommandSucceeded = '\x06';
+    inline constexpr char kCommandFailed = '\x15';
+
+    // Local stream sockets, used between the CLI and the daemon. All return -1 / false off POSIX.
+    [[nodiscard]] int ConnectUnix(const fs::path& path);
+    [[nodiscard]] int ListenUnix(const fs::path& path); // replaces a stale socket file, left connectable by its owner only
+    [[nodiscard]] int AcceptClient(int listenFd);
+    [[nodiscard]] bool PeerIsCurrentUser(int fd); // the other end runs as this process's user
+    void SetTimeout(int fd, std::chrono::milliseconds timeout); // sends and receives then fail rather than block past it
+    bool SendAll(int fd, std::string_view data);
+    bool ReceiveLine(int fd, std::string& line); // up to '\n', which is dropped; false on a timeout
+    [[nodiscard]] std::ptrdiff_t ReceiveSome(int fd, char* buf, std::size_t size); // 0 once the peer closes
+    void ShutdownWrite(int fd); // the peer reads end of file
+    void CloseSocket(int fd);
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace vsprofile::utils {
+
+    struct MedianEstimate {
+        double median {};
+        double lo {}; // confidence interval bounds
+        double hi {};
+        double confidence {}; // actual coverage of [lo, hi], order statistics only reach discrete levels
+    };
+
+    // Median with a distribution-free confidence interval taken from order statistics:
+    // [x(j), x(n-1-j)] covers the median with probability 1 - 2 * P(Binomial(n, 1/2) <= j).
+    inline MedianEstimate EstimateMedian(std::vector<double> samples, const double confidence = 0.95) {
+        MedianEstimate est;
+        if (samples.empty()) return est;
+        std::ranges::sort(samples);
+        const std::size_t n = samples.size();
+        est.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+
+        // Widest-first: start from [min, max] and narrow while coverage stays above the target
+        std::size_t j = 0;
+        double tail = std::ldexp(1.0, -static_cast<int>(n)); // P(X <= 0)
+        double coefficient = 1.0;
+        est.confidence = 1.0 - 2.0 * tail;
+        while (j + 1 < n / 2) {
+            coefficient = coefficient * static_cast<double>(n - j) / static_cast<double>(j + 1);
+            const double nextTail = tail + coefficient * std::ldexp(1.0, -static_cast<int>(n));
+            if (1.0 - 2.0 * nextTail < confidence) break;
+            tail = nextTail;
+            ++j;
+            est.confidence = 1.0 - 2.0 * tail;
+        }
+        est.lo = samples[j];
+        est.hi = samples[n - 1 - j];
+        return est;
+    }
+
+}
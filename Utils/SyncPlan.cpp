@@ -0,0 +1,386 @@
+#include "SyncPlan.hpp"
+#include "CopyCalibration.hpp"
+#include "DirectoryScan.hpp"
+#include "DiskLayout.hpp"
+#include "Durability.hpp"
+#include "FileUtils.hpp"
+#include "IoRing.hpp"
+#include "TextUtils.hpp"
+#include "Trash.hpp"
+#include "WorkStealing.hpp"
+#include <algorithm>
+#include <mutex>
+#include <set>
+#include <unordered_set>
+#include <utility>
+
+namespace vsprofile::utils {
+
+    namespace {
+        bool SameFile(const DirEntry& a, const DirEntry& b) {
+            if (a.inode != 0 && a.inode == b.inode && a.device == b.device) return true;
+            return a.size == b.size && a.mtime == b.mtime;
+        }
+
+        // A folder that cannot be read must not pass for an empty one, which would plan the removal of everything it mirrors
+        bool ReadFolder(const fs::path& dir, DirectoryScan& scan) {
+            std::error_code ec;
+            scan = DirectoryScan::Read(dir, ScanDetail::Stats, ec);
+            if (!ec) return true;
+            PrintErr(std::format("Could not read '{}': {}\n", dir.string(), ec.message()));
+            return false;
+        }
+
+        bool PlanDirectory(const fs::path& from, const fs::path& to, const bool toExists, const SyncStrategy strategy, std::vector<FileOp>& ops) {
+            // One batched read and a statx per entry on each side, no per-file path lookups after that
+            DirectoryScan src;
+            DirectoryScan dst;
+            if (!ReadFolder(from, src) || (toExists && !ReadFolder(to, dst))) return false;
+            for (const DirEntry& entry : src) {
+                if (IsHiddenEntry(entry.name)) continue;
+                const fs::path target {to / entry.name};
+                const DirEntry* other {dst.Find(entry.name)};
+                if (entry.IsDirectory()) {
+                    const bool dstIsDir = other && other->IsDirectory();
+                    if (other && !dstIsDir) ops.push_back({FileOp::Kind::Remove, {}, target});
+                    if (!dstIsDir) ops.push_back({FileOp::Kind::MakeDir, {}, target});
+                    if (!PlanDirectory(from / entry.name, target, dstIsDir, strategy, ops)) return false;
+                } else if (entry.IsFile()) {
+                    if (other && other->IsFile() && SameFile(entry, *other)) continue;
+                    if (other && other->IsDirectory()) ops.push_back({FileOp::Kind::Remove, {}, target});
+                    const auto kind = strategy == SyncStrategy::Link ? FileOp::Kind::Link : FileOp::Kind::Copy;
+                    ops.push_back({kind, from / entry.name, target, entry.size});
+                }
+            }
+            for (const DirEntry& entry : dst) {
+                if (!IsHiddenEntry(entry.name) && !src.Find(entry.name)) ops.push_back({FileOp::Kind::Remove, {}, to / entry.name});
+            }
+            return true;
+        }
+
+        bool PlanDelta(const fs::path& from, const fs::path& to, const fs::path& reference, const std::string& prefix,
+                       const SyncStrategy strategy, std::vector<FileOp>& ops, std::vector<SharedFile>& shared) {
+            DirectoryScan src;
+            DirectoryScan ref;
+            if (!ReadFolder(from, src) || (!reference.empty() && !ReadFolder(reference, ref))) return false;
+            for (const DirEntry& entry : src) {
+                if (IsHiddenEntry(entry.name)) continue;
+                const DirEntry* other {ref.Find(entry.name)};
+                std::string rel {prefix};
+                rel += entry.name;
+                if (entry.IsDirectory()) {
+                    // Folders are always created, so putting shared files back needs no mkdir and empty ones survive
+                    ops.push_back({FileOp::Kind::MakeDir, {}, to / entry.name});
+                    const fs::path nextRef {other && other->IsDirectory() ? reference / entry.name : fs::path{}};
+                    if (!PlanDelta(from / entry.name, to / entry.name, nextRef, rel + '/', strategy, ops, shared)) return false;
+                } else if (entry.IsFile()) {
+                    if (other && other->IsFile() && SameFile(entry, *other)) {
+                        shared.push_back({std::move(rel), entry.size, entry.mtime});
+                        continue;
+                    }
+                    const auto kind = strategy == SyncStrategy::Link ? FileOp::Kind::Link : FileOp::Kind::Copy;
+                    ops.push_back({kind, from / entry.name, to / entry.name, entry.size});
+                }
+            }
+            return true;
+        }
+
+        // Writes next to the target and renames over it, leaving other links to the old inode untouched
+        bool ReplaceFile(const FileOp& op, std::error_code& ec, CopyHashLog* hashes) {
+            const fs::path tmp {op.to.string() + ".vsprofile-tmp"};
+            fs::remove(tmp, ec);
+            ec.clear();
+            bool written = false;
+            if (op.kind == FileOp::Kind::Link && !HardLinksKnownBroken(op.from, op.to)) {
+                fs::create_hard_link(op.from, tmp, ec);
+                written = !ec;
+                ec.clear();
+            }
+            std::string hash;
+            std::error_code ignored; // cleaning up must not throw, nor replace the error being reported
+            if (!written) {
+                if (hashes ? !CopyAndHash(op.from, tmp, hash, ec) : !CloneFile(op.from, tmp, ec)) return false;
+                const fs::file_time_type mtime {fs::last_write_time(op.from, ec)};
+                if (!ec) fs::last_write_time(tmp, mtime, ec); // keeps the next sync incremental
+                if (ec) {
+                    fs::remove(tmp, ignored);
+                    return false;
+                }
+                if (hashes && hashes->verify && !VerifyFileHash(tmp, hash, ec)) {
+                    PrintErr(std::format("Copy of '{}' does not read back as written\n", op.from.string()));
+                    fs::remove(tmp, ignored);
+                    return false;
+                }
+                if (CurrentDurability() == Durability::Strict) SyncFile(tmp);
+            }
+            fs::rename(tmp, op.to, ec);
+            if (ec) {
+                fs::remove(tmp, ignored);
+                return false;
+            }
+            if (CurrentDurability() == Durability::Strict) SyncDirectory(op.to.parent_path());
+            if (!hash.empty()) {
+                const HashedCopy copy {op.to, fs::file_size(op.to, ec), fs::last_write_time(op.to, ec).time_since_epoch().count(), hash};
+                std::scoped_lock lock {hashes->mtx};
+                hashes->copies.push_back(copy);
+            }
+            ec.clear();
+            return true;
+        }
+
+        bool ExecuteOp(const FileOp& op, std::error_code& ec, CopyHashLog* hashes) {
+            switch (op.kind) {
+                case FileOp::Kind::MakeDir:
+                    fs::create_directories(op.to, ec);
+                    if (!ec && CurrentDurability() == Durability::Strict) SyncDirectory(op.to.parent_path());
+                    return !ec;
+                case FileOp::Kind::Remove:
+                    // Folders are renamed into the trash rather than deleted file by file
+                    if (fs::is_directory(fs::symlink_status(op.to, ec))) {
+                        if (!MoveToTrash(op.to, ec)) return false;
+                    } else {
+                        fs::remove_all(op.to, ec);
+                        if (ec) return false;
+                    }
+                    if (CurrentDurability() == Durability::Strict) SyncDirectory(op.to.parent_path());
+                    return true;
+                case FileOp::Kind::Link:
+                case FileOp::Kind::Copy:
+                    return ReplaceFile(op, ec, hashes);
+            }
+            return false;
+        }
+    }
+
+    namespace {
+        constexpr std::uint64_t kUntracked = ~std::uint64_t{0};
+
+        // Orders operations by where their sources sit on disk, for one-at-a-time runs on spinning disks
+        void SortByDiskOrder(const std::vector<FileOp>& ops, std::vector<std::size_t>& indices) {
+            std::vector<std::pair<std::uint64_t, std::size_t>> keyed;
+            for (const std::size_t i : indices) keyed.emplace_back(DiskOrderKey(ops[i].from), i);
+            std::ranges::sort(keyed);
+            for (std::size_t k = 0; k < keyed.size(); ++k) indices[k] = keyed[k].second;
+        }
+
+        // Link: drop a stale temporary name, link beside the target and rename over it, as one chain.
+        // Remove: a plain unlink, which refuses folders. Anything the ring did not complete (folders,
+        // links across filesystems, a failed chain) goes through ExecuteOp afterwards.
+        template <typename Record>
+        void RunBatch(IoRing& ring, const std::vector<FileOp>& ops, const std::vector<std::size_t>& batch,
+                      CopyHashLog* hashes, Record&& record) {
+            std::vector<std::string> tmps(batch.size());
+            for (std::size_t k = 0; k < batch.size(); ++k) {
+                const FileOp& op {ops[batch[k]]};
+                if (op.kind == FileOp::Kind::Remove) {
+                    ring.UnlinkAt(IoRing::kCwd, op.to.c_str(), 0, k);
+                    continue;
+                }
+                tmps[k] = op.to.string() + ".vsprofile-tmp";
+                ring.Reserve(3);
+                ring.UnlinkAt(IoRing::kCwd, tmps[k].c_str(), 0, kUntracked, IoRing::kHardLink);
+                ring.LinkAt(IoRing::kCwd, op.from.c_str(), IoRing::kCwd, tmps[k].c_str(), kUntracked, IoRing::kLink);
+                ring.RenameAt(IoRing::kCwd, tmps[k].c_str(), IoRing::kCwd, op.to.c_str(), k);
+            }
+            std::vector<bool> completed(batch.size());
+            for (const auto& [tag, result] : ring.Drain()) {
+                if (tag < batch.size() && result >= 0) completed[tag] = true;
+            }
+            std::vector<std::size_t> leftover;
+            std::set<fs::path> renamedIn; // folders whose entries the batch changed, flushed together under strict
+            for (std::size_t k = 0; k < batch.size(); ++k) {
+                if (!completed[k]) leftover.push_back(batch[k]);
+                else renamedIn.insert(ops[batch[k]].to.parent_path());
+            }
+            if (CurrentDurability() == Durability::Strict) SyncDirectories(renamedIn);
+            for (std::size_t k = 0; k < batch.size(); ++k) {
+                if (completed[k]) record(ops[batch[k]], true, {});
+            }
+            // Links that failed across filesystems become copies, read in disk order from a spinning source
+            if (!leftover.empty() && PreferSequential(ops[leftover.front()].from)) SortByDiskOrder(ops, leftover);
+            for (const std::size_t i : leftover) {
+                std::error_code ec;
+                record(ops[i], ExecuteOp(ops[i], ec, hashes), ec);
+            }
+        }
+    }
+
+    std::string_view ToString(const SyncStrategy strategy) {
+        return strategy == SyncStrategy::Link ? "link" : "copy";
+    }
+
+    SyncStrategy SyncStrategyFromString(const std::string_view name) {
+        return name == "link" ? SyncStrategy::Link : SyncStrategy::Copy;
+    }
+
+    bool SyncPlan::AddSync(const fs::path& from, const fs::path& to, const SyncStrategy strategy) {
+        std::error_code ec;
+        if (!fs::is_directory(from, ec)) return true;
+        const std::size_t before {ops.size()};
+        const bool toExists = fs::is_directory(to, ec);
+        if (!toExists) ops.push_back({FileOp::Kind::MakeDir, {}, to});
+        if (PlanDirectory(from, to, toExists, strategy, ops)) return true;
+        ops.resize(before);
+        return false;
+    }
+
+    bool SyncPlan::AddDelta(const fs::path& from, const fs::path& to, const fs::path& reference, const SyncStrategy strategy,
+                            std::vector<SharedFile>& shared) {
+        std::error_code ec;
+        if (!fs::is_directory(from, ec)) return true;
+        const std::size_t before {ops.size()};
+        const std::size_t sharedBefore {shared.size()};
+        if (!fs::is_directory(to, ec)) ops.push_back({FileOp::Kind::MakeDir, {}, to});
+        if (PlanDelta(from, to, fs::is_directory(reference, ec) ? reference : fs::path{}, {}, strategy, ops, shared)) return true;
+        ops.resize(before);
+        shared.resize(sharedBefore);
+        return false;
+    }
+
+    bool SyncPlan::AddSelected(const fs::path& from, const fs::path& to, const std::vector<std::string>& names,
+                               const SyncStrategy strategy) {
+        std::error_code ec;
+        if (!fs::is_directory(from, ec)) return true;
+        const std::size_t before {ops.size()};
+        const bool toExists = fs::is_directory(to, ec);
+        DirectoryScan src;
+        DirectoryScan dst;
+        if (!ReadFolder(from, src) || (toExists && !ReadFolder(to, dst))) return false;
+        if (!toExists) ops.push_back({FileOp::Kind::MakeDir, {}, to});
+        const std::set<std::string, std::less<>> wanted {names.begin(), names.end()};
+        for (const DirEntry& entry : dst) {
+            if (!IsHiddenEntry(entry.name) && !wanted.contains(entry.name)) ops.push_back({FileOp::Kind::Remove, {}, to / entry.name});
+        }
+        for (const std::string& name : names) {
+            const DirEntry* entry {src.Find(name)};
+            if (!entry) continue;
+            const DirEntry* other {dst.Find(name)};
+            const fs::path target {to / name};
+            if (entry->IsDirectory()) {
+                const bool dstIsDir = other && other->IsDirectory();
+                if (other && !dstIsDir) ops.push_back({FileOp::Kind::Remove, {}, target});
+                if (!dstIsDir) ops.push_back({FileOp::Kind::MakeDir, {}, target});
+                if (!PlanDirectory(from / name, target, dstIsDir, strategy, ops)) {
+                    ops.resize(before);
+                    return false;
+                }
+            } else if (entry->IsFile()) {
+                if (other && other->IsFile() && SameFile(*entry, *other)) continue;
+                if (other && other->IsDirectory()) ops.push_back({FileOp::Kind::Remove, {}, target});
+                const auto kind = strategy == SyncStrategy::Link ? FileOp::Kind::Link : FileOp::Kind::Copy;
+                ops.push_back({kind, from / name, target, entry->size});
+            }
+        }
+        return true;
+    }
+
+    bool ExecuteOp(const FileOp& op, std::error_code& ec) {
+        return ExecuteOp(op, ec, nullptr);
+    }
+
+    std::uintmax_t SyncPlan::CopyBytes() const {
+        std::uintmax_t bytes {};
+        for (const FileOp& op : ops) {
+            if (op.kind == FileOp::Kind::Copy) bytes += op.bytes;
+        }
+        return bytes;
+    }
+
+    std::size_t SyncPlan::Execute() const {
+        std::size_t failures {}, linked {}, copied {}, removed {};
+        std::uintmax_t bytes {};
+        std::mutex mtx;
+        DurableBatch durable; // flushed once the whole plan has run
+        const bool group {CurrentDurability() == Durability::Group};
+        auto record = [&](const FileOp& op, const bool ok, const std::error_code& ec) {
+            std::scoped_lock lock {mtx};
+            if (!ok) {
+                PrintErr(std::format("Failed on '{}': {}\n", op.to.string(), ec.message()));
+                ++failures;
+                return;
+            }
+            if (group) durable.Add(op.to);
+            if (op.kind == FileOp::Kind::Link) ++linked;
+            if (op.kind == FileOp::Kind::Copy) { ++copied; bytes += op.bytes; }
+            if (op.kind == FileOp::Kind::Remove) ++removed;
+            if (completed) completed(static_cast<std::size_t>(&op - ops.data()));
+        };
+        // Runs of file operations with distinct targets, none reading what another writes, are
+        // independent of each other: links and removals go through io_uring together, copies run in
+        // parallel. Folders are created up front in plan order, except one replacing something an
+        // earlier removal clears, which stays where it is as a barrier.
+        IoRing* ring {IoRing::ForThisThread()};
+        if (ring && !ring->SupportsLinking()) ring = nullptr;
+        std::vector<std::size_t> batch;
+        std::unordered_set<std::string> targets;
+        std::unordered_set<std::string> reads; // each source and the folders above it, which removing would pull from under it
+        auto runOne = [&](const std::size_t i) {
+            std::error_code ec;
+            record(ops[i], ExecuteOp(ops[i], ec, hashes), ec);
+        };
+        auto flush = [&] {
+            std::vector<std::size_t> viaRing, copies, sequential;
+            for (const std::size_t i : batch) {
+                if (ops[i].kind == FileOp::Kind::Copy) {
+                    (PreferSequential(ops[i].from) || PreferSequential(ops[i].to) ? sequential : copies).push_back(i);
+                } else if (ring) {
+                    viaRing.push_back(i);
+                } else {
+                    runOne(i);
+                }
+            }
+            if (!viaRing.empty()) RunBatch(*ring, ops, viaRing, hashes, record);
+            // Copies touching a spinning disk run one at a time so the heads sweep instead of seeking
+            SortByDiskOrder(ops, sequential);
+            for (const std::size_t i : sequential) runOne(i);
+            if (copies.size() > 1) {
+                WorkStealingPool<std::size_t>{}.Run(std::move(copies), [&](const std::size_t i, auto&&) { runOne(i); });
+            } else if (!copies.empty()) {
+                runOne(copies.front());
+            }
+            batch.clear();
+            targets.clear();
+            reads.clear();
+        };
+        std::vector<bool> hoisted(ops.size());
+        {
+            std::unordered_set<std::string> removed;
+            for (std::size_t i = 0; i < ops.size(); ++i) {
+                if (ops[i].kind == FileOp::Kind::Remove) removed.insert(ops[i].to.native());
+                if (ops[i].kind != FileOp::Kind::MakeDir) continue;
+                bool cleared {false};
+                for (fs::path dir {ops[i].to}; dir.has_relative_path() && !cleared; dir = dir.parent_path()) {
+                    cleared = removed.contains(dir.native());
+                }
+                if (cleared) continue;
+                hoisted[i] = true;
+                runOne(i);
+            }
+        }
+        for (std::size_t i = 0; i < ops.size(); ++i) {
+            if (hoisted[i]) continue;
+            if (ops[i].kind == FileOp::Kind::MakeDir) {
+                flush();
+                runOne(i);
+                continue;
+            }
+            const FileOp& op {ops[i]};
+            // A capture reading a live file and a restore replacing it later in the plan must stay in that order
+            if (targets.contains(op.to.native()) || reads.contains(op.to.native())
+                || (!op.from.empty() && targets.contains(op.from.native()))) {
+                flush();
+            }
+            batch.push_back(i);
+            targets.insert(op.to.native());
+            for (fs::path read {op.from}; read.has_relative_path(); read = read.parent_path()) {
+                if (!reads.insert(read.native()).second) break;
+            }
+        }
+        flush();
+        durable.Commit();
+        PrintLog(std::format("Synced: {} linked, {} copied ({:.1f} MiB), {} removed\n",
+                             linked, copied, static_cast<double>(bytes) / (1024.0 * 1024.0), removed));
+        return failures;
+    }
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vsprofile::utils {
+
+    namespace fs = std::filesystem;
+
+    enum class SyncStrategy {
+        Link, // hard links, for large immutable files such as mod zips; copies when linking is impossible
+        Copy, // independent copies, for small files the game rewrites such as mod configs
+    };
+
+    [[nodiscard]] std::string_view ToString(SyncStrategy strategy);
+    [[nodiscard]] SyncStrategy SyncStrategyFromString(std::string_view name); // unknown names map to Copy
+
+    struct FileOp {
+        enum class Kind { MakeDir, Link, Copy, Remove };
+        Kind kind;
+        fs::path from;
+        fs::path to;
+        std::uintmax_t bytes {};
+    };
+
+    struct HashedCopy {
+        fs::path to;
+        std::uintmax_t size {};
+        long long mtime {}; // file_time_type ticks
+        std::string hash;   // Murmur3 128, hex
+    };
+
+    // A file a delta sync left out because the reference already holds it unchanged
+    struct SharedFile {
+        std::string path; // relative, '/'-separated
+        std::uintmax_t size {};
+        long long mtime {}; // file_time_type ticks
+    };
+
+    // Copies hashed in flight by a plan it is attached to, instead of cloned
+    struct CopyHashLog {
+        bool verify {false}; // re-read each copy past the page cache before it replaces its target
+        std::mutex mtx;
+        std::vector<HashedCopy> copies;
+    };
+
+    // File operations computed up front so several directory trees are reconciled in a single pass.
+    // Operations run in order and replace files through a rename, so a hard-linked target is never written in place.
+    struct SyncPlan {
+        std::vector<FileOp> ops;
+        CopyHashLog* hashes {nullptr}; // when set, copies are hashed (and verified) and recorded here
+        std::function<void(std::size_t)> completed; // called with the index of each operation that succeeded
+
+        // Appends the operations that make `to` mirror `from`; unchanged files (same inode, or same size and mtime) are skipped.
+        // Returns false, appending nothing, when a folder on either side cannot be read; the sync must then not run.
+        [[nodiscard]] bool AddSync(const fs::path& from, const fs::path& to, SyncStrategy strategy);
+        // As AddSync into a `to` that is still empty, except that files `reference` holds unchanged at the
+        // same relative path are not written but appended to `shared`, to be linked or copied from there later
+        [[nodiscard]] bool AddDelta(const fs::path& from, const fs::path& to, const fs::path& reference, SyncStrategy strategy,
+                                    std::vector<SharedFile>& shared);
+        // As AddSync, but `to` ends up holding only the top-level entries of `from` that are in `names`
+        [[nodiscard]] bool AddSelected(const fs::path& from, const fs::path& to, const std::vector<std::string>& names, SyncStrategy strategy);
+        [[nodiscard]] bool Empty() const { return ops.empty(); }
+        [[nodiscard]] std::uintmax_t CopyBytes() const; // what the copies write, links and removals move nothing
+
+        // Runs every operation and reports a summary, returns the number of failed operations.
+        // What has run is on stable storage when it returns as far as CurrentDurability() asks.
+        std::size_t Execute() const;
+    };
+
+    // Runs a single operation, also used to replay operations from elsewhere
+    bool ExecuteOp(const FileOp& op, std::error_code& ec);
+
+}
@@ -40,6 +40,10 @@ namespace vsprofile::utils {
         return std::format("\x1b[51m{}\x1b[0m", s);
     }
 
+    // Set on threads doing background work (staging, purging) rather than the command being run, so
+    // a daemon serving that command keeps their output out of its client's
+    inline thread_local bool tBackgroundOutput {false};
+
     inline void PrintErr(std::string_view s) {
         std::cout << Red(s);
     }
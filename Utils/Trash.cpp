@@ -0,0 +1,195 @@
+#include "Trash.hpp"
+#include "AppConstants.hpp"
+#include "DirectoryScan.hpp"
+#include "TextUtils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <fstream>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vsprofile::utils {
+
+    namespace {
+        constexpr std::string_view kPurgingPrefix = ".purging-";
+
+        std::string NewBatchId() {
+            static std::atomic<unsigned> sequence {};
+            const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+#if defined(_WIN32)
+            const long pid {0};
+#else
+            const long pid {static_cast<long>(getpid())};
+#endif
+            return std::format("{}-{}-{}", ms, pid, sequence++);
+        }
+
+        std::chrono::system_clock::time_point BatchTime(const std::string& id) {
+            long long ms {};
+            try { ms = std::stoll(id); } catch (...) {} // foreign names count as old
+            return std::chrono::system_clock::time_point{std::chrono::milliseconds{ms}};
+        }
+
+#if !defined(_WIN32)
+        // Device of the nearest existing ancestor, for paths that have not been created yet
+        bool DeviceOf(fs::path path, dev_t& device, fs::path& existing) {
+            struct stat st {};
+            while (::stat(path.c_str(), &st) != 0) {
+                if (path == path.parent_path()) return false;
+                path = path.parent_path();
+            }
+            device = st.st_dev;
+            existing = path;
+            return true;
+        }
+#endif
+
+        // Depth-first delete that checks for a stop request between files; false if interrupted
+        bool RemoveTree(const fs::path& dir, const std::stop_token& stop, std::uintmax_t& bytes) {
+            std::error_code ec;
+            // Folders guarded read-only must become writable before their entries can go
+            fs::permissions(dir, fs::perms::owner_all, fs::perm_options::add, ec);
+            for (const DirEntry& e : DirectoryScan::Read(dir, ScanDetail::LinkStats, ec)) {
+                if (stop.stop_requested()) return false;
+                const fs::path path {dir / e.name};
+                if (e.IsDirectory()) {
+                    if (!RemoveTree(path, stop, bytes)) return false;
+                    continue;
+                }
+                if (fs::remove(path, ec)) bytes += e.size;
+            }
+            fs::remove(dir, ec);
+            return true;
+        }
+    }
+
+    fs::path TrashDirFor(const fs::path& path) {
+#if defined(_WIN32)
+        return constants::kTrashDir;
+#else
+        dev_t device {}, appDevice {};
+        fs::path existing, appExisting;
+        std::error_code ec;
+        if (!DeviceOf(fs::absolute(path, ec), device, existing)) return constants::kTrashDir;
+        if (!DeviceOf(constants::kTrashDir, appDevice, appExisting) || device == appDevice) return constants::kTrashDir;
+        // Climb to the top of the volume, noting how far up this user can still create folders
+        const auto writable = [](const fs::path& dir) { return ::access(dir.c_str(), W_OK | X_OK) == 0; };
+        fs::path highestWritable {writable(existing) ? existing : fs::path{}};
+        dev_t parentDevice {};
+        fs::path parentExisting;
+        while (existing != existing.parent_path() && DeviceOf(existing.parent_path(), parentDevice, parentExisting)
+               && parentDevice == device) {
+            existing = existing.parent_path();
+            if (!highestWritable.empty() && highestWritable.parent_path() == existing && writable(existing)) highestWritable = existing;
+        }
+        const std::string name {std::format("{}{}", constants::kVolumeTrashPrefix, getuid())};
+        // The top of a mounted volume usually belongs to root; a folder of the user's own on it still keeps trashing a rename
+        if (const fs::path top {existing / name}; writable(top) || writable(existing) || highestWritable.empty()) return top;
+        return highestWritable / name;
+#endif
+    }
+
+    std::string MoveToTrash(const fs::path& origin, const std::vector<fs::path>& entries, std::error_code& ec) {
+        if (entries.empty()) return {};
+        const std::string id {NewBatchId()};
+        const fs::path batch {TrashDirFor(origin) / id};
+        std::error_code local;
+        const bool haveBatch {fs::create_directories(batch / "files", local)};
+        if (haveBatch) std::ofstream{batch / "origin"} << fs::absolute(origin, local).string() << '\n';
+        std::size_t trashed {}, deleted {};
+        for (const auto& entry : entries) {
+            if (haveBatch) {
+                fs::rename(entry, batch / "files" / entry.filename(), local);
+                if (!local) {
+                    ++trashed;
+                    continue;
+                }
+            }
+            // No trash on this volume (or a mount point inside it): delete now
+            if (fs::remove_all(entry, local) > 0) ++deleted;
+            if (local) ec = local;
+        }
+        if (deleted > 0) {
+            PrintWarn(std::format("No trash could take {} entr{} of '{}', deleted {} for good\n", deleted, deleted == 1 ? "y" : "ies",
+                                  origin.string(), deleted == 1 ? "it" : "them"));
+        }
+        if (trashed == 0) {
+            fs::remove_all(batch, local);
+            return {};
+        }
+        return id;
+    }
+
+    bool MoveToTrash(const fs::path& path, std::error_code& ec) {
+        MoveToTrash(path.parent_path(), {path}, ec);
+        return !ec;
+    }
+
+    std::vector<TrashBatch> ListTrash(const fs::path& trashDir) {
+        std::vector<TrashBatch> batches;
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(trashDir, ec)) {
+            const std::string id {entry.path().filename().string()};
+            if (id.starts_with('.') || !entry.is_directory(ec)) continue;
+            TrashBatch batch {id, entry.path(), {}, BatchTime(id), {}};
+            std::string origin;
+            std::getline(std::ifstream{entry.path() / "origin"}, origin);
+            batch.origin = origin;
+            for (const DirEntry& e : DirectoryScan::Read(entry.path() / "files", ScanDetail::Names, ec)) {
+                batch.names.emplace_back(e.name);
+            }
+            batches.push_back(std::move(batch));
+        }
+        std::ranges::sort(batches, {}, &TrashBatch::time);
+        return batches;
+    }
+
+    bool RestoreTrash(const TrashBatch& batch, std::error_code& ec) {
+        if (batch.origin.empty()) {
+            ec = std::make_error_code(std::errc::no_such_file_or_directory);
+            return false;
+        }
+        fs::create_directories(batch.origin, ec);
+        if (ec) return false;
+        bool complete {true};
+        for (const auto& name : batch.names) {
+            const fs::path target {batch.origin / name};
+            if (fs::exists(fs::symlink_status(target, ec))) {
+                PrintWarn(std::format("'{}' exists again, its trashed copy stays in '{}'\n", target.string(), batch.dir.string()));
+                complete = false;
+                continue;
+            }
+            fs::rename(batch.dir / "files" / name, target, ec);
+            if (ec) return false;
+        }
+        if (complete) fs::remove_all(batch.dir, ec);
+        return complete;
+    }
+
+    std::uintmax_t PurgeTrash(const fs::path& trashDir, const std::chrono::seconds minAge, const std::stop_token stop) {
+        const auto cutoff {std::chrono::system_clock::now() - minAge};
+        std::uintmax_t bytes {};
+        std::error_code ec;
+        std::vector<fs::path> doomed;
+        for (const DirEntry& e : DirectoryScan::Read(trashDir, ScanDetail::Names, ec)) {
+            const std::string name {e.name};
+            if (name.starts_with(kPurgingPrefix)) {
+                doomed.push_back(trashDir / name); // left over from an interrupted purge
+            } else if (!name.starts_with('.') && BatchTime(name) <= cutoff) {
+                const fs::path claimed {trashDir / std::format("{}{}", kPurgingPrefix, name)};
+                fs::rename(trashDir / name, claimed, ec);
+                if (!ec) doomed.push_back(claimed);
+            }
+        }
+        for (const auto& dir : doomed) {
+            if (!RemoveTree(dir, stop, bytes)) break;
+        }
+        return bytes;
+    }
+
+}
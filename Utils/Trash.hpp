@@ -0,0 +1,39 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+namespace vsprofile::utils {
+
+    namespace fs = std::filesystem;
+
+    // Entries deleted together, kept as <trash>/<id>/files with the folder they came from in <trash>/<id>/origin
+    struct TrashBatch {
+        std::string id; // milliseconds since the epoch, then a sequence number, so ids sort by age
+        fs::path dir;
+        fs::path origin;
+        std::chrono::system_clock::time_point time;
+        std::vector<std::string> names;
+    };
+
+    // Trash on the same filesystem as `path`, so trashing is a rename: the app's trash when it shares
+    // the volume, otherwise .vsprofile-trash-<uid> at the top of the volume (as the freedesktop trash does)
+    // when this user can write there, or else in the highest folder above `path` that this user can
+    [[nodiscard]] fs::path TrashDirFor(const fs::path& path);
+
+    // Renames `entries` (all inside `origin`) into a new trash batch and returns its id. Entries that
+    // cannot be renamed into a trash are deleted in place instead, with a warning.
+    std::string MoveToTrash(const fs::path& origin, const std::vector<fs::path>& entries, std::error_code& ec);
+    bool MoveToTrash(const fs::path& path, std::error_code& ec);
+
+    [[nodiscard]] std::vector<TrashBatch> ListTrash(const fs::path& trashDir); // oldest first
+    // Renames a batch back into its origin, leaving entries whose name has been taken since
+    bool RestoreTrash(const TrashBatch& batch, std::error_code& ec);
+    // Deletes batches older than `minAge`, one file at a time so a stop request is noticed quickly.
+    // A batch is renamed out of sight before it is deleted, so it cannot be restored half-gone.
+    std::uintmax_t PurgeTrash(const fs::path& trashDir, std::chrono::seconds minAge, std::stop_token stop = {});
+
+}
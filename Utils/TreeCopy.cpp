@@ -0,0 +1,198 @@
+#include "TreeCopy.hpp"
+#include "DirectoryScan.hpp"
+#include "DiskLayout.hpp"
+#include "Durability.hpp"
+#include "FileUtils.hpp"
+#include "TextUtils.hpp"
+#include "WorkStealing.hpp"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+namespace vsprofile::utils {
+
+    namespace {
+        constexpr std::size_t kFilesPerTask = 32; // small enough to spread one big folder over every worker
+
+        struct FileItem {
+            std::string name;
+            std::uint32_t mode;
+            long long mtime;
+            std::uintmax_t size;
+        };
+
+        struct CopyTask {
+            fs::path from;
+            fs::path to;
+            std::vector<FileItem> files; // empty: copy the folder `from` itself
+        };
+
+        struct DiskOrdered {
+            std::uint64_t key;
+            const CopyTask* task;
+            const FileItem* file;
+        };
+
+        struct FolderMeta {
+            fs::path path;
+            std::uint32_t mode;
+            long long mtime;
+            std::size_t depth;
+        };
+
+        void SetMtime(const fs::path& path, const long long mtime, const bool symlink, std::error_code& ec) {
+            const fs::file_time_type t {fs::file_time_type::duration{mtime}};
+#if defined(__linux__)
+            if (symlink) {
+                // last_write_time follows links, utimensat can leave them alone
+                const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::file_clock::to_sys(t).time_since_epoch()).count();
+                const timespec times[2] {{0, UTIME_OMIT}, {static_cast<time_t>(ns / 1'000'000'000), static_cast<long>(ns % 1'000'000'000)}};
+                if (utimensat(AT_FDCWD, path.c_str(), times, AT_SYMLINK_NOFOLLOW) != 0) ec.assign(errno, std::generic_category());
+                return;
+            }
+#endif
+            if (!symlink) fs::last_write_time(path, t, ec);
+        }
+    }
+
+    TreeCopyStats CopyTree(const fs::path& from, const fs::path& to, const bool skipHidden) {
+        TreeCopyStats stats;
+        std::mutex mtx; // guards stats, folders and error output
+        std::vector<FolderMeta> folders;
+        auto fail = [&](const fs::path& path, const std::error_code& ec) {
+            std::scoped_lock lock {mtx};
+            ++stats.failures;
+            PrintErr(std::format("Copy failed: '{}': {}\n", path.string(), ec.message()));
+        };
+
+        std::error_code ec;
+        fs::create_directories(to, ec);
+        if (ec) {
+            fail(to, ec);
+            return stats;
+        }
+
+        // Copies are new files nothing refers to until the copy ends, so strict flushes them all together at the end
+        const bool strict {CurrentDurability() == Durability::Strict};
+        DurableBatch durable;
+        auto copyFile = [&](const fs::path& fromDir, const fs::path& toDir, const FileItem& file) {
+            std::error_code ec;
+            const fs::path src {fromDir / file.name};
+            const fs::path dst {toDir / file.name};
+            // Never write through an existing hard link into someone else's copy
+            fs::remove(dst, ec);
+            if (!CloneFile(src, dst, ec)) { fail(src, ec); return false; }
+            SetMtime(dst, file.mtime, false, ec);
+            if (ec) { fail(dst, ec); return false; }
+            if (strict) durable.AddUnsynced(dst);
+            return true;
+        };
+
+        // On a spinning disk parallel copies turn into seeks: the walk only collects the files, which
+        // are then copied one at a time in the order they sit on the source disk
+        const bool sequential {PreferSequential(from) || PreferSequential(to)};
+        std::vector<CopyTask> deferred;
+
+        WorkStealingPool<CopyTask> pool;
+        pool.Run({{from, to, {}}}, [&](CopyTask& task, auto&& spawn) {
+            std::error_code ec;
+            if (!task.files.empty()) {
+                std::uintmax_t bytes {};
+                std::size_t copied {};
+                for (const auto& file : task.files) {
+                    if (!copyFile(task.from, task.to, file)) continue;
+                    bytes += file.size;
+                    ++copied;
+                }
+                std::scoped_lock lock {mtx};
+                stats.files += copied;
+                stats.bytes += bytes;
+                return;
+            }
+            auto queueFiles = [&](CopyTask&& files) {
+                if (!sequential) {
+                    spawn(std::move(files));
+                    return;
+                }
+                std::scoped_lock lock {mtx};
+                deferred.push_back(std::move(files));
+            };
+
+            const DirectoryScan scan {DirectoryScan::Read(task.from, ScanDetail::LinkStats, ec)};
+            if (ec) { fail(task.from, ec); return; }
+            std::vector<FileItem> batch;
+            for (const DirEntry& e : scan) {
+                if (skipHidden && IsHiddenEntry(e.name)) continue;
+                const fs::path src {task.from / e.name};
+                const fs::path dst {task.to / e.name};
+                switch (e.type) {
+                    case EntryType::Directory: {
+                        fs::create_directory(dst, ec);
+                        if (ec) { fail(dst, ec); break; }
+                        {
+                            std::scoped_lock lock {mtx};
+                            ++stats.directories;
+                            folders.push_back({dst, e.mode, e.mtime, static_cast<std::size_t>(std::distance(dst.begin(), dst.end()))});
+                        }
+                        spawn(CopyTask{src, dst, {}});
+                        break;
+                    }
+                    case EntryType::Symlink: {
+                        fs::remove(dst, ec);
+                        fs::copy_symlink(src, dst, ec);
+                        if (ec) { fail(src, ec); break; }
+                        SetMtime(dst, e.mtime, true, ec);
+                        std::scoped_lock lock {mtx};
+                        ++stats.symlinks;
+                        break;
+                    }
+                    case EntryType::File:
+                        batch.push_back({std::string{e.name}, e.mode, e.mtime, e.size});
+                        if (batch.size() == kFilesPerTask) queueFiles(CopyTask{task.from, task.to, std::exchange(batch, {})});
+                        break;
+                    default:
+                        break; // sockets, fifos and devices have no place in a mod folder
+                }
+            }
+            if (!batch.empty()) queueFiles(CopyTask{task.from, task.to, std::move(batch)});
+        });
+
+        if (sequential) {
+            std::vector<DiskOrdered> order;
+            for (const auto& task : deferred) {
+                for (const auto& file : task.files) order.push_back({DiskOrderKey(task.from / file.name), &task, &file});
+            }
+            std::ranges::sort(order, {}, &DiskOrdered::key);
+            for (const auto& [key, task, file] : order) {
+                if (!copyFile(task->from, task->to, *file)) continue;
+                ++stats.files;
+                stats.bytes += file->size;
+            }
+        }
+
+        // Folders last and deepest first: writing their contents would move their mtimes again, and a
+        // read-only folder could not have been filled
+        std::ranges::sort(folders, std::ranges::greater{}, &FolderMeta::depth);
+        for (const auto& folder : folders) {
+            fs::permissions(folder.path, static_cast<fs::perms>(folder.mode), ec);
+            if (!ec) SetMtime(folder.path, folder.mtime, false, ec);
+            if (ec) fail(folder.path, ec);
+        }
+        // Every folder that gained entries, `to` itself included, and the folder holding `to`
+        for (const auto& folder : folders) durable.AddDirectory(folder.path);
+        durable.AddDirectory(to);
+        durable.Add(to);
+        durable.Commit();
+        return stats;
+    }
+
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+
+namespace vsprofile::utils {
+
+    namespace fs = std::filesystem;
+
+    struct TreeCopyStats {
+        std::size_t files {};
+        std::size_t directories {};
+        std::size_t symlinks {};
+        std::size_t failures {};
+        std::uintmax_t bytes {};
+    };
+
+    // Recursive copy of a folder's contents into `to`, folders walked in parallel with work stealing
+    // and files copied in parallel batches. Files keep their permissions and mtimes, folders get theirs
+    // once their contents are written, symlinks are recreated as symlinks rather than followed.
+    // When either side is on a spinning disk (or configured sequential) files are copied one at a time
+    // in the order of their first extent on the source instead.
+    // Failures are reported and counted, the rest of the tree is still copied.
+    TreeCopyStats CopyTree(const fs::path& from, const fs::path& to, bool skipHidden = true);
+
+}
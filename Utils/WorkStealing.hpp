@@ -0,0 +1,95 @@
+#pragma once
+#include "TextUtils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace vsprofile::utils {
+
+    // Runs a set of tasks, and the tasks they spawn, across hardware threads. Each worker takes its
+    // newest task first (depth first, warm caches) and steals the oldest task of another worker when
+    // it runs dry, so one huge folder does not leave the other threads idle.
+    template <typename Task>
+    class WorkStealingPool {
+        struct Lane {
+            std::mutex mtx;
+            std::deque<Task> tasks;
+        };
+        std::vector<Lane> lanes_;
+        std::atomic<std::size_t> pending_ {0};
+        std::atomic<std::uint32_t> wakes_ {0}; // bumped when work is queued or the last task ends, idle workers wait on it
+
+        std::optional<Task> Take(const std::size_t self) {
+            {
+                Lane& own {lanes_[self]};
+                std::scoped_lock lock {own.mtx};
+                if (!own.tasks.empty()) {
+                    Task t {std::move(own.tasks.back())};
+                    own.tasks.pop_back();
+                    return t;
+                }
+            }
+            for (std::size_t i = 1; i < lanes_.size(); ++i) {
+                Lane& other {lanes_[(self + i) % lanes_.size()]};
+                std::scoped_lock lock {other.mtx};
+                if (!other.tasks.empty()) {
+                    Task t {std::move(other.tasks.front())};
+                    other.tasks.pop_front();
+                    return t;
+                }
+            }
+            return std::nullopt;
+        }
+
+    public:
+        explicit WorkStealingPool(const std::size_t workers = std::max(1u, std::thread::hardware_concurrency()))
+            : lanes_(std::max<std::size_t>(1, workers)) {}
+
+        // fn(task, spawn) is called once per task; spawn(Task) queues more work on the calling worker
+        template <typename Fn>
+        void Run(std::vector<Task> initial, Fn fn) {
+            if (initial.empty()) return;
+            pending_ = initial.size();
+            for (std::size_t i = 0; i < initial.size(); ++i) lanes_[i % lanes_.size()].tasks.push_back(std::move(initial[i]));
+            const bool background {tBackgroundOutput};
+            auto worker = [&, background](const std::size_t self) {
+                tBackgroundOutput = background; // output follows whoever the work is done for
+                auto spawn = [&, self](Task t) {
+                    pending_.fetch_add(1);
+                    {
+                        std::scoped_lock lock {lanes_[self].mtx};
+                        lanes_[self].tasks.push_back(std::move(t));
+                    }
+                    wakes_.fetch_add(1);
+                    wakes_.notify_one();
+                };
+                while (true) {
+                    // Read before looking for work, so a task queued in between still ends the wait
+                    const std::uint32_t seen {wakes_.load()};
+                    if (pending_.load() == 0) break;
+                    std::optional<Task> t {Take(self)};
+                    if (!t) {
+                        wakes_.wait(seen); // the last tasks are still running elsewhere
+                        continue;
+                    }
+                    fn(*t, spawn);
+                    if (pending_.fetch_sub(1) == 1) {
+                        wakes_.fetch_add(1);
+                        wakes_.notify_all();
+                    }
+                }
+            };
+            {
+                std::vector<std::jthread> threads;
+                for (std::size_t i = 1; i < lanes_.size(); ++i) threads.emplace_back(worker, i);
+                worker(0);
+            }
+        }
+    };
+
+}
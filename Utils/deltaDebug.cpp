@@ -1,18 +1,10 @@
 //
 // Created by Jacopo Uggeri on 27/07/2025.
 //
-#include <iostream>
-#include <vector>
-#include <functional>
+#include "deltaDebug.hpp"
+#include <algorithm>
 
-// Interactive test
-bool manualTest(const std::vector<std::string>& mods) {
-    std::cout << "\nTesting (" << mods.size() << " mods):\n";
-    for (auto &m : mods) std::cout << "  " << m << "\n";
-    std::cout << "Crash? (y/n): ";
-    char c; std::cin >> c;
-    return (c=='y');
-}
+namespace vsprofile::utils {
 
 std::vector<std::string> withoutChunk(const std::vector<std::string>& mods,
                                       int i, int n) {
@@ -53,19 +45,4 @@ std::vector<std::string> ddmin(const std::vector<std::string>& mods,
     return current;
 }
 
-int run() {
-    std::vector<std::string> allMods = {
-            "modA.zip","modB.zip","modC.zip","modD.zip","modE.zip"
-    };
-
-    std::cout << "Full set crash? ";
-    if (!manualTest(allMods)) {
-        std::cout << "Nothing to debug.\n";
-        return 0;
-    }
-
-    auto culprit = ddmin(allMods, manualTest);
-
-    std::cout << "\n>>> Minimal failing set (" << culprit.size() << "):\n";
-    for (auto &m: culprit) std::cout << "  " << m << "\n";
 }
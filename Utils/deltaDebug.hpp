@@ -0,0 +1,15 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace vsprofile::utils {
+
+    // Copy of mods with the i-th of n roughly equal chunks removed
+    std::vector<std::string> withoutChunk(const std::vector<std::string>& mods, int i, int n);
+
+    // Delta debugging: shrinks mods to a minimal subset for which test still returns true
+    std::vector<std::string> ddmin(const std::vector<std::string>& mods,
+                                   std::function<bool(const std::vector<std::string>&)> test);
+
+}